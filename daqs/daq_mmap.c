@@ -0,0 +1,1289 @@
+/*--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+*/
+/* daq_mmap.c author Cisco */
+
+/* Offline replay of pcap and pcapng files.  The whole file is mapped and
+   messages point straight into the mapping, so packets are never copied.
+   The mapping is private, in-place changes made by the application (e.g.
+   normalizations) only copy the touched pages.
+
+   In shard mode all instances read the same file.  A reader thread walks
+   the file and passes each packet to the instance selected by a symmetric
+   hash of its addresses and ports, through one single producer / single
+   consumer ring per instance, so both directions of a flow are processed
+   in file order by the same instance. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <daq_module_api.h>
+
+#define DAQ_MOD_VERSION 0
+#define DAQ_NAME "mmap"
+#define DAQ_TYPE (DAQ_TYPE_FILE_CAPABLE|DAQ_TYPE_INTF_CAPABLE|DAQ_TYPE_MULTI_INSTANCE)
+
+#define MMAP_DEFAULT_POOL_SIZE 64
+#define MMAP_DEFAULT_SNAPLEN 65535
+#define MMAP_DEFAULT_PREFETCH (4 * 1024 * 1024)
+#define MMAP_MAX_INTERFACES 64
+
+/* ring entries per shard, must be a power of 2 */
+#define MMAP_RING_SIZE 4096
+#define MMAP_RING_MASK (MMAP_RING_SIZE - 1)
+/* how long an empty shard polls before reporting a timeout */
+#define MMAP_POLL_USEC 100
+#define MMAP_POLL_COUNT 10
+
+#define PCAP_MAGIC          0xa1b2c3d4
+#define PCAP_MAGIC_NSEC     0xa1b23c4d
+#define PCAP_FILE_HDR_LEN   24
+#define PCAP_PKT_HDR_LEN    16
+
+#define PCAPNG_SHB          0x0a0d0d0a
+#define PCAPNG_IDB          0x00000001
+#define PCAPNG_OPB          0x00000002
+#define PCAPNG_SPB          0x00000003
+#define PCAPNG_EPB          0x00000006
+#define PCAPNG_BYTE_ORDER   0x1a2b3c4d
+#define PCAPNG_OPT_TSRESOL  9
+
+#define SET_ERROR(modinst, ...)    daq_base_api.set_errbuf(modinst, __VA_ARGS__)
+
+typedef enum
+{
+    MMAP_FMT_PCAP,
+    MMAP_FMT_PCAPNG
+} MmapFormat;
+
+typedef struct
+{
+    const uint8_t* data;
+    uint32_t caplen;
+    uint32_t pktlen;
+    struct timeval ts;
+} MmapPacket;
+
+typedef struct _mmap_msg_desc
+{
+    DAQ_Msg_t msg;
+    DAQ_PktHdr_t pkthdr;
+    struct _mmap_msg_desc* next;
+} MmapMsgDesc;
+
+typedef struct
+{
+    MmapMsgDesc* pool;
+    MmapMsgDesc* freelist;
+    DAQ_MsgPoolInfo_t info;
+} MmapMsgPool;
+
+typedef struct
+{
+    int dlt;
+    /* timestamp units per second */
+    uint64_t ts_units;
+} MmapInterface;
+
+typedef struct
+{
+    const char* filename;
+    size_t prefetch;
+
+    const uint8_t* base;
+    size_t size;
+    size_t offset;
+    size_t prefetched;
+
+    MmapFormat format;
+    bool swapped;
+    bool nsec;
+    int dlt;
+
+    MmapInterface ifaces[MMAP_MAX_INTERFACES];
+    unsigned num_ifaces;
+
+    uint64_t packets_read;
+    uint64_t bytes_read;
+    struct timespec start_time;
+} MmapFile;
+
+/* head is only written by the reader and tail by the owning instance */
+typedef struct
+{
+    uint32_t head __attribute__((aligned(64)));
+    uint32_t tail __attribute__((aligned(64)));
+    int closed __attribute__((aligned(64)));
+    MmapPacket slots[MMAP_RING_SIZE];
+} MmapRing;
+
+typedef struct _mmap_shard_group
+{
+    char* filename;
+    unsigned total;
+    unsigned refs;
+    bool throughput;
+
+    MmapFile file;
+    MmapRing* rings;
+
+    pthread_t reader;
+    int done;
+    int stop;
+    uint64_t ring_full;
+
+    struct _mmap_shard_group* next;
+} MmapShardGroup;
+
+typedef struct
+{
+    /* Configuration */
+    char* filename;
+    unsigned snaplen;
+    size_t prefetch;
+    bool throughput;
+    bool shard;
+    unsigned instance_id;
+    unsigned total_instances;
+
+    /* State */
+    DAQ_ModuleInstance_h modinst;
+    MmapMsgPool pool;
+    volatile bool interrupted;
+
+    MmapFile file;
+    MmapShardGroup* group;
+    MmapRing* ring;
+    int dlt;
+
+    DAQ_Stats_t stats;
+} MmapContext;
+
+static DAQ_VariableDesc_t mmap_variable_descriptions[] = {
+    { "prefetch", "Bytes of the file to read ahead of the current packet (integer)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "throughput", "Print the read throughput to stderr when stopped", DAQ_VAR_DESC_FORBIDS_ARGUMENT },
+    { "shard", "Spread the flows of one file over all instances", DAQ_VAR_DESC_FORBIDS_ARGUMENT },
+};
+
+static DAQ_BaseAPI_t daq_base_api;
+
+static pthread_mutex_t shard_groups_mutex = PTHREAD_MUTEX_INITIALIZER;
+static MmapShardGroup* shard_groups = NULL;
+
+//-------------------------------------------------------------------------
+// utility functions
+//-------------------------------------------------------------------------
+
+static inline uint16_t get16(const MmapFile* mf, const uint8_t* p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return mf->swapped ? __builtin_bswap16(v) : v;
+}
+
+static inline uint32_t get32(const MmapFile* mf, const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return mf->swapped ? __builtin_bswap32(v) : v;
+}
+
+static void destroy_message_pool(MmapContext* mc)
+{
+    MmapMsgPool* pool = &mc->pool;
+    if (pool->pool)
+    {
+        free(pool->pool);
+        pool->pool = NULL;
+    }
+    pool->freelist = NULL;
+    pool->info.size = 0;
+    pool->info.available = 0;
+    pool->info.mem_size = 0;
+}
+
+static int create_message_pool(MmapContext* mc, unsigned size)
+{
+    MmapMsgPool* pool = &mc->pool;
+    pool->pool = calloc(sizeof(MmapMsgDesc), size);
+    if (!pool->pool)
+    {
+        SET_ERROR(mc->modinst, "%s: Could not allocate %zu bytes for a packet descriptor pool!",
+                __func__, sizeof(MmapMsgDesc) * size);
+        return DAQ_ERROR_NOMEM;
+    }
+    /* Descriptors only, packet data stays in the mapping */
+    pool->info.mem_size = sizeof(MmapMsgDesc) * size;
+    while (pool->info.size < size)
+    {
+        MmapMsgDesc *desc = &pool->pool[pool->info.size];
+
+        /* Initialize non-zero invariant packet header fields. */
+        DAQ_PktHdr_t *pkthdr = &desc->pkthdr;
+        pkthdr->ingress_index = DAQ_PKTHDR_UNKNOWN;
+        pkthdr->ingress_group = DAQ_PKTHDR_UNKNOWN;
+        pkthdr->egress_index = DAQ_PKTHDR_UNKNOWN;
+        pkthdr->egress_group = DAQ_PKTHDR_UNKNOWN;
+
+        /* Initialize non-zero invariant message header fields. */
+        DAQ_Msg_t *msg = &desc->msg;
+        msg->type = DAQ_MSG_TYPE_PACKET;
+        msg->hdr_len = sizeof(*pkthdr);
+        msg->hdr = pkthdr;
+        msg->owner = mc->modinst;
+        msg->priv = desc;
+
+        /* Place it on the free list */
+        desc->next = pool->freelist;
+        pool->freelist = desc;
+
+        pool->info.size++;
+    }
+    pool->info.available = pool->info.size;
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+// file functions
+//-------------------------------------------------------------------------
+
+static int pcap_setup(MmapFile* mf)
+{
+    if (mf->size < PCAP_FILE_HDR_LEN)
+        return -1;
+
+    uint32_t magic;
+    memcpy(&magic, mf->base, sizeof(magic));
+
+    if (magic == PCAP_MAGIC || magic == PCAP_MAGIC_NSEC)
+        mf->swapped = false;
+    else if (__builtin_bswap32(magic) == PCAP_MAGIC || __builtin_bswap32(magic) == PCAP_MAGIC_NSEC)
+        mf->swapped = true;
+    else
+        return -1;
+
+    mf->format = MMAP_FMT_PCAP;
+    mf->nsec = (get32(mf, mf->base) == PCAP_MAGIC_NSEC);
+    mf->dlt = get32(mf, mf->base + 20) & 0x0fffffff;
+    mf->offset = PCAP_FILE_HDR_LEN;
+
+    return 0;
+}
+
+static int pcapng_setup(MmapFile* mf)
+{
+    /* the section header block type is a palindrome, the byte order magic isn't */
+    if (mf->size < 28)
+        return -1;
+
+    uint32_t type;
+    memcpy(&type, mf->base, sizeof(type));
+
+    if (type != PCAPNG_SHB)
+        return -1;
+
+    uint32_t bom;
+    memcpy(&bom, mf->base + 8, sizeof(bom));
+
+    if (bom == PCAPNG_BYTE_ORDER)
+        mf->swapped = false;
+    else if (__builtin_bswap32(bom) == PCAPNG_BYTE_ORDER)
+        mf->swapped = true;
+    else
+        return -1;
+
+    mf->format = MMAP_FMT_PCAPNG;
+    mf->num_ifaces = 0;
+    mf->dlt = -1;
+    mf->offset = 0;
+
+    /* the link type must be known before the first packet is read */
+    size_t off = 0;
+
+    while (off + 12 <= mf->size)
+    {
+        uint32_t len = get32(mf, mf->base + off + 4);
+
+        if (len < 12 || len > mf->size - off)
+            break;
+
+        if (get32(mf, mf->base + off) == PCAPNG_IDB && len >= 20)
+        {
+            mf->dlt = get16(mf, mf->base + off + 8);
+            break;
+        }
+        off += len;
+    }
+
+    return mf->dlt < 0 ? -1 : 0;
+}
+
+static void add_interface(MmapFile* mf, const uint8_t* body, uint32_t body_len)
+{
+    if (mf->num_ifaces >= MMAP_MAX_INTERFACES || body_len < 8)
+        return;
+
+    MmapInterface* iface = &mf->ifaces[mf->num_ifaces++];
+    iface->dlt = get16(mf, body);
+    iface->ts_units = 1000000;
+
+    /* options follow the linktype, reserved and snaplen fields */
+    const uint8_t* opt = body + 8;
+    const uint8_t* end = body + body_len;
+
+    while (opt + 4 <= end)
+    {
+        uint16_t code = get16(mf, opt);
+        uint16_t len = get16(mf, opt + 2);
+
+        if (!code || opt + 4 + len > end)
+            break;
+
+        if (code == PCAPNG_OPT_TSRESOL && len == 1)
+        {
+            uint8_t resol = opt[4];
+            uint64_t units = 1;
+
+            if (resol & 0x80)
+                units <<= (resol & 0x7f) < 64 ? (resol & 0x7f) : 63;
+            else
+                for (unsigned i = 0; i < resol && i < 19; ++i)
+                    units *= 10;
+
+            iface->ts_units = units;
+        }
+        opt += 4 + ((len + 3) & ~3);
+    }
+}
+
+static int file_setup(MmapFile* mf, DAQ_ModuleInstance_h modinst)
+{
+    int fd = open(mf->filename, O_RDONLY);
+
+    if (fd < 0)
+    {
+        char error_msg[1024] = {0};
+        if (strerror_r(errno, error_msg, sizeof(error_msg)) == 0)
+            SET_ERROR(modinst, "%s: can't open file (%s)", DAQ_NAME, error_msg);
+        else
+            SET_ERROR(modinst, "%s: can't open file: %d", DAQ_NAME, errno);
+        return -1;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) || !st.st_size)
+    {
+        SET_ERROR(modinst, "%s: can't map empty or unreadable file %s", DAQ_NAME, mf->filename);
+        close(fd);
+        return -1;
+    }
+
+    /* writable private mapping, see above */
+    void* base = mmap(NULL, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        SET_ERROR(modinst, "%s: can't map file: %d", DAQ_NAME, errno);
+        return -1;
+    }
+
+    mf->base = (const uint8_t*) base;
+    mf->size = st.st_size;
+    mf->prefetched = 0;
+
+    madvise(base, mf->size, MADV_SEQUENTIAL);
+
+    if (pcap_setup(mf) && pcapng_setup(mf))
+    {
+        SET_ERROR(modinst, "%s: %s is not a pcap or pcapng file", DAQ_NAME, mf->filename);
+        munmap(base, mf->size);
+        mf->base = NULL;
+        return -1;
+    }
+
+    mf->packets_read = 0;
+    mf->bytes_read = 0;
+    clock_gettime(CLOCK_MONOTONIC, &mf->start_time);
+
+    return 0;
+}
+
+static void file_cleanup(MmapFile* mf)
+{
+    if (mf->base)
+        munmap((void*) mf->base, mf->size);
+
+    mf->base = NULL;
+    mf->size = 0;
+    mf->offset = 0;
+}
+
+static void report_throughput(const MmapFile* mf)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    double secs = (now.tv_sec - mf->start_time.tv_sec) +
+        (now.tv_nsec - mf->start_time.tv_nsec) / 1e9;
+
+    if (secs <= 0.0)
+        secs = 1e-9;
+
+    fprintf(stderr, "%s: %s: %" PRIu64 " packets, %" PRIu64 " bytes in %.3f s "
+        "(%.0f pkts/s, %.1f MB/s)\n", DAQ_NAME, mf->filename,
+        mf->packets_read, mf->bytes_read, secs,
+        mf->packets_read / secs, mf->bytes_read / secs / 1e6);
+}
+
+/* Keep the kernel reading ahead of the packets being handed out. */
+static void file_prefetch(MmapFile* mf)
+{
+    if (!mf->prefetch || mf->prefetched >= mf->size)
+        return;
+
+    if (mf->offset + mf->prefetch / 2 < mf->prefetched)
+        return;
+
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t start = mf->prefetched & ~(page - 1);
+    size_t len = mf->prefetch;
+
+    if (start + len > mf->size)
+        len = mf->size - start;
+
+    madvise((void*) (mf->base + start), len, MADV_WILLNEED);
+    mf->prefetched = start + len;
+}
+
+static void set_packet(MmapPacket* pkt, const uint8_t* data, uint32_t caplen,
+    uint32_t pktlen, uint64_t sec, uint64_t usec)
+{
+    pkt->data = data;
+    pkt->caplen = caplen;
+    pkt->pktlen = pktlen;
+    pkt->ts.tv_sec = sec;
+    pkt->ts.tv_usec = usec;
+}
+
+static bool pcap_read_packet(MmapFile* mf, MmapPacket* pkt)
+{
+    if (mf->offset + PCAP_PKT_HDR_LEN > mf->size)
+        return false;
+
+    const uint8_t* hdr = mf->base + mf->offset;
+    uint32_t caplen = get32(mf, hdr + 8);
+
+    /* a truncated last packet ends the file like libpcap does */
+    if (caplen > mf->size - mf->offset - PCAP_PKT_HDR_LEN)
+        return false;
+
+    uint32_t frac = get32(mf, hdr + 4);
+
+    set_packet(pkt, hdr + PCAP_PKT_HDR_LEN, caplen, get32(mf, hdr + 12),
+        get32(mf, hdr), mf->nsec ? frac / 1000 : frac);
+
+    mf->offset += PCAP_PKT_HDR_LEN + caplen;
+    mf->bytes_read += PCAP_PKT_HDR_LEN + caplen;
+
+    return true;
+}
+
+static bool pcapng_read_packet(MmapFile* mf, MmapPacket* pkt)
+{
+    while (mf->offset + 12 <= mf->size)
+    {
+        const uint8_t* blk = mf->base + mf->offset;
+        uint32_t type;
+        memcpy(&type, blk, sizeof(type));
+
+        /* a new section may switch the byte order */
+        if (type == PCAPNG_SHB)
+        {
+            uint32_t bom;
+            memcpy(&bom, blk + 8, sizeof(bom));
+            mf->swapped = (bom != PCAPNG_BYTE_ORDER);
+            mf->num_ifaces = 0;
+        }
+        else
+            type = get32(mf, blk);
+
+        uint32_t len = get32(mf, blk + 4);
+
+        if (len < 12 || (len & 3) || len > mf->size - mf->offset)
+            return false;
+
+        const uint8_t* body = blk + 8;
+        uint32_t body_len = len - 12;
+
+        mf->offset += len;
+        mf->bytes_read += len;
+
+        switch (type)
+        {
+        case PCAPNG_IDB:
+            add_interface(mf, body, body_len);
+            break;
+
+        case PCAPNG_EPB:
+        case PCAPNG_OPB:
+        {
+            if (body_len < 20)
+                break;
+
+            uint32_t id = (type == PCAPNG_EPB) ? get32(mf, body) : get16(mf, body);
+            uint32_t caplen = get32(mf, body + 12);
+
+            if (id >= mf->num_ifaces || caplen > body_len - 20)
+                break;
+
+            const MmapInterface* iface = &mf->ifaces[id];
+
+            /* only packets of the reported link type can be decoded */
+            if (iface->dlt != mf->dlt)
+                break;
+
+            uint64_t ts = ((uint64_t) get32(mf, body + 4) << 32) | get32(mf, body + 8);
+            uint64_t sec = ts / iface->ts_units;
+            uint64_t usec = (ts % iface->ts_units) * 1000000 / iface->ts_units;
+
+            set_packet(pkt, body + 20, caplen, get32(mf, body + 16), sec, usec);
+            return true;
+        }
+
+        case PCAPNG_SPB:
+        {
+            if (body_len < 4 || !mf->num_ifaces || mf->ifaces[0].dlt != mf->dlt)
+                break;
+
+            uint32_t pktlen = get32(mf, body);
+            uint32_t caplen = pktlen < body_len - 4 ? pktlen : body_len - 4;
+
+            /* simple packets carry no timestamp */
+            set_packet(pkt, body + 4, caplen, pktlen, 0, 0);
+            return true;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    return false;
+}
+
+static bool file_read_packet(MmapFile* mf, MmapPacket* pkt)
+{
+    bool ok = (mf->format == MMAP_FMT_PCAP) ? pcap_read_packet(mf, pkt) : pcapng_read_packet(mf, pkt);
+
+    if (ok)
+        mf->packets_read++;
+
+    return ok;
+}
+
+//-------------------------------------------------------------------------
+// shard functions
+//-------------------------------------------------------------------------
+
+#define DLT_EN10MB      1
+#define DLT_RAW         12
+#define DLT_RAW_OPENBSD 14
+#define DLT_LINUX_SLL   113
+#define LINKTYPE_RAW    101
+#define LINKTYPE_IPV4   228
+#define LINKTYPE_IPV6   229
+
+static uint32_t hash_bytes(uint32_t h, const uint8_t* p, unsigned len)
+{
+    while (len--)
+        h = (h ^ *p++) * 16777619;
+    return h;
+}
+
+static uint32_t hash_endpoints(const uint8_t* src, const uint8_t* dst, unsigned addr_len,
+    const uint8_t* ports, uint8_t proto)
+{
+    uint16_t sp = 0, dp = 0;
+
+    if (ports)
+    {
+        sp = (ports[0] << 8) | ports[1];
+        dp = (ports[2] << 8) | ports[3];
+    }
+
+    /* order the endpoints so that both directions hash the same */
+    int cmp = memcmp(src, dst, addr_len);
+
+    if (cmp > 0 || (cmp == 0 && sp > dp))
+    {
+        const uint8_t* a = src;
+        src = dst;
+        dst = a;
+        uint16_t p = sp;
+        sp = dp;
+        dp = p;
+    }
+
+    uint8_t tail[5] = { sp >> 8, sp & 0xff, dp >> 8, dp & 0xff, proto };
+
+    uint32_t h = 2166136261;
+    h = hash_bytes(h, src, addr_len);
+    h = hash_bytes(h, dst, addr_len);
+    h = hash_bytes(h, tail, sizeof(tail));
+
+    /* spread the low bits used to select the shard */
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+
+    return h;
+}
+
+static bool has_ports(uint8_t proto)
+{
+    return proto == 6 || proto == 17 || proto == 132;
+}
+
+/* Fragments are hashed on addresses only, so all fragments of a datagram
+   reach the same instance.  Anything that isn't IP goes to the first one. */
+static uint32_t hash_ip(const uint8_t* ip, uint32_t len)
+{
+    if (len < 1)
+        return 0;
+
+    if ((ip[0] >> 4) == 4)
+    {
+        unsigned hlen = (ip[0] & 0x0f) * 4;
+
+        if (len < 20 || hlen < 20)
+            return 0;
+
+        uint8_t proto = ip[9];
+        bool frag = (((ip[6] << 8) | ip[7]) & 0x3fff) != 0;
+        const uint8_t* ports = (!frag && has_ports(proto) && len >= hlen + 4) ? ip + hlen : NULL;
+
+        return hash_endpoints(ip + 12, ip + 16, 4, ports, frag ? 0 : proto);
+    }
+
+    if ((ip[0] >> 4) == 6)
+    {
+        if (len < 40)
+            return 0;
+
+        uint8_t proto = ip[6];
+        uint32_t off = 40;
+        bool frag = false;
+
+        /* hop-by-hop, routing and destination options */
+        while ((proto == 0 || proto == 43 || proto == 60) && off + 8 <= len)
+        {
+            proto = ip[off];
+            off += (ip[off + 1] + 1) * 8;
+        }
+        if (proto == 44)
+            frag = true;
+
+        const uint8_t* ports = (!frag && has_ports(proto) && len >= off + 4) ? ip + off : NULL;
+
+        return hash_endpoints(ip + 8, ip + 24, 16, ports, frag ? 0 : proto);
+    }
+
+    return 0;
+}
+
+static uint32_t hash_packet(int dlt, const MmapPacket* pkt)
+{
+    const uint8_t* p = pkt->data;
+    uint32_t len = pkt->caplen;
+    uint32_t off;
+
+    switch (dlt)
+    {
+    case DLT_EN10MB:
+        off = 12;
+        while (off + 2 <= len)
+        {
+            uint16_t type = (p[off] << 8) | p[off + 1];
+
+            if (type == 0x8100 || type == 0x88a8 || type == 0x9100)
+                off += 4;
+            else if (type == 0x0800 || type == 0x86dd)
+                return hash_ip(p + off + 2, len - off - 2);
+            else
+                break;
+        }
+        return 0;
+
+    case DLT_LINUX_SLL:
+        return len > 16 ? hash_ip(p + 16, len - 16) : 0;
+
+    case DLT_RAW:
+    case DLT_RAW_OPENBSD:
+    case LINKTYPE_RAW:
+    case LINKTYPE_IPV4:
+    case LINKTYPE_IPV6:
+        return hash_ip(p, len);
+
+    default:
+        return 0;
+    }
+}
+
+static void* shard_reader(void* arg)
+{
+    MmapShardGroup* sg = (MmapShardGroup*) arg;
+    MmapFile* mf = &sg->file;
+    MmapPacket pkt;
+
+    while (!__atomic_load_n(&sg->stop, __ATOMIC_RELAXED))
+    {
+        file_prefetch(mf);
+
+        if (!file_read_packet(mf, &pkt))
+            break;
+
+        MmapRing* ring = &sg->rings[hash_packet(mf->dlt, &pkt) % sg->total];
+        uint32_t head = ring->head;
+
+        /* per-flow order is kept by waiting for room, packets are never reordered */
+        while (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == MMAP_RING_SIZE)
+        {
+            if (__atomic_load_n(&ring->closed, __ATOMIC_RELAXED) ||
+                __atomic_load_n(&sg->stop, __ATOMIC_RELAXED))
+                break;
+
+            sg->ring_full++;
+            struct timespec ts = { 0, MMAP_POLL_USEC * 1000 };
+            nanosleep(&ts, NULL);
+        }
+
+        /* nobody is left to process this shard */
+        if (__atomic_load_n(&ring->closed, __ATOMIC_RELAXED))
+            continue;
+
+        if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == MMAP_RING_SIZE)
+            break;
+
+        ring->slots[head & MMAP_RING_MASK] = pkt;
+        __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    }
+
+    if (sg->throughput)
+    {
+        report_throughput(mf);
+        fprintf(stderr, "%s: %s: reader waited %" PRIu64 " times for a full shard\n",
+            DAQ_NAME, mf->filename, sg->ring_full);
+    }
+
+    __atomic_store_n(&sg->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void destroy_shard_group(MmapShardGroup* sg)
+{
+    file_cleanup(&sg->file);
+    free(sg->rings);
+    free(sg->filename);
+    free(sg);
+}
+
+static MmapShardGroup* join_shard_group(MmapContext* mc)
+{
+    pthread_mutex_lock(&shard_groups_mutex);
+
+    MmapShardGroup* sg;
+
+    for (sg = shard_groups; sg; sg = sg->next)
+        if (sg->total == mc->total_instances && !strcmp(sg->filename, mc->filename))
+            break;
+
+    if (!sg)
+    {
+        sg = calloc(1, sizeof(*sg));
+
+        if (sg)
+        {
+            sg->filename = strdup(mc->filename);
+            sg->rings = calloc(mc->total_instances, sizeof(*sg->rings));
+        }
+        if (!sg || !sg->filename || !sg->rings)
+        {
+            SET_ERROR(mc->modinst, "%s: Couldn't allocate memory for the shard rings!", DAQ_NAME);
+            if (sg)
+            {
+                free(sg->rings);
+                free(sg->filename);
+                free(sg);
+            }
+            pthread_mutex_unlock(&shard_groups_mutex);
+            return NULL;
+        }
+
+        sg->total = mc->total_instances;
+        sg->throughput = mc->throughput;
+        sg->file.filename = sg->filename;
+        sg->file.prefetch = mc->prefetch;
+
+        if (file_setup(&sg->file, mc->modinst))
+        {
+            destroy_shard_group(sg);
+            pthread_mutex_unlock(&shard_groups_mutex);
+            return NULL;
+        }
+
+        if (pthread_create(&sg->reader, NULL, shard_reader, sg))
+        {
+            SET_ERROR(mc->modinst, "%s: Couldn't start the shard reader thread!", DAQ_NAME);
+            destroy_shard_group(sg);
+            pthread_mutex_unlock(&shard_groups_mutex);
+            return NULL;
+        }
+
+        sg->next = shard_groups;
+        shard_groups = sg;
+    }
+
+    sg->refs++;
+
+    pthread_mutex_unlock(&shard_groups_mutex);
+    return sg;
+}
+
+static void leave_shard_group(MmapContext* mc)
+{
+    MmapShardGroup* sg = mc->group;
+
+    /* let the reader skip the flows of this instance from now on */
+    __atomic_store_n(&mc->ring->closed, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&shard_groups_mutex);
+
+    if (!--sg->refs)
+    {
+        MmapShardGroup** pp = &shard_groups;
+
+        while (*pp != sg)
+            pp = &(*pp)->next;
+
+        *pp = sg->next;
+
+        __atomic_store_n(&sg->stop, 1, __ATOMIC_RELAXED);
+        pthread_join(sg->reader, NULL);
+        destroy_shard_group(sg);
+    }
+
+    pthread_mutex_unlock(&shard_groups_mutex);
+
+    mc->group = NULL;
+    mc->ring = NULL;
+}
+
+//-------------------------------------------------------------------------
+// daq utilities
+//-------------------------------------------------------------------------
+
+static void set_message(MmapContext* mc, MmapMsgDesc* desc, const MmapPacket* pkt)
+{
+    desc->msg.data = (uint8_t*) pkt->data;
+    desc->msg.data_len = pkt->caplen < mc->snaplen ? pkt->caplen : mc->snaplen;
+    desc->pkthdr.pktlen = pkt->pktlen;
+    desc->pkthdr.ts = pkt->ts;
+}
+
+static DAQ_RecvStatus read_message(MmapContext* mc, MmapMsgDesc* desc)
+{
+    MmapPacket pkt;
+
+    if (!file_read_packet(&mc->file, &pkt))
+        return DAQ_RSTAT_EOF;
+
+    set_message(mc, desc, &pkt);
+    return DAQ_RSTAT_OK;
+}
+
+static DAQ_RecvStatus shard_read_message(MmapContext* mc, MmapMsgDesc* desc, bool wait)
+{
+    MmapRing* ring = mc->ring;
+    uint32_t tail = ring->tail;
+    unsigned polls = 0;
+
+    while (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+    {
+        if (__atomic_load_n(&mc->group->done, __ATOMIC_ACQUIRE))
+        {
+            /* the reader may have added a last packet before finishing */
+            if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+                return DAQ_RSTAT_EOF;
+            break;
+        }
+
+        if (!wait || ++polls > MMAP_POLL_COUNT)
+            return DAQ_RSTAT_TIMEOUT;
+
+        struct timespec ts = { 0, MMAP_POLL_USEC * 1000 };
+        nanosleep(&ts, NULL);
+    }
+
+    set_message(mc, desc, &ring->slots[tail & MMAP_RING_MASK]);
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return DAQ_RSTAT_OK;
+}
+
+//-------------------------------------------------------------------------
+// daq
+//-------------------------------------------------------------------------
+
+static int mmap_daq_module_load(const DAQ_BaseAPI_t* base_api)
+{
+    if (base_api->api_version != DAQ_BASE_API_VERSION || base_api->api_size != sizeof(DAQ_BaseAPI_t))
+        return DAQ_ERROR;
+
+    daq_base_api = *base_api;
+
+    return DAQ_SUCCESS;
+}
+
+static int mmap_daq_get_variable_descs(const DAQ_VariableDesc_t** var_desc_table)
+{
+    *var_desc_table = mmap_variable_descriptions;
+
+    return sizeof(mmap_variable_descriptions) / sizeof(DAQ_VariableDesc_t);
+}
+
+static int mmap_daq_instantiate(const DAQ_ModuleConfig_h modcfg, DAQ_ModuleInstance_h modinst, void** ctxt_ptr)
+{
+    MmapContext* mc;
+    int rval = DAQ_ERROR;
+
+    mc = calloc(1, sizeof(*mc));
+    if (!mc)
+    {
+        SET_ERROR(modinst, "%s: Couldn't allocate memory for the new Mmap context!", DAQ_NAME);
+        rval = DAQ_ERROR_NOMEM;
+        goto err;
+    }
+    mc->modinst = modinst;
+
+    mc->snaplen = daq_base_api.config_get_snaplen(modcfg) ? daq_base_api.config_get_snaplen(modcfg) : MMAP_DEFAULT_SNAPLEN;
+    mc->prefetch = MMAP_DEFAULT_PREFETCH;
+
+    const char* varKey, * varValue;
+    daq_base_api.config_first_variable(modcfg, &varKey, &varValue);
+    while (varKey)
+    {
+        if (!strcmp(varKey, "prefetch"))
+            mc->prefetch = strtoul(varValue, NULL, 10);
+        else if (!strcmp(varKey, "throughput"))
+            mc->throughput = true;
+        else if (!strcmp(varKey, "shard"))
+            mc->shard = true;
+        else
+        {
+            SET_ERROR(modinst, "%s: Unknown variable name: '%s'", DAQ_NAME, varKey);
+            rval = DAQ_ERROR_INVAL;
+            goto err;
+        }
+
+        daq_base_api.config_next_variable(modcfg, &varKey, &varValue);
+    }
+
+    /* a single instance reads the file by itself */
+    mc->total_instances = daq_base_api.config_get_total_instances(modcfg);
+    mc->instance_id = daq_base_api.config_get_instance_id(modcfg);
+
+    if (mc->total_instances < 2 || !mc->instance_id || mc->instance_id > mc->total_instances)
+        mc->shard = false;
+
+    const char* filename = daq_base_api.config_get_input(modcfg);
+    if (!filename)
+    {
+        SET_ERROR(modinst, "%s: No file to read from!", DAQ_NAME);
+        rval = DAQ_ERROR_INVAL;
+        goto err;
+    }
+    if (!(mc->filename = strdup(filename)))
+    {
+        SET_ERROR(modinst, "%s: Couldn't allocate memory for the filename!", DAQ_NAME);
+        rval = DAQ_ERROR_NOMEM;
+        goto err;
+    }
+    mc->file.filename = mc->filename;
+    mc->file.prefetch = mc->prefetch;
+
+    uint32_t pool_size = daq_base_api.config_get_msg_pool_size(modcfg);
+    rval = create_message_pool(mc, pool_size ? pool_size : MMAP_DEFAULT_POOL_SIZE);
+    if (rval != DAQ_SUCCESS)
+        goto err;
+
+    *ctxt_ptr = mc;
+
+    return DAQ_SUCCESS;
+
+err:
+    if (mc)
+    {
+        if (mc->filename)
+            free(mc->filename);
+        destroy_message_pool(mc);
+        free(mc);
+    }
+    return rval;
+}
+
+static int mmap_daq_stop(void* handle);
+
+static void mmap_daq_destroy(void* handle)
+{
+    MmapContext* mc = (MmapContext*) handle;
+
+    mmap_daq_stop(mc);
+    if (mc->filename)
+        free(mc->filename);
+    destroy_message_pool(mc);
+    free(mc);
+}
+
+static int mmap_daq_start(void* handle)
+{
+    MmapContext* mc = (MmapContext*) handle;
+
+    if (mc->shard)
+    {
+        if (!(mc->group = join_shard_group(mc)))
+            return DAQ_ERROR;
+
+        mc->ring = &mc->group->rings[mc->instance_id - 1];
+        mc->dlt = mc->group->file.dlt;
+    }
+    else
+    {
+        if (file_setup(&mc->file, mc->modinst))
+            return DAQ_ERROR;
+
+        mc->dlt = mc->file.dlt;
+    }
+
+    return DAQ_SUCCESS;
+}
+
+static int mmap_daq_interrupt(void* handle)
+{
+    MmapContext* mc = (MmapContext*) handle;
+    mc->interrupted = true;
+    return DAQ_SUCCESS;
+}
+
+static int mmap_daq_stop(void* handle)
+{
+    MmapContext* mc = (MmapContext*) handle;
+
+    if (mc->group)
+        leave_shard_group(mc);
+
+    else if (mc->file.base)
+    {
+        if (mc->throughput)
+            report_throughput(&mc->file);
+
+        file_cleanup(&mc->file);
+    }
+    return DAQ_SUCCESS;
+}
+
+static int mmap_daq_get_stats(void* handle, DAQ_Stats_t* stats)
+{
+    MmapContext* mc = (MmapContext*) handle;
+    memcpy(stats, &mc->stats, sizeof(DAQ_Stats_t));
+    return DAQ_SUCCESS;
+}
+
+static void mmap_daq_reset_stats(void* handle)
+{
+    MmapContext* mc = (MmapContext*) handle;
+    memset(&mc->stats, 0, sizeof(mc->stats));
+}
+
+static int mmap_daq_get_snaplen(void* handle)
+{
+    MmapContext* mc = (MmapContext*) handle;
+    return mc->snaplen;
+}
+
+static uint32_t mmap_daq_get_capabilities(void* handle)
+{
+    (void) handle;
+    return DAQ_CAPA_BLOCK | DAQ_CAPA_REPLACE | DAQ_CAPA_INTERRUPT | DAQ_CAPA_UNPRIV_START;
+}
+
+static int mmap_daq_get_datalink_type(void *handle)
+{
+    MmapContext* mc = (MmapContext*) handle;
+    return mc->dlt;
+}
+
+static unsigned mmap_daq_msg_receive(void* handle, const unsigned max_recv, const DAQ_Msg_t* msgs[], DAQ_RecvStatus* rstat)
+{
+    MmapContext* mc = (MmapContext*) handle;
+    DAQ_RecvStatus status = DAQ_RSTAT_OK;
+    unsigned idx = 0;
+
+    if (!mc->group && !mc->file.base)
+    {
+        *rstat = DAQ_RSTAT_EOF;
+        return 0;
+    }
+
+    if (!mc->group)
+        file_prefetch(&mc->file);
+
+    while (idx < max_recv)
+    {
+        /* Check to see if the receive has been canceled.  If so, reset it and return appropriately. */
+        if (mc->interrupted)
+        {
+            mc->interrupted = false;
+            status = DAQ_RSTAT_INTERRUPTED;
+            break;
+        }
+
+        /* Make sure that we have a message descriptor available to populate. */
+        MmapMsgDesc* desc = mc->pool.freelist;
+        if (!desc)
+        {
+            status = DAQ_RSTAT_NOBUF;
+            break;
+        }
+
+        /* Point the descriptor at the next packet in the mapping.  A shard
+           only waits for the reader when it has nothing to return yet. */
+        if (mc->group)
+        {
+            status = shard_read_message(mc, desc, idx == 0);
+
+            if (status == DAQ_RSTAT_TIMEOUT && idx)
+            {
+                status = DAQ_RSTAT_OK;
+                break;
+            }
+        }
+        else
+            status = read_message(mc, desc);
+
+        if (status != DAQ_RSTAT_OK)
+            break;
+
+        mc->stats.hw_packets_received++;
+        mc->stats.packets_received++;
+
+        /* Last, but not least, extract this descriptor from the free list and
+           place the message in the return vector. */
+        mc->pool.freelist = desc->next;
+        desc->next = NULL;
+        mc->pool.info.available--;
+        msgs[idx] = &desc->msg;
+
+        idx++;
+    }
+
+    *rstat = status;
+
+    return idx;
+}
+
+static int mmap_daq_msg_finalize(void* handle, const DAQ_Msg_t* msg, DAQ_Verdict verdict)
+{
+    MmapContext* mc = (MmapContext*) handle;
+    MmapMsgDesc* desc = (MmapMsgDesc *) msg->priv;
+
+    if (verdict >= MAX_DAQ_VERDICT)
+        verdict = DAQ_VERDICT_PASS;
+    mc->stats.verdicts[verdict]++;
+
+    /* Toss the descriptor back on the free list for reuse. */
+    desc->next = mc->pool.freelist;
+    mc->pool.freelist = desc;
+    mc->pool.info.available++;
+
+    return DAQ_SUCCESS;
+}
+
+static int mmap_daq_get_msg_pool_info(void* handle, DAQ_MsgPoolInfo_t* info)
+{
+    MmapContext* mc = (MmapContext*) handle;
+
+    *info = mc->pool.info;
+
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+
+#ifdef BUILDING_SO
+DAQ_SO_PUBLIC const DAQ_ModuleAPI_t DAQ_MODULE_DATA =
+#else
+const DAQ_ModuleAPI_t mmap_daq_module_data =
+#endif
+{
+    /* .api_version = */ DAQ_MODULE_API_VERSION,
+    /* .api_size = */ sizeof(DAQ_ModuleAPI_t),
+    /* .module_version = */ DAQ_MOD_VERSION,
+    /* .name = */ DAQ_NAME,
+    /* .type = */ DAQ_TYPE,
+    /* .load = */ mmap_daq_module_load,
+    /* .unload = */ NULL,
+    /* .get_variable_descs = */ mmap_daq_get_variable_descs,
+    /* .instantiate = */ mmap_daq_instantiate,
+    /* .destroy = */ mmap_daq_destroy,
+    /* .set_filter = */ NULL,
+    /* .start = */ mmap_daq_start,
+    /* .inject = */ NULL,
+    /* .inject_relative = */ NULL,
+    /* .interrupt = */ mmap_daq_interrupt,
+    /* .stop = */ mmap_daq_stop,
+    /* .ioctl = */ NULL,
+    /* .get_stats = */ mmap_daq_get_stats,
+    /* .reset_stats = */ mmap_daq_reset_stats,
+    /* .get_snaplen = */ mmap_daq_get_snaplen,
+    /* .get_capabilities = */ mmap_daq_get_capabilities,
+    /* .get_datalink_type = */ mmap_daq_get_datalink_type,
+    /* .config_load = */ NULL,
+    /* .config_swap = */ NULL,
+    /* .config_free = */ NULL,
+    /* .msg_receive = */ mmap_daq_msg_receive,
+    /* .msg_finalize = */ mmap_daq_msg_finalize,
+    /* .get_msg_pool_info = */ mmap_daq_get_msg_pool_info,
+};
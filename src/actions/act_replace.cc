@@ -67,7 +67,10 @@ static void Replace_ModifyPacket(Packet* p)
     }
 
     if ( modified )
+    {
         p->packet_flags |= PKT_MODIFIED;
+        p->clear_cksums_current();
+    }
 
     DetectionEngine::clear_replacement();
 }
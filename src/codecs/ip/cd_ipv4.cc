@@ -132,6 +132,9 @@ private:
 
 inline bool Ipv4Codec::valid_checksum_from_daq(const RawData& raw)
 {
+    if (!snort::get_network_policy()->checksum_offload)
+        return false;
+
     const DAQ_PktDecodeData_t* pdd =
         (const DAQ_PktDecodeData_t*) daq_msg_get_meta(raw.daq_msg, DAQ_PKT_META_DECODE_DATA);
     if (!pdd || !pdd->flags.bits.l3_checksum || !pdd->flags.bits.ipv4 || !pdd->flags.bits.l3)
@@ -20,7 +20,15 @@
 #ifndef CODECS_CHECKSUM_H
 #define CODECS_CHECKSUM_H
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <protocols/protocol_ids.h>
 
@@ -64,6 +72,13 @@ inline uint16_t icmp_cksum(const uint16_t* buf, std::size_t len, const Pseudohea
 inline uint16_t icmp_cksum(const uint16_t* buf, std::size_t len);
 inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len);
 
+//  RFC 1624 incremental update of a checksum over a range of len bytes
+//  rewritten from old_data to new_data, without summing the rest of the
+//  data again.  The range must start at an even offset from the start of
+//  the checksummed data and must not include the checksum itself.
+inline uint16_t cksum_update(uint16_t cksum, const void* old_data, const void* new_data,
+    std::size_t len);
+
 /*
  *  NOTE: Since multiple dynamic libraries use checksums, the choice
  *          is to either include all of the checksum details in a header,
@@ -79,94 +94,123 @@ inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len);
  */
 namespace detail
 {
-inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
-{
-    const uint16_t* sp = buf;
+// The one's complement sum is independent of byte order and of the width
+// of the words added as long as the carries are folded back in, so wider
+// words are summed into a 64 bit accumulator and folded at the end.
+// Loads go through memcpy, the buffer may be at any alignment.
 
-    // if pointer is 16 bit aligned calculate checksum in tight loop...
-    // gcc 5.4 -O3 generates unaligned quadword instructions that crash; fixed in gcc 8.0.1
-    if ( !( reinterpret_cast<std::uintptr_t>(sp) & 0x01 ) )
+inline uint64_t sum_words(const uint8_t*& sp, std::size_t& len, uint64_t sum)
+{
+    while ( len >= 8 )
     {
-        while ( len > 1 )
-        {
-            cksum += *sp++;
-            len -= 2;
-        }
+        uint32_t w[2];
+        memcpy(w, sp, sizeof(w));
+        sum += w[0];
+        sum += w[1];
+        sp += 8;
+        len -= 8;
     }
-    else if ( len > 1 )
+    return sum;
+}
+
+#if defined(__AVX2__)
+// 16 bit words are widened to 32 bit lanes, a lane takes at most
+// 0x1FFFE per load so it can't overflow below 2^15 loads
+inline uint64_t sum_vectors(const uint8_t*& sp, std::size_t& len, uint64_t sum)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    while ( len >= 32 )
     {
-        std::size_t sn = ((len / 2) & 0xF);  // == len/2 % 16
-        std::size_t n = (((len / 2) + 15) / 16);   // ceiling of (len / 2) / 16
+        __m256i acc = zero;
+        std::size_t n = std::min(len / 32, (std::size_t)0x4000);
+        len -= n * 32;
 
-        switch (sn)
+        while ( n-- )
         {
-        case 0:
-            sn = 16;
-            cksum += sp[15];    // fallthrough
-        case 15:
-            cksum += sp[14];    // fallthrough
-        case 14:
-            cksum += sp[13];    // fallthrough
-        case 13:
-            cksum += sp[12];    // fallthrough
-        case 12:
-            cksum += sp[11];    // fallthrough
-        case 11:
-            cksum += sp[10];    // fallthrough
-        case 10:
-            cksum += sp[9];     // fallthrough
-        case 9:
-            cksum += sp[8];     // fallthrough
-        case 8:
-            cksum  += sp[7];    // fallthrough
-        case 7:
-            cksum += sp[6];     // fallthrough
-        case 6:
-            cksum += sp[5];     // fallthrough
-        case 5:
-            cksum += sp[4];     // fallthrough
-        case 4:
-            cksum += sp[3];     // fallthrough
-        case 3:
-            cksum += sp[2];     // fallthrough
-        case 2:
-            cksum += sp[1];     // fallthrough
-        case 1:
-            cksum += sp[0];
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sp));
+            acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+            acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+            sp += 32;
         }
-        sp += sn;
 
-        /* unroll loop using Duff's device. */
-        while (--n > 0)
+        uint32_t lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+
+        for ( auto l : lanes )
+            sum += l;
+    }
+    return sum;
+}
+#elif defined(__SSE2__)
+// same as above with 128 bit vectors
+inline uint64_t sum_vectors(const uint8_t*& sp, std::size_t& len, uint64_t sum)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    while ( len >= 16 )
+    {
+        __m128i acc = zero;
+        std::size_t n = std::min(len / 16, (std::size_t)0x4000);
+        len -= n * 16;
+
+        while ( n-- )
         {
-            cksum += sp[0];
-            cksum += sp[1];
-            cksum += sp[2];
-            cksum += sp[3];
-            cksum += sp[4];
-            cksum += sp[5];
-            cksum += sp[6];
-            cksum += sp[7];
-            cksum += sp[8];
-            cksum += sp[9];
-            cksum += sp[10];
-            cksum += sp[11];
-            cksum += sp[12];
-            cksum += sp[13];
-            cksum += sp[14];
-            cksum += sp[15];
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp));
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
             sp += 16;
         }
+
+        uint32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+
+        for ( auto l : lanes )
+            sum += l;
+    }
+    return sum;
+}
+#else
+inline uint64_t sum_vectors(const uint8_t*& sp, std::size_t& len, uint64_t sum)
+{ return sum_words(sp, len, sum); }
+#endif
+
+inline uint16_t fold(uint64_t sum)
+{
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    return (uint16_t)sum;
+}
+
+inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
+{
+    const uint8_t* sp = reinterpret_cast<const uint8_t*>(buf);
+    uint64_t sum = cksum;
+
+    sum = sum_vectors(sp, len, sum);
+    sum = sum_words(sp, len, sum);
+
+    while ( len > 1 )
+    {
+        uint16_t w;
+        memcpy(&w, sp, sizeof(w));
+        sum += w;
+        sp += 2;
+        len -= 2;
     }
 
     // if len is odd, sum in the last byte...
     if ( len & 0x01 )
-        cksum += *((const uint8_t*) sp);
-
-    cksum  = (cksum >> 16) + (cksum & 0x0000ffff);
-    cksum += (cksum >> 16);
+    {
+        uint16_t w = 0;
+        memcpy(&w, sp, 1);
+        sum += w;
+    }
 
-    return (uint16_t)(~cksum);
+    return (uint16_t)(~fold(sum));
 }
 
 inline void add_ipv4_pseudoheader(const Pseudoheader& ph4, uint32_t& cksum)
@@ -328,6 +372,38 @@ inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len)
 
 inline uint16_t cksum_add(const uint16_t* buf, std::size_t len)
 { return detail::cksum_add(buf, len, 0); }
+
+inline uint16_t cksum_update(uint16_t cksum, const void* old_data, const void* new_data,
+    std::size_t len)
+{
+    // HC' = ~(~HC + ~m + m')
+    const uint8_t* o = static_cast<const uint8_t*>(old_data);
+    const uint8_t* n = static_cast<const uint8_t*>(new_data);
+    uint64_t sum = (uint16_t)~cksum;
+
+    while ( len > 1 )
+    {
+        uint16_t ow, nw;
+        memcpy(&ow, o, sizeof(ow));
+        memcpy(&nw, n, sizeof(nw));
+        sum += (uint16_t)~ow;
+        sum += nw;
+        o += 2;
+        n += 2;
+        len -= 2;
+    }
+
+    if ( len )
+    {
+        uint16_t ow = 0, nw = 0;
+        memcpy(&ow, o, 1);
+        memcpy(&nw, n, 1);
+        sum += (uint16_t)~ow;
+        sum += nw;
+    }
+
+    return (uint16_t)~detail::fold(sum);
+}
 } // namespace checksum
 
 #endif  /* CODECS_CHECKSUM_H */
@@ -0,0 +1,134 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// checksum_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "../checksum.h"
+
+// one 16 bit word at a time as in RFC 1071
+static uint16_t reference_cksum(const uint8_t* buf, size_t len)
+{
+    uint32_t sum = 0;
+
+    for ( ; len > 1; buf += 2, len -= 2 )
+    {
+        uint16_t w;
+        memcpy(&w, buf, sizeof(w));
+        sum += w;
+    }
+
+    if ( len )
+        sum += *buf;
+
+    while ( sum >> 16 )
+        sum = (sum >> 16) + (sum & 0xffff);
+
+    return (uint16_t)~sum;
+}
+
+static void fill(uint8_t* buf, size_t len, unsigned seed)
+{
+    for ( size_t i = 0; i < len; ++i )
+    {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+TEST_CASE("checksum matches reference", "[checksum]")
+{
+    uint8_t buf[2048 + 3];
+    fill(buf, sizeof(buf), 1);
+
+    for ( size_t off = 0; off < 4; ++off )
+    {
+        for ( size_t len = 0; len <= 2048; ++len )
+        {
+            const uint8_t* data = buf + off;
+            CHECK(checksum::cksum_add((const uint16_t*)data, len) == reference_cksum(data, len));
+        }
+    }
+}
+
+TEST_CASE("checksum of all ones", "[checksum]")
+{
+    // exercises the carries of every lane
+    std::vector<uint8_t> buf(65535, 0xff);
+    CHECK(checksum::cksum_add((const uint16_t*)buf.data(), buf.size()) ==
+        reference_cksum(buf.data(), buf.size()));
+}
+
+TEST_CASE("incremental update matches recomputation", "[checksum]")
+{
+    uint8_t hdr[60];
+    fill(hdr, sizeof(hdr), 7);
+
+    const uint16_t cksum = checksum::cksum_add((const uint16_t*)hdr, sizeof(hdr));
+
+    SECTION("one byte")
+    {
+        uint8_t old_hdr[sizeof(hdr)];
+        memcpy(old_hdr, hdr, sizeof(hdr));
+        hdr[9] ^= 0x5a;
+
+        uint16_t updated = checksum::cksum_update(cksum, old_hdr, hdr, sizeof(hdr));
+        CHECK(updated == checksum::cksum_add((const uint16_t*)hdr, sizeof(hdr)));
+    }
+
+    SECTION("range")
+    {
+        uint8_t old_opts[20];
+        memcpy(old_opts, hdr + 20, sizeof(old_opts));
+        memset(hdr + 20, 1, sizeof(old_opts));
+
+        uint16_t updated = checksum::cksum_update(cksum, old_opts, hdr + 20, sizeof(old_opts));
+        CHECK(updated == checksum::cksum_add((const uint16_t*)hdr, sizeof(hdr)));
+    }
+
+    SECTION("odd length")
+    {
+        uint8_t old_byte = hdr[58];
+        hdr[58] = 0;
+
+        uint16_t updated = checksum::cksum_update(cksum, &old_byte, hdr + 58, 1);
+        CHECK(updated == checksum::cksum_add((const uint16_t*)hdr, sizeof(hdr)));
+    }
+
+    SECTION("checksum field")
+    {
+        // a valid header sums to zero with its checksum in place
+        hdr[10] = hdr[11] = 0;
+        uint16_t c = checksum::cksum_add((const uint16_t*)hdr, sizeof(hdr));
+        memcpy(hdr + 10, &c, sizeof(c));
+        REQUIRE(checksum::cksum_add((const uint16_t*)hdr, sizeof(hdr)) == 0);
+
+        uint8_t old_ttl[2] = { hdr[8], hdr[9] };
+        hdr[8] = 1;
+
+        c = checksum::cksum_update(c, old_ttl, hdr + 8, sizeof(old_ttl));
+        memcpy(hdr + 10, &c, sizeof(c));
+        CHECK(checksum::cksum_add((const uint16_t*)hdr, sizeof(hdr)) == 0);
+    }
+}
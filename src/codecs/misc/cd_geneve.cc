@@ -22,6 +22,7 @@
 #endif
 
 #include "codecs/codec_module.h"
+#include "codecs/tunnel_cache.h"
 #include "framework/codec.h"
 #include "log/text_log.h"
 #include "main/snort_config.h"
@@ -43,6 +44,22 @@ using namespace snort;
 
 namespace
 {
+const PegInfo pegs[]
+{
+    { CountType::SUM, "cache_hits", "option headers found in the tunnel cache" },
+    { CountType::SUM, "cache_misses", "option headers validated and added to the tunnel cache" },
+    { CountType::END, nullptr, nullptr }
+};
+
+struct Stats
+{
+    PegCount cache_hits;
+    PegCount cache_misses;
+};
+
+static THREAD_LOCAL Stats stats;
+static THREAD_LOCAL TunnelCache* tunnel_cache = nullptr;
+
 static const RuleMap geneve_rules[] =
 {
     { DECODE_GENEVE_DGRAM_LT_GENEVE_HDR, "insufficient room for geneve header" },
@@ -60,6 +77,12 @@ public:
 
     const RuleMap* get_rules() const override
     { return geneve_rules; }
+
+    const PegInfo* get_pegs() const override
+    { return pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&stats; }
 };
 
 class GeneveCodec : public Codec
@@ -127,7 +150,7 @@ bool GeneveCodec::validate_options(const uint8_t* rptr, uint16_t hdrlen, CodecDa
     return true;
 }
 
-bool GeneveCodec::decode(const RawData& raw, CodecData& codec, DecodeData&)
+bool GeneveCodec::decode(const RawData& raw, CodecData& codec, DecodeData& dd)
 {
     if ( raw.len < sizeof(geneve::GeneveHdr) )
     {
@@ -136,31 +159,46 @@ bool GeneveCodec::decode(const RawData& raw, CodecData& codec, DecodeData&)
     }
 
     const geneve::GeneveHdr* const hdr = reinterpret_cast<const geneve::GeneveHdr*>(raw.data);
-
-    if (hdr->version() != RFC_8926_GENEVE_VERSION)
-    {
-        codec_event(codec, DECODE_GENEVE_INVALID_VERSION);
-        return false;
-    }
-
     const uint16_t opts_len = hdr->opts_len();
     const uint32_t hdrlen = hdr->hlen();
-    if (raw.len <  hdrlen)
-    {
-        codec_event(codec, DECODE_GENEVE_INVALID_HEADER);
-        return false;
-    }
 
-    /* If critical header present bit is set, opts_len cannot be 0 */
-    if (hdr->is_set(GENEVE_FLAG_C) && (opts_len == 0))
-    {
-        codec_event(codec, DECODE_GENEVE_INVALID_FLAGS);
-        return false;
-    }
+    /* All packets of a tunnel carry the same options, a header which is
+     * byte for byte one already validated needs no further checks */
+    const bool cache_hdr = (opts_len && tunnel_cache);
 
-    if (!validate_options(raw.data, hdrlen, codec))
+    if (cache_hdr && tunnel_cache->find(dd.ip_api, hdr->vni(), raw.data, raw.len))
+        stats.cache_hits++;
+    else
     {
-        return false;
+        if (hdr->version() != RFC_8926_GENEVE_VERSION)
+        {
+            codec_event(codec, DECODE_GENEVE_INVALID_VERSION);
+            return false;
+        }
+
+        if (raw.len <  hdrlen)
+        {
+            codec_event(codec, DECODE_GENEVE_INVALID_HEADER);
+            return false;
+        }
+
+        /* If critical header present bit is set, opts_len cannot be 0 */
+        if (hdr->is_set(GENEVE_FLAG_C) && (opts_len == 0))
+        {
+            codec_event(codec, DECODE_GENEVE_INVALID_FLAGS);
+            return false;
+        }
+
+        if (!validate_options(raw.data, hdrlen, codec))
+        {
+            return false;
+        }
+
+        if (cache_hdr)
+        {
+            stats.cache_misses++;
+            tunnel_cache->add(dd.ip_api, hdr->vni(), raw.data, hdrlen);
+        }
     }
 
     if ( codec.conf->tunnel_bypass_enabled(TUNNEL_GENEVE) )
@@ -243,6 +281,17 @@ static Module* mod_ctor()
 static void mod_dtor(Module* m)
 { delete m; }
 
+static void geneve_codec_tinit()
+{
+    tunnel_cache = new TunnelCache;
+}
+
+static void geneve_codec_tterm()
+{
+    delete tunnel_cache;
+    tunnel_cache = nullptr;
+}
+
 static Codec* ctor(Module*)
 { return new GeneveCodec(); }
 
@@ -265,8 +314,8 @@ static const CodecApi geneve_api =
     },
     nullptr, // pinit
     nullptr, // pterm
-    nullptr, // tinit
-    nullptr, // tterm
+    geneve_codec_tinit, // tinit
+    geneve_codec_tterm, // tterm
     ctor, // ctor
     dtor, // dtor
 };
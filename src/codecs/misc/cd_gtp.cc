@@ -23,6 +23,7 @@
 #endif
 
 #include "codecs/codec_module.h"
+#include "codecs/tunnel_cache.h"
 #include "framework/codec.h"
 #include "main/snort_config.h"
 
@@ -33,6 +34,22 @@ using namespace snort;
 
 namespace
 {
+const PegInfo pegs[]
+{
+    { CountType::SUM, "cache_hits", "extension headers found in the tunnel cache" },
+    { CountType::SUM, "cache_misses", "extension headers validated and added to the tunnel cache" },
+    { CountType::END, nullptr, nullptr }
+};
+
+struct Stats
+{
+    PegCount cache_hits;
+    PegCount cache_misses;
+};
+
+static THREAD_LOCAL Stats stats;
+static THREAD_LOCAL TunnelCache* tunnel_cache = nullptr;
+
 static const RuleMap gtp_rules[] =
 {
     { DECODE_GTP_MULTIPLE_ENCAPSULATION, "two or more GTP encapsulation layers present" },
@@ -47,6 +64,12 @@ public:
 
     const RuleMap* get_rules() const override
     { return gtp_rules; }
+
+    const PegInfo* get_pegs() const override
+    { return pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&stats; }
 };
 
 //-------------------------------------------------------------------------
@@ -132,6 +155,26 @@ bool GtpCodec::decode(const RawData& raw, CodecData& codec, DecodeData& dd)
             }
             uint8_t next_hdr_type = *(raw.data + len - 1);
 
+            /* The extension headers, from the next type of the fixed header
+             * on, are the same for all packets of a tunnel */
+            const uint8_t* ext = raw.data + GTP_V1_HEADER_LEN - 1;
+            uint32_t teid = 0;
+            memcpy(&teid, raw.data + GTP_MIN_LEN - sizeof(teid), sizeof(teid));
+
+            if (next_hdr_type && tunnel_cache)
+            {
+                if (uint16_t ext_len = tunnel_cache->find(dd.ip_api, teid, ext, raw.len - (len - 1)))
+                {
+                    stats.cache_hits++;
+                    len += ext_len - 1;
+                    next_hdr_type = 0;
+                }
+                else
+                    stats.cache_misses++;
+            }
+
+            const bool cache_ext = (next_hdr_type && tunnel_cache);
+
             /*Check extension headers*/
             while (next_hdr_type)
             {
@@ -159,6 +202,9 @@ bool GtpCodec::decode(const RawData& raw, CodecData& codec, DecodeData& dd)
                 }
                 next_hdr_type = *(raw.data + len - 1);
             }
+
+            if (cache_ext)
+                tunnel_cache->add(dd.ip_api, teid, ext, len - GTP_V1_HEADER_LEN + 1);
         }
         else
             len = GTP_MIN_LEN;
@@ -251,6 +297,17 @@ static Module* mod_ctor()
 static void mod_dtor(Module* m)
 { delete m; }
 
+static void gtp_codec_tinit()
+{
+    tunnel_cache = new TunnelCache;
+}
+
+static void gtp_codec_tterm()
+{
+    delete tunnel_cache;
+    tunnel_cache = nullptr;
+}
+
 static Codec* ctor(Module*)
 { return new GtpCodec(); }
 
@@ -273,8 +330,8 @@ static const CodecApi gtp_api =
     },
     nullptr, // pinit
     nullptr, // pterm
-    nullptr, // tinit
-    nullptr, // tterm
+    gtp_codec_tinit, // tinit
+    gtp_codec_tterm, // tterm
     ctor, // ctor
     dtor, // dtor
 };
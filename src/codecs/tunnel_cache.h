@@ -0,0 +1,102 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// tunnel_cache.h author Cisco
+
+#ifndef CODECS_TUNNEL_CACHE_H
+#define CODECS_TUNNEL_CACHE_H
+
+// Per thread cache of tunnel headers already validated by a codec.  All
+// packets of a tunnel carry the same variable length part of the tunnel
+// header (extension headers, options), so it is looked up by the outer
+// endpoints and the tunnel id and its validation is skipped when the bytes
+// are the same as when it was validated.  A miss just falls back to the
+// full validation; only headers which passed it are added.
+//
+// Header only since the tunnel codecs may be built as dynamic plugins.
+
+#include <cstdint>
+#include <cstring>
+
+#include "protocols/ip.h"
+
+namespace snort
+{
+class TunnelCache
+{
+public:
+    static constexpr unsigned max_entries = 256;
+    static constexpr unsigned max_hdr_len = 64;
+
+    // length of the validated header at hdr, 0 if not cached
+    uint16_t find(const ip::IpApi& ip_api, uint32_t id, const uint8_t* hdr, uint32_t avail) const
+    {
+        if ( !ip_api.is_ip() )
+            return 0;
+
+        const Entry& e = entries[index(ip_api, id)];
+
+        if ( !e.len or e.len > avail or e.id != id or
+            memcmp(e.src, ip_api.get_src()->get_ip6_ptr(), sizeof(e.src)) or
+            memcmp(e.dst, ip_api.get_dst()->get_ip6_ptr(), sizeof(e.dst)) or
+            memcmp(e.hdr, hdr, e.len) )
+            return 0;
+
+        return e.len;
+    }
+
+    // replaces whatever was cached for another tunnel in the same slot
+    void add(const ip::IpApi& ip_api, uint32_t id, const uint8_t* hdr, uint16_t len)
+    {
+        if ( !ip_api.is_ip() or !len or len > max_hdr_len )
+            return;
+
+        Entry& e = entries[index(ip_api, id)];
+        memcpy(e.src, ip_api.get_src()->get_ip6_ptr(), sizeof(e.src));
+        memcpy(e.dst, ip_api.get_dst()->get_ip6_ptr(), sizeof(e.dst));
+        memcpy(e.hdr, hdr, len);
+        e.id = id;
+        e.len = len;
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t src[4];
+        uint32_t dst[4];
+        uint32_t id = 0;
+        uint16_t len = 0;
+        uint8_t hdr[max_hdr_len];
+    };
+
+    static unsigned index(const ip::IpApi& ip_api, uint32_t id)
+    {
+        const uint32_t* s = ip_api.get_src()->get_ip6_ptr();
+        const uint32_t* d = ip_api.get_dst()->get_ip6_ptr();
+        uint32_t h = id;
+
+        for ( unsigned i = 0; i < 4; ++i )
+            h = (h ^ s[i] ^ (d[i] << 1)) * 0x9e3779b1;
+
+        return (h >> 24) % max_entries;
+    }
+
+    Entry entries[max_entries];
+};
+}
+
+#endif
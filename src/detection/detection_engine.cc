@@ -29,6 +29,7 @@
 #include "framework/endianness.h"
 #include "helpers/ring.h"
 #include "latency/packet_latency.h"
+#include "latency/phase_latency.h"
 #include "main/analyzer.h"
 #include "main/snort_config.h"
 #include "main/thread.h"
@@ -234,7 +235,10 @@ void DetectionEngine::finish_inspect_with_latency(Packet* p)
 
 void DetectionEngine::finish_inspect(Packet* p, bool inspected)
 {
-    log_events(p);
+    {
+        PhaseLatency::Context log_latency_ctx { PhaseLatency::LOG };
+        log_events(p);
+    }
 
     if ( PacketTracer::is_daq_activated() )
         populate_trace_data();
@@ -633,6 +637,7 @@ bool DetectionEngine::inspect(Packet* p)
     bool inspected = false;
     {
         PacketLatency::Context pkt_latency_ctx { p };
+        PhaseLatency::Context phase_latency_ctx { PhaseLatency::PACKET };
 
         if ( p->ptrs.decode_flags & DECODE_ERR_FLAGS )
         {
@@ -647,7 +652,10 @@ bool DetectionEngine::inspect(Packet* p)
         {
             enable_content(p);
 
-            InspectorManager::execute(p);
+            {
+                PhaseLatency::Context inspect_latency_ctx { PhaseLatency::INSPECT };
+                InspectorManager::execute(p);
+            }
             inspected = true;
 
             if ( !all_disabled(p) )
@@ -655,6 +663,8 @@ bool DetectionEngine::inspect(Packet* p)
                 if ( PacketTracer::is_daq_activated() )
                     PacketTracer::pt_timer_start();
 
+                PhaseLatency::Context detect_latency_ctx { PhaseLatency::DETECT };
+
                 if ( detect(p, true) )
                     return false; // don't finish out offloaded packets
             }
@@ -683,8 +693,7 @@ int DetectionEngine::queue_event(const OptTreeNode* otn)
         return 0;
     }
 
-    SF_EVENTQ* pq = get_event_queue();
-    EventNode* en = (EventNode*)sfeventq_event_alloc(pq);
+    EventNode* en = sfeventq_add(get_event_queue());
 
     if ( !en )
         return -1;
@@ -692,9 +701,6 @@ int DetectionEngine::queue_event(const OptTreeNode* otn)
     en->otn = otn;
     en->rtn = rtn;
 
-    if ( sfeventq_add(pq, en) )
-        return -1;
-
     return 0;
 }
 
@@ -705,8 +711,7 @@ int DetectionEngine::queue_event(unsigned gid, unsigned sid)
     if ( !otn )
         return 0;
 
-    SF_EVENTQ* pq = get_event_queue();
-    EventNode* en = (EventNode*)sfeventq_event_alloc(pq);
+    EventNode* en = sfeventq_add(get_event_queue());
 
     if ( !en )
         return -1;
@@ -714,19 +719,14 @@ int DetectionEngine::queue_event(unsigned gid, unsigned sid)
     en->otn = otn;
     en->rtn = nullptr;  // lookup later after ips policy selection
 
-    if ( sfeventq_add(pq, en) )
-        return -1;
-
     return 0;
 }
 
-static int log_events(void* event, void* user)
+static int log_events(EventNode* en, void* user)
 {
-    if ( !event || !user )
+    if ( !en || !user )
         return 0;
 
-    EventNode* en = (EventNode*)event;
-
     if ( !en->rtn )
     {
         en->rtn = getRtnFromOtn(en->otn);
@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// event_select.h author Cisco
+
+#ifndef EVENT_SELECT_H
+#define EVENT_SELECT_H
+
+// Returns the matches of an action group in logging order without sorting
+// all of them.  The matches are made into a heap, which takes linear time,
+// and each next() pops the first remaining match, so taking the first k of
+// n matches costs O(n + k log n) instead of O(n log n).  Only up to
+// max_queue events are taken from a packet, usually far fewer than match.
+//
+// The order is total (ties are broken by sid) so the events taken are the
+// same as with a full sort.
+
+#include <algorithm>
+
+#include "detection/treenodes.h"
+#include "events/event_queue.h"
+
+class EventSelector
+{
+public:
+    EventSelector(const OptTreeNode** m, unsigned n, int order) :
+        matches(m), count(n), end(n),
+        after(order == SNORT_EVENTQ_PRIORITY ? after_by_priority : after_by_length)
+    { std::make_heap(matches, matches + count, after); }
+
+    // null when all have been taken
+    const OptTreeNode* next()
+    {
+        if ( !end )
+            return nullptr;
+
+        std::pop_heap(matches, matches + end, after);
+        return matches[--end];
+    }
+
+    unsigned remaining() const
+    { return end; }
+
+    // true if otn was taken before the last one
+    bool taken(const OptTreeNode* otn) const
+    { return std::find(matches + end + 1, matches + count, otn) != matches + count; }
+
+    // true if a is logged after b
+    static bool after_by_priority(const OptTreeNode* a, const OptTreeNode* b)
+    {
+        if ( a->sigInfo.priority != b->sigInfo.priority )
+            return a->sigInfo.priority > b->sigInfo.priority;
+
+        return a->sigInfo.sid > b->sigInfo.sid;
+    }
+
+    // FIXIT-L pattern length is not a valid event sort criterion for
+    // non-literals
+    static bool after_by_length(const OptTreeNode* a, const OptTreeNode* b)
+    {
+        if ( a->longestPatternLen != b->longestPatternLen )
+            return a->longestPatternLen < b->longestPatternLen;
+
+        return a->sigInfo.sid < b->sigInfo.sid;
+    }
+
+private:
+    const OptTreeNode** matches;
+    const unsigned count;
+    unsigned end;
+    bool (* after)(const OptTreeNode*, const OptTreeNode*);
+};
+
+#endif
@@ -74,6 +74,7 @@
 #include "detection_module.h"
 #include "detection_options.h"
 #include "detection_util.h"
+#include "event_select.h"
 #include "fp_config.h"
 #include "fp_create.h"
 #include "fp_utils.h"
@@ -452,62 +453,6 @@ static void rule_tree_match(
     }
 }
 
-static int sortOrderByPriority(const void* e1, const void* e2)
-{
-    const OptTreeNode* otn1;
-    const OptTreeNode* otn2;
-
-    if (!e1 || !e2)
-        return 0;
-
-    otn1 = *(OptTreeNode* const*)e1;
-    otn2 = *(OptTreeNode* const*)e2;
-
-    if ( otn1->sigInfo.priority < otn2->sigInfo.priority )
-        return -1;
-
-    if ( otn1->sigInfo.priority > otn2->sigInfo.priority )
-        return +1;
-
-    /* This improves stability of repeated tests */
-    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
-        return -1;
-
-    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
-        return +1;
-
-    return 0;
-}
-
-// FIXIT-L pattern length is not a valid event sort criterion for
-// non-literals
-static int sortOrderByContentLength(const void* e1, const void* e2)
-{
-    const OptTreeNode* otn1;
-    const OptTreeNode* otn2;
-
-    if (!e1 || !e2)
-        return 0;
-
-    otn1 = *(OptTreeNode* const*)e1;
-    otn2 = *(OptTreeNode* const*)e2;
-
-    if (otn1->longestPatternLen < otn2->longestPatternLen)
-        return +1;
-
-    if (otn1->longestPatternLen > otn2->longestPatternLen)
-        return -1;
-
-    /* This improves stability of repeated tests */
-    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
-        return +1;
-
-    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
-        return -1;
-
-    return 0;
-}
-
 /*
 **  DESCRIPTION
 **    This function flags an alert per session.
@@ -626,9 +571,6 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
     unsigned tcnt = 0;
     int res = 0;
     EventQueueConfig* eq = p->context->conf->event_queue_config;
-    int (*compar)(const void *, const void *);
-    compar = ( eq->order == SNORT_EVENTQ_PRIORITY )
-        ? &sortOrderByPriority : sortOrderByContentLength;
 
     for ( unsigned i = 0; i < p->context->conf->num_rule_types; i++ )
     {
@@ -650,19 +592,16 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
              * built in drop/block/reset comes before alert/pass/log as
              * part of the natural ordering....Jan '06..
              */
-            /* Sort the rules in this action group */
-            qsort(omd->matchInfo[i].MatchArray, omd->matchInfo[i].iMatchCount,
-                sizeof(void*), compar);
+            /* Only the rules taken from this action group are ordered */
+            EventSelector sel(omd->matchInfo[i].MatchArray, omd->matchInfo[i].iMatchCount,
+                eq->order);
 
             /* Process each event in the action (alert,drop,log,...) groups */
-            for ( unsigned j = 0; j < omd->matchInfo[i].iMatchCount; j++ )
+            while ( const OptTreeNode* otn = sel.next() )
             {
-                const OptTreeNode* otn = omd->matchInfo[i].MatchArray[j];
-                assert(otn);
-
                 if ( tcnt >= eq->max_events )
                 {
-                    pc.queue_limit += omd->matchInfo[i].iMatchCount - j;
+                    pc.queue_limit += sel.remaining() + 1;
                     res = 1;
                     break;
                 }
@@ -679,17 +618,8 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
                         return 1;
                 }
 
-                //  Loop here so we don't log the same event multiple times.
-                for (unsigned k = 0; k < j; k++)
-                {
-                    if ( omd->matchInfo[i].MatchArray[k] == otn )
-                    {
-                        otn = nullptr;
-                        break;
-                    }
-                }
-
-                if ( !otn )
+                //  Check here so we don't log the same event multiple times.
+                if ( sel.taken(otn) )
                     continue;
 
                 if ( !fpSessionAlerted(p, otn) )
@@ -1385,9 +1315,9 @@ static inline int fp_do_actions(OtnxMatchData* omd, Packet* p)
     {
         if (omd->matchInfo[i].iMatchCount)
         {
-            qsort(omd->matchInfo[i].MatchArray, omd->matchInfo[i].iMatchCount,
-                sizeof(void*), sortOrderByContentLength);
-            const OptTreeNode* otn = omd->matchInfo[i].MatchArray[0];
+            EventSelector sel(omd->matchInfo[i].MatchArray, omd->matchInfo[i].iMatchCount,
+                SNORT_EVENTQ_CONTENT_LEN);
+            const OptTreeNode* otn = sel.next();
             RuleTreeNode* rtn = getRtnFromOtn(otn);
             IpsAction* act = get_ips_policy()->action[rtn->action];
             act->exec(p, otn);
@@ -60,7 +60,7 @@ IpsContext::IpsContext(unsigned size) :
 
     conf = SnortConfig::get_conf();
     const EventQueueConfig* qc = conf->event_queue_config;
-    equeue = sfeventq_new(qc->max_events, qc->log_events, sizeof(EventNode));
+    equeue = sfeventq_new(qc->max_events, qc->log_events);
 
     packet->context = this;
     fp_set_context(*this);
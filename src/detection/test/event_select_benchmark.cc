@@ -0,0 +1,137 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// event_select_benchmark.cc author Cisco
+// selection of the events logged from the matches of one action group, a
+// full sort of all matches against taking the first max_queue from a heap.
+// Rule sets with many overlapping content rules produce tens of matches per
+// packet while only max_queue (8 by default) are logged.
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "detection/event_select.h"
+
+#define MAX_QUEUE 8
+
+OptTreeNode::~OptTreeNode() = default;
+
+static int sort_by_priority(const void* e1, const void* e2)
+{
+    const OptTreeNode* a = *(const OptTreeNode* const*)e1;
+    const OptTreeNode* b = *(const OptTreeNode* const*)e2;
+
+    if ( EventSelector::after_by_priority(a, b) )
+        return +1;
+
+    if ( EventSelector::after_by_priority(b, a) )
+        return -1;
+
+    return 0;
+}
+
+static std::vector<OptTreeNode> make_rules(unsigned n)
+{
+    std::vector<OptTreeNode> rules(n);
+    unsigned seed = 1;
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        seed = seed * 1103515245 + 12345;
+        rules[i].sigInfo.sid = 1000 + i;
+        rules[i].sigInfo.priority = 1 + (seed >> 16) % 4;
+        rules[i].longestPatternLen = (seed >> 8) % 32;
+    }
+    return rules;
+}
+
+static unsigned sort_all(const OptTreeNode** m, unsigned n, const OptTreeNode** out)
+{
+    qsort(m, n, sizeof(void*), sort_by_priority);
+
+    unsigned k = n < MAX_QUEUE ? n : MAX_QUEUE;
+
+    for ( unsigned i = 0; i < k; ++i )
+        out[i] = m[i];
+
+    return k;
+}
+
+static unsigned select_top(const OptTreeNode** m, unsigned n, const OptTreeNode** out)
+{
+    EventSelector sel(m, n, SNORT_EVENTQ_PRIORITY);
+    unsigned k = 0;
+
+    while ( k < MAX_QUEUE )
+    {
+        const OptTreeNode* otn = sel.next();
+
+        if ( !otn )
+            break;
+
+        out[k++] = otn;
+    }
+    return k;
+}
+
+TEST_CASE("event selection", "[event_select]")
+{
+    for ( unsigned n : { 10, 50, 100 } )
+    {
+        std::vector<OptTreeNode> rules = make_rules(n);
+        std::vector<const OptTreeNode*> matches;
+
+        for ( const auto& r : rules )
+            matches.emplace_back(&r);
+
+        std::vector<const OptTreeNode*> work(matches);
+        const OptTreeNode* sorted[MAX_QUEUE];
+        const OptTreeNode* selected[MAX_QUEUE];
+
+        unsigned ns = sort_all(work.data(), n, sorted);
+        work = matches;
+        unsigned nt = select_top(work.data(), n, selected);
+
+        REQUIRE(ns == nt);
+
+        for ( unsigned i = 0; i < ns; ++i )
+            CHECK(sorted[i] == selected[i]);
+
+        BENCHMARK("sort all, " + std::to_string(n) + " matches")
+        {
+            work = matches;
+            return sort_all(work.data(), n, sorted);
+        };
+
+        BENCHMARK("heap top " + std::to_string(MAX_QUEUE) + ", " + std::to_string(n) + " matches")
+        {
+            work = matches;
+            return select_top(work.data(), n, selected);
+        };
+    }
+}
+
+#endif
@@ -20,56 +20,41 @@
 #ifndef SFEVENTQ_H
 #define SFEVENTQ_H
 
-struct SF_EVENTQ_NODE
-{
-    void* event;
+// The event queue of a context is a fixed array of events, sized once from
+// the event_queue configuration when the context is created.  Events are
+// queued in the order they are to be logged, which fpFinalSelectEvent()
+// takes care of, so adding an event is just filling in the next slot.
 
-    SF_EVENTQ_NODE* prev;
-    SF_EVENTQ_NODE* next;
-};
+#include "events/event_queue.h"
 
 struct SF_EVENTQ
 {
-    /*
-    **  Handles the actual ordering and memory
-    **  of the event queue and it's nodes.
-    */
-    SF_EVENTQ_NODE* head;
-    SF_EVENTQ_NODE* last;
-
-    SF_EVENTQ_NODE* node_mem;
-    char* event_mem;
+    EventNode* events;
 
-    /*
-    **  The reserve event allows us to allocate one extra node
-    **  and compare against the last event in the queue to determine
-    **  if the incoming event is a higher priority than the last
-    **  event in the queue.
-    */
-    char* reserve_event;
+    unsigned max_events;
+    unsigned log_events;
 
-    /*
-    **  Queue configuration
-    */
-    int max_nodes;
-    int log_nodes;
-    int event_size;
-
-    /*
-    **  This element tracks the current number of
-    **  nodes in the event queue.
-    */
-    int cur_nodes;
-    int cur_events;
+    unsigned count;
     unsigned fails;
 };
 
-SF_EVENTQ* sfeventq_new(int max_nodes, int log_nodes, int event_size);
-void* sfeventq_event_alloc(SF_EVENTQ*);
-unsigned sfeventq_reset(SF_EVENTQ*);  // returns fail count since last reset
-int sfeventq_add(SF_EVENTQ*, void* event);
-int sfeventq_action(SF_EVENTQ*, int (* action_func)(void* event, void* user), void* user);
+SF_EVENTQ* sfeventq_new(unsigned max_events, unsigned log_events);
+unsigned sfeventq_reset(SF_EVENTQ*);  // returns 1 if an event did not fit since last reset
+int sfeventq_action(SF_EVENTQ*, int (* action_func)(EventNode*, void* user), void* user);
 void sfeventq_free(SF_EVENTQ*);
 
+// returns the event to fill in or null if the queue is full
+inline EventNode* sfeventq_add(SF_EVENTQ* eq)
+{
+    if ( eq->count >= eq->max_events )
+    {
+        // like the reserve event this replaced, only the first overflow
+        // of a packet is counted
+        eq->fails = 1;
+        return nullptr;
+    }
+    return eq->events + eq->count++;
+}
+
 #endif
 
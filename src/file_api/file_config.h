@@ -38,6 +38,7 @@
 #define DEFAULT_FILE_CAPTURE_BLOCK_SIZE     32768       // 32 KiB
 #define DEFAULT_MAX_FILES_CACHED            65536
 #define DEFAULT_MAX_FILES_PER_FLOW          128
+#define DEFAULT_FILE_SIGNATURE_MEM          16          // 16 MiB
 
 #define FILE_ID_NAME "file_id"
 #define FILE_ID_HELP "configure file identification"
@@ -64,6 +65,8 @@ public:
     int64_t file_depth =  0;
     int64_t max_files_cached = DEFAULT_MAX_FILES_CACHED;
     uint64_t max_files_per_flow = DEFAULT_MAX_FILES_PER_FLOW;
+    uint32_t signature_threads = 0;
+    int64_t signature_memcap = DEFAULT_FILE_SIGNATURE_MEM;
 
     int64_t show_data_depth = DEFAULT_FILE_SHOW_DATA_DEPTH;
     bool trace_type = false;
@@ -565,7 +565,12 @@ static void file_config_show(const FileConfig* fc)
         ConfigLogger::log_value("type_depth", fc->file_type_depth);
 
     if ( ConfigLogger::log_flag("enable_signature", FileService::is_file_signature_enabled()) )
+    {
         ConfigLogger::log_value("signature_depth", fc->file_signature_depth);
+        ConfigLogger::log_value("signature_threads", fc->signature_threads);
+        if ( fc->signature_threads )
+            ConfigLogger::log_value("signature_memcap", fc->signature_memcap);
+    }
 
     if ( ConfigLogger::log_flag("block_timeout_lookup", fc->block_timeout_lookup) )
         ConfigLogger::log_value("block_timeout", fc->file_block_timeout);
@@ -0,0 +1,262 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// file_hash_pool.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "file_hash_pool.h"
+
+#include <cassert>
+
+#include "hash/sha256_mb.h"
+
+#ifdef UNIT_TEST
+#include <cstring>
+
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+std::vector<std::thread*> FileHashPool::workers;
+std::mutex FileHashPool::pool_mutex;
+std::condition_variable FileHashPool::pool_cv;
+std::queue<FileHashJob*> FileHashPool::jobs_ready;
+std::atomic<int64_t> FileHashPool::bytes_queued { 0 };
+int64_t FileHashPool::max_bytes_queued = 0;
+bool FileHashPool::running = true;
+
+//--------------------------------------------------------------------------
+// job
+//--------------------------------------------------------------------------
+
+bool FileHashJob::update(const uint8_t* data, size_t size)
+{
+    if (!FileHashPool::reserve(size))
+        return false;
+
+    std::lock_guard<std::mutex> lk(job_mutex);
+    chunks.emplace(data, data + size);
+
+    if (!scheduled)
+    {
+        scheduled = true;
+        FileHashPool::schedule(this);
+    }
+
+    return true;
+}
+
+void FileHashJob::wait()
+{
+    std::unique_lock<std::mutex> lk(job_mutex);
+    job_cv.wait(lk, [this] { return !scheduled; });
+}
+
+// Called by a worker, only one worker runs a job at a time.
+// Each round hashes the next chunk of every job in the batch.
+void FileHashJob::run(FileHashJob** jobs, unsigned count)
+{
+    std::vector<uint8_t> chunks[SHA256_MB_MAX_LANES];
+    SHA256_CTX* ctx[SHA256_MB_MAX_LANES];
+    const uint8_t* data[SHA256_MB_MAX_LANES];
+    size_t size[SHA256_MB_MAX_LANES];
+    size_t bytes = 0;
+
+    assert(count <= SHA256_MB_MAX_LANES);
+
+    while (count)
+    {
+        for (unsigned i = 0; i < count; )
+        {
+            FileHashJob* job = jobs[i];
+            std::lock_guard<std::mutex> lk(job->job_mutex);
+
+            if (job->chunks.empty())
+            {
+                // the owner may release the job as soon as the lock is dropped
+                job->scheduled = false;
+                job->job_cv.notify_all();
+                jobs[i] = jobs[--count];
+                continue;
+            }
+
+            chunks[i] = std::move(job->chunks.front());
+            job->chunks.pop();
+
+            ctx[i] = job->context;
+            data[i] = chunks[i].data();
+            size[i] = chunks[i].size();
+            bytes += size[i];
+            ++i;
+        }
+
+        sha256_mb_update(ctx, data, size, count);
+        FileHashPool::release(bytes);
+        bytes = 0;
+    }
+}
+
+//--------------------------------------------------------------------------
+// pool
+//--------------------------------------------------------------------------
+
+void FileHashPool::worker_thread()
+{
+    const unsigned batch_size = sha256_mb_lanes();
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lk(pool_mutex);
+        pool_cv.wait(lk, [] { return !running or !jobs_ready.empty(); });
+
+        // When !running we hash out any remaining data before exiting
+        if (jobs_ready.empty())
+            break;
+
+        FileHashJob* batch[SHA256_MB_MAX_LANES];
+        unsigned count = 0;
+
+        while (count < batch_size and !jobs_ready.empty())
+        {
+            batch[count++] = jobs_ready.front();
+            jobs_ready.pop();
+        }
+
+        lk.unlock();
+
+        FileHashJob::run(batch, count);
+    }
+}
+
+void FileHashPool::init(unsigned threads, int64_t memcap)
+{
+    assert(workers.empty());
+    max_bytes_queued = memcap;
+    running = true;
+
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back(new std::thread(worker_thread));
+}
+
+void FileHashPool::exit()
+{
+    {
+        std::lock_guard<std::mutex> lk(pool_mutex);
+        running = false;
+    }
+    pool_cv.notify_all();
+
+    for (auto worker : workers)
+    {
+        worker->join();
+        delete worker;
+    }
+
+    workers.clear();
+}
+
+bool FileHashPool::reserve(size_t size)
+{
+    int64_t queued = bytes_queued.load(std::memory_order_relaxed);
+
+    do
+    {
+        if (queued + (int64_t)size > max_bytes_queued)
+            return false;
+    }
+    while (!bytes_queued.compare_exchange_weak(queued, queued + size,
+        std::memory_order_relaxed));
+
+    return true;
+}
+
+void FileHashPool::release(size_t size)
+{
+    bytes_queued.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void FileHashPool::schedule(FileHashJob* job)
+{
+    {
+        std::lock_guard<std::mutex> lk(pool_mutex);
+        jobs_ready.push(job);
+    }
+    pool_cv.notify_one();
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+TEST_CASE("signature hashed by workers matches inline signature", "[file_hash_pool]")
+{
+    uint8_t data[4096];
+
+    for (unsigned i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)(i * 7);
+
+    uint8_t expected[SHA256_DIGEST_LENGTH];
+    SHA256(data, sizeof(data), expected);
+
+    FileHashPool::init(2, sizeof(data));
+
+    SECTION("all data queued")
+    {
+        SHA256_CTX ctx;
+        SHA256_Init(&ctx);
+        FileHashJob job(&ctx);
+
+        for (unsigned i = 0; i < sizeof(data); i += 512)
+            CHECK(job.update(data + i, 512));
+
+        job.wait();
+
+        uint8_t digest[SHA256_DIGEST_LENGTH];
+        SHA256_Final(digest, &ctx);
+        CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+    }
+
+    SECTION("memcap exceeded")
+    {
+        SHA256_CTX ctx;
+        SHA256_Init(&ctx);
+        FileHashJob job(&ctx);
+
+        CHECK(job.update(data, sizeof(data) - 1));
+
+        if (!job.update(data + sizeof(data) - 1, 1))
+        {
+            job.wait();
+            SHA256_Update(&ctx, data + sizeof(data) - 1, 1);
+        }
+
+        job.wait();
+
+        uint8_t digest[SHA256_DIGEST_LENGTH];
+        SHA256_Final(digest, &ctx);
+        CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+    }
+
+    FileHashPool::exit();
+    CHECK(!FileHashPool::is_enabled());
+}
+#endif
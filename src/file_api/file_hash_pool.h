@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// file_hash_pool.h author Cisco
+
+#ifndef FILE_HASH_POOL_H
+#define FILE_HASH_POOL_H
+
+// Worker threads computing file signatures off the packet threads.
+// A packet thread hands file data over to its file's job and goes on with
+// the next packet; the data of a single file is hashed in order by one
+// worker at a time, while different files are hashed in parallel.
+// A worker takes up to sha256_mb_lanes() files at once and hashes their
+// data side by side with the multi-buffer SHA-256.
+// Before the signature is finalized the packet thread waits for the job
+// to drain, so verdicts are still looked up from the packet thread.
+// Queued data is bounded by a memcap. When it is exhausted the caller
+// hashes the data itself.
+
+#include <openssl/sha.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace snort
+{
+class FileHashJob
+{
+public:
+    // the context must outlive the job
+    FileHashJob(SHA256_CTX* ctx) : context(ctx) { }
+
+    // Hand file data over to the workers
+    // Returns:
+    //   true: data is queued
+    //   false: no room, the data should be hashed by the caller after wait()
+    bool update(const uint8_t* data, size_t size);
+
+    // Wait until all data queued for this job is hashed.
+    // The context can be used by the caller afterwards.
+    void wait();
+
+private:
+    friend class FileHashPool;
+    static void run(FileHashJob**, unsigned count);
+
+    SHA256_CTX* context;
+    std::mutex job_mutex;
+    std::condition_variable job_cv;
+    std::queue<std::vector<uint8_t>> chunks;
+    bool scheduled = false;
+};
+
+class FileHashPool
+{
+public:
+    // this must be called during snort init
+    static void init(unsigned threads, int64_t memcap);
+
+    // this must be called when snort exits, after all jobs are released
+    static void exit();
+
+    static bool is_enabled()
+    { return !workers.empty(); }
+
+private:
+    friend class FileHashJob;
+
+    static bool reserve(size_t);
+    static void release(size_t);
+    static void schedule(FileHashJob*);
+    static void worker_thread();
+
+    static std::vector<std::thread*> workers;
+    static std::mutex pool_mutex;
+    static std::condition_variable pool_cv;
+    static std::queue<FileHashJob*> jobs_ready;
+    static std::atomic<int64_t> bytes_queued;
+    static int64_t max_bytes_queued;
+    static bool running;
+};
+}
+
+#endif
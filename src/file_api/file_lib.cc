@@ -50,6 +50,7 @@
 #include "file_config.h"
 #include "file_cache.h"
 #include "file_flows.h"
+#include "file_hash_pool.h"
 #include "file_service.h"
 #include "file_segment.h"
 #include "file_stats.h"
@@ -328,6 +329,11 @@ FileContext::FileContext ()
 
 FileContext::~FileContext ()
 {
+    if (file_hash_job)
+    {
+        file_hash_job->wait();
+        delete file_hash_job;
+    }
     if (file_signature_context)
         snort_free(file_signature_context);
     if (file_capture)
@@ -694,13 +700,15 @@ void FileContext::process_file_signature_sha256(const uint8_t* file_data, int da
     case SNORT_FILE_START:
         if (!file_signature_context)
             file_signature_context = snort_calloc(sizeof(SHA256_CTX));
+        sync_file_signature();
         SHA256_Init((SHA256_CTX*)file_signature_context);
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        update_file_signature(file_data, data_size);
         FILE_DEBUG(file_trace, DEFAULT_TRACE_OPTION_ID, TRACE_DEBUG_LEVEL, GET_CURRENT_PACKET,
             "position is start of file\n");
         if (file_state.sig_state == FILE_SIG_FLUSH)
         {
             static uint8_t file_signature_context_backup[sizeof(SHA256_CTX)];
+            sync_file_signature();
             sha256 = (uint8_t*)snort_alloc(SHA256_HASH_SIZE);
             memcpy(file_signature_context_backup, file_signature_context, sizeof(SHA256_CTX));
 
@@ -712,12 +720,13 @@ void FileContext::process_file_signature_sha256(const uint8_t* file_data, int da
     case SNORT_FILE_MIDDLE:
         if (!file_signature_context)
             return;
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        update_file_signature(file_data, data_size);
         FILE_DEBUG(file_trace, DEFAULT_TRACE_OPTION_ID, TRACE_DEBUG_LEVEL, GET_CURRENT_PACKET,
             "position is middle of the file\n");
         if (file_state.sig_state == FILE_SIG_FLUSH)
         {
             static uint8_t file_signature_context_backup[sizeof(SHA256_CTX)];
+            sync_file_signature();
             if ( !sha256 )
                 sha256 = (uint8_t*)snort_alloc(SHA256_HASH_SIZE);
             memcpy(file_signature_context_backup, file_signature_context, sizeof(SHA256_CTX));
@@ -731,7 +740,8 @@ void FileContext::process_file_signature_sha256(const uint8_t* file_data, int da
     case SNORT_FILE_END:
         if (!file_signature_context)
             return;
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        update_file_signature(file_data, data_size);
+        sync_file_signature();
         sha256 = new uint8_t[SHA256_HASH_SIZE];
         SHA256_Final(sha256, (SHA256_CTX*)file_signature_context);
         file_state.sig_state = FILE_SIG_DONE;
@@ -742,6 +752,7 @@ void FileContext::process_file_signature_sha256(const uint8_t* file_data, int da
     case SNORT_FILE_FULL:
         if (!file_signature_context)
             file_signature_context = snort_calloc(sizeof (SHA256_CTX));
+        sync_file_signature();
         SHA256_Init((SHA256_CTX*)file_signature_context);
         SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
         sha256 = new uint8_t[SHA256_HASH_SIZE];
@@ -756,6 +767,34 @@ void FileContext::process_file_signature_sha256(const uint8_t* file_data, int da
     }
 }
 
+// Hash the data on a signature thread if possible
+void FileContext::update_file_signature(const uint8_t* file_data, int data_size)
+{
+    if (FileHashPool::is_enabled())
+    {
+        if (!file_hash_job)
+            file_hash_job = new FileHashJob((SHA256_CTX*)file_signature_context);
+
+        if (file_hash_job->update(file_data, data_size))
+        {
+            file_counts.signature_bytes_offloaded += data_size;
+            return;
+        }
+
+        file_counts.signature_queue_full++;
+        file_hash_job->wait();
+    }
+
+    SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+}
+
+// Wait for the queued data to be hashed before using the signature context
+void FileContext::sync_file_signature()
+{
+    if (file_hash_job)
+        file_hash_job->wait();
+}
+
 FileCaptureState FileContext::process_file_capture(const uint8_t* file_data,
     int data_size, FilePosition position)
 {
@@ -43,6 +43,7 @@ class FileSegments;
 namespace snort
 {
 class FileCapture;
+class FileHashJob;
 class FileInspect;
 class Flow;
 
@@ -158,6 +159,7 @@ private:
     uint64_t processed_bytes = 0;
     void* file_type_context;
     void* file_signature_context;
+    FileHashJob* file_hash_job = nullptr;
     FileSegments* file_segments;
     FileInspect* inspector;
     FileConfig*  config;
@@ -165,6 +167,8 @@ private:
 
     void finalize_file_type();
     void finish_signature_lookup(Packet*, bool, FilePolicyBase*);
+    void update_file_signature(const uint8_t* file_data, int data_size);
+    void sync_file_signature();
     void find_file_type_from_ips(Packet*, const uint8_t *file_data, int data_size, FilePosition);
     void process_file_type(Packet*, const uint8_t* file_data, int data_size, FilePosition);
 };
@@ -99,6 +99,12 @@ static const Parameter file_id_params[] =
     { "decompress_buffer_size", Parameter::PT_INT, "1024:max31", "100000",
       "file decompression buffer size" },
 
+    { "signature_threads", Parameter::PT_INT, "0:64", "0",
+      "number of threads computing file signatures off the packet threads; 0 computes them inline" },
+
+    { "signature_memcap", Parameter::PT_INT, "1:max32", "16",
+      "memcap for file data queued to signature threads in megabytes" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -109,6 +115,8 @@ static const PegInfo file_pegs[] =
     { CountType::SUM, "cache_failures", "number of file cache add failures" },
     { CountType::SUM, "files_not_processed", "number of files not processed due to per-flow limit" },
     { CountType::MAX, "max_concurrent_files", "maximum files processed concurrently on a flow" },
+    { CountType::SUM, "signature_bytes_offloaded", "number of file data bytes hashed by signature threads" },
+    { CountType::SUM, "signature_queue_full", "number of times file data was hashed inline due to signature_memcap" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -205,6 +213,12 @@ bool FileIdModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("trace_stream") )
         fc->trace_stream = v.get_bool();
 
+    else if ( v.is("signature_threads") )
+        fc->signature_threads = v.get_uint32();
+
+    else if ( v.is("signature_memcap") )
+        fc->signature_memcap = v.get_int64();
+
     else if ( v.is("decompress_buffer_size") )
         FileService::decode_conf.set_decompress_buffer_size(v.get_uint32());
 
@@ -37,6 +37,7 @@
 #include "file_cache.h"
 #include "file_capture.h"
 #include "file_flows.h"
+#include "file_hash_pool.h"
 #include "file_stats.h"
 
 using namespace snort;
@@ -53,6 +54,8 @@ DecodeConfig FileService::decode_conf;
 static int64_t max_files_cached = 0;
 static int64_t capture_memcap = 0;
 static int64_t capture_block_size = 0;
+static uint32_t signature_threads = 0;
+static int64_t signature_memcap = 0;
 
 void FileService::init()
 {
@@ -82,6 +85,14 @@ void FileService::post_init()
         capture_memcap = conf->capture_memcap;
         capture_block_size = conf->capture_block_size;
     }
+
+    if (file_signature_enabled and conf->signature_threads)
+    {
+        FileHashPool::init(conf->signature_threads, conf->signature_memcap * 1024 * 1024);
+        signature_threads = conf->signature_threads;
+        signature_memcap = conf->signature_memcap;
+    }
+
     const SnortConfig* sc = SnortConfig::get_conf();
     conf->snort_protocol_id = sc->proto_ref->find("file_id");
 }
@@ -104,6 +115,12 @@ void FileService::verify_reload(const SnortConfig* sc)
             ReloadError("Changing file_id.capture_block_size requires a restart.\n");
     }
 
+    if (file_signature_enabled and signature_threads != conf->signature_threads)
+        ReloadError("Changing file_id.signature_threads requires a restart.\n");
+
+    if (signature_threads and signature_memcap != conf->signature_memcap)
+        ReloadError("Changing file_id.signature_memcap requires a restart.\n");
+
     if (conf->snort_protocol_id == UNKNOWN_PROTOCOL_ID)
     {
         conf->snort_protocol_id = sc->proto_ref->find("file_id");
@@ -117,6 +134,7 @@ void FileService::close()
 
     MimeSession::exit();
     FileCapture::exit();
+    FileHashPool::exit();
 }
 
 void FileService::thread_init()
@@ -26,6 +26,8 @@
 
 #include "sfrf.h"
 
+#include <mutex>
+
 #include "main/thread.h"
 #include "detection/rules.h"
 #include "framework/ips_action.h"
@@ -38,6 +40,8 @@
 #include "utils/sflsq.h"
 #include "utils/util.h"
 
+#include "shared_filter_table.h"
+
 using namespace snort;
 
 // Number of hash rows for gid 1 (rules)
@@ -103,6 +107,13 @@ typedef struct
 
 static THREAD_LOCAL XHash* rf_hash = nullptr;
 
+// used by all packet threads when rate filters are shared
+static std::mutex rf_shared_mutex;
+static SharedFilterTable* rf_shared = nullptr;
+static unsigned rf_shared_users = 0;
+
+static THREAD_LOCAL SharedFilterTable* rf_table = nullptr;
+
 // private methods ...
 static int _checkThreshold(
     tSFRFConfigNode*,
@@ -122,6 +133,17 @@ static tSFRFTrackingNode* _getSFRFTrackingNode(
     time_t curTime
     );
 
+static void _updateCount(
+    tSFRFConfigNode*,
+    tSFRFTrackingNode*,
+    SFRF_COUNT_OPERATION
+    );
+
+static bool _dropsOverCount(
+    tSFRFConfigNode*,
+    tSFRFTrackingNode*
+    );
+
 static void _updateDependentThresholds(
     RateFilterConfig* config,
     unsigned gid,
@@ -158,6 +180,18 @@ static void SFRF_New(unsigned nbytes)
 
 void SFRF_Delete()
 {
+    if ( rf_table )
+    {
+        std::lock_guard<std::mutex> lock(rf_shared_mutex);
+
+        if ( !--rf_shared_users )
+        {
+            delete rf_shared;
+            rf_shared = nullptr;
+        }
+        rf_table = nullptr;
+    }
+
     if ( !rf_hash )
         return;
 
@@ -165,6 +199,7 @@ void SFRF_Delete()
     rf_hash = nullptr;
 }
 
+// the shared table is not flushed since other threads may be using it
 void SFRF_Flush()
 {
     if ( rf_hash )
@@ -198,8 +233,23 @@ static void SFRF_SidNodeFree(void* item)
     snort_free(pSidnode);
 }
 
-int SFRF_Alloc(unsigned int memcap)
+int SFRF_Alloc(unsigned int memcap, bool shared)
 {
+    if ( rf_table )
+        return 0;
+
+    if ( shared )
+    {
+        std::lock_guard<std::mutex> lock(rf_shared_mutex);
+
+        if ( !rf_shared )
+            rf_shared = new SharedFilterTable(memcap, sizeof(tSFRFTrackingNodeKey));
+
+        rf_shared_users++;
+        rf_table = rf_shared;
+        return 0;
+    }
+
     if ( rf_hash == nullptr )
     {
         SFRF_New(memcap);
@@ -334,6 +384,145 @@ int SFRF_ConfigAdd(SnortConfig*, RateFilterConfig* rf_config, tSFRFConfigNode* c
     return 0;
 }
 
+/* In a shared table the tracking node is kept in atomic words which are
+ * updated with compare and swap so no locks are needed:
+ *
+ *   state[0]: tstart << 32 | count << 2 | overRate << 1 | used
+ *   state[1]: revertTime << 32 | filterState
+ *   state[2]: tlast
+ *
+ * The sampling period and count are updated together but the filter state
+ * separately, so with concurrent events for the same node the filter state
+ * may be decided on a count which does not include the other event yet.
+ */
+#define SFRF_SHARED_USED      1
+#define SFRF_SHARED_OVER_RATE 2
+#define SFRF_SHARED_MAX_COUNT (UINT32_MAX >> 2)
+
+static void SFRF_UnpackCount(uint64_t w, tSFRFTrackingNode* dynNode, time_t curTime)
+{
+    if ( w & SFRF_SHARED_USED )
+    {
+        dynNode->tstart = (time_t)(w >> 32);
+        dynNode->count = (unsigned)((uint32_t)w >> 2);
+#ifdef SFRF_OVER_RATE
+        dynNode->overRate = (w & SFRF_SHARED_OVER_RATE) ? 1 : 0;
+#endif
+    }
+    else
+    {
+        dynNode->tstart = curTime;
+        dynNode->count = 0;
+#ifdef SFRF_OVER_RATE
+        dynNode->overRate = 0;
+#endif
+    }
+}
+
+static uint64_t SFRF_PackCount(const tSFRFTrackingNode* dynNode)
+{
+    uint64_t w = (uint64_t)(uint32_t)dynNode->tstart << 32;
+    unsigned count = dynNode->count;
+
+    if ( count > SFRF_SHARED_MAX_COUNT )
+        count = SFRF_SHARED_MAX_COUNT;
+
+    w |= (uint64_t)count << 2;
+#ifdef SFRF_OVER_RATE
+    if ( dynNode->overRate )
+        w |= SFRF_SHARED_OVER_RATE;
+#endif
+    return w | SFRF_SHARED_USED;
+}
+
+static int SFRF_TestObjectShared(
+    tSFRFConfigNode* cfgNode,
+    const SfIp* ip,
+    time_t curTime,
+    SFRF_COUNT_OPERATION op
+    )
+{
+    tSFRFTrackingNodeKey key;
+    key.ip = *(ip);
+    key.tid = cfgNode->tid;
+    key.policyId = get_inspection_policy()->policy_id;
+    key.padding = 0;
+
+    SharedFilterTable::Ref ref = rf_table->find_else_create(&key, (uint32_t)curTime);
+
+    if ( !ref )
+    {
+        rate_filter_stats.xhash_nomem_peg++;
+        return -1;
+    }
+
+    std::atomic<uint64_t>* state = ref.state();
+
+    tSFRFTrackingNode dynNode;
+    uint64_t old = state[0].load(std::memory_order_relaxed);
+    uint64_t cnt;
+
+#ifdef SFRF_OVER_RATE
+    uint64_t tlast = state[2].load(std::memory_order_relaxed);
+#endif
+
+    do
+    {
+        SFRF_UnpackCount(old, &dynNode, curTime);
+#ifdef SFRF_OVER_RATE
+        dynNode.tlast = (old & SFRF_SHARED_USED) ? (time_t)tlast : curTime;
+#endif
+        _checkSamplingPeriod(cfgNode, &dynNode, curTime);
+        _updateCount(cfgNode, &dynNode, op);
+        cnt = SFRF_PackCount(&dynNode);
+    }
+    while ( !state[0].compare_exchange_weak(old, cnt, std::memory_order_relaxed) );
+
+#ifdef SFRF_OVER_RATE
+    state[2].store((uint64_t)curTime, std::memory_order_relaxed);
+#endif
+
+    old = state[1].load(std::memory_order_relaxed);
+    uint64_t val;
+    int retValue;
+
+    do
+    {
+        FilterState fs = (FilterState)(old & 0x3);
+        dynNode.filterState = (fs == FS_NEW) ? FS_OFF : fs;
+        dynNode.revertTime = (time_t)(old >> 32);
+        SFRF_UnpackCount(cnt, &dynNode, curTime);
+
+        retValue = _checkThreshold(cfgNode, &dynNode, curTime);
+        val = ((uint64_t)(uint32_t)dynNode.revertTime << 32) | dynNode.filterState;
+    }
+    while ( !state[1].compare_exchange_weak(old, val, std::memory_order_relaxed) );
+
+#ifdef SFRF_OVER_RATE
+    if ( dynNode.overRate )
+        state[0].fetch_or(SFRF_SHARED_OVER_RATE, std::memory_order_relaxed);
+#endif
+
+    if ( _dropsOverCount(cfgNode, &dynNode) )
+    {
+        old = state[0].load(std::memory_order_relaxed);
+
+        do
+        {
+            SFRF_UnpackCount(old, &dynNode, curTime);
+
+            if ( !dynNode.count )
+                break;
+
+            dynNode.count--;
+            val = SFRF_PackCount(&dynNode);
+        }
+        while ( !state[0].compare_exchange_weak(old, val, std::memory_order_relaxed) );
+    }
+
+    return retValue;
+}
+
 /*
  *
  *  Find/Test/Add an event against a single threshold object.
@@ -359,6 +548,9 @@ static int SFRF_TestObject(
     tSFRFTrackingNode* dynNode;
     int retValue = -1;
 
+    if ( rf_table )
+        return SFRF_TestObjectShared(cfgNode, ip, curTime, op);
+
     dynNode = _getSFRFTrackingNode(ip, cfgNode->tid, curTime);
 
     if ( dynNode == nullptr )
@@ -372,45 +564,12 @@ static int SFRF_TestObject(
 #endif
     }
 
-    switch (op)
-    {
-    case SFRF_COUNT_INCREMENT:
-        // cppcheck-suppress knownConditionTrueFalse
-        if ( (dynNode->count+1) != 0 )
-        {
-            dynNode->count++;
-        }
-        break;
-    case SFRF_COUNT_DECREMENT:
-        if ( cfgNode->seconds == 0 )
-        {
-            // count can be decremented only for total count, and not for rate
-            if ( dynNode->count != 0 )
-            {
-                dynNode->count--;
-            }
-        }
-        break;
-    case SFRF_COUNT_RESET:
-        dynNode->count = 0;
-        break;
-    default:
-        break;
-    }
+    _updateCount(cfgNode, dynNode, op);
 
     retValue = _checkThreshold(cfgNode, dynNode, curTime);
 
-    // we drop after the session count has been incremented
-    // but the decrement will never come so we "fix" it here
-    // if the count were not incremented in such cases, the
-    // threshold would never be exceeded.
-    if ( !cfgNode->seconds && (dynNode->count > cfgNode->count)
-      && Actions::is_valid_action(cfgNode->newAction) )
-    {
-        IpsAction* act = get_ips_policy()->action[cfgNode->newAction];
-        if ( act->drops_traffic() )
-            dynNode->count--;
-    }
+    if ( _dropsOverCount(cfgNode, dynNode) )
+        dynNode->count--;
 
 #ifdef SFRF_DEBUG
     printf("--SFRF_DEBUG: %d-%u-%u: %u Packet IP %s, op: %d, count %u, action %d\n",
@@ -807,3 +966,54 @@ static tSFRFTrackingNode* _getSFRFTrackingNode(const SfIp* ip, unsigned tid, tim
 
     return dynNode;
 }
+
+static void _updateCount(
+    tSFRFConfigNode* cfgNode,
+    tSFRFTrackingNode* dynNode,
+    SFRF_COUNT_OPERATION op
+    )
+{
+    switch (op)
+    {
+    case SFRF_COUNT_INCREMENT:
+        // cppcheck-suppress knownConditionTrueFalse
+        if ( (dynNode->count+1) != 0 )
+        {
+            dynNode->count++;
+        }
+        break;
+    case SFRF_COUNT_DECREMENT:
+        if ( cfgNode->seconds == 0 )
+        {
+            // count can be decremented only for total count, and not for rate
+            if ( dynNode->count != 0 )
+            {
+                dynNode->count--;
+            }
+        }
+        break;
+    case SFRF_COUNT_RESET:
+        dynNode->count = 0;
+        break;
+    default:
+        break;
+    }
+}
+
+// we drop after the session count has been incremented
+// but the decrement will never come so we "fix" it here
+// if the count were not incremented in such cases, the
+// threshold would never be exceeded.
+static bool _dropsOverCount(
+    tSFRFConfigNode* cfgNode,
+    tSFRFTrackingNode* dynNode
+    )
+{
+    if ( !cfgNode->seconds && (dynNode->count > cfgNode->count)
+      && Actions::is_valid_action(cfgNode->newAction) )
+    {
+        IpsAction* act = get_ips_policy()->action[cfgNode->newAction];
+        return act->drops_traffic();
+    }
+    return false;
+}
@@ -142,6 +142,7 @@ struct RateFilterConfig
     snort::GHash* genHash [SFRF_MAX_GENID];
 
     unsigned memcap;
+    bool shared;
     unsigned noRevertCount;
     int count;
     int internal_event_mask;
@@ -187,6 +188,6 @@ inline bool is_internal_event_enabled(RateFilterConfig* config, uint32_t sid)
     return (config->internal_event_mask & (1 << sid));
 }
 
-int SFRF_Alloc(unsigned int memcap);
+int SFRF_Alloc(unsigned int memcap, bool shared = false);
 
 #endif
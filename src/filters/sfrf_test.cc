@@ -889,7 +889,7 @@ static void PrintTests()
 
 //---------------------------------------------------------------
 
-static void Init(const SnortConfig* sc, unsigned cap)
+static void Init(const SnortConfig* sc, unsigned cap, bool shared = false)
 {
     // FIXIT-L must set policies because they may have been invalidated
     // by prior tests with transient SnortConfigs.  better to fix sfrf
@@ -899,7 +899,9 @@ static void Init(const SnortConfig* sc, unsigned cap)
     rfc = RateFilter_ConfigNew();
     rfc->memcap = cap;
 
-    SFRF_Alloc(rfc->memcap);
+    rfc->shared = shared;
+
+    SFRF_Alloc(rfc->memcap, rfc->shared);
 
     for ( unsigned i = 0; i < NUM_NODES; i++ )
     {
@@ -1004,6 +1006,24 @@ TEST_CASE("sfrf default memcap", "[sfrf]")
     Term();
 }
 
+TEST_CASE("sfrf shared", "[sfrf]")
+{
+    SnortConfig sc;
+    Init(&sc, MEM_DEFAULT, true);
+
+    SECTION("setup")
+    {
+        for ( unsigned i = 0; i < NUM_NODES; ++i )
+            CHECK(SetupCheck(i) == 1);
+    }
+    SECTION("event")
+    {
+        for ( unsigned i = 0; i < NUM_NODES; ++i )
+            CHECK(EventCheck(i) == 1);
+    }
+    Term();
+}
+
 TEST_CASE("sfrf minimum memcap", "[sfrf]")
 {
     SnortConfig sc;
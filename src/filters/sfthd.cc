@@ -44,6 +44,8 @@
 #include "utils/sflsq.h"
 #include "utils/util.h"
 
+#include "shared_filter_table.h"
+
 using namespace snort;
 
 //  Debug Printing
@@ -105,13 +107,23 @@ XHash* sfthd_global_new(unsigned bytes)
     return global_hash;
 }
 
-THD_STRUCT* sfthd_new(unsigned lbytes, unsigned gbytes)
+THD_STRUCT* sfthd_new(unsigned lbytes, unsigned gbytes, bool shared)
 {
     THD_STRUCT* thd;
 
     /* Create the THD struct */
     thd = (THD_STRUCT*)snort_calloc(sizeof(THD_STRUCT));
 
+    if ( shared )
+    {
+        thd->shared_nodes = new SharedFilterTable(lbytes, sizeof(THD_IP_NODE_KEY));
+
+        if ( gbytes )
+            thd->shared_gnodes = new SharedFilterTable(gbytes, sizeof(THD_IP_GNODE_KEY));
+
+        return thd;
+    }
+
     /* Create hash table for all of the local IP Nodes */
     thd->ip_nodes = sfthd_local_new(lbytes);
     if ( !thd->ip_nodes )
@@ -227,6 +239,9 @@ void sfthd_free(THD_STRUCT* thd)
     if ( thd->ip_gnodes )
         delete thd->ip_gnodes;
 
+    delete thd->shared_nodes;
+    delete thd->shared_gnodes;
+
     snort_free(thd);
 }
 
@@ -797,6 +812,72 @@ static inline int sfthd_test_non_suppress(
     return 0;  /* should not get here, so log it just to be safe */
 }
 
+/*
+ *  Find/Test/Add an event in a shared table.  The node state is packed into
+ *  a single word, tstart in the high half and the count above a bit which
+ *  is set once the node is in use, so the whole update is one compare and
+ *  swap.  The event filters do not use prev and tlast, only detection
+ *  filters (THD_TYPE_DETECT) do and those are not tracked in shared tables.
+ */
+#define THD_SHARED_USED 1
+
+static int sfthd_test_shared(
+    SharedFilterTable* table,
+    THD_NODE* sfthd_node,
+    const void* key,
+    time_t curtime,
+    PegCount& nomem)
+{
+    assert(sfthd_node->type != THD_TYPE_DETECT);
+    SharedFilterTable::Ref ref = table->find_else_create(key, (uint32_t)curtime);
+
+    if ( !ref )
+    {
+        nomem++;
+        return 1;
+    }
+
+    std::atomic<uint64_t>* state = ref.state();
+    uint64_t old = state->load(std::memory_order_relaxed);
+    uint64_t val;
+    int status;
+
+    do
+    {
+        THD_IP_NODE node;
+
+        if ( old & THD_SHARED_USED )
+        {
+            node.count = (unsigned)((uint32_t)old >> 1) + 1;
+            node.tstart = (time_t)(old >> 32);
+        }
+        else
+        {
+            node.count = 1;
+            node.tstart = curtime;
+        }
+        node.prev = 0;
+        node.tlast = node.tstart;
+
+        status = sfthd_test_non_suppress(sfthd_node, &node, curtime);
+
+        // like the hashes, a new node is added as it was before the test
+        if ( !(old & THD_SHARED_USED) )
+        {
+            node.count = 1;
+            node.tstart = curtime;
+        }
+        else if ( node.count > (UINT32_MAX >> 1) )
+            node.count = UINT32_MAX >> 1;
+
+        val = ((uint64_t)(uint32_t)node.tstart << 32) | ((uint64_t)node.count << 1) |
+            THD_SHARED_USED;
+    }
+    while ( !state->compare_exchange_weak(old, val, std::memory_order_relaxed) );
+
+    return status;
+}
+
 /*!
  *
  *  Find/Test/Add an event against a single threshold object.
@@ -820,7 +901,8 @@ int sfthd_test_local(
     const SfIp* sip,
     const SfIp* dip,
     time_t curtime,
-    PolicyId policy_id)
+    PolicyId policy_id,
+    SharedFilterTable* shared)
 {
     THD_IP_NODE_KEY key;
     THD_IP_NODE data,* sfthd_ip_node;
@@ -875,6 +957,10 @@ int sfthd_test_local(
     key.thd_id = sfthd_node->thd_id;
     key.padding = 0;
 
+    if ( shared )
+        return sfthd_test_shared(shared, sfthd_node, &key, curtime,
+            event_filter_stats.xhash_nomem_peg_local);
+
     /* Set up a new data element */
     data.count  = 1;
     data.prev   = 0;
@@ -919,6 +1005,7 @@ int sfthd_test_local(
  */
 static inline int sfthd_test_global(
     XHash* global_hash,
+    SharedFilterTable* shared,
     THD_NODE* sfthd_node,
     unsigned sig_id,     /* from current event */
     const SfIp* sip,        /* " */
@@ -977,6 +1064,10 @@ static inline int sfthd_test_global(
     key.policyId = policy_id;
     key.padding = 0;
 
+    if ( shared )
+        return sfthd_test_shared(shared, sfthd_node, &key, curtime,
+            event_filter_stats.xhash_nomem_peg_global);
+
     /* Set up a new data element */
     data.count  = 1;
     data.prev  = 0;
@@ -1122,7 +1213,8 @@ int sfthd_test_threshold(
         /*
          *   Test SUPPRESSION and THRESHOLDING
          */
-        int status = sfthd_test_local(thd->ip_nodes, sfthd_node, sip, dip, curtime, policy_id);
+        int status = sfthd_test_local(thd->ip_nodes, sfthd_node, sip, dip, curtime, policy_id,
+            thd->shared_nodes);
 
         if ( status < 0 ) /* -1 == Don't log and stop looking */
         {
@@ -1163,7 +1255,7 @@ global_test:
 
     if ( g_thd_node )
     {
-        int status = sfthd_test_global(thd->ip_gnodes, g_thd_node, sig_id,
+        int status = sfthd_test_global(thd->ip_gnodes, thd->shared_gnodes, g_thd_node, sig_id,
                 sip, dip, curtime, policy_id);
 
         if ( status < 0 ) /* -1 == Don't log and stop looking */
@@ -37,6 +37,7 @@ class XHash;
 struct SnortConfig;
 }
 
+class SharedFilterTable;
 typedef struct sf_list SF_LIST;
 
 static std::mutex sfthd_hash_mutex;
@@ -189,11 +190,16 @@ struct tThdItemKey
 
     Local and global threshold thd_id's are all unique, so we use just one
     ip_nodes lookup table
+
+    A shared THD_STRUCT is used by all packet threads and has shared tables
+    instead of the per thread hashes.
  */
 struct THD_STRUCT
 {
     snort::XHash* ip_nodes;   /* Global hash of active IP's key=THD_IP_NODE_KEY, data=THD_IP_NODE */
     snort::XHash* ip_gnodes;  /* Global hash of active IP's key=THD_IP_GNODE_KEY, data=THD_IP_GNODE */
+    SharedFilterTable* shared_nodes;
+    SharedFilterTable* shared_gnodes;
 };
 
 struct ThresholdObjects
@@ -224,7 +230,8 @@ struct EventFilterStats
  */
 // lbytes = local threshold memcap
 // gbytes = global threshold memcap (0 to disable global)
-THD_STRUCT* sfthd_new(unsigned lbytes, unsigned gbytes);
+// shared = one table for all packet threads
+THD_STRUCT* sfthd_new(unsigned lbytes, unsigned gbytes, bool shared = false);
 snort::XHash* sfthd_local_new(unsigned bytes);
 snort::XHash* sfthd_global_new(unsigned bytes);
 void sfthd_free(THD_STRUCT*);
@@ -256,7 +263,8 @@ int sfthd_test_threshold(ThresholdObjects*, THD_STRUCT*, unsigned gen_id, unsign
 snort::XHash* sfthd_new_hash(unsigned, size_t, size_t);
 
 int sfthd_test_local(snort::XHash* local_hash, THD_NODE* sfthd_node, const snort::SfIp* sip,
-    const snort::SfIp* dip, time_t curtime, PolicyId policy_id);
+    const snort::SfIp* dip, time_t curtime, PolicyId policy_id,
+    SharedFilterTable* shared = nullptr);
 
 #ifdef THD_DEBUG
 int sfthd_show_objects(THD_STRUCT* thd);
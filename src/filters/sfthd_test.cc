@@ -22,9 +22,13 @@
 #include "config.h"
 #endif
 
+#include <thread>
+#include <vector>
+
 #include "catch/snort_catch.h"
 #include "main/snort_config.h"
 #include "hash/xhash.h"
+#include "main/thread.h"
 #include "parser/parse_ip.h"
 #include "sfip/sf_ip.h"
 
@@ -32,6 +36,8 @@
 
 using namespace snort;
 
+extern THREAD_LOCAL EventFilterStats event_filter_stats; // in sfthd.cc
+
 //---------------------------------------------------------------
 
 #define IP_ANY   nullptr          // used to get "unset"
@@ -786,6 +792,13 @@ static void InitMincap(const SnortConfig* sc)
     Init(sc, thData, NUM_THDS);
 }
 
+static void InitShared(const SnortConfig* sc)
+{
+    pThdObjs = sfthd_objs_new();
+    pThd = sfthd_new(MEM_DEFAULT, MEM_DEFAULT, true);
+    Init(sc, thData, NUM_THDS);
+}
+
 static void InitDetect(const SnortConfig* sc)
 {
     dThd = sfthd_local_new(MEM_DEFAULT);
@@ -911,6 +924,80 @@ static int PacketCheck(int i)
     return 0;
 }
 
+//---------------------------------------------------------------
+// the shared table is checked with several threads testing the same
+// sources against each type of threshold at the same time.  lookups which
+// fail as out of memory are not counted by the table so they are not
+// counted here either.
+
+#define NUM_THREADS 4
+#define NUM_SOURCES 8
+#define NUM_REPEATS 500
+
+static ThreshData sharedData[] =
+{
+    { 200, 1, THD_TRK_SRC, THD_TYPE_LIMIT,     10, 60, IP_ANY, 0, 0, nullptr }
+    ,{ 200, 2, THD_TRK_SRC, THD_TYPE_THRESHOLD,  7, 60, IP_ANY, 0, 0, nullptr }
+    ,{ 200, 3, THD_TRK_SRC, THD_TYPE_BOTH,       5, 60, IP_ANY, 0, 0, nullptr }
+};
+
+#define NUM_SHARED (sizeof(sharedData)/sizeof(sharedData[0]))
+
+struct SharedCounts
+{
+    unsigned tested[NUM_SHARED][NUM_SOURCES] = { };
+    unsigned logged[NUM_SHARED][NUM_SOURCES] = { };
+};
+
+static void SharedTest(SharedCounts* counts, PolicyId policy_id)
+{
+    SfIp dip;
+    dip.set(IP4_DST);
+
+    for ( unsigned n = 0; n < NUM_REPEATS; ++n )
+    {
+        for ( unsigned s = 0; s < NUM_SOURCES; ++s )
+        {
+            SfIp sip;
+            uint32_t addr = htonl(0x0a000001 + s);
+            sip.set(&addr, AF_INET);
+
+            for ( unsigned i = 0; i < NUM_SHARED; ++i )
+            {
+                ThreshData* p = sharedData + i;
+                PegCount nomem = event_filter_stats.xhash_nomem_peg_local;
+
+                int status = sfthd_test_threshold(
+                    pThdObjs, pThd, p->gid, p->sid, &sip, &dip, 1, policy_id);
+
+                if ( event_filter_stats.xhash_nomem_peg_local != nomem )
+                    continue;
+
+                counts->tested[i][s]++;
+
+                if ( status == LOG_OK )
+                    counts->logged[i][s]++;
+            }
+        }
+    }
+}
+
+static unsigned SharedExpect(const ThreshData* p, unsigned tested)
+{
+    switch ( p->type )
+    {
+    case THD_TYPE_LIMIT:
+        return tested < (unsigned)p->count ? tested : p->count;
+
+    case THD_TYPE_THRESHOLD:
+        return tested / p->count;
+
+    case THD_TYPE_BOTH:
+        return tested >= (unsigned)p->count ? 1 : 0;
+    }
+    return 0;
+}
+
 //---------------------------------------------------------------
 
 TEST_CASE("sfthd normal", "[sfthd]")
@@ -931,6 +1018,74 @@ TEST_CASE("sfthd normal", "[sfthd]")
     Term();
 }
 
+TEST_CASE("sfthd shared", "[sfthd]")
+{
+    SnortConfig sc;
+    InitShared(&sc);
+
+    SECTION("setup")
+    {
+        for ( unsigned i = 0; i < NUM_THDS; ++i )
+            CHECK(SetupCheck(i) == 1);
+    }
+    SECTION("event")
+    {
+        for ( unsigned i = 0; i < NUM_EVTS; ++i )
+            CHECK(EventCheck(i) == 1);
+    }
+    Term();
+}
+
+TEST_CASE("sfthd shared threads", "[sfthd]")
+{
+    SnortConfig sc;
+    set_default_policy(&sc);
+
+    pThdObjs = sfthd_objs_new();
+    pThd = sfthd_new(MEM_DEFAULT, MEM_DEFAULT, true);
+
+    // the policy is per thread so it is taken from this one
+    PolicyId policy_id = get_network_policy()->policy_id;
+
+    for ( unsigned i = 0; i < NUM_SHARED; ++i )
+    {
+        ThreshData* p = sharedData + i;
+
+        p->create = sfthd_create_threshold(nullptr,
+            pThdObjs, p->gid, p->sid, p->tracking, p->type, PRIORITY,
+            p->count, p->seconds, nullptr, policy_id);
+
+        CHECK(p->create == p->expect);
+    }
+
+    SharedCounts counts[NUM_THREADS];
+    std::vector<std::thread> threads;
+
+    for ( unsigned t = 0; t < NUM_THREADS; ++t )
+        threads.emplace_back(SharedTest, counts + t, policy_id);
+
+    for ( auto& t : threads )
+        t.join();
+
+    for ( unsigned i = 0; i < NUM_SHARED; ++i )
+    {
+        for ( unsigned s = 0; s < NUM_SOURCES; ++s )
+        {
+            unsigned tested = 0;
+            unsigned logged = 0;
+
+            for ( const auto& c : counts )
+            {
+                tested += c.tested[i][s];
+                logged += c.logged[i][s];
+            }
+            CHECK(tested > NUM_REPEATS);
+            CHECK(logged == SharedExpect(sharedData + i, tested));
+        }
+    }
+    Term();
+}
+
 TEST_CASE("sfthd mincap", "[sfthd]")
 {
     SnortConfig sc;
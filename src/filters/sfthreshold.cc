@@ -43,6 +43,8 @@
 
 #include "sfthreshold.h"
 
+#include <mutex>
+
 #include "hash/xhash.h"
 #include "main/snort_config.h"
 #include "utils/util.h"
@@ -54,6 +56,11 @@ using namespace snort;
 /* Data */
 static THREAD_LOCAL THD_STRUCT* thd_runtime = nullptr;
 
+// used by all packet threads when event filters are shared
+static std::mutex thd_shared_mutex;
+static THD_STRUCT* thd_shared = nullptr;
+static unsigned thd_shared_users = 0;
+
 static THREAD_LOCAL int thd_checked = 0; // per packet
 static THREAD_LOCAL int thd_answer = 0;  // per packet
 
@@ -68,6 +75,7 @@ ThresholdConfig* ThresholdConfigNew()
     tc->thd_objs = sfthd_objs_new();
     tc->memcap = 1024 * 1024;
     tc->enabled = 1;
+    tc->shared = false;
 
     return tc;
 }
@@ -88,21 +96,44 @@ void ThresholdConfigFree(ThresholdConfig* tc)
 
 void sfthreshold_free()
 {
-    if (thd_runtime != nullptr)
+    if (thd_runtime == nullptr)
+        return;
+
+    if (thd_runtime == thd_shared)
+    {
+        std::lock_guard<std::mutex> lock(thd_shared_mutex);
+
+        if ( !--thd_shared_users )
+        {
+            sfthd_free(thd_shared);
+            thd_shared = nullptr;
+        }
+    }
+    else
         sfthd_free(thd_runtime);
 
     thd_runtime = nullptr;
 }
 
-int sfthreshold_alloc(unsigned int l_memcap, unsigned int g_memcap)
+int sfthreshold_alloc(unsigned int l_memcap, unsigned int g_memcap, bool shared)
 {
-    if (thd_runtime == nullptr)
+    if (thd_runtime != nullptr)
+        return 0;
+
+    if (shared)
     {
-        thd_runtime = sfthd_new(l_memcap, g_memcap);
-        if (thd_runtime == nullptr)
-            return -1;
+        std::lock_guard<std::mutex> lock(thd_shared_mutex);
+
+        if (thd_shared == nullptr)
+            thd_shared = sfthd_new(l_memcap, g_memcap, true);
+
+        thd_shared_users++;
+        thd_runtime = thd_shared;
     }
-    return 0;
+    else
+        thd_runtime = sfthd_new(l_memcap, g_memcap);
+
+    return thd_runtime ? 0 : -1;
 }
 
 
@@ -35,6 +35,7 @@ struct ThresholdConfig
     ThresholdObjects* thd_objs;
     unsigned memcap;
     int enabled;
+    bool shared;
 };
 
 ThresholdConfig* ThresholdConfigNew();
@@ -46,6 +47,6 @@ int sfthreshold_test(
     PolicyId);
 void sfthreshold_free();
 
-int sfthreshold_alloc(unsigned int l_memcap, unsigned int g_memcap);
+int sfthreshold_alloc(unsigned int l_memcap, unsigned int g_memcap, bool shared = false);
 
 #endif
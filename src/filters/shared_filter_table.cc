@@ -0,0 +1,170 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// shared_filter_table.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "shared_filter_table.h"
+
+#include <cassert>
+#include <cstring>
+
+SharedFilterTable::SharedFilterTable(unsigned memcap, unsigned key_size)
+{
+    assert(key_size <= max_key);
+    key_bytes = key_size;
+    key_words = (key_size + 7) / 8;
+
+    // a power of 2 so the index is just masked
+    num_slots = 16;
+
+    while ( num_slots * 2 * sizeof(Slot) <= memcap )
+        num_slots *= 2;
+
+    slots = new Slot[num_slots]();
+}
+
+SharedFilterTable::~SharedFilterTable()
+{ delete[] slots; }
+
+// the key words are read while another thread may be replacing them so
+// the sequence is checked again after reading them
+bool SharedFilterTable::matches(const Slot& s, uint32_t seq, const uint64_t* key) const
+{
+    for ( unsigned i = 0; i < key_words; ++i )
+    {
+        if ( s.key[i].load(std::memory_order_relaxed) != key[i] )
+            return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return get_seq(s.tag.load(std::memory_order_relaxed)) == seq;
+}
+
+// the slot may have been replaced since it matched; once pinned with the
+// same sequence it can't be until the pin is released
+SharedFilterTable::Ref SharedFilterTable::pin(Slot& s, uint32_t seq)
+{
+    uint32_t tag = s.tag.fetch_add(1, std::memory_order_acquire);
+
+    if ( get_seq(tag) != seq )
+    {
+        s.tag.fetch_sub(1, std::memory_order_release);
+        return Ref();
+    }
+    return Ref(&s.tag, s.state);
+}
+
+// fails if another thread keyed the slot or has it pinned
+SharedFilterTable::Ref SharedFilterTable::claim(
+    Slot& s, uint32_t seq, const uint64_t* key, uint32_t now)
+{
+    uint32_t tag = seq << seq_shift;
+    uint32_t odd = (seq + 1) & pin_mask;
+
+    if ( !s.tag.compare_exchange_strong(tag, odd << seq_shift, std::memory_order_acquire) )
+        return Ref();
+
+    for ( unsigned i = 0; i < key_words; ++i )
+        s.key[i].store(key[i], std::memory_order_relaxed);
+
+    for ( auto& w : s.state )
+        w.store(0, std::memory_order_relaxed);
+
+    s.touched.store(now, std::memory_order_relaxed);
+
+    // other threads may pin the slot while it is keyed and fail, so this
+    // adds to the tag instead of storing it, skipping 0 when it wraps
+    uint32_t next = (odd + 1) & pin_mask;
+
+    if ( !next )
+        next = 2;
+
+    uint32_t step = ((next - odd) & pin_mask) << seq_shift;
+    s.tag.fetch_add(step + 1, std::memory_order_release);
+
+    return Ref(&s.tag, s.state);
+}
+
+SharedFilterTable::Ref SharedFilterTable::find_else_create(const void* k, uint32_t now)
+{
+    uint64_t key[max_key / 8] = { };
+    memcpy(key, k, key_bytes);
+
+    uint64_t h = 0;
+
+    for ( unsigned i = 0; i < key_words; ++i )
+        h = (h ^ key[i]) * 0x9e3779b97f4a7c15;
+
+    unsigned idx = (unsigned)(h >> 32);
+    Slot* victim = nullptr;
+    uint32_t victim_seq = 0;
+
+    for ( unsigned n = 0; n < max_probe; ++n )
+    {
+        Slot& s = slots[(idx + n) & (num_slots - 1)];
+        uint32_t tag = s.tag.load(std::memory_order_acquire);
+
+        if ( !tag )
+        {
+            if ( Ref ref = claim(s, 0, key, now) )
+                return ref;
+
+            tag = s.tag.load(std::memory_order_acquire);
+        }
+
+        // another thread is keying this slot, possibly with this key, which
+        // only takes a few stores unless that thread was preempted; rather
+        // than wait on it or add the key twice the lookup fails
+        for ( unsigned spin = 0; get_seq(tag) & 1; ++spin )
+        {
+            if ( spin == max_spin )
+                return Ref();
+
+            tag = s.tag.load(std::memory_order_acquire);
+        }
+
+        uint32_t seq = get_seq(tag);
+
+        if ( matches(s, seq, key) )
+        {
+            Ref ref = pin(s, seq);
+
+            if ( ref and s.touched.load(std::memory_order_relaxed) != now )
+                s.touched.store(now, std::memory_order_relaxed);
+
+            return ref;
+        }
+
+        // slots in use by other threads can't be replaced
+        if ( tag & pin_mask )
+            continue;
+
+        uint32_t t = s.touched.load(std::memory_order_relaxed);
+
+        if ( t < now and (!victim or t < victim->touched.load(std::memory_order_relaxed)) )
+        {
+            victim = &s;
+            victim_seq = seq;
+        }
+    }
+
+    return victim ? claim(*victim, victim_seq, key, now) : Ref();
+}
+
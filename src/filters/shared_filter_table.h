@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// shared_filter_table.h author Cisco
+
+#ifndef SHARED_FILTER_TABLE_H
+#define SHARED_FILTER_TABLE_H
+
+// Fixed size hash table of event and rate filter tracking state which is
+// shared by all packet threads instead of one XHash per thread, so filters
+// count the events of all threads and the memcap is not multiplied by the
+// number of threads.
+//
+// The hot path takes no locks.  Each entry is a few 64 bit words which the
+// filters update with compare and swap.  Keys are added to empty slots or
+// replace the least recently used of the probed slots which was not used
+// in the current second, with a sequence count so a lookup never matches a
+// key while it is being replaced.  If all probed slots were used in the
+// current second the lookup fails, like an XHash that is out of memory.
+//
+// A lookup returns a Ref which pins the slot until it is released, and a
+// pinned slot is never replaced, so the state words can't be given to
+// another key while a thread is still updating them.  Lookups which would
+// otherwise wait on another thread, for a key being added or a slot being
+// replaced, fail instead and are counted as out of memory.
+
+#include <atomic>
+#include <cstdint>
+
+class SharedFilterTable
+{
+public:
+    static constexpr unsigned max_key = 32;
+    static constexpr unsigned max_probe = 8;
+    static constexpr unsigned num_words = 3;
+
+    // pins a slot while its state words are in use
+    class Ref
+    {
+    public:
+        Ref() = default;
+        Ref(const Ref&) = delete;
+        Ref& operator=(const Ref&) = delete;
+
+        Ref(Ref&& r) noexcept : tag(r.tag), words(r.words)
+        { r.tag = nullptr; r.words = nullptr; }
+
+        ~Ref()
+        {
+            if ( tag )
+                tag->fetch_sub(1, std::memory_order_release);
+        }
+
+        explicit operator bool() const
+        { return words != nullptr; }
+
+        std::atomic<uint64_t>* state() const
+        { return words; }
+
+    private:
+        friend class SharedFilterTable;
+
+        Ref(std::atomic<uint32_t>* t, std::atomic<uint64_t>* w) : tag(t), words(w)
+        { }
+
+        std::atomic<uint32_t>* tag = nullptr;
+        std::atomic<uint64_t>* words = nullptr;
+    };
+
+    SharedFilterTable(unsigned memcap, unsigned key_size);
+    ~SharedFilterTable();
+
+    // the state words of key, zeroed when it is added
+    // empty if it could not be found or added
+    Ref find_else_create(const void* key, uint32_t now);
+
+    unsigned get_num_slots() const
+    { return num_slots; }
+
+private:
+    // the tag is the sequence in the upper half and the number of pins in
+    // the lower half; the sequence is 0 when empty, odd while keying, and
+    // is never 0 again once keyed.  a slot is keyed at most once a second
+    // so it takes hours for the sequence to wrap.
+    static constexpr unsigned seq_shift = 16;
+    static constexpr uint32_t pin_mask = (1u << seq_shift) - 1;
+
+    // reads of a slot being keyed before giving up
+    static constexpr unsigned max_spin = 64;
+
+    struct Slot
+    {
+        std::atomic<uint32_t> tag;
+        std::atomic<uint32_t> touched;  // time of last use
+        std::atomic<uint64_t> key[max_key / 8];
+        std::atomic<uint64_t> state[num_words];
+    };
+
+    static uint32_t get_seq(uint32_t tag)
+    { return tag >> seq_shift; }
+
+    bool matches(const Slot&, uint32_t seq, const uint64_t* key) const;
+    Ref pin(Slot&, uint32_t seq);
+    Ref claim(Slot&, uint32_t seq, const uint64_t* key, uint32_t now);
+
+    Slot* slots;
+    unsigned num_slots;
+    unsigned key_bytes;
+    unsigned key_words;
+};
+
+#endif
+
@@ -172,6 +172,11 @@ void DataBus::publish(unsigned pid, unsigned eid, DataEvent& e, Flow* f)
     pi->dbus._publish(pid, eid, e, f);
 }
 
+bool DataBus::has_global_subscriber(unsigned pid, unsigned eid)
+{
+    return SnortConfig::get_conf()->global_dbus->_has_subscriber(pid, eid);
+}
+
 void DataBus::publish(unsigned pid, unsigned eid, const uint8_t* buf, unsigned len, Flow* f)
 {
     BufferEvent e(buf, len);
@@ -253,3 +258,9 @@ void DataBus::_publish(unsigned pid, unsigned eid, DataEvent& e, Flow* f) const
         h->handle(e, f);
 }
 
+bool DataBus::_has_subscriber(unsigned pid, unsigned eid) const
+{
+    unsigned idx = pid + eid;
+    return idx < pub_sub.size() and !pub_sub[idx].empty();
+}
+
@@ -125,11 +125,15 @@ public:
     static void publish(unsigned pub_id, unsigned evt_id, const uint8_t*, unsigned, Flow* = nullptr);
     static void publish(unsigned pub_id, unsigned evt_id, Packet*, Flow* = nullptr);
 
+    // lets publishers skip building events nobody gets
+    static bool has_global_subscriber(unsigned pub_id, unsigned evt_id);
+
 private:
     void _subscribe(unsigned pub_id, unsigned evt_id, DataHandler*);
     void _subscribe(const PubKey&, unsigned evt_id, DataHandler*);
     void _unsubscribe(const PubKey&, unsigned evt_id, const DataHandler*);
     void _publish(unsigned pub_id, unsigned evt_id, DataEvent&, Flow*) const;
+    bool _has_subscriber(unsigned pub_id, unsigned evt_id) const;
 
 private:
     typedef std::vector<DataHandler*> SubList;
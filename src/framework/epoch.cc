@@ -0,0 +1,161 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// epoch.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "epoch.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "main/thread.h"
+#include "main/thread_config.h"
+
+using namespace snort;
+
+namespace
+{
+// the epoch a packet thread last saw at a quiescent point, padded to a cache
+// line since it is written by its thread and read by the main thread
+struct ThreadEpoch
+{
+    std::atomic<uint64_t> seen { offline };
+    char pad[64 - sizeof(std::atomic<uint64_t>)];
+
+    static constexpr uint64_t offline = UINT64_MAX;
+};
+
+struct Retired
+{
+    uint64_t epoch;
+    std::function<void()> free;
+};
+}
+
+static std::atomic<uint64_t> global_epoch { 1 };
+
+static ThreadEpoch* thread_epochs = nullptr;
+static unsigned num_threads = 0;
+
+static std::mutex retired_mutex;
+static std::deque<Retired> retired;
+
+static ThreadEpoch* get_thread_epoch()
+{
+    unsigned id = get_instance_id();
+    return id < num_threads ? &thread_epochs[id] : nullptr;
+}
+
+void Epoch::init()
+{
+    assert(!thread_epochs);
+    num_threads = ThreadConfig::get_instance_max();
+    thread_epochs = new ThreadEpoch[num_threads];
+}
+
+void Epoch::term()
+{
+    std::deque<Retired> all;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex);
+        all.swap(retired);
+    }
+
+    for ( auto& r : all )
+        r.free();
+
+    delete[] thread_epochs;
+    thread_epochs = nullptr;
+    num_threads = 0;
+}
+
+void Epoch::thread_init()
+{
+    if ( ThreadEpoch* te = get_thread_epoch() )
+        te->seen.store(global_epoch.load());
+}
+
+// an offline thread references nothing and never holds up reclamation
+void Epoch::thread_term()
+{
+    if ( ThreadEpoch* te = get_thread_epoch() )
+        te->seen.store(ThreadEpoch::offline);
+}
+
+void Epoch::quiescent()
+{
+    ThreadEpoch* te = get_thread_epoch();
+
+    if ( !te )
+        return;
+
+    uint64_t e = global_epoch.load(std::memory_order_acquire);
+
+    // only write when something was retired since the last time
+    if ( te->seen.load(std::memory_order_relaxed) != e )
+        te->seen.store(e, std::memory_order_release);
+}
+
+// the retired version is only reachable by threads which have not seen the
+// epoch that follows its retirement
+void Epoch::retire(const std::function<void()>& free)
+{
+    std::lock_guard<std::mutex> lock(retired_mutex);
+    retired.push_back({ global_epoch.fetch_add(1), free });
+}
+
+void Epoch::reclaim()
+{
+    uint64_t oldest = ThreadEpoch::offline;
+
+    for ( unsigned i = 0; i < num_threads; ++i )
+    {
+        uint64_t e = thread_epochs[i].seen.load(std::memory_order_acquire);
+
+        if ( e < oldest )
+            oldest = e;
+    }
+
+    std::deque<Retired> done;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex);
+
+        while ( !retired.empty() and retired.front().epoch < oldest )
+        {
+            done.emplace_back(std::move(retired.front()));
+            retired.pop_front();
+        }
+    }
+
+    for ( auto& r : done )
+        r.free();
+}
+
+unsigned Epoch::pending()
+{
+    std::lock_guard<std::mutex> lock(retired_mutex);
+    return retired.size();
+}
+
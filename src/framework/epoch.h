@@ -0,0 +1,66 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// epoch.h author Cisco
+
+#ifndef EPOCH_H
+#define EPOCH_H
+
+// Epoch based reclamation for data which is read by the packet threads
+// without locks.  A writer publishes a new version with an atomic pointer
+// store and retires the old version instead of deleting it.  The packet
+// threads pass through a quiescent point between message batches, when they
+// hold no references to shared data, and a retired version is freed by the
+// main thread once every packet thread has passed a quiescent point since it
+// was retired.
+//
+// Readers must not keep pointers to retired data past a quiescent point, so
+// eg nothing obtained from such data may be stored on a flow.
+
+#include <functional>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+class SO_PUBLIC Epoch
+{
+public:
+    // main thread, before and after the packet threads run
+    static void init();
+    static void term();
+
+    // packet threads
+    static void thread_init();
+    static void thread_term();
+    static void quiescent();
+
+    // any thread, after the replacement is published
+    static void retire(const std::function<void()>&);
+
+    template <typename T>
+    static void retire(T* p)
+    { retire([p]() { delete p; }); }
+
+    // main thread, frees what no packet thread can reference any more
+    static void reclaim();
+    static unsigned pending();
+};
+}
+
+#endif
+
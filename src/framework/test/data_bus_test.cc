@@ -157,6 +157,18 @@ TEST(data_bus, subscribe_global)
     CHECK(200 == h.evt_msg); // unsubscribed!
 }
 
+TEST(data_bus, has_global_subscriber)
+{
+    CHECK_FALSE(DataBus::has_global_subscriber(pub_id, DbUtIds::EVENT));
+
+    UTestHandler h;
+    DataBus::subscribe_global(pub_key, DbUtIds::EVENT, &h, *snort_conf);
+    CHECK_TRUE(DataBus::has_global_subscriber(pub_id, DbUtIds::EVENT));
+
+    DataBus::unsubscribe_global(pub_key, DbUtIds::EVENT, &h, *snort_conf);
+    CHECK_FALSE(DataBus::has_global_subscriber(pub_id, DbUtIds::EVENT));
+}
+
 TEST(data_bus, subscribe_network)
 {
     UTestHandler* h = new UTestHandler();
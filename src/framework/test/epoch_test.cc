@@ -0,0 +1,176 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2019-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// epoch_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "framework/epoch.h"
+#include "main/thread.h"
+#include "main/thread_config.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// mocks
+//--------------------------------------------------------------------------
+// the packet threads are simulated by switching the instance id
+static unsigned s_instance = 0;
+
+namespace snort
+{
+unsigned get_instance_id()
+{ return s_instance; }
+}
+
+unsigned ThreadConfig::get_instance_max()
+{ return 3; }
+
+//--------------------------------------------------------------------------
+struct Data
+{
+    Data(unsigned& n) : freed(n) { }
+    ~Data()
+    { ++freed; }
+
+    unsigned& freed;
+};
+
+static void run_thread(unsigned id, void (*f)())
+{
+    s_instance = id;
+    f();
+}
+
+static void start_threads()
+{
+    for ( unsigned i = 0; i < ThreadConfig::get_instance_max(); ++i )
+        run_thread(i, Epoch::thread_init);
+}
+
+static void stop_threads()
+{
+    for ( unsigned i = 0; i < ThreadConfig::get_instance_max(); ++i )
+        run_thread(i, Epoch::thread_term);
+}
+
+TEST_GROUP(epoch)
+{
+    void setup() override
+    { Epoch::init(); }
+
+    void teardown() override
+    { Epoch::term(); }
+};
+
+TEST(epoch, reclaim_after_all_quiescent)
+{
+    unsigned freed = 0;
+    start_threads();
+
+    Epoch::retire(new Data(freed));
+    Epoch::reclaim();
+    CHECK(1 == Epoch::pending());
+
+    run_thread(0, Epoch::quiescent);
+    run_thread(1, Epoch::quiescent);
+    Epoch::reclaim();
+    CHECK(0 == freed);
+
+    run_thread(2, Epoch::quiescent);
+    Epoch::reclaim();
+    CHECK(1 == freed);
+    CHECK(0 == Epoch::pending());
+
+    stop_threads();
+}
+
+TEST(epoch, reclaim_in_order)
+{
+    unsigned freed = 0;
+    start_threads();
+
+    Epoch::retire(new Data(freed));
+    run_thread(0, Epoch::quiescent);
+    run_thread(1, Epoch::quiescent);
+    run_thread(2, Epoch::quiescent);
+
+    // the second version is retired after the threads moved on
+    Epoch::retire(new Data(freed));
+    Epoch::reclaim();
+    CHECK(1 == freed);
+    CHECK(1 == Epoch::pending());
+
+    run_thread(0, Epoch::quiescent);
+    run_thread(1, Epoch::quiescent);
+    run_thread(2, Epoch::quiescent);
+    Epoch::reclaim();
+    CHECK(2 == freed);
+
+    stop_threads();
+}
+
+TEST(epoch, offline_threads_do_not_block)
+{
+    unsigned freed = 0;
+    start_threads();
+    run_thread(2, Epoch::thread_term);
+
+    Epoch::retire(new Data(freed));
+    run_thread(0, Epoch::quiescent);
+    run_thread(1, Epoch::quiescent);
+    Epoch::reclaim();
+    CHECK(1 == freed);
+
+    run_thread(0, Epoch::thread_term);
+    run_thread(1, Epoch::thread_term);
+
+    Epoch::retire(new Data(freed));
+    Epoch::reclaim();
+    CHECK(2 == freed);
+}
+
+TEST(epoch, term_frees_pending)
+{
+    unsigned freed = 0;
+    start_threads();
+
+    Epoch::retire(new Data(freed));
+    Epoch::retire([&freed]() { ++freed; });
+    CHECK(2 == Epoch::pending());
+
+    stop_threads();
+    Epoch::term();
+    CHECK(2 == freed);
+
+    // for teardown
+    Epoch::init();
+}
+
+//-------------------------------------------------------------------------
+// main
+//-------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
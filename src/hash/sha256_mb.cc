@@ -0,0 +1,424 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sha256_mb.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "sha256_mb.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SHA256_MB_AVX2
+#include <cpuid.h>
+#include <immintrin.h>
+
+#ifndef bit_SHA
+#define bit_SHA (1 << 29)
+#endif
+#endif
+
+namespace snort
+{
+//--------------------------------------------------------------------------
+// lanes
+//--------------------------------------------------------------------------
+
+// progress of a single message through a batch
+struct Sha256Lane
+{
+    SHA256_CTX* ctx;
+    const uint8_t* data;    // next full block of the input
+    size_t blocks;          // full blocks left in the input
+    const uint8_t* tail;    // bytes left for the context buffer
+    size_t tail_size;
+    bool buffered;          // the context buffer is a full block to compress first
+
+    bool has_work() const
+    { return buffered or blocks; }
+};
+
+// mirrors the length and buffer handling of SHA256_Update
+static void lane_start(Sha256Lane& lane, SHA256_CTX* ctx, const uint8_t* data, size_t size)
+{
+    SHA_LONG bits = ctx->Nl + (((SHA_LONG)size) << 3);
+
+    if (bits < ctx->Nl)
+        ctx->Nh++;
+
+    ctx->Nh += (SHA_LONG)(size >> 29);
+    ctx->Nl = bits;
+
+    lane.ctx = ctx;
+    lane.buffered = false;
+
+    if (ctx->num)
+    {
+        uint8_t* buf = (uint8_t*)ctx->data;
+        size_t n = std::min(size, (size_t)(SHA256_CBLOCK - ctx->num));
+
+        memcpy(buf + ctx->num, data, n);
+        ctx->num += n;
+        data += n;
+        size -= n;
+
+        if (ctx->num == SHA256_CBLOCK)
+        {
+            lane.buffered = true;
+            ctx->num = 0;
+        }
+    }
+
+    lane.data = data;
+    lane.blocks = size / SHA256_CBLOCK;
+    lane.tail = data + lane.blocks * SHA256_CBLOCK;
+    lane.tail_size = size % SHA256_CBLOCK;
+}
+
+static void lane_finish(Sha256Lane& lane)
+{
+    if (lane.tail_size)
+    {
+        memcpy(lane.ctx->data, lane.tail, lane.tail_size);
+        lane.ctx->num = lane.tail_size;
+    }
+}
+
+//--------------------------------------------------------------------------
+// vector compression
+//--------------------------------------------------------------------------
+
+#ifdef SHA256_MB_AVX2
+
+static const uint32_t sha256_k[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+
+#define BSIG0(x) XOR3(ROTR(x, 2), ROTR(x, 13), ROTR(x, 22))
+#define BSIG1(x) XOR3(ROTR(x, 6), ROTR(x, 11), ROTR(x, 25))
+#define SSIG0(x) XOR3(ROTR(x, 7), ROTR(x, 18), _mm256_srli_epi32(x, 3))
+#define SSIG1(x) XOR3(ROTR(x, 17), ROTR(x, 19), _mm256_srli_epi32(x, 10))
+
+#define CH(x, y, z) _mm256_xor_si256(_mm256_and_si256(x, y), _mm256_andnot_si256(x, z))
+#define MAJ(x, y, z) _mm256_or_si256(_mm256_and_si256(x, y), \
+    _mm256_and_si256(z, _mm256_or_si256(x, y)))
+
+static inline uint32_t load_be32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return __builtin_bswap32(v);
+}
+
+// compress count consecutive blocks of each of n <= 8 messages,
+// unused lanes compute garbage which is never stored
+__attribute__((target("avx2")))
+static void sha256_x8_avx2(SHA256_CTX* ctx[], const uint8_t* block[], unsigned n, size_t count)
+{
+    alignas(32) uint32_t v[SHA256_MB_MAX_LANES] = { };
+    __m256i s[8];
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        for (unsigned j = 0; j < n; ++j)
+            v[j] = ctx[j]->h[i];
+
+        s[i] = _mm256_load_si256((const __m256i*)v);
+    }
+
+    for (size_t b = 0; b < count; ++b)
+    {
+        __m256i w[64];
+
+        for (unsigned t = 0; t < 16; ++t)
+        {
+            for (unsigned j = 0; j < n; ++j)
+                v[j] = load_be32(block[j] + b * SHA256_CBLOCK + t * 4);
+
+            w[t] = _mm256_load_si256((const __m256i*)v);
+        }
+
+        for (unsigned t = 16; t < 64; ++t)
+            w[t] = _mm256_add_epi32(_mm256_add_epi32(SSIG1(w[t - 2]), w[t - 7]),
+                _mm256_add_epi32(SSIG0(w[t - 15]), w[t - 16]));
+
+        __m256i a = s[0], bb = s[1], c = s[2], d = s[3];
+        __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+
+        for (unsigned t = 0; t < 64; ++t)
+        {
+            __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, BSIG1(e)),
+                _mm256_add_epi32(CH(e, f, g),
+                _mm256_add_epi32(_mm256_set1_epi32(sha256_k[t]), w[t])));
+            __m256i t2 = _mm256_add_epi32(BSIG0(a), MAJ(a, bb, c));
+
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c;
+            c = bb;
+            bb = a;
+            a = _mm256_add_epi32(t1, t2);
+        }
+
+        s[0] = _mm256_add_epi32(s[0], a);
+        s[1] = _mm256_add_epi32(s[1], bb);
+        s[2] = _mm256_add_epi32(s[2], c);
+        s[3] = _mm256_add_epi32(s[3], d);
+        s[4] = _mm256_add_epi32(s[4], e);
+        s[5] = _mm256_add_epi32(s[5], f);
+        s[6] = _mm256_add_epi32(s[6], g);
+        s[7] = _mm256_add_epi32(s[7], h);
+    }
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        _mm256_store_si256((__m256i*)v, s[i]);
+
+        for (unsigned j = 0; j < n; ++j)
+            ctx[j]->h[i] = v[j];
+    }
+}
+
+#define ROTR16(x, n) _mm512_ror_epi32(x, n)
+// 0x96: x ^ y ^ z, 0xca: x ? y : z, 0xe8: majority
+#define XOR3_16(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+
+#define BSIG0_16(x) XOR3_16(ROTR16(x, 2), ROTR16(x, 13), ROTR16(x, 22))
+#define BSIG1_16(x) XOR3_16(ROTR16(x, 6), ROTR16(x, 11), ROTR16(x, 25))
+#define SSIG0_16(x) XOR3_16(ROTR16(x, 7), ROTR16(x, 18), _mm512_srli_epi32(x, 3))
+#define SSIG1_16(x) XOR3_16(ROTR16(x, 17), ROTR16(x, 19), _mm512_srli_epi32(x, 10))
+
+#define CH16(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xca)
+#define MAJ16(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xe8)
+
+// same as sha256_x8_avx2 for n <= 16 messages
+__attribute__((target("avx512f")))
+static void sha256_x16_avx512(SHA256_CTX* ctx[], const uint8_t* block[], unsigned n, size_t count)
+{
+    alignas(64) uint32_t v[SHA256_MB_MAX_LANES] = { };
+    __m512i s[8];
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        for (unsigned j = 0; j < n; ++j)
+            v[j] = ctx[j]->h[i];
+
+        s[i] = _mm512_load_si512((const void*)v);
+    }
+
+    for (size_t b = 0; b < count; ++b)
+    {
+        __m512i w[64];
+
+        for (unsigned t = 0; t < 16; ++t)
+        {
+            for (unsigned j = 0; j < n; ++j)
+                v[j] = load_be32(block[j] + b * SHA256_CBLOCK + t * 4);
+
+            w[t] = _mm512_load_si512((const void*)v);
+        }
+
+        for (unsigned t = 16; t < 64; ++t)
+            w[t] = _mm512_add_epi32(_mm512_add_epi32(SSIG1_16(w[t - 2]), w[t - 7]),
+                _mm512_add_epi32(SSIG0_16(w[t - 15]), w[t - 16]));
+
+        __m512i a = s[0], bb = s[1], c = s[2], d = s[3];
+        __m512i e = s[4], f = s[5], g = s[6], h = s[7];
+
+        for (unsigned t = 0; t < 64; ++t)
+        {
+            __m512i t1 = _mm512_add_epi32(_mm512_add_epi32(h, BSIG1_16(e)),
+                _mm512_add_epi32(CH16(e, f, g),
+                _mm512_add_epi32(_mm512_set1_epi32(sha256_k[t]), w[t])));
+            __m512i t2 = _mm512_add_epi32(BSIG0_16(a), MAJ16(a, bb, c));
+
+            h = g;
+            g = f;
+            f = e;
+            e = _mm512_add_epi32(d, t1);
+            d = c;
+            c = bb;
+            bb = a;
+            a = _mm512_add_epi32(t1, t2);
+        }
+
+        s[0] = _mm512_add_epi32(s[0], a);
+        s[1] = _mm512_add_epi32(s[1], bb);
+        s[2] = _mm512_add_epi32(s[2], c);
+        s[3] = _mm512_add_epi32(s[3], d);
+        s[4] = _mm512_add_epi32(s[4], e);
+        s[5] = _mm512_add_epi32(s[5], f);
+        s[6] = _mm512_add_epi32(s[6], g);
+        s[7] = _mm512_add_epi32(s[7], h);
+    }
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        _mm512_store_si512((void*)v, s[i]);
+
+        for (unsigned j = 0; j < n; ++j)
+            ctx[j]->h[i] = v[j];
+    }
+}
+
+// AVX2 lanes are slower than a single message with SHA extensions
+static unsigned get_vector_lanes()
+{
+    if (__builtin_cpu_supports("avx512f"))
+        return 16;
+
+    if (!__builtin_cpu_supports("avx2"))
+        return 1;
+
+    unsigned eax, ebx, ecx, edx;
+
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) and (ebx & bit_SHA))
+        return 1;
+
+    return 8;
+}
+
+static unsigned vector_lanes()
+{
+    static const unsigned lanes = get_vector_lanes();
+    return lanes;
+}
+
+#else
+
+static unsigned vector_lanes()
+{ return 1; }
+
+#endif
+
+//--------------------------------------------------------------------------
+// batch
+//--------------------------------------------------------------------------
+
+static void update_lanes(Sha256Lane* lanes, unsigned count)
+{
+    while (true)
+    {
+        SHA256_CTX* ctx[SHA256_MB_MAX_LANES];
+        const uint8_t* block[SHA256_MB_MAX_LANES];
+        bool buffered = false;
+        size_t blocks = SIZE_MAX;
+        unsigned n = 0;
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            Sha256Lane& lane = lanes[i];
+
+            if (!lane.has_work())
+                continue;
+
+            ctx[n] = lane.ctx;
+            block[n++] = lane.buffered ? (const uint8_t*)lane.ctx->data : lane.data;
+            buffered = buffered or lane.buffered;
+            blocks = std::min(blocks, lane.blocks);
+        }
+
+        if (!n)
+            break;
+
+        // a buffered block is not followed by the input, it goes alone
+        if (buffered)
+            blocks = 1;
+
+#ifdef SHA256_MB_AVX2
+        if (n > 1 and vector_lanes() == 16)
+            sha256_x16_avx512(ctx, block, n, blocks);
+        else if (n > 1 and vector_lanes() == 8)
+        {
+            for (unsigned j = 0; j < n; j += 8)
+                sha256_x8_avx2(ctx + j, block + j, std::min(n - j, 8u), blocks);
+        }
+        else
+#endif
+        {
+            for (unsigned j = 0; j < n; ++j)
+                for (size_t b = 0; b < blocks; ++b)
+                    SHA256_Transform(ctx[j], block[j] + b * SHA256_CBLOCK);
+        }
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            Sha256Lane& lane = lanes[i];
+
+            if (!lane.has_work())
+                continue;
+
+            if (lane.buffered)
+            {
+                lane.buffered = false;
+                continue;
+            }
+
+            lane.data += blocks * SHA256_CBLOCK;
+            lane.blocks -= blocks;
+        }
+    }
+}
+
+unsigned sha256_mb_lanes()
+{
+    return vector_lanes();
+}
+
+void sha256_mb_update(SHA256_CTX* ctx[], const uint8_t* data[], const size_t size[],
+    unsigned count)
+{
+    if (vector_lanes() == 1)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            SHA256_Update(ctx[i], data[i], size[i]);
+
+        return;
+    }
+
+    for (unsigned first = 0; first < count; first += SHA256_MB_MAX_LANES)
+    {
+        Sha256Lane lanes[SHA256_MB_MAX_LANES];
+        unsigned n = std::min(count - first, (unsigned)SHA256_MB_MAX_LANES);
+
+        for (unsigned i = 0; i < n; ++i)
+            lane_start(lanes[i], ctx[first + i], data[first + i], size[first + i]);
+
+        update_lanes(lanes, n);
+
+        for (unsigned i = 0; i < n; ++i)
+            lane_finish(lanes[i]);
+    }
+}
+}
@@ -0,0 +1,48 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sha256_mb.h author Cisco
+
+#ifndef SHA256_MB_H
+#define SHA256_MB_H
+
+// Multi-buffer SHA-256: update several independent SHA-256 contexts at once.
+// Blocks of different messages are compressed side by side, one message
+// per 32-bit vector lane, so the throughput scales with the vector width
+// instead of being bound by the latency of a single message's rounds.
+// Contexts are regular OpenSSL contexts, they can be initialized, updated
+// and finalized with SHA256_* functions before and after a batch.
+
+#include <openssl/sha.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+#define SHA256_MB_MAX_LANES 16
+
+// number of messages compressed at once on this CPU, 1 without vector support
+SO_PUBLIC unsigned sha256_mb_lanes();
+
+// same as SHA256_Update on each context, count is not limited by the lanes
+SO_PUBLIC void sha256_mb_update(SHA256_CTX* ctx[], const uint8_t* data[],
+    const size_t size[], unsigned count);
+}
+#endif
@@ -0,0 +1,135 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sha256_mb_benchmark.cc author Cisco
+// files per second of the multi-buffer SHA-256 against one file at a time
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "hash/sha256_mb.h"
+
+using namespace snort;
+
+// signature depth is 10 MiB, typical mail attachments are much smaller
+static const size_t file_sizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024 };
+
+// files are transferred in chunks of this size
+#define CHUNK_SIZE 16384
+
+// files hashed per iteration, several batches of lanes
+#define FILES (4 * SHA256_MB_MAX_LANES)
+
+static std::vector<uint8_t> make_file(size_t size, unsigned seed)
+{
+    std::vector<uint8_t> file(size);
+
+    for (size_t i = 0; i < size; ++i)
+        file[i] = (uint8_t)(seed * 131 + i);
+
+    return file;
+}
+
+static void hash_single(const std::vector<std::vector<uint8_t>>& files, uint8_t* digests)
+{
+    for (unsigned f = 0; f < files.size(); ++f)
+    {
+        SHA256_CTX ctx;
+        SHA256_Init(&ctx);
+
+        for (size_t off = 0; off < files[f].size(); off += CHUNK_SIZE)
+            SHA256_Update(&ctx, files[f].data() + off, std::min((size_t)CHUNK_SIZE, files[f].size() - off));
+
+        SHA256_Final(digests + f * SHA256_DIGEST_LENGTH, &ctx);
+    }
+}
+
+static void hash_multi(const std::vector<std::vector<uint8_t>>& files, uint8_t* digests)
+{
+    const unsigned lanes = sha256_mb_lanes();
+
+    for (unsigned first = 0; first < files.size(); first += lanes)
+    {
+        unsigned count = std::min((unsigned)files.size() - first, lanes);
+        SHA256_CTX ctxs[SHA256_MB_MAX_LANES];
+        SHA256_CTX* ctx[SHA256_MB_MAX_LANES];
+        const uint8_t* data[SHA256_MB_MAX_LANES];
+        size_t size[SHA256_MB_MAX_LANES];
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            SHA256_Init(&ctxs[i]);
+            ctx[i] = &ctxs[i];
+        }
+
+        for (size_t off = 0; off < files[first].size(); off += CHUNK_SIZE)
+        {
+            for (unsigned i = 0; i < count; ++i)
+            {
+                data[i] = files[first + i].data() + off;
+                size[i] = std::min((size_t)CHUNK_SIZE, files[first + i].size() - off);
+            }
+
+            sha256_mb_update(ctx, data, size, count);
+        }
+
+        for (unsigned i = 0; i < count; ++i)
+            SHA256_Final(digests + (first + i) * SHA256_DIGEST_LENGTH, &ctxs[i]);
+    }
+}
+
+TEST_CASE("SHA-256 file signatures", "[sha256_mb]")
+{
+    uint8_t digests[FILES * SHA256_DIGEST_LENGTH];
+    uint8_t expected[FILES * SHA256_DIGEST_LENGTH];
+
+    for (auto file_size : file_sizes)
+    {
+        std::vector<std::vector<uint8_t>> files;
+
+        for (unsigned i = 0; i < FILES; ++i)
+            files.emplace_back(make_file(file_size, i));
+
+        hash_single(files, expected);
+        hash_multi(files, digests);
+        REQUIRE(memcmp(digests, expected, sizeof(digests)) == 0);
+
+        std::string size = std::to_string(file_size / 1024) + " KiB files, ";
+        std::string count = std::to_string(FILES) + " per iteration";
+
+        BENCHMARK((size + "one at a time, " + count).c_str())
+        {
+            hash_single(files, digests);
+            return digests[0];
+        };
+
+        BENCHMARK((size + std::to_string(sha256_mb_lanes()) + " lanes, " + count).c_str())
+        {
+            hash_multi(files, digests);
+            return digests[0];
+        };
+    }
+}
+
+#endif
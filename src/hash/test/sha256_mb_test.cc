@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sha256_mb_test.cc author Cisco
+// unit tests for the multi-buffer SHA-256
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <vector>
+
+#include "../sha256_mb.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+#define MAX_MESSAGES (2 * SHA256_MB_MAX_LANES + 3)
+
+static void fill(std::vector<uint8_t>& buf, size_t size, unsigned seed)
+{
+    buf.resize(size);
+
+    for (size_t i = 0; i < size; ++i)
+        buf[i] = (uint8_t)(seed + i * 31 + (i >> 8));
+}
+
+// hash count messages of different sizes in chunks of the given size
+// and compare against the single-buffer digests
+static void check_messages(unsigned count, size_t chunk)
+{
+    std::vector<uint8_t> msgs[MAX_MESSAGES];
+    SHA256_CTX ctxs[MAX_MESSAGES];
+    size_t off[MAX_MESSAGES] = { };
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        fill(msgs[i], i * 97 + (i % 3) * SHA256_CBLOCK, i);
+        SHA256_Init(&ctxs[i]);
+    }
+
+    bool more = true;
+
+    while (more)
+    {
+        SHA256_CTX* ctx[MAX_MESSAGES];
+        const uint8_t* data[MAX_MESSAGES];
+        size_t size[MAX_MESSAGES];
+
+        more = false;
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            size_t n = std::min(chunk, msgs[i].size() - off[i]);
+
+            ctx[i] = &ctxs[i];
+            data[i] = msgs[i].data() + off[i];
+            size[i] = n;
+            off[i] += n;
+            more = more or off[i] < msgs[i].size();
+        }
+
+        sha256_mb_update(ctx, data, size, count);
+    }
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        uint8_t digest[SHA256_DIGEST_LENGTH];
+        uint8_t expected[SHA256_DIGEST_LENGTH];
+
+        SHA256_Final(digest, &ctxs[i]);
+        SHA256(msgs[i].data(), msgs[i].size(), expected);
+        CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+    }
+}
+
+TEST_GROUP(sha256_mb)
+{ };
+
+TEST(sha256_mb, lane_count)
+{
+    unsigned lanes = sha256_mb_lanes();
+    CHECK(lanes == 1 or lanes == 8 or lanes == SHA256_MB_MAX_LANES);
+}
+
+TEST(sha256_mb, abc)
+{
+    static const uint8_t expected[SHA256_DIGEST_LENGTH] =
+    {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+    };
+    SHA256_CTX c1, c2;
+    SHA256_CTX* ctx[] = { &c1, &c2 };
+    const uint8_t* data[] = { (const uint8_t*)"abc", (const uint8_t*)"abc" };
+    size_t size[] = { 3, 3 };
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+
+    SHA256_Init(&c1);
+    SHA256_Init(&c2);
+    sha256_mb_update(ctx, data, size, 2);
+
+    SHA256_Final(digest, &c1);
+    CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+    SHA256_Final(digest, &c2);
+    CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+}
+
+TEST(sha256_mb, single_message)
+{
+    check_messages(1, 1000);
+}
+
+TEST(sha256_mb, whole_messages)
+{
+    check_messages(MAX_MESSAGES, SIZE_MAX);
+}
+
+TEST(sha256_mb, block_chunks)
+{
+    check_messages(SHA256_MB_MAX_LANES, SHA256_CBLOCK);
+}
+
+TEST(sha256_mb, odd_chunks)
+{
+    check_messages(MAX_MESSAGES, 37);
+    check_messages(MAX_MESSAGES, 130);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -23,6 +23,7 @@
 
 #include "hyper_scratch_allocator.h"
 #include "log/messages.h"
+#include "main/thread_config.h"
 
 namespace snort
 {
@@ -44,7 +45,10 @@ bool HyperScratchAllocator::setup(SnortConfig* sc)
         return false;
 
     for ( unsigned i = 0; i < sc->num_slots; ++i )
+    {
+        ThreadMemPlacement place(sc->thread_config, STHREAD_TYPE_PACKET, i);
         hs_clone_scratch(scratch, get_addr(sc, i));
+    }
 
     hs_free_scratch(scratch);
     scratch = nullptr;
@@ -25,6 +25,7 @@
 #include "../hyper_search.h"
 
 #include "main/snort_config.h"
+#include "main/thread_config.h"
 
 #include <algorithm>
 #include <CppUTest/CommandLineTestRunner.h>
@@ -75,6 +76,9 @@ void SnortConfig::release_scratch(int)
     s_state.shrink_to_fit();
 }
 
+ThreadMemPlacement::ThreadMemPlacement(const ThreadConfig*, SThreadType, unsigned) { }
+ThreadMemPlacement::~ThreadMemPlacement() = default;
+
 const SnortConfig* SnortConfig::get_conf()
 { return snort_conf; }
 
@@ -30,6 +30,7 @@
 #include "framework/module.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "main/thread_config.h"
 #include "ports/port_group.h"
 #include "profiler/profiler_defs.h"
 #include "protocols/packet.h"
@@ -81,6 +82,9 @@ void SnortConfig::release_scratch(int)
     s_state.shrink_to_fit();
 }
 
+ThreadMemPlacement::ThreadMemPlacement(const ThreadConfig*, SThreadType, unsigned) { }
+ThreadMemPlacement::~ThreadMemPlacement() = default;
+
 const SnortConfig* SnortConfig::get_conf()
 { return snort_conf; }
 
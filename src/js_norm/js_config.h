@@ -20,6 +20,8 @@
 #ifndef JS_CONFIG_H
 #define JS_CONFIG_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <unordered_set>
 
@@ -30,6 +32,8 @@ struct JSNormConfig
     uint8_t max_template_nesting = 32;
     uint32_t max_bracket_depth = 256;
     uint32_t max_scope_depth = 256;
+    size_t cache_memcap = 0;
+    uint32_t generation = 0;
     std::unordered_set<std::string> ignored_ids;
     std::unordered_set<std::string> ignored_props;
 };
@@ -41,6 +41,10 @@ enum PEG_COUNT
     PEG_BYTES = 0,
     PEG_IDENTIFIERS,
     PEG_IDENTIFIER_OVERFLOWS,
+    PEG_CACHE_ADDS,
+    PEG_CACHE_HITS,
+    PEG_CACHE_MISSES,
+    PEG_CACHE_PRUNES,
     PEG_COUNT_MAX
 };
 
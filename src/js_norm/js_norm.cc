@@ -23,10 +23,13 @@
 
 #include "js_norm.h"
 
+#include <cstring>
+
 #include "log/messages.h"
 #include "trace/trace_api.h"
 
 #include "js_identifier_ctx.h"
+#include "js_norm_cache.h"
 #include "js_normalizer.h"
 #include "js_norm_module.h"
 
@@ -63,7 +66,7 @@ const char* jsn::ret2str(int r)
 
 JSNorm::JSNorm(JSNormConfig* jsn_config, bool ext_script_type) :
     alive(true), pdu_cnt(0), src_ptr(nullptr), src_end(nullptr),
-    idn_ctx(nullptr), jsn_ctx(nullptr), ext_script_type(ext_script_type)
+    idn_ctx(nullptr), jsn_ctx(nullptr), ext_script_type(ext_script_type), cached_size(0)
 {
     config = jsn_config;
     alive = (bool)config;
@@ -112,12 +115,31 @@ void JSNorm::normalize(const void* in_data, size_t in_len, const void*& data, si
 
     while (alive and pre_proc())
     {
-        if (idn_ctx == nullptr)
-            idn_ctx = new JSIdentifierCtx(config->identifier_depth,
-                config->max_scope_depth, config->ignored_ids, config->ignored_props);
-        if (jsn_ctx == nullptr)
-            jsn_ctx = new JSNormalizer(*idn_ctx, config->bytes_depth,
-                config->max_template_nesting, config->max_bracket_depth);
+        // other flows would have to replay it to continue too
+        if (!added.expired())
+        {
+            JSNormCache::remove(added.lock());
+            added.reset();
+        }
+
+        if (cached)
+            replay_cached();
+        else if (jsn_ctx == nullptr and use_cached())
+        {
+            trace_logf(3, js_trace, TRACE_PROC, packet,
+                "normalized script[%zu] taken from cache\n", src_end - src_ptr);
+
+            JSNormModule::increment_peg_counts(PEG_BYTES, src_end - src_ptr);
+            src_ptr = src_end;
+
+            alive = post_proc(cached->ret);
+            continue;
+        }
+
+        // only a script normalized from the initial state can be reused by other flows
+        const bool cacheable = ext_script_type and jsn_ctx == nullptr and config->cache_memcap;
+
+        create_ctx();
         trace_logf(3, js_trace, TRACE_DUMP, packet,
             "original[%zu]: %.*s\n", src_end - src_ptr, (int)(src_end - src_ptr), src_ptr);
 
@@ -127,13 +149,27 @@ void JSNorm::normalize(const void* in_data, size_t in_len, const void*& data, si
         trace_logf(3, js_trace, TRACE_PROC, packet,
             "normalizer returned with %d '%s'\n", ret, jsn::ret2str(ret));
 
+        if (cacheable and next == src_end and
+            (ret == JSTokenizer::EOS or ret == JSTokenizer::SCRIPT_CONTINUE) and
+            !jsn_ctx->is_unescape_nesting_seen() and !jsn_ctx->is_mixed_encoding_seen() and
+            !jsn_ctx->is_opening_tag_seen() and !jsn_ctx->is_closing_tag_seen())
+        {
+            added = JSNormCache::add(*config, (const char*)src_ptr, src_end - src_ptr,
+                jsn_ctx->get_script(), jsn_ctx->script_size(), ret);
+        }
+
         JSNormModule::increment_peg_counts(PEG_BYTES, next - src_ptr);
         src_ptr = next;
 
         alive = post_proc(ret);
     }
 
-    if (jsn_ctx != nullptr)
+    if (cached)
+    {
+        len = cached_size;
+        data = cached->script.data();
+    }
+    else if (jsn_ctx != nullptr)
     {
         len = jsn_ctx->script_size();
         data = jsn_ctx->get_script();
@@ -145,7 +181,16 @@ void JSNorm::normalize(const void* in_data, size_t in_len, const void*& data, si
 
 void JSNorm::flush_data(const void*& data, size_t& len)
 {
-    if (jsn_ctx != nullptr)
+    if (cached)
+    {
+        // the caller takes ownership, hand out a copy of the shared script
+        char* script = new char[cached_size];
+        memcpy(script, cached->script.data(), cached_size);
+        len = cached_size;
+        data = script;
+        cached_size = 0;
+    }
+    else if (jsn_ctx != nullptr)
     {
         len = jsn_ctx->script_size();
         data = jsn_ctx->take_script();
@@ -154,7 +199,11 @@ void JSNorm::flush_data(const void*& data, size_t& len)
 
 void JSNorm::flush_data()
 {
-    if (jsn_ctx != nullptr)
+    if (cached)
+    {
+        cached_size = 0;
+    }
+    else if (jsn_ctx != nullptr)
     {
         delete[] jsn_ctx->take_script();
     }
@@ -162,13 +211,56 @@ void JSNorm::flush_data()
 
 void JSNorm::get_data(const void*& data, size_t& len)
 {
-    if (jsn_ctx != nullptr)
+    if (cached)
+    {
+        len = cached_size;
+        data = cached->script.data();
+    }
+    else if (jsn_ctx != nullptr)
     {
         len = jsn_ctx->script_size();
         data = jsn_ctx->get_script();
     }
 }
 
+void JSNorm::create_ctx()
+{
+    if (idn_ctx == nullptr)
+        idn_ctx = new JSIdentifierCtx(config->identifier_depth,
+            config->max_scope_depth, config->ignored_ids, config->ignored_props);
+    if (jsn_ctx == nullptr)
+        jsn_ctx = new JSNormalizer(*idn_ctx, config->bytes_depth,
+            config->max_template_nesting, config->max_bracket_depth);
+}
+
+bool JSNorm::use_cached()
+{
+    if (!ext_script_type or !config->cache_memcap)
+        return false;
+
+    cached = JSNormCache::find(*config, (const char*)src_ptr, src_end - src_ptr);
+    cached_size = cached ? cached->script.size() : 0;
+
+    return (bool)cached;
+}
+
+// The script goes on beyond the whole script taken from the cache. Normalize the cached source
+// again, once per script, to get the normalizer into the state the next chunk expects. Entries
+// are only kept for scripts which ended with their first PDU, so this is rare.
+void JSNorm::replay_cached()
+{
+    const bool flushed = cached_size == 0;
+
+    create_ctx();
+    jsn_ctx->normalize(cached->source.data(), cached->source.size(), ext_script_type);
+
+    if (flushed)
+        delete[] jsn_ctx->take_script();
+
+    cached.reset();
+    cached_size = 0;
+}
+
 bool JSNorm::pre_proc()
 {
     return src_ptr < src_end;
@@ -176,17 +268,21 @@ bool JSNorm::pre_proc()
 
 bool JSNorm::post_proc(int ret)
 {
-    if (jsn_ctx->is_unescape_nesting_seen())
-        events.create_event(EVENT_NEST_UNESCAPE_FUNC);
+    // scripts are cached only if none of these were seen
+    if (jsn_ctx != nullptr)
+    {
+        if (jsn_ctx->is_unescape_nesting_seen())
+            events.create_event(EVENT_NEST_UNESCAPE_FUNC);
 
-    if (jsn_ctx->is_mixed_encoding_seen())
-        events.create_event(EVENT_MIXED_UNESCAPE_SEQUENCE);
+        if (jsn_ctx->is_mixed_encoding_seen())
+            events.create_event(EVENT_MIXED_UNESCAPE_SEQUENCE);
 
-    if (jsn_ctx->is_opening_tag_seen())
-        events.create_event(EVENT_OPENING_TAG);
+        if (jsn_ctx->is_opening_tag_seen())
+            events.create_event(EVENT_OPENING_TAG);
 
-    if (jsn_ctx->is_closing_tag_seen())
-        events.create_event(EVENT_CLOSING_TAG);
+        if (jsn_ctx->is_closing_tag_seen())
+            events.create_event(EVENT_CLOSING_TAG);
+    }
 
     switch ((JSTokenizer::JSRet)ret)
     {
@@ -20,6 +20,8 @@
 #ifndef JS_NORM_H
 #define JS_NORM_H
 
+#include <memory>
+
 #include "utils/event_gen.h"
 
 #include "js_config.h"
@@ -29,6 +31,7 @@ namespace jsn
 {
 class JSIdentifier;
 class JSNormalizer;
+struct JSNormCacheEntry;
 
 const char* ret2str(int);
 }
@@ -55,6 +58,10 @@ protected:
     virtual bool pre_proc();
     virtual bool post_proc(int);
 
+    void create_ctx();
+    bool use_cached();
+    void replay_cached();
+
     bool alive;
     uint32_t pdu_cnt;
 
@@ -65,6 +72,13 @@ protected:
     jsn::JSNormalizer* jsn_ctx;
     bool ext_script_type;
 
+    // the script normalized so far was taken from the cache instead of jsn_ctx
+    std::shared_ptr<const jsn::JSNormCacheEntry> cached;
+    size_t cached_size;
+
+    // the first PDU added to the cache, until the script turns out to go on
+    std::weak_ptr<const jsn::JSNormCacheEntry> added;
+
     JSEvents events;
     JSNormConfig* config;
 };
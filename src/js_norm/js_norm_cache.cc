@@ -0,0 +1,157 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// js_norm_cache.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "js_norm_cache.h"
+
+#include <cstring>
+
+#include "main/thread.h"
+
+#include "js_config.h"
+#include "js_enum.h"
+#include "js_norm_module.h"
+
+using namespace jsn;
+
+static THREAD_LOCAL JSNormCache* js_norm_cache = nullptr;
+
+// FNV-1a, the length is folded in so that prefixes of the same source do not share a bucket
+uint64_t JSNormCache::hash(const char* src, size_t src_len)
+{
+    uint64_t h = 0xcbf29ce484222325ULL ^ src_len;
+
+    for (size_t i = 0; i < src_len; ++i)
+    {
+        h ^= (uint8_t)src[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    return h;
+}
+
+void JSNormCache::set_memcap(size_t new_memcap)
+{
+    if (memcap == new_memcap)
+        return;
+
+    memcap = new_memcap;
+    prune();
+}
+
+void JSNormCache::prune()
+{
+    while (mem_used > memcap and !list.empty())
+    {
+        auto it = --list.end();
+        mem_used -= it->second->size();
+        map.erase(it->first);
+        list.erase(it);
+        JSNormModule::increment_peg_counts(PEG_CACHE_PRUNES);
+    }
+}
+
+JSNormCacheRef JSNormCache::find(const JSNormConfig& config, const char* src, size_t src_len)
+{
+    if (!config.cache_memcap or !js_norm_cache)
+        return nullptr;
+
+    js_norm_cache->set_memcap(config.cache_memcap);
+
+    auto it = js_norm_cache->map.find(hash(src, src_len));
+    if (it == js_norm_cache->map.end())
+    {
+        JSNormModule::increment_peg_counts(PEG_CACHE_MISSES);
+        return nullptr;
+    }
+
+    const JSNormCacheRef& entry = it->second->second;
+
+    if (entry->config_gen != config.generation or entry->source.size() != src_len
+        or memcmp(entry->source.data(), src, src_len))
+    {
+        JSNormModule::increment_peg_counts(PEG_CACHE_MISSES);
+        return nullptr;
+    }
+
+    JSNormModule::increment_peg_counts(PEG_CACHE_HITS);
+    js_norm_cache->list.splice(js_norm_cache->list.begin(), js_norm_cache->list, it->second);
+    return entry;
+}
+
+JSNormCacheRef JSNormCache::add(const JSNormConfig& config, const char* src, size_t src_len,
+    const char* dst, size_t dst_len, int ret)
+{
+    if (!config.cache_memcap)
+        return nullptr;
+
+    if (!js_norm_cache)
+        js_norm_cache = new JSNormCache;
+
+    js_norm_cache->set_memcap(config.cache_memcap);
+
+    const uint64_t key = hash(src, src_len);
+    auto entry = std::make_shared<const JSNormCacheEntry>(key, config.generation, src, src_len,
+        dst, dst_len, ret);
+
+    if (entry->size() > config.cache_memcap)
+        return nullptr;
+
+    auto it = js_norm_cache->map.find(key);
+
+    if (it != js_norm_cache->map.end())
+    {
+        js_norm_cache->mem_used -= it->second->second->size();
+        js_norm_cache->list.erase(it->second);
+        js_norm_cache->map.erase(it);
+    }
+
+    js_norm_cache->list.emplace_front(key, entry);
+    js_norm_cache->map[key] = js_norm_cache->list.begin();
+    js_norm_cache->mem_used += entry->size();
+    JSNormModule::increment_peg_counts(PEG_CACHE_ADDS);
+
+    js_norm_cache->prune();
+    return entry;
+}
+
+void JSNormCache::remove(const JSNormCacheRef& entry)
+{
+    if (!js_norm_cache or !entry)
+        return;
+
+    auto it = js_norm_cache->map.find(entry->key);
+
+    // it may have been pruned or replaced since
+    if (it == js_norm_cache->map.end() or it->second->second != entry)
+        return;
+
+    js_norm_cache->mem_used -= entry->size();
+    js_norm_cache->list.erase(it->second);
+    js_norm_cache->map.erase(it);
+}
+
+void JSNormCache::thread_term()
+{
+    delete js_norm_cache;
+    js_norm_cache = nullptr;
+}
@@ -0,0 +1,89 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// js_norm_cache.h author Cisco
+
+#ifndef JS_NORM_CACHE_H
+#define JS_NORM_CACHE_H
+
+// JSNormCache - a thread-local, memcap-enforced LRU of normalized scripts.
+//
+// Only scripts normalized by a fresh context are stored, so the output depends on nothing but
+// the source and the configuration. The source is kept with the entry and compared on lookup,
+// a hash collision never returns somebody else's script. An entry is removed again when its
+// script turns out to go on in the next PDU, so only whole scripts stay cached.
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+struct JSNormConfig;
+
+namespace jsn
+{
+
+struct JSNormCacheEntry
+{
+    JSNormCacheEntry(uint64_t k, uint32_t gen, const char* src, size_t src_len,
+        const char* dst, size_t dst_len, int r) :
+        key(k), config_gen(gen), source(src, src_len), script(dst, dst_len), ret(r)
+    { }
+
+    size_t size() const
+    { return sizeof(*this) + source.size() + script.size(); }
+
+    const uint64_t key;
+    const uint32_t config_gen;
+    const std::string source;
+    const std::string script;
+    const int ret;
+};
+
+using JSNormCacheRef = std::shared_ptr<const JSNormCacheEntry>;
+
+class JSNormCache
+{
+public:
+    static JSNormCacheRef find(const JSNormConfig&, const char* src, size_t src_len);
+    static JSNormCacheRef add(const JSNormConfig&, const char* src, size_t src_len,
+        const char* dst, size_t dst_len, int ret);
+    static void remove(const JSNormCacheRef&);
+    static void thread_term();
+
+    size_t get_mem_used() const
+    { return mem_used; }
+
+private:
+    JSNormCache() = default;
+
+    static uint64_t hash(const char* src, size_t src_len);
+    void set_memcap(size_t);
+    void prune();
+
+    using LruList = std::list<std::pair<uint64_t, JSNormCacheRef>>;
+
+    size_t memcap = 0;
+    size_t mem_used = 0;
+    LruList list;
+    std::unordered_map<uint64_t, LruList::iterator> map;
+};
+
+}
+
+#endif
@@ -39,6 +39,9 @@ THREAD_LOCAL const Trace* js_trace = nullptr;
 THREAD_LOCAL PegCount JSNormModule::peg_counts[PEG_COUNT_MAX] = {};
 THREAD_LOCAL ProfileStats JSNormModule::profile_stats;
 
+// Distinguishes configurations across reloads, cached scripts are only reused by the same one
+static uint32_t config_generation = 0;
+
 static const Parameter ident_ignore_param[] =
 {
     { "ident_name", Parameter::PT_STRING, nullptr, nullptr, "name of the identifier to ignore" },
@@ -74,6 +77,10 @@ const Parameter JSNormModule::params[] =
     { "prop_ignore", Parameter::PT_LIST, prop_ignore_param, nullptr,
       "list of JavaScript ignored object properties which will not be normalized" },
 
+    { "cache_memcap", Parameter::PT_INT, "0:maxSZ", "0",
+      "maximum bytes per packet thread of normalized external scripts cached across flows "
+      "(0 disables the cache)" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -93,6 +100,10 @@ const PegInfo JSNormModule::peg_names[PEG_COUNT_MAX + 1] =
     { CountType::SUM, "bytes", "total number of bytes processed" },
     { CountType::SUM, "identifiers", "total number of unique identifiers processed" },
     { CountType::SUM, "identifier_overflows", "total number of unique identifier limit overflows" },
+    { CountType::SUM, "cache_adds", "total number of normalized scripts added to the cache" },
+    { CountType::SUM, "cache_hits", "total number of scripts served from the cache" },
+    { CountType::SUM, "cache_misses", "total number of cache lookups without a matching script" },
+    { CountType::SUM, "cache_prunes", "total number of scripts pruned from the cache" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -127,6 +138,7 @@ bool JSNormModule::begin(const char* fqn, int, SnortConfig*)
     delete policy->jsn_config;
     policy->jsn_config = new JSNormConfig;
     config = policy->jsn_config;
+    config->generation = ++config_generation;
 
     return true;
 }
@@ -163,6 +175,10 @@ bool JSNormModule::set(const char*, Value& v, SnortConfig*)
     {
         config->ignored_props.insert(v.get_string());
     }
+    else if (v.is("cache_memcap"))
+    {
+        config->cache_memcap = v.get_size();
+    }
 
     return true;
 }
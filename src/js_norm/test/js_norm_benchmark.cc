@@ -23,17 +23,26 @@
 #include "config.h"
 #endif
 
+#include <dirent.h>
+
+#include <algorithm>
 #include <cstring>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "catch/catch.hpp"
 
 #include "js_norm/js_identifier_ctx.h"
+#include "js_norm/js_norm.h"
+#include "js_norm/js_norm_cache.h"
 #include "js_norm/js_normalizer.h"
 
 #include "js_test_utils.h"
 
 using namespace jsn;
+using namespace snort;
 
 static constexpr const char* s_closing_tag = "</script>";
 
@@ -296,5 +305,118 @@ TEST_CASE("JS Normalizer, unescape", "[JSNormalizer]")
     };
 }
 
-#endif
+// Scripts from the directory in JS_NORM_CORPUS, if set. Otherwise, a few synthetic libraries.
+static std::vector<std::string> load_corpus()
+{
+    std::vector<std::string> corpus;
+    const char* path = getenv("JS_NORM_CORPUS");
+    DIR* dir = path ? opendir(path) : nullptr;
+
+    if (dir)
+    {
+        while (const dirent* de = readdir(dir))
+        {
+            std::ifstream file(std::string(path) + "/" + de->d_name, std::ios::binary);
+            std::stringstream content;
+
+            if (de->d_name[0] == '.' or !(content << file.rdbuf()))
+                continue;
+
+            corpus.emplace_back(content.str());
+        }
+        closedir(dir);
+    }
+
+    if (corpus.empty())
+    {
+        const char* patterns[] =
+        {
+            "function foo(bar) { return bar.baz + 1 ; } ",
+            "var a = [1, 2, 3].map(function (x) { return x * 2 ; }) ; ",
+            "/* comment */ if (a && b) { c = 'string literal' ; } ",
+        };
+
+        for (auto pattern : patterns)
+        {
+            std::string script;
+            while (script.size() < (1 << 16))
+                script.append(pattern);
+            corpus.emplace_back(script);
+        }
+    }
+
+    return corpus;
+}
+
+// Each script is fed in PDUs of pdu_size bytes (0 is the whole script), taking the output of
+// each PDU as HTTP does, so a cached first PDU of a longer script is seen as such.
+static size_t normalize_corpus(JSNormConfig& config, const std::vector<std::string>& corpus,
+    size_t pdu_size)
+{
+    size_t total = 0;
+
+    for (const auto& script : corpus)
+    {
+        JSNorm jsn(&config, true);
+        const size_t step = pdu_size ? pdu_size : script.size();
+
+        for (size_t offset = 0; offset < script.size(); offset += step)
+        {
+            const void* dst = nullptr;
+            size_t dst_len = 0;
+
+            jsn.tick();
+            jsn.normalize(script.c_str() + offset, std::min(step, script.size() - offset),
+                dst, dst_len);
+            jsn.flush_data();
+            total += dst_len;
+        }
+    }
 
+    return total;
+}
+
+TEST_CASE("JS Normalizer, script cache", "[JSNorm]")
+{
+    const auto corpus = load_corpus();
+    constexpr size_t pdu_size = 16384;
+
+    JSNormConfig config;
+    config.generation = 1;
+
+    const size_t whole = normalize_corpus(config, corpus, 0);
+    const size_t segmented = normalize_corpus(config, corpus, pdu_size);
+
+    BENCHMARK("whole scripts without cache")
+    {
+        return normalize_corpus(config, corpus, 0);
+    };
+
+    BENCHMARK("16K PDUs without cache")
+    {
+        return normalize_corpus(config, corpus, pdu_size);
+    };
+
+    config.cache_memcap = 1 << 26;
+
+    // the cached output is the same and scripts which go on are not kept
+    REQUIRE(normalize_corpus(config, corpus, 0) == whole);
+    REQUIRE(normalize_corpus(config, corpus, 0) == whole);
+    REQUIRE(normalize_corpus(config, corpus, pdu_size) == segmented);
+
+    BENCHMARK("whole scripts with cache")
+    {
+        return normalize_corpus(config, corpus, 0);
+    };
+
+    JSNormCache::thread_term();
+
+    BENCHMARK("16K PDUs with cache")
+    {
+        return normalize_corpus(config, corpus, pdu_size);
+    };
+
+    JSNormCache::thread_term();
+}
+
+#endif
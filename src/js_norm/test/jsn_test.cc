@@ -26,6 +26,8 @@
 #include "catch/catch.hpp"
 
 #include "js_norm/js_norm.h"
+#include "js_norm/js_norm_cache.h"
+#include "js_norm/js_norm_module.h"
 
 using namespace jsn;
 using namespace snort;
@@ -277,4 +279,154 @@ TEST_CASE("blocking events", "[JSNorm]")
     CHECK(std::string((const char*)dst, dst_len) == exp);
 }
 
+TEST_CASE("script cache", "[JSNorm]")
+{
+    JSNormCache::thread_term();
+
+    JSNormConfig config;
+    config.cache_memcap = 1 << 20;
+    config.generation = 1;
+
+    const void* dst = nullptr;
+    size_t dst_len = 0;
+
+    const std::string pdu_1 = "var a = ";
+    const std::string pdu_2 = "1 ;";
+
+    const std::string norm_pdu_1 = "var var_0000=";
+    const std::string norm_pdu_2 = "var var_0000=1;";
+
+    JSNorm first(&config, true);
+    first.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+    REQUIRE(dst != nullptr);
+    CHECK(std::string((const char*)dst, dst_len) == norm_pdu_1);
+
+    const PegCount adds = JSNormModule::get_peg_counts(PEG_CACHE_ADDS);
+    const PegCount hits = JSNormModule::get_peg_counts(PEG_CACHE_HITS);
+    const PegCount misses = JSNormModule::get_peg_counts(PEG_CACHE_MISSES);
+
+    SECTION("hit")
+    {
+        JSNorm jsn(&config, true);
+        jsn.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+
+        REQUIRE(dst != nullptr);
+        CHECK(std::string((const char*)dst, dst_len) == norm_pdu_1);
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_HITS) == hits + 1);
+    }
+
+    SECTION("continued after hit")
+    {
+        JSNorm jsn(&config, true);
+        jsn.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+        jsn.tick();
+        jsn.normalize(pdu_2.c_str(), pdu_2.size(), dst, dst_len);
+
+        REQUIRE(dst != nullptr);
+        CHECK(std::string((const char*)dst, dst_len) == norm_pdu_2);
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_HITS) == hits + 1);
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_ADDS) == adds);
+    }
+
+    SECTION("continued script not kept")
+    {
+        first.tick();
+        first.normalize(pdu_2.c_str(), pdu_2.size(), dst, dst_len);
+
+        REQUIRE(dst != nullptr);
+        CHECK(std::string((const char*)dst, dst_len) == norm_pdu_2);
+
+        JSNorm jsn(&config, true);
+        jsn.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_HITS) == hits);
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_ADDS) == adds + 1);
+    }
+
+    SECTION("replayed once per script")
+    {
+        const std::string pdu_3 = " var b = a ;";
+        const std::string norm_pdu_3 = "var var_0000=1;var var_0001=var_0000;";
+
+        JSNorm jsn(&config, true);
+        jsn.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+        jsn.tick();
+        jsn.normalize(pdu_2.c_str(), pdu_2.size(), dst, dst_len);
+        jsn.tick();
+        jsn.normalize(pdu_3.c_str(), pdu_3.size(), dst, dst_len);
+
+        REQUIRE(dst != nullptr);
+        CHECK(std::string((const char*)dst, dst_len) == norm_pdu_3);
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_HITS) == hits + 1);
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_MISSES) == misses);
+    }
+
+    SECTION("flushed and continued after hit")
+    {
+        JSNorm jsn(&config, true);
+        jsn.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+        jsn.flush_data(dst, dst_len);
+
+        REQUIRE(dst != nullptr);
+        CHECK(std::string((const char*)dst, dst_len) == norm_pdu_1);
+        delete[] (const char*)dst;
+
+        jsn.tick();
+        jsn.normalize(pdu_2.c_str(), pdu_2.size(), dst, dst_len);
+
+        REQUIRE(dst != nullptr);
+        CHECK(std::string((const char*)dst, dst_len) == "1;");
+    }
+
+    SECTION("other configuration")
+    {
+        JSNormConfig other_config = config;
+        other_config.generation = 2;
+
+        JSNorm jsn(&other_config, true);
+        jsn.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_HITS) == hits);
+    }
+
+    SECTION("inline script")
+    {
+        JSNorm jsn(&config, false);
+        jsn.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_HITS) == hits);
+    }
+
+    SECTION("script with events")
+    {
+        const std::string src = "'<script>' ;";
+
+        JSNorm jsn(&config, true);
+        jsn.normalize(src.c_str(), src.size(), dst, dst_len);
+
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_ADDS) == adds);
+    }
+
+    SECTION("memcap")
+    {
+        const PegCount prunes = JSNormModule::get_peg_counts(PEG_CACHE_PRUNES);
+
+        config.cache_memcap = sizeof(JSNormCacheEntry) + 64;
+
+        const std::string src = "var b = 2 ;";
+
+        JSNorm jsn(&config, true);
+        jsn.normalize(src.c_str(), src.size(), dst, dst_len);
+
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_PRUNES) == prunes + 1);
+
+        JSNorm tmp_jsn(&config, true);
+        tmp_jsn.normalize(pdu_1.c_str(), pdu_1.size(), dst, dst_len);
+
+        CHECK(JSNormModule::get_peg_counts(PEG_CACHE_HITS) == hits);
+    }
+
+    JSNormCache::thread_term();
+}
+
 #endif
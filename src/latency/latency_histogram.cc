@@ -0,0 +1,161 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// latency_histogram.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "latency_histogram.h"
+
+#include <cmath>
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+uint64_t LatencyHistogram::upper_bound(unsigned idx)
+{
+    if ( idx < sub_count )
+        return idx;
+
+    unsigned shift = idx / sub_count - 1;
+    uint64_t low = (uint64_t)(sub_count + idx % sub_count) << shift;
+
+    return low + ((uint64_t)1 << shift) - 1;
+}
+
+uint64_t LatencyHistogram::get_percentile(double pct) const
+{
+    if ( !count )
+        return 0;
+
+    uint64_t rank = (uint64_t)std::ceil(pct * count / 100.0);
+
+    if ( !rank )
+        rank = 1;
+
+    uint64_t seen = 0;
+
+    for ( unsigned i = 0; i < num_buckets; ++i )
+    {
+        seen += buckets[i];
+
+        if ( seen >= rank )
+        {
+            uint64_t v = upper_bound(i);
+            return v < max ? v : max;
+        }
+    }
+    return max;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& rhs)
+{
+    for ( unsigned i = 0; i < num_buckets; ++i )
+        buckets[i] += rhs.buckets[i];
+
+    count += rhs.count;
+
+    if ( rhs.max > max )
+        max = rhs.max;
+}
+
+// -----------------------------------------------------------------------------
+// unit tests
+// -----------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE ( "latency histogram buckets", "[latency]" )
+{
+    SECTION( "small values are exact" )
+    {
+        for ( uint64_t v = 0; v < 2 * LatencyHistogram::sub_count; ++v )
+            CHECK( LatencyHistogram::upper_bound(LatencyHistogram::index(v)) == v );
+    }
+
+    SECTION( "buckets are contiguous" )
+    {
+        for ( unsigned i = 1; i < LatencyHistogram::num_buckets; ++i )
+        {
+            uint64_t v = LatencyHistogram::upper_bound(i - 1) + 1;
+            CHECK( LatencyHistogram::index(v) == i );
+            CHECK( LatencyHistogram::index(v - 1) == i - 1 );
+        }
+    }
+
+    SECTION( "relative error" )
+    {
+        for ( uint64_t v = 100; v < 100000000; v = v * 3 + 7 )
+        {
+            uint64_t ub = LatencyHistogram::upper_bound(LatencyHistogram::index(v));
+            CHECK( ub >= v );
+            CHECK( ub - v <= v / LatencyHistogram::sub_count );
+        }
+    }
+
+    SECTION( "overflow" )
+    {
+        CHECK( LatencyHistogram::index(UINT64_MAX) == LatencyHistogram::num_buckets - 1 );
+    }
+}
+
+TEST_CASE ( "latency histogram percentiles", "[latency]" )
+{
+    LatencyHistogram h;
+
+    CHECK( h.get_percentile(50) == 0 );
+
+    for ( uint64_t v = 1; v <= 1000; ++v )
+        h.add(v);
+
+    CHECK( h.get_count() == 1000 );
+    CHECK( h.get_max() == 1000 );
+
+    uint64_t p50 = h.get_percentile(50);
+    CHECK( p50 >= 500 );
+    CHECK( p50 <= 500 + 500 / LatencyHistogram::sub_count );
+
+    uint64_t p99 = h.get_percentile(99);
+    CHECK( p99 >= 990 );
+    CHECK( p99 <= 1000 );
+
+    CHECK( h.get_percentile(100) == 1000 );
+
+    SECTION( "merge" )
+    {
+        LatencyHistogram h2;
+        h2.add(1000000);
+        h.merge(h2);
+
+        CHECK( h.get_count() == 1001 );
+        CHECK( h.get_max() == 1000000 );
+        CHECK( h.get_percentile(100) == 1000000 );
+        CHECK( h.get_percentile(50) == p50 );
+    }
+
+    SECTION( "reset" )
+    {
+        h.reset();
+        CHECK( h.get_count() == 0 );
+        CHECK( h.get_percentile(99) == 0 );
+    }
+}
+
+#endif
@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// latency_histogram.h author Cisco
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+// Log linear histogram of latencies in clock ticks.  Each power of 2 is
+// split into 16 buckets so a percentile is within 1/16 of the actual value
+// while a histogram covering up to 2^48 ticks takes a few KB.  Adding a
+// value is a count leading zeros, a shift, and an increment so it can stay
+// on for every packet.
+
+#include <cstdint>
+#include <cstring>
+
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned sub_bits = 4;
+    static constexpr unsigned sub_count = 1 << sub_bits;
+    static constexpr unsigned max_bits = 48;
+    static constexpr unsigned num_buckets = (max_bits - sub_bits + 1) * sub_count;
+
+    LatencyHistogram()
+    { reset(); }
+
+    void add(uint64_t ticks)
+    {
+        ++buckets[index(ticks)];
+        ++count;
+
+        if ( ticks > max )
+            max = ticks;
+    }
+
+    uint64_t get_count() const
+    { return count; }
+
+    uint64_t get_max() const
+    { return max; }
+
+    // smallest value with at least pct percent of the values at or below it,
+    // rounded up to its bucket
+    uint64_t get_percentile(double pct) const;
+
+    void merge(const LatencyHistogram&);
+
+    void reset()
+    {
+        memset(buckets, 0, sizeof(buckets));
+        count = max = 0;
+    }
+
+    static unsigned index(uint64_t ticks)
+    {
+        if ( ticks < sub_count )
+            return (unsigned)ticks;
+
+        unsigned msb = 63 - __builtin_clzll(ticks);
+
+        if ( msb >= max_bits )
+            return num_buckets - 1;
+
+        return (msb - sub_bits + 1) * sub_count + ((ticks >> (msb - sub_bits)) & (sub_count - 1));
+    }
+
+    // largest value counted in the bucket
+    static uint64_t upper_bound(unsigned idx);
+
+private:
+    uint64_t buckets[num_buckets];
+    uint64_t count;
+    uint64_t max;
+};
+
+#endif
@@ -25,18 +25,27 @@
 #include "latency_module.h"
 
 #include <chrono>
+#include <lua.hpp>
+#include <string>
+#include <vector>
 
+#include "control/control.h"
+#include "main/analyzer_command.h"
 #include "main/snort_config.h"
+#include "main/thread_config.h"
 #include "trace/trace.h"
 
 #include "latency_config.h"
 #include "latency_rules.h"
 #include "latency_stats.h"
+#include "phase_latency.h"
 
 using namespace snort;
 
 THREAD_LOCAL const Trace* latency_trace = nullptr;
 
+static int show_histograms(lua_State*);
+
 // -----------------------------------------------------------------------------
 // latency attributes
 // -----------------------------------------------------------------------------
@@ -53,6 +62,9 @@ static const Parameter s_packet_params[] =
     { "fastpath", Parameter::PT_BOOL, nullptr, "false",
         "fastpath expensive packets (max_time exceeded)" },
 
+    { "histograms", Parameter::PT_BOOL, nullptr, "false",
+        "track latency percentiles of the packet processing phases" },
+
 #ifdef REG_TEST
     { "test_timeout", Parameter::PT_BOOL, nullptr, "false",
         "timeout on every packet" },
@@ -116,9 +128,88 @@ static const PegInfo latency_pegs[] =
     { CountType::SUM, "total_rule_evals", "total rule evals monitored" },
     { CountType::SUM, "rule_eval_timeouts", "rule evals that timed out" },
     { CountType::SUM, "rule_tree_enables", "rule tree re-enables" },
+    { CountType::MAX, "packet_p50_nsecs", "median nsecs to process a packet" },
+    { CountType::MAX, "packet_p99_nsecs", "99th percentile nsecs to process a packet" },
+    { CountType::MAX, "packet_p999_nsecs", "99.9th percentile nsecs to process a packet" },
+    { CountType::MAX, "decode_p50_nsecs", "median nsecs to decode a packet" },
+    { CountType::MAX, "decode_p99_nsecs", "99th percentile nsecs to decode a packet" },
+    { CountType::MAX, "decode_p999_nsecs", "99.9th percentile nsecs to decode a packet" },
+    { CountType::MAX, "stream_p50_nsecs", "median nsecs of flow tracking" },
+    { CountType::MAX, "stream_p99_nsecs", "99th percentile nsecs of flow tracking" },
+    { CountType::MAX, "stream_p999_nsecs", "99.9th percentile nsecs of flow tracking" },
+    { CountType::MAX, "inspect_p50_nsecs", "median nsecs of inspection" },
+    { CountType::MAX, "inspect_p99_nsecs", "99th percentile nsecs of inspection" },
+    { CountType::MAX, "inspect_p999_nsecs", "99.9th percentile nsecs of inspection" },
+    { CountType::MAX, "detect_p50_nsecs", "median nsecs of detection" },
+    { CountType::MAX, "detect_p99_nsecs", "99th percentile nsecs of detection" },
+    { CountType::MAX, "detect_p999_nsecs", "99.9th percentile nsecs of detection" },
+    { CountType::MAX, "log_p50_nsecs", "median nsecs to log events" },
+    { CountType::MAX, "log_p99_nsecs", "99th percentile nsecs to log events" },
+    { CountType::MAX, "log_p999_nsecs", "99.9th percentile nsecs to log events" },
     { CountType::END, nullptr, nullptr }
 };
 
+static const Command latency_cmds[] =
+{
+    { "show_histograms", show_histograms, nullptr,
+      "show latency percentiles of the packet processing phases for each thread" },
+
+    { nullptr, nullptr, nullptr, nullptr }
+};
+
+// -----------------------------------------------------------------------------
+// latency commands
+// -----------------------------------------------------------------------------
+
+class ShowHistograms : public AnalyzerCommand
+{
+public:
+    ShowHistograms(ControlConn* conn) : AnalyzerCommand(conn),
+        summaries(ThreadConfig::get_instance_max()) { }
+    ~ShowHistograms() override;
+
+    bool execute(Analyzer&, void**) override;
+    const char* stringify() override { return "LATENCY_SHOW_HISTOGRAMS"; }
+
+private:
+    // one per packet thread, each only written by its thread
+    std::vector<std::string> summaries;
+};
+
+bool ShowHistograms::execute(Analyzer&, void**)
+{
+    unsigned id = get_instance_id();
+
+    if ( id < summaries.size() )
+        summaries[id] = PhaseLatency::get_summary(id);
+
+    return true;
+}
+
+ShowHistograms::~ShowHistograms()
+{
+    bool any = false;
+
+    for ( const auto& s : summaries )
+    {
+        if ( !s.empty() )
+        {
+            log_message("%s", s.c_str());
+            any = true;
+        }
+    }
+
+    if ( !any )
+        log_message("latency histograms are not enabled\n");
+}
+
+static int show_histograms(lua_State* L)
+{
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    main_broadcast_command(new ShowHistograms(ctrlcon), ctrlcon);
+    return 0;
+}
+
 // -----------------------------------------------------------------------------
 // latency module
 // -----------------------------------------------------------------------------
@@ -132,6 +223,9 @@ static inline bool latency_set(const Value& v, PacketLatencyConfig& config)
     }
     else if ( v.is("fastpath") )
         config.fastpath = v.get_bool();
+
+    else if ( v.is("histograms") )
+        config.histograms = v.get_bool();
 #ifdef REG_TEST
     else if ( v.is("test_timeout") )
         config.test_timeout = v.get_bool();
@@ -217,6 +311,28 @@ const RuleMap* LatencyModule::get_rules() const
 unsigned LatencyModule::get_gid() const
 { return GID_LATENCY; }
 
+const Command* LatencyModule::get_commands() const
+{ return latency_cmds; }
+
+void LatencyModule::prep_counts(bool)
+{ PhaseLatency::prep_counts(latency_stats); }
+
+// perf_monitor sums the counts after each interval so the percentiles of
+// the next one start over; the summary keeps the worst interval
+void LatencyModule::sum_stats(bool dump_stats)
+{
+    Module::sum_stats(dump_stats);
+
+    if ( !dump_stats )
+        PhaseLatency::reset();
+}
+
+void LatencyModule::reset_stats()
+{
+    PhaseLatency::reset();
+    Module::reset_stats();
+}
+
 const PegInfo* LatencyModule::get_pegs() const
 { return latency_pegs; }
 
@@ -31,12 +31,20 @@ public:
     bool set(const char*, snort::Value&, snort::SnortConfig*) override;
     bool end(const char*, int, snort::SnortConfig*) override;
 
+    const snort::Command* get_commands() const override;
     const snort::RuleMap* get_rules() const override;
     unsigned get_gid() const override;
 
     const PegInfo* get_pegs() const override;
     PegCount* get_counts() const override;
 
+    bool counts_need_prep() const override
+    { return true; }
+
+    void prep_counts(bool) override;
+    void sum_stats(bool) override;
+    void reset_stats() override;
+
     Usage get_usage() const override
     { return CONTEXT; }
 
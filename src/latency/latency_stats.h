@@ -33,6 +33,24 @@ struct LatencyStats
     PegCount total_rule_evals;
     PegCount rule_eval_timeouts;
     PegCount rule_tree_enables;
+    PegCount packet_p50_nsecs;
+    PegCount packet_p99_nsecs;
+    PegCount packet_p999_nsecs;
+    PegCount decode_p50_nsecs;
+    PegCount decode_p99_nsecs;
+    PegCount decode_p999_nsecs;
+    PegCount stream_p50_nsecs;
+    PegCount stream_p99_nsecs;
+    PegCount stream_p999_nsecs;
+    PegCount inspect_p50_nsecs;
+    PegCount inspect_p99_nsecs;
+    PegCount inspect_p999_nsecs;
+    PegCount detect_p50_nsecs;
+    PegCount detect_p99_nsecs;
+    PegCount detect_p999_nsecs;
+    PegCount log_p50_nsecs;
+    PegCount log_p99_nsecs;
+    PegCount log_p999_nsecs;
 };
 
 extern THREAD_LOCAL LatencyStats latency_stats;
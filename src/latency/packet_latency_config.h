@@ -28,6 +28,7 @@ struct PacketLatencyConfig
     hr_duration max_time = CLOCK_ZERO;
     bool fastpath = false;
     bool force_enable = false;
+    bool histograms = false;
 #ifdef REG_TEST
     bool test_timeout = false;
 #endif
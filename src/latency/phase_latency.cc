@@ -0,0 +1,165 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// phase_latency.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "phase_latency.h"
+
+#include <cinttypes>
+
+#include "main/snort_config.h"
+#include "main/thread.h"
+
+#include "latency_config.h"
+#include "latency_histogram.h"
+#include "latency_stats.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+static const char* const phase_names[PhaseLatency::MAX_PHASE] =
+{ "packet", "decode", "stream", "inspect", "detect", "log" };
+
+// allocated on first use since it is only needed when enabled
+static THREAD_LOCAL LatencyHistogram* histograms = nullptr;
+
+static uint64_t to_nsecs(uint64_t ticks)
+{
+#ifdef USE_TSC_CLOCK
+    return ticks * 1000 / clock_scale();
+#else
+    return TO_NSECS(hr_duration(ticks));
+#endif
+}
+
+bool PhaseLatency::enabled()
+{ return SnortConfig::get_conf()->latency->packet_latency.histograms; }
+
+void PhaseLatency::record(Phase phase, uint64_t ticks)
+{
+    if ( !histograms )
+        histograms = new LatencyHistogram[MAX_PHASE];
+
+    histograms[phase].add(ticks);
+}
+
+// the percentiles are MAX pegs so the summary gives the worst thread
+void PhaseLatency::prep_counts(LatencyStats& stats)
+{
+    if ( !histograms )
+        return;
+
+    PegCount* p = &stats.packet_p50_nsecs;
+
+    for ( unsigned i = 0; i < MAX_PHASE; ++i )
+    {
+        *p++ = to_nsecs(histograms[i].get_percentile(50.0));
+        *p++ = to_nsecs(histograms[i].get_percentile(99.0));
+        *p++ = to_nsecs(histograms[i].get_percentile(99.9));
+    }
+}
+
+std::string PhaseLatency::get_summary(unsigned thread_id)
+{
+    std::string s;
+
+    if ( !histograms )
+        return s;
+
+    char buf[160];
+
+    for ( unsigned i = 0; i < MAX_PHASE; ++i )
+    {
+        const LatencyHistogram& h = histograms[i];
+
+        snprintf(buf, sizeof(buf), "thread %u %-7s count %" PRIu64 " p50 %" PRIu64
+            " p99 %" PRIu64 " p99.9 %" PRIu64 " max %" PRIu64 " nsecs\n",
+            thread_id, phase_names[i], h.get_count(), to_nsecs(h.get_percentile(50.0)),
+            to_nsecs(h.get_percentile(99.0)), to_nsecs(h.get_percentile(99.9)),
+            to_nsecs(h.get_max()));
+
+        s += buf;
+    }
+    return s;
+}
+
+void PhaseLatency::reset()
+{
+    if ( !histograms )
+        return;
+
+    for ( unsigned i = 0; i < MAX_PHASE; ++i )
+        histograms[i].reset();
+}
+
+void PhaseLatency::tterm()
+{
+    delete[] histograms;
+    histograms = nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// unit tests
+// -----------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE ( "phase latency reset", "[latency]" )
+{
+    LatencyStats stats = { };
+
+    for ( unsigned i = 0; i < 1000; ++i )
+        PhaseLatency::record(PhaseLatency::DETECT, 1000000);
+
+    PhaseLatency::prep_counts(stats);
+    CHECK( stats.detect_p99_nsecs > 0 );
+
+    SECTION( "empty after reset" )
+    {
+        PhaseLatency::reset();
+        PhaseLatency::prep_counts(stats);
+        CHECK( stats.detect_p50_nsecs == 0 );
+        CHECK( stats.detect_p99_nsecs == 0 );
+        CHECK( stats.detect_p999_nsecs == 0 );
+    }
+
+    SECTION( "only counts since reset" )
+    {
+        PhaseLatency::prep_counts(stats);
+        uint64_t before = stats.detect_p99_nsecs;
+
+        PhaseLatency::reset();
+
+        for ( unsigned i = 0; i < 1000; ++i )
+            PhaseLatency::record(PhaseLatency::DETECT, 1000);
+
+        PhaseLatency::prep_counts(stats);
+        CHECK( stats.detect_p99_nsecs > 0 );
+        CHECK( stats.detect_p99_nsecs < before );
+    }
+
+    PhaseLatency::tterm();
+}
+
+#endif
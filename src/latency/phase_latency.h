@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// phase_latency.h author Cisco
+
+#ifndef PHASE_LATENCY_H
+#define PHASE_LATENCY_H
+
+// Per packet thread latency histograms of the processing phases.  Enabled
+// with latency.packet.histograms; the percentiles are reported by the
+// latency pegs, perf_monitor, and latency.show_histograms().
+//
+// The phases nest: packet covers inspect and detect, the same span as
+// packet latency, and inspect covers stream.  Decode and log are timed
+// before and after the packet phase.
+
+#include <cstdint>
+#include <string>
+
+#include "time/clock_defs.h"
+
+struct LatencyStats;
+
+class PhaseLatency
+{
+public:
+    enum Phase : uint8_t
+    {
+        PACKET, DECODE, STREAM, INSPECT, DETECT, LOG, MAX_PHASE
+    };
+
+    static bool enabled();
+    static void record(Phase, uint64_t ticks);
+
+    static void prep_counts(LatencyStats&);
+    static std::string get_summary(unsigned thread_id);
+
+    // start over, for the next perf_monitor interval or reset_stats
+    static void reset();
+
+    static void tterm();
+
+    class Context
+    {
+    public:
+        Context(Phase ph) : phase(ph), on(PhaseLatency::enabled())
+        {
+            if ( on )
+                start = SnortClock::now();
+        }
+
+        ~Context()
+        {
+            if ( on )
+            {
+                hr_duration elapsed = SnortClock::now() - start;
+                PhaseLatency::record(phase, TO_TICKS(elapsed));
+            }
+        }
+
+    private:
+        hr_time start = hr_time();
+        Phase phase;
+        bool on;
+    };
+};
+
+#endif
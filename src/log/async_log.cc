@@ -0,0 +1,246 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// async_log.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "async_log.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <thread>
+#include <vector>
+
+#include "main/snort_config.h"
+#include "main/thread_config.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+THREAD_LOCAL AsyncLogStats async_log_stats;
+
+namespace
+{
+struct Record
+{
+    AsyncLog::Sink sink;
+    void* ctx;
+    char* data;
+    unsigned len;
+};
+
+// the indices are padded to separate cache lines since each is written by
+// one side and polled by the other
+class RecordRing
+{
+public:
+    RecordRing(unsigned size) : mask(size - 1)
+    {
+        assert(size and !(size & mask));
+        store = new Record[size];
+    }
+
+    ~RecordRing()
+    { delete[] store; }
+
+    // producer
+    bool put(const Record& r)
+    {
+        unsigned h = head.load(std::memory_order_relaxed);
+
+        if ( h - tail.load(std::memory_order_acquire) > mask )
+            return false;
+
+        store[h & mask] = r;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer, the record stays queued until it is popped so the producer
+    // can tell when it has been written
+    Record* peek()
+    {
+        unsigned t = tail.load(std::memory_order_relaxed);
+
+        if ( t == head.load(std::memory_order_acquire) )
+            return nullptr;
+
+        return store + (t & mask);
+    }
+
+    void pop()
+    { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    unsigned count() const
+    { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<unsigned> head { 0 };
+    char pad[64 - sizeof(std::atomic<unsigned>)];
+    std::atomic<unsigned> tail { 0 };
+    Record* store;
+    const unsigned mask;
+};
+}
+
+static std::vector<RecordRing*> rings;
+static std::thread* writer = nullptr;
+static std::atomic<bool> running { false };
+static bool drop_when_full = false;
+
+static THREAD_LOCAL RecordRing* local_ring = nullptr;
+
+static constexpr std::chrono::microseconds idle_wait(500);
+static constexpr std::chrono::microseconds full_wait(50);
+
+// records taken from one ring before moving on to the next
+static constexpr unsigned max_batch = 64;
+
+// the largest queue_size, so the ring size can't overflow
+static constexpr unsigned max_ring = 1u << 16;
+
+static unsigned drain_rings(unsigned batch)
+{
+    unsigned written = 0;
+
+    for ( auto* ring : rings )
+    {
+        unsigned n = 0;
+        Record* r;
+
+        while ( n < batch and (r = ring->peek()) )
+        {
+            r->sink(r->ctx, r->data, r->len);
+            snort_free(r->data);
+            ring->pop();
+            ++n;
+        }
+        written += n;
+    }
+    return written;
+}
+
+static void writer_loop()
+{
+    while ( running.load(std::memory_order_acquire) )
+    {
+        if ( !drain_rings(max_batch) )
+            std::this_thread::sleep_for(idle_wait);
+    }
+
+    // the packet threads have exited but may have left some behind
+    drain_rings(UINT_MAX);
+}
+
+void AsyncLog::start(const SnortConfig* sc)
+{
+    if ( !sc->async_log_queue or writer )
+        return;
+
+    assert(sc->async_log_queue <= max_ring);
+    unsigned size = 1;
+
+    while ( size < sc->async_log_queue and size < max_ring )
+        size <<= 1;
+
+    for ( unsigned i = 0; i < ThreadConfig::get_instance_max(); ++i )
+        rings.emplace_back(new RecordRing(size));
+
+    drop_when_full = sc->async_log_drop;
+    running = true;
+    writer = new std::thread(writer_loop);
+}
+
+void AsyncLog::stop()
+{
+    if ( !writer )
+        return;
+
+    running = false;
+    writer->join();
+    delete writer;
+    writer = nullptr;
+
+    for ( auto* ring : rings )
+        delete ring;
+
+    rings.clear();
+}
+
+void AsyncLog::thread_init()
+{
+    unsigned id = get_instance_id();
+
+    if ( id < rings.size() )
+        local_ring = rings[id];
+}
+
+void AsyncLog::thread_term()
+{
+    if ( local_ring )
+    {
+        drain();
+        local_ring = nullptr;
+    }
+}
+
+bool AsyncLog::active()
+{ return local_ring != nullptr; }
+
+bool AsyncLog::write(Sink sink, void* ctx, char* data, unsigned len)
+{
+    assert(local_ring);
+    Record r { sink, ctx, data, len };
+
+    if ( !local_ring->put(r) )
+    {
+        if ( drop_when_full )
+        {
+            snort_free(data);
+            ++async_log_stats.dropped;
+            return false;
+        }
+
+        ++async_log_stats.blocked;
+
+        while ( !local_ring->put(r) )
+            std::this_thread::sleep_for(full_wait);
+    }
+
+    ++async_log_stats.queued;
+
+    PegCount n = local_ring->count();
+
+    if ( n > async_log_stats.max_queued )
+        async_log_stats.max_queued = n;
+
+    return true;
+}
+
+void AsyncLog::drain()
+{
+    if ( !local_ring )
+        return;
+
+    while ( local_ring->count() )
+        std::this_thread::sleep_for(full_wait);
+}
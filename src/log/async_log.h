@@ -0,0 +1,76 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// async_log.h author Cisco
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+// Moves log file writes off the packet threads.  Each packet thread queues
+// its filled buffers on its own single producer, single consumer ring and
+// a dedicated writer thread drains all the rings and does the writes, so a
+// slow disk only delays the writer.  When a ring is full the packet thread
+// either waits for the writer or drops the buffer, as configured.
+//
+// Records are written in the order they were queued by each thread.  A
+// sink must stay valid until the thread that queued to it has drained.
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+#include "main/thread.h"
+
+namespace snort
+{
+struct SnortConfig;
+}
+
+struct AsyncLogStats
+{
+    PegCount queued;
+    PegCount dropped;
+    PegCount blocked;
+    PegCount max_queued;
+};
+
+extern THREAD_LOCAL AsyncLogStats async_log_stats;
+
+class SO_PUBLIC AsyncLog
+{
+public:
+    // called by the writer thread with each queued buffer
+    typedef void (*Sink)(void* ctx, const char* data, unsigned len);
+
+    // main thread, before the packet threads start and after they exit
+    static void start(const snort::SnortConfig*);
+    static void stop();
+
+    // packet threads
+    static void thread_init();
+    static void thread_term();
+
+    // true if writes from this thread go to the writer thread
+    static bool active();
+
+    // takes ownership of data, which must be from snort_alloc; returns
+    // false if it was dropped
+    static bool write(Sink, void* ctx, char* data, unsigned len);
+
+    // wait until everything this thread queued is written
+    static void drain();
+};
+
+#endif
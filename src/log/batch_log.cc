@@ -0,0 +1,179 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// batch_log.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "batch_log.h"
+
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+
+#include "framework/data_bus.h"
+#include "pub_sub/intrinsic_event_ids.h"
+#include "time/packet_time.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// handlers
+//--------------------------------------------------------------------------
+
+namespace
+{
+// don't leave records unwritten while there is no traffic
+class BatchIdleHandler : public DataHandler
+{
+public:
+    BatchIdleHandler(SnortConfig& sc, const char* mod_name, BatchLog::Get g) :
+        DataHandler(mod_name), get(g)
+    { DataBus::subscribe_global(intrinsic_pub_key, IntrinsicEventIds::THREAD_IDLE, this, sc); }
+
+    void handle(DataEvent&, Flow*) override
+    {
+        if ( BatchLog* batch = get() )
+            batch->flush();
+    }
+
+private:
+    BatchLog::Get get;
+};
+
+// nor while there is traffic but nothing else to log
+class BatchPacketHandler : public DataHandler
+{
+public:
+    BatchPacketHandler(SnortConfig& sc, const char* mod_name, BatchLog::Get g) :
+        DataHandler(mod_name), get(g)
+    { DataBus::subscribe_global(intrinsic_pub_key, IntrinsicEventIds::WIRE_PACKET, this, sc); }
+
+    void handle(DataEvent&, Flow*) override
+    {
+        if ( BatchLog* batch = get() )
+            batch->flush_if_due(packet_time());
+    }
+
+private:
+    BatchLog::Get get;
+};
+}
+
+//--------------------------------------------------------------------------
+// batch log
+//--------------------------------------------------------------------------
+
+void BatchLog::subscribe(SnortConfig& sc, const char* mod_name, Get get)
+{
+    new BatchIdleHandler(sc, mod_name, get);
+    new BatchPacketHandler(sc, mod_name, get);
+}
+
+bool BatchLog::write(AsyncLog::Sink sink, void* out, char* data, unsigned len)
+{
+    if ( AsyncLog::active() )
+    {
+        AsyncLog::write(sink, out, data, len);
+        return true;
+    }
+    sink(out, data, len);
+    return false;
+}
+
+int BatchLog::write_all(int fd, const void* data, size_t len)
+{
+    const uint8_t* buf = (const uint8_t*)data;
+    int max_retries = 3;
+
+    // no fsync(), it is a total performance killer
+    while ( len )
+    {
+        ssize_t n = ::write(fd, buf, len);
+
+        if ( n < 0 )
+        {
+            // don't loop forever if the write is constantly interrupted
+            if ( errno == EINTR and --max_retries > 0 )
+                continue;
+
+            return errno;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// batch buffer
+//--------------------------------------------------------------------------
+
+BatchBuffer::BatchBuffer(size_t sz, size_t max_record, unsigned seconds,
+    void* o, AsyncLog::Sink write, AsyncLog::Sink roll_write) :
+    BatchLog(seconds), out(o), write_sink(write), roll_sink(roll_write)
+{
+    size = sz > max_record ? sz : max_record;
+    block = (uint8_t*)snort_alloc(size);
+    each = !sz;
+}
+
+BatchBuffer::~BatchBuffer()
+{
+    snort_free(block);
+}
+
+uint8_t* BatchBuffer::reserve(size_t len)
+{
+    assert(len <= size);
+
+    if ( used + len > size )
+        flush();
+
+    return block + used;
+}
+
+void BatchBuffer::commit(size_t len)
+{
+    assert(used + len <= size);
+
+    const time_t now = packet_time();
+    hold(now);
+    used += len;
+
+    if ( each or due(now) )
+        flush();
+}
+
+void BatchBuffer::flush()
+{
+    release();
+
+    if ( !used )
+        return;
+
+    if ( write(rolling ? roll_sink : write_sink, out, (char*)block, used) )
+        block = (uint8_t*)snort_alloc(size);
+
+    used = 0;
+    rolling = false;
+}
+
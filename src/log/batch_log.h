@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// batch_log.h author Cisco
+
+#ifndef BATCH_LOG_H
+#define BATCH_LOG_H
+
+// Binary loggers collect what they log in a per thread batch and write it
+// together.  A batch is written when the logger finds it full, when the
+// packet thread is idle, and once its oldest record has waited for the
+// given seconds of packet time.  That is checked as each packet is
+// received, so a lone record doesn't wait for another alert or for the
+// traffic to stop.  With async logging the batch itself is handed to the
+// writer thread, which then owns the file, so the packet thread never
+// waits on the disk.
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "log/async_log.h"
+#include "main/snort_types.h"
+
+namespace snort
+{
+struct SnortConfig;
+}
+
+class SO_PUBLIC BatchLog
+{
+public:
+    virtual ~BatchLog() = default;
+
+    // write what is held now
+    virtual void flush() = 0;
+
+    void flush_if_due(time_t now)
+    {
+        if ( due(now) )
+            flush();
+    }
+
+    // returns the batch of the calling packet thread, if any
+    typedef BatchLog* (*Get)();
+
+    // configure time; has the batches of a logger written when the thread
+    // is idle and when they are due
+    static void subscribe(snort::SnortConfig&, const char* mod_name, Get);
+
+    // write len bytes of data, from snort_alloc(), with the sink; returns
+    // true if the data went to the writer thread and the caller needs a
+    // new buffer
+    static bool write(AsyncLog::Sink, void* out, char* data, unsigned len);
+
+    // write all of data to fd, retrying interrupted writes a few times;
+    // returns 0 or errno
+    static int write_all(int fd, const void* data, size_t len);
+
+protected:
+    // seconds is how long a record may be held, 0 is no limit
+    BatchLog(unsigned s) : seconds(s) { }
+
+    // call with each record added, only the first one starts the clock
+    void hold(time_t now)
+    {
+        if ( !held )
+        {
+            deadline = now + seconds;
+            held = true;
+        }
+    }
+
+    void release()
+    { held = false; }
+
+    bool due(time_t now) const
+    { return held and seconds and now >= deadline; }
+
+private:
+    time_t deadline = 0;
+    unsigned seconds;
+    bool held = false;
+};
+
+// records are built in place in a block which is written with one write;
+// records never span blocks and a roll starts a new file just before the
+// next block is written
+class SO_PUBLIC BatchBuffer : public BatchLog
+{
+public:
+    // a size of 0 writes each record as it is committed; the block is
+    // never smaller than the largest record
+    BatchBuffer(size_t size, size_t max_record, unsigned seconds,
+        void* out, AsyncLog::Sink write, AsyncLog::Sink roll_write);
+
+    ~BatchBuffer() override;
+
+    // where to put a record of len bytes, writing the block first if the
+    // record doesn't fit
+    uint8_t* reserve(size_t len);
+
+    // add the record put at reserve(), writing the block if due
+    void commit(size_t len);
+
+    void flush() override;
+
+    // the next block starts a new file
+    void roll()
+    { rolling = true; }
+
+    // drop what is held
+    void discard()
+    { used = 0; release(); }
+
+    size_t get_size() const
+    { return size; }
+
+    size_t get_used() const
+    { return used; }
+
+private:
+    uint8_t* block;
+    size_t size;
+    size_t used = 0;
+
+    void* out;
+    AsyncLog::Sink write_sink;
+    AsyncLog::Sink roll_sink;
+
+    bool each;
+    bool rolling = false;
+};
+
+#endif
+
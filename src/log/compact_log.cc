@@ -0,0 +1,167 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// compact_log.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "compact_log.h"
+
+#include <zlib.h>
+
+#include <cassert>
+#include <cstring>
+
+enum U32Column
+{ SECOND, MICROSECOND, EVENT_ID, GID, SID, REV, CLASS_ID, PRIORITY, PAYLOAD_LEN };
+
+CompactBlock::CompactBlock(unsigned max) : max_events(max)
+{
+    for ( auto& col : u32 )
+        col = new uint32_t[max_events];
+
+    src_ip = new uint8_t[max_events * 16];
+    dst_ip = new uint8_t[max_events * 16];
+    src_port = new uint16_t[max_events];
+    dst_port = new uint16_t[max_events];
+    ip_proto = new uint8_t[max_events];
+    action = new uint8_t[max_events];
+
+    clear();
+}
+
+CompactBlock::~CompactBlock()
+{
+    for ( auto col : u32 )
+        delete[] col;
+
+    delete[] src_ip;
+    delete[] dst_ip;
+    delete[] src_port;
+    delete[] dst_port;
+    delete[] ip_proto;
+    delete[] action;
+}
+
+void CompactBlock::clear()
+{
+    memset(&summary, 0, sizeof(summary));
+    summary.min_sid = UINT32_MAX;
+    payload.clear();
+}
+
+uint8_t* CompactBlock::add(const CompactEvent& e, uint32_t len)
+{
+    assert(!full());
+    unsigned n = summary.events++;
+
+    u32[SECOND][n] = e.second;
+    u32[MICROSECOND][n] = e.microsecond;
+    u32[EVENT_ID][n] = e.event_id;
+    u32[GID][n] = e.gid;
+    u32[SID][n] = e.sid;
+    u32[REV][n] = e.rev;
+    u32[CLASS_ID][n] = e.class_id;
+    u32[PRIORITY][n] = e.priority;
+    u32[PAYLOAD_LEN][n] = len;
+
+    memcpy(src_ip + n * 16, e.src_ip, 16);
+    memcpy(dst_ip + n * 16, e.dst_ip, 16);
+    src_port[n] = e.src_port;
+    dst_port[n] = e.dst_port;
+    ip_proto[n] = e.ip_proto;
+    action[n] = e.action;
+
+    if ( !n or e.second < summary.first_second )
+        summary.first_second = e.second;
+
+    if ( e.second > summary.last_second )
+        summary.last_second = e.second;
+
+    if ( e.sid < summary.min_sid )
+        summary.min_sid = e.sid;
+
+    if ( e.sid > summary.max_sid )
+        summary.max_sid = e.sid;
+
+    summary.sids[(e.sid % COMPACT_SID_BITS) / 32] |= 1u << (e.sid % 32);
+
+    size_t off = payload.size();
+    payload.resize(off + len);
+    return len ? payload.data() + off : nullptr;
+}
+
+void CompactBlock::finish(std::vector<uint8_t>& out, int level)
+{
+    unsigned n = summary.events;
+    raw.resize(n * CompactColumns::event_size + payload.size());
+    uint8_t* p = raw.data();
+
+    for ( auto col : u32 )
+    {
+        memcpy(p, col, n * 4);
+        p += n * 4;
+    }
+
+    memcpy(p, src_ip, n * 16);
+    p += n * 16;
+    memcpy(p, dst_ip, n * 16);
+    p += n * 16;
+    memcpy(p, src_port, n * 2);
+    p += n * 2;
+    memcpy(p, dst_port, n * 2);
+    p += n * 2;
+    memcpy(p, ip_proto, n);
+    p += n;
+    memcpy(p, action, n);
+    p += n;
+
+    if ( !payload.empty() )
+        memcpy(p, payload.data(), payload.size());
+
+    CompactBlockHeader hdr;
+    hdr.magic = COMPACT_LOG_BLOCK_MAGIC;
+    hdr.flags = 0;
+    hdr.raw_size = raw.size();
+    hdr.summary = summary;
+
+    size_t start = out.size();
+    out.resize(start + sizeof(hdr) + compressBound(raw.size()));
+    uint8_t* data = out.data() + start + sizeof(hdr);
+
+    uLongf stored = out.size() - start - sizeof(hdr);
+
+    // keep the data as is if it doesn't get any smaller
+    if ( level and compress2(data, &stored, raw.data(), raw.size(), level) == Z_OK and
+        stored < raw.size() )
+    {
+        hdr.flags |= COMPACT_BLOCK_DEFLATE;
+    }
+    else
+    {
+        memcpy(data, raw.data(), raw.size());
+        stored = raw.size();
+    }
+
+    hdr.stored_size = stored;
+    memcpy(out.data() + start, &hdr, sizeof(hdr));
+    out.resize(start + sizeof(hdr) + stored);
+
+    clear();
+}
@@ -0,0 +1,93 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// compact_log.h author Cisco
+
+#ifndef COMPACT_LOG_H
+#define COMPACT_LOG_H
+
+// Builds the blocks of the compact event log described in
+// compact_log_format.h.  Events are added to per column arrays so a block
+// is serialized with one copy per column and compresses well since like
+// values are together.
+
+#include <vector>
+
+#include "log/compact_log_format.h"
+#include "main/snort_types.h"
+
+struct CompactEvent
+{
+    uint32_t second;
+    uint32_t microsecond;
+    uint32_t event_id;
+    uint32_t gid;
+    uint32_t sid;
+    uint32_t rev;
+    uint32_t class_id;
+    uint32_t priority;
+    const uint32_t* src_ip;  // 16 bytes
+    const uint32_t* dst_ip;
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint8_t ip_proto;
+    uint8_t action;
+};
+
+class SO_PUBLIC CompactBlock
+{
+public:
+    CompactBlock(unsigned max_events);
+    ~CompactBlock();
+
+    // returns where to put the payload, which is len bytes
+    uint8_t* add(const CompactEvent&, uint32_t len);
+
+    // appends the block to out and empties it; level is the zlib
+    // compression level or 0 to store the data as is
+    void finish(std::vector<uint8_t>& out, int level);
+
+    bool empty() const
+    { return !summary.events; }
+
+    bool full() const
+    { return summary.events >= max_events; }
+
+    const CompactBlockSummary& get_summary() const
+    { return summary; }
+
+private:
+    void clear();
+
+private:
+    const unsigned max_events;
+
+    uint32_t* u32[CompactColumns::u32_columns];
+    uint8_t* src_ip;
+    uint8_t* dst_ip;
+    uint16_t* src_port;
+    uint16_t* dst_port;
+    uint8_t* ip_proto;
+    uint8_t* action;
+
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> raw;
+
+    CompactBlockSummary summary;
+};
+
+#endif
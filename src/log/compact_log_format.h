@@ -0,0 +1,177 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// compact_log_format.h author Cisco
+
+#ifndef COMPACT_LOG_FORMAT_H
+#define COMPACT_LOG_FORMAT_H
+
+// Layout of the compact event log, shared by log_compact and the reader in
+// tools/compact_reader.  This header has no other dependencies.
+//
+// A file is a CompactFileHeader followed by blocks.  Each block is a
+// CompactBlockHeader followed by its data, which is deflated when the
+// header says so.  The data is columnar: each field of all the events in
+// the block is stored together, followed by the payloads of all the events.
+// A cleanly closed file ends with an index of all its blocks and a
+// CompactTrailer, so a reader can map the file, read the index from the
+// end and skip the blocks which can't match by time or sid without
+// reading them.  The same summary is in each block header so a file which
+// was not closed can still be read sequentially.
+//
+// Until the file is closed, the index entry of each block is also appended
+// to a file of the same name plus COMPACT_LOG_INDEX_SUFFIX once the block
+// is written.  That file is removed when the index is put in the log so a
+// reader of a log which was not closed can still use the index for all
+// but the blocks which were written last.
+//
+// Everything is in host byte order; a reader on the other byte order sees
+// a wrong magic number.
+
+#include <cstdint>
+
+#define COMPACT_LOG_MAGIC        0x4c454353  // "SCEL"
+#define COMPACT_LOG_BLOCK_MAGIC  0x4b4c4253  // "SBLK"
+#define COMPACT_LOG_INDEX_MAGIC  0x58444e49  // "INDX"
+#define COMPACT_LOG_VERSION      1
+
+#define COMPACT_LOG_INDEX_SUFFIX ".idx"
+
+#define COMPACT_BLOCK_DEFLATE    0x1
+
+#define COMPACT_SID_BITS         256
+
+struct CompactFileHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t linktype;   // of the payloads
+    uint32_t created;    // seconds
+};
+
+// the events in a block, from the block header or the index
+struct CompactBlockSummary
+{
+    uint32_t first_second;
+    uint32_t last_second;
+    uint32_t events;
+    uint32_t min_sid;
+    uint32_t max_sid;
+    uint32_t sids[COMPACT_SID_BITS / 32];  // bit sid % COMPACT_SID_BITS of each sid
+
+    bool overlaps(uint32_t from, uint32_t to) const
+    { return first_second <= to and last_second >= from; }
+
+    bool may_have_sid(uint32_t sid) const
+    {
+        return sid >= min_sid and sid <= max_sid and
+            (sids[(sid % COMPACT_SID_BITS) / 32] & (1u << (sid % 32)));
+    }
+};
+
+struct CompactBlockHeader
+{
+    uint32_t magic;
+    uint32_t flags;
+    uint32_t raw_size;     // of the columns and payloads
+    uint32_t stored_size;  // of the data following the header
+    CompactBlockSummary summary;
+};
+
+struct CompactIndexEntry
+{
+    uint64_t offset;  // of the block header
+    CompactBlockSummary summary;
+};
+
+// the last bytes of a closed file
+struct CompactTrailer
+{
+    uint64_t index_offset;
+    uint32_t blocks;
+    uint32_t magic;
+};
+
+// the columns of a block in the order they are stored, fixed size fields
+// first so each is naturally aligned in the data
+struct CompactColumns
+{
+    const uint32_t* second;
+    const uint32_t* microsecond;
+    const uint32_t* event_id;
+    const uint32_t* gid;
+    const uint32_t* sid;
+    const uint32_t* rev;
+    const uint32_t* class_id;
+    const uint32_t* priority;
+    const uint32_t* payload_len;
+    const uint8_t* src_ip;       // 16 bytes each, ip4 is mapped
+    const uint8_t* dst_ip;
+    const uint16_t* src_port;    // or icmp type
+    const uint16_t* dst_port;    // or icmp code
+    const uint8_t* ip_proto;
+    const uint8_t* action;
+    const uint8_t* payload;      // all payloads back to back
+    uint32_t payload_size;
+
+    static constexpr unsigned u32_columns = 9;
+    static constexpr unsigned event_size = u32_columns * 4 + 2 * 16 + 2 * 2 + 2;
+
+    // false if the data is too short for the given number of events
+    bool map(const uint8_t* data, uint32_t size, uint32_t events)
+    {
+        if ( (uint64_t)events * event_size > size )
+            return false;
+
+        const uint32_t** u32[u32_columns] =
+        { &second, &microsecond, &event_id, &gid, &sid, &rev, &class_id, &priority, &payload_len };
+
+        for ( auto col : u32 )
+        {
+            *col = (const uint32_t*)data;
+            data += events * 4;
+        }
+
+        src_ip = data;
+        data += events * 16;
+        dst_ip = data;
+        data += events * 16;
+
+        src_port = (const uint16_t*)data;
+        data += events * 2;
+        dst_port = (const uint16_t*)data;
+        data += events * 2;
+
+        ip_proto = data;
+        data += events;
+        action = data;
+        data += events;
+
+        payload = data;
+        payload_size = size - events * event_size;
+
+        uint64_t total = 0;
+
+        for ( uint32_t i = 0; i < events; ++i )
+            total += payload_len[i];
+
+        return total <= payload_size;
+    }
+};
+
+#endif
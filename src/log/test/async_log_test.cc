@@ -0,0 +1,348 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// async_log_test.cc author Cisco
+
+// unit test main
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../async_log.h"
+#include "../messages.h"
+#include "../text_log.h"
+
+#include "main/snort_config.h"
+#include "main/thread_config.h"
+#include "utils/util.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+static THREAD_LOCAL unsigned instance_id = 0;
+static std::string log_dir;
+
+namespace snort
+{
+SnortConfig::SnortConfig(const SnortConfig* const, const char*) { }
+SnortConfig::~SnortConfig() = default;
+
+unsigned get_instance_id() { return instance_id; }
+
+// like the real one, only right on the packet thread
+const char* get_instance_file(std::string& file, const char* name)
+{
+    file = log_dir + '/' + std::to_string(instance_id) + '_' + name;
+    return file.c_str();
+}
+
+char* snort_strdup(const char* s)
+{ return strdup(s); }
+
+const char* get_error(int errnum)
+{ return strerror(errnum); }
+
+[[noreturn]] void FatalError(const char* format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+    exit(1);
+}
+}
+
+unsigned ThreadConfig::get_instance_max() { return 2; }
+
+//--------------------------------------------------------------------------
+// output
+//--------------------------------------------------------------------------
+
+// the writer thread waits in the sink while the gate is closed, holding
+// the first queued record
+static std::atomic<bool> gate_open { true };
+
+static std::mutex written_mutex;
+static std::vector<unsigned> written;
+
+static void sink(void*, const char* data, unsigned len)
+{
+    while ( !gate_open )
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+    unsigned id;
+    CHECK(len == sizeof(id));
+    memcpy(&id, data, sizeof(id));
+
+    std::lock_guard<std::mutex> lock(written_mutex);
+    written.emplace_back(id);
+}
+
+static bool put(unsigned id)
+{
+    char* data = (char*)snort_alloc(sizeof(id));
+    memcpy(data, &id, sizeof(id));
+    return AsyncLog::write(sink, nullptr, data, sizeof(id));
+}
+
+static void open_gate_later()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gate_open = true;
+}
+
+static std::string read_file(const std::string& path)
+{
+    std::string s;
+    FILE* f = fopen(path.c_str(), "r");
+
+    if ( !f )
+        return s;
+
+    char buf[256];
+    size_t n;
+
+    while ( (n = fread(buf, 1, sizeof(buf), f)) > 0 )
+        s.append(buf, n);
+
+    fclose(f);
+    return s;
+}
+
+static std::vector<std::string> list_dir(const std::string& dir)
+{
+    std::vector<std::string> files;
+    DIR* d = opendir(dir.c_str());
+
+    while ( dirent* de = readdir(d) )
+    {
+        if ( de->d_name[0] != '.' )
+            files.emplace_back(de->d_name);
+    }
+    closedir(d);
+    return files;
+}
+
+static std::vector<unsigned> ids(unsigned from, unsigned to)
+{
+    std::vector<unsigned> v;
+
+    for ( unsigned id = from; id < to; ++id )
+        v.emplace_back(id);
+
+    return v;
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(async_log)
+{
+    SnortConfig sc;
+
+    void setup() override
+    {
+        gate_open = true;
+        written.clear();
+        memset(&async_log_stats, 0, sizeof(async_log_stats));
+        sc.async_log_drop = false;
+    }
+
+    void start(unsigned queue)
+    {
+        sc.async_log_queue = queue;
+        AsyncLog::start(&sc);
+        AsyncLog::thread_init();
+        CHECK_TRUE(AsyncLog::active());
+    }
+
+    void teardown() override
+    {
+        gate_open = true;
+        AsyncLog::thread_term();
+        CHECK_FALSE(AsyncLog::active());
+        AsyncLog::stop();
+    }
+};
+
+TEST(async_log, written_in_order)
+{
+    start(8);
+
+    for ( unsigned id = 0; id < 100; ++id )
+        CHECK_TRUE(put(id));
+
+    AsyncLog::drain();
+    CHECK(ids(0, 100) == written);
+    LONGS_EQUAL(100, async_log_stats.queued);
+    CHECK(async_log_stats.max_queued <= 8);
+}
+
+TEST(async_log, full_queue_drops)
+{
+    sc.async_log_drop = true;
+
+    // rounded up to 8
+    start(5);
+    gate_open = false;
+
+    for ( unsigned id = 0; id < 8; ++id )
+        CHECK_TRUE(put(id));
+
+    CHECK_FALSE(put(8));
+    LONGS_EQUAL(1, async_log_stats.dropped);
+    LONGS_EQUAL(8, async_log_stats.queued);
+    LONGS_EQUAL(8, async_log_stats.max_queued);
+
+    gate_open = true;
+    AsyncLog::drain();
+    CHECK(ids(0, 8) == written);
+}
+
+TEST(async_log, full_queue_blocks)
+{
+    start(1);
+    gate_open = false;
+
+    CHECK_TRUE(put(0));
+
+    std::thread opener(open_gate_later);
+    CHECK_TRUE(put(1));
+    opener.join();
+
+    LONGS_EQUAL(1, async_log_stats.blocked);
+    LONGS_EQUAL(0, async_log_stats.dropped);
+
+    AsyncLog::drain();
+    CHECK(ids(0, 2) == written);
+}
+
+TEST(async_log, largest_queue)
+{
+    sc.async_log_drop = true;
+    start(65536);
+    gate_open = false;
+
+    for ( unsigned id = 0; id < 65536; ++id )
+        put(id);
+
+    CHECK_FALSE(put(65536));
+    LONGS_EQUAL(65536, async_log_stats.queued);
+
+    gate_open = true;
+    AsyncLog::drain();
+    LONGS_EQUAL(65536, written.size());
+}
+
+TEST(async_log, stop_writes_what_exited_threads_left)
+{
+    start(16);
+    gate_open = false;
+
+    // a packet thread which exits without draining
+    std::thread packet_thread([]()
+    {
+        instance_id = 1;
+        AsyncLog::thread_init();
+
+        for ( unsigned id = 0; id < 10; ++id )
+            put(id);
+    });
+    packet_thread.join();
+
+    // this thread queued nothing
+    AsyncLog::thread_term();
+
+    std::thread opener(open_gate_later);
+    AsyncLog::stop();
+    opener.join();
+
+    CHECK(ids(0, 10) == written);
+}
+
+TEST(async_log, text_log_rolls_on_writer)
+{
+    char dir[] = "/tmp/async_log_test.XXXXXX";
+    CHECK(mkdtemp(dir));
+    log_dir = dir;
+
+    start(8);
+
+    std::thread packet_thread([]()
+    {
+        instance_id = 1;
+        AsyncLog::thread_init();
+
+        TextLog* txt = TextLog_Init("alert.txt", 0, 16);
+        TextLog_Print(txt, "first line\n");
+        TextLog_Flush(txt);
+        AsyncLog::drain();
+
+        // files are not rolled more than once a second
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+        TextLog_Print(txt, "second line\n");
+        TextLog_Flush(txt);
+        TextLog_Term(txt);
+
+        AsyncLog::thread_term();
+    });
+    packet_thread.join();
+
+    std::vector<std::string> files = list_dir(log_dir);
+    LONGS_EQUAL(2, files.size());
+
+    for ( const auto& f : files )
+    {
+        std::string path = log_dir + '/' + f;
+
+        if ( f == "1_alert.txt" )
+            CHECK(read_file(path) == "second line\n");
+        else
+        {
+            CHECK(f.compare(0, 12, "1_alert.txt.") == 0);
+            CHECK(read_file(path) == "first line\n");
+        }
+        unlink(path.c_str());
+    }
+    rmdir(dir);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
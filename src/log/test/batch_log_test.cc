@@ -0,0 +1,301 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// batch_log_test.cc author Cisco
+// unit test main
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "../batch_log.h"
+
+#include "framework/data_bus.h"
+#include "pub_sub/intrinsic_event_ids.h"
+#include "utils/util.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+static time_t now = 0;
+static bool async = false;
+static unsigned queued = 0;
+static DataHandler* handlers[IntrinsicEventIds::num_ids];
+
+namespace snort
+{
+time_t packet_time() { return now; }
+
+void DataBus::subscribe_global(const PubKey&, unsigned id, DataHandler* h, SnortConfig&)
+{ handlers[id] = h; }
+}
+
+bool AsyncLog::active() { return async; }
+
+// the writer thread is done inline
+bool AsyncLog::write(Sink sink, void* ctx, char* data, unsigned len)
+{
+    ++queued;
+    sink(ctx, data, len);
+    snort_free(data);
+    return true;
+}
+
+//--------------------------------------------------------------------------
+// output
+//--------------------------------------------------------------------------
+
+struct Out
+{
+    FILE* fh;
+    unsigned writes;
+    unsigned rolls;
+};
+
+static void write_out(void* o, const char* data, unsigned len)
+{
+    Out* out = (Out*)o;
+    ++out->writes;
+    LONGS_EQUAL(0, BatchLog::write_all(fileno(out->fh), data, len));
+}
+
+static void roll_write_out(void* o, const char* data, unsigned len)
+{
+    ++((Out*)o)->rolls;
+    write_out(o, data, len);
+}
+
+static long on_disk(const Out& out)
+{
+    struct stat st;
+    fstat(fileno(out.fh), &st);
+    return st.st_size;
+}
+
+static BatchLog* batch = nullptr;
+
+static BatchLog* get_batch()
+{ return batch; }
+
+static void packet()
+{
+    BareDataEvent e;
+    handlers[IntrinsicEventIds::WIRE_PACKET]->handle(e, nullptr);
+}
+
+static void idle()
+{
+    BareDataEvent e;
+    handlers[IntrinsicEventIds::THREAD_IDLE]->handle(e, nullptr);
+}
+
+static void add(BatchBuffer& b, size_t len, char c)
+{
+    memset(b.reserve(len), c, len);
+    b.commit(len);
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(batch_log)
+{
+    Out out;
+
+    void setup() override
+    {
+        out.fh = tmpfile();
+        out.writes = out.rolls = 0;
+        now = 100;
+        async = false;
+        queued = 0;
+    }
+
+    void teardown() override
+    {
+        fclose(out.fh);
+        batch = nullptr;
+    }
+};
+
+TEST(batch_log, lone_record_written_when_due)
+{
+    BatchBuffer b(4096, 64, 1, &out, write_out, roll_write_out);
+    batch = &b;
+
+    add(b, 10, 'a');
+    packet();
+    LONGS_EQUAL(0, on_disk(out));
+
+    // no more records, but the next packet a second later writes it
+    now = 101;
+    packet();
+    LONGS_EQUAL(10, on_disk(out));
+    LONGS_EQUAL(1, out.writes);
+
+    packet();
+    LONGS_EQUAL(1, out.writes);
+}
+
+TEST(batch_log, deadline_from_first_record)
+{
+    BatchBuffer b(4096, 64, 2, &out, write_out, roll_write_out);
+    batch = &b;
+
+    add(b, 10, 'a');
+    now = 101;
+    add(b, 10, 'b');
+    LONGS_EQUAL(0, out.writes);
+
+    now = 102;
+    packet();
+    LONGS_EQUAL(20, on_disk(out));
+}
+
+TEST(batch_log, due_on_commit)
+{
+    BatchBuffer b(4096, 64, 1, &out, write_out, roll_write_out);
+
+    add(b, 10, 'a');
+    now = 101;
+    add(b, 10, 'b');
+    LONGS_EQUAL(1, out.writes);
+    LONGS_EQUAL(20, on_disk(out));
+}
+
+TEST(batch_log, idle_writes_partial_batch)
+{
+    BatchBuffer b(4096, 64, 1, &out, write_out, roll_write_out);
+    batch = &b;
+
+    idle();
+    LONGS_EQUAL(0, out.writes);
+
+    add(b, 10, 'a');
+    idle();
+    LONGS_EQUAL(10, on_disk(out));
+    LONGS_EQUAL(0, b.get_used());
+}
+
+TEST(batch_log, full_batch_written_first)
+{
+    BatchBuffer b(64, 64, 1, &out, write_out, roll_write_out);
+
+    add(b, 40, 'a');
+    add(b, 40, 'b');
+    LONGS_EQUAL(1, out.writes);
+    LONGS_EQUAL(40, on_disk(out));
+    LONGS_EQUAL(40, b.get_used());
+
+    b.flush();
+    LONGS_EQUAL(80, on_disk(out));
+
+    char buf[80];
+    rewind(out.fh);
+    LONGS_EQUAL(1, fread(buf, sizeof(buf), 1, out.fh));
+    CHECK(buf[0] == 'a' and buf[39] == 'a' and buf[40] == 'b' and buf[79] == 'b');
+}
+
+TEST(batch_log, unbatched_writes_each_record)
+{
+    BatchBuffer b(0, 64, 1, &out, write_out, roll_write_out);
+    LONGS_EQUAL(64, b.get_size());
+
+    add(b, 10, 'a');
+    add(b, 64, 'b');
+    LONGS_EQUAL(2, out.writes);
+    LONGS_EQUAL(74, on_disk(out));
+}
+
+TEST(batch_log, roll_starts_next_block)
+{
+    BatchBuffer b(4096, 64, 1, &out, write_out, roll_write_out);
+
+    b.roll();
+    b.flush();
+    LONGS_EQUAL(0, out.rolls);
+
+    add(b, 10, 'a');
+    b.flush();
+    LONGS_EQUAL(1, out.rolls);
+
+    add(b, 10, 'a');
+    b.flush();
+    LONGS_EQUAL(1, out.rolls);
+    LONGS_EQUAL(2, out.writes);
+}
+
+TEST(batch_log, async_hands_off_block)
+{
+    async = true;
+    BatchBuffer b(4096, 64, 1, &out, write_out, roll_write_out);
+
+    add(b, 10, 'a');
+    b.flush();
+    add(b, 20, 'b');
+    b.flush();
+    LONGS_EQUAL(2, queued);
+    LONGS_EQUAL(30, on_disk(out));
+}
+
+TEST(batch_log, no_time_limit)
+{
+    BatchBuffer b(4096, 64, 0, &out, write_out, roll_write_out);
+    batch = &b;
+
+    add(b, 10, 'a');
+    now = 1000;
+    packet();
+    add(b, 10, 'a');
+    LONGS_EQUAL(0, out.writes);
+
+    b.discard();
+    idle();
+    LONGS_EQUAL(0, out.writes);
+}
+
+TEST(batch_log, no_batch_on_thread)
+{
+    packet();
+    idle();
+    LONGS_EQUAL(0, out.writes);
+}
+
+int main(int argc, char** argv)
+{
+    static uint64_t conf;
+    BatchLog::subscribe(*reinterpret_cast<SnortConfig*>(&conf), "test", get_batch);
+
+    int ret = CommandLineTestRunner::RunAllTests(argc, argv);
+
+    for ( auto* h : handlers )
+        delete h;
+
+    return ret;
+}
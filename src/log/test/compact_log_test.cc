@@ -0,0 +1,233 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// compact_log_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <zlib.h>
+
+#include <cstring>
+#include <vector>
+
+#include "../compact_log.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+static const uint32_t src[4] = { 0, 0, 0xffff0000, 0x0100000a };
+static const uint32_t dst[4] = { 1, 2, 3, 4 };
+
+static CompactEvent make_event(uint32_t n)
+{
+    CompactEvent e;
+    e.second = 1000 + n;
+    e.microsecond = n;
+    e.event_id = n;
+    e.gid = 1;
+    e.sid = 2000 + n * 300;
+    e.rev = 2;
+    e.class_id = 3;
+    e.priority = 4;
+    e.src_ip = src;
+    e.dst_ip = dst;
+    e.src_port = 1234;
+    e.dst_port = 80;
+    e.ip_proto = 6;
+    e.action = 1;
+    return e;
+}
+
+static void fill_block(CompactBlock& block, unsigned events)
+{
+    for ( unsigned i = 0; i < events; ++i )
+    {
+        uint8_t* p = block.add(make_event(i), i);
+
+        if ( p )
+            memset(p, 'a' + i, i);
+    }
+}
+
+// returns the raw data of the block at the start of buf
+static std::vector<uint8_t> read_block(const std::vector<uint8_t>& buf, CompactBlockHeader& hdr)
+{
+    CHECK(buf.size() >= sizeof(hdr));
+    memcpy(&hdr, buf.data(), sizeof(hdr));
+
+    CHECK(hdr.magic == COMPACT_LOG_BLOCK_MAGIC);
+    CHECK(buf.size() == sizeof(hdr) + hdr.stored_size);
+
+    std::vector<uint8_t> raw(hdr.raw_size);
+    const uint8_t* data = buf.data() + sizeof(hdr);
+
+    if ( hdr.flags & COMPACT_BLOCK_DEFLATE )
+    {
+        uLongf len = raw.size();
+        CHECK(uncompress(raw.data(), &len, data, hdr.stored_size) == Z_OK);
+        CHECK(len == hdr.raw_size);
+    }
+    else
+    {
+        CHECK(hdr.stored_size == hdr.raw_size);
+        memcpy(raw.data(), data, raw.size());
+    }
+    return raw;
+}
+
+static void check_columns(const std::vector<uint8_t>& raw, unsigned events)
+{
+    CompactColumns col;
+    CHECK(col.map(raw.data(), raw.size(), events));
+
+    const uint8_t* payload = col.payload;
+
+    for ( unsigned i = 0; i < events; ++i )
+    {
+        CompactEvent e = make_event(i);
+
+        CHECK(col.second[i] == e.second);
+        CHECK(col.microsecond[i] == e.microsecond);
+        CHECK(col.event_id[i] == e.event_id);
+        CHECK(col.gid[i] == e.gid);
+        CHECK(col.sid[i] == e.sid);
+        CHECK(col.rev[i] == e.rev);
+        CHECK(col.class_id[i] == e.class_id);
+        CHECK(col.priority[i] == e.priority);
+        CHECK(!memcmp(col.src_ip + i * 16, src, 16));
+        CHECK(!memcmp(col.dst_ip + i * 16, dst, 16));
+        CHECK(col.src_port[i] == e.src_port);
+        CHECK(col.dst_port[i] == e.dst_port);
+        CHECK(col.ip_proto[i] == e.ip_proto);
+        CHECK(col.action[i] == e.action);
+        CHECK(col.payload_len[i] == i);
+
+        for ( unsigned j = 0; j < i; ++j )
+            CHECK(payload[j] == 'a' + i);
+
+        payload += i;
+    }
+    CHECK(payload == col.payload + col.payload_size);
+}
+
+TEST_GROUP(compact_log)
+{ };
+
+TEST(compact_log, summary)
+{
+    CompactBlock block(8);
+    CHECK(block.empty());
+
+    fill_block(block, 8);
+    CHECK(block.full());
+
+    const CompactBlockSummary& s = block.get_summary();
+    CHECK(s.events == 8);
+    CHECK(s.first_second == 1000);
+    CHECK(s.last_second == 1007);
+    CHECK(s.min_sid == 2000);
+    CHECK(s.max_sid == 4100);
+
+    for ( unsigned i = 0; i < 8; ++i )
+        CHECK(s.may_have_sid(2000 + i * 300));
+
+    CHECK(!s.may_have_sid(1999));
+    CHECK(!s.may_have_sid(2001));
+    CHECK(!s.may_have_sid(4101));
+
+    CHECK(s.overlaps(1007, 2000));
+    CHECK(s.overlaps(0, 1000));
+    CHECK(!s.overlaps(1008, 2000));
+    CHECK(!s.overlaps(0, 999));
+}
+
+TEST(compact_log, stored)
+{
+    CompactBlock block(16);
+    fill_block(block, 10);
+
+    std::vector<uint8_t> buf;
+    block.finish(buf, 0);
+    CHECK(block.empty());
+
+    CompactBlockHeader hdr;
+    std::vector<uint8_t> raw = read_block(buf, hdr);
+
+    CHECK(!(hdr.flags & COMPACT_BLOCK_DEFLATE));
+    CHECK(hdr.summary.events == 10);
+    check_columns(raw, 10);
+}
+
+TEST(compact_log, deflated)
+{
+    CompactBlock block(64);
+    fill_block(block, 64);
+
+    std::vector<uint8_t> buf;
+    block.finish(buf, 1);
+
+    CompactBlockHeader hdr;
+    std::vector<uint8_t> raw = read_block(buf, hdr);
+
+    CHECK(hdr.flags & COMPACT_BLOCK_DEFLATE);
+    CHECK(hdr.stored_size < hdr.raw_size);
+    check_columns(raw, 64);
+}
+
+TEST(compact_log, reuse)
+{
+    CompactBlock block(4);
+    std::vector<uint8_t> buf;
+
+    fill_block(block, 4);
+    block.finish(buf, 1);
+    buf.clear();
+
+    fill_block(block, 3);
+    block.finish(buf, 1);
+
+    CompactBlockHeader hdr;
+    std::vector<uint8_t> raw = read_block(buf, hdr);
+
+    CHECK(hdr.summary.events == 3);
+    CHECK(hdr.summary.last_second == 1002);
+    check_columns(raw, 3);
+}
+
+TEST(compact_log, truncated)
+{
+    CompactBlock block(4);
+    fill_block(block, 4);
+
+    std::vector<uint8_t> buf;
+    block.finish(buf, 0);
+
+    CompactBlockHeader hdr;
+    std::vector<uint8_t> raw = read_block(buf, hdr);
+
+    CompactColumns col;
+    CHECK(col.map(raw.data(), raw.size(), 4));
+    CHECK(!col.map(raw.data(), raw.size() - 1, 4));
+    CHECK(!col.map(raw.data(), raw.size(), 5));
+}
+
+int main(int argc, char* argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
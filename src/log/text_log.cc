@@ -35,11 +35,16 @@
 #include <time.h>
 
 #include <algorithm>
+#include <cerrno>
 #include <cstdarg>
+#include <string>
 
+#include "main/thread.h"
 #include "utils/util.h"
 
+#include "async_log.h"
 #include "log.h"
+#include "messages.h"
 
 using namespace snort;
 
@@ -52,7 +57,7 @@ struct TextLog
 /* private:
    file attributes: */
     FILE* file;
-    char* name;
+    char* path;   // instance file, resolved on the packet thread; null for stdout
     size_t size;
     size_t maxFile;
     time_t last;
@@ -67,9 +72,9 @@ struct TextLog
  * TextLog_Open/Close: open/close associated log file
  *-------------------------------------------------------------------
  */
-static FILE* TextLog_Open(const char* name)
+static FILE* TextLog_Open(const char* path)
 {
-    if ( name && !strcasecmp(name, "stdout") )
+    if ( !path )
     {
 #ifdef USE_STDLOG
         FILE* stdlog = fdopen(STDLOG_FILENO, "w");
@@ -79,7 +84,13 @@ static FILE* TextLog_Open(const char* name)
 #endif
     }
 
-    return OpenAlertFile(name);
+    FILE* file = fopen(path, "a");
+
+    if ( !file )
+        FatalError("TextLog_Open() => fopen() alert file %s: %s\n", path, get_error(errno));
+
+    setvbuf(file, (char*)nullptr, _IOLBF, (size_t)0);
+    return file;
 }
 
 static void TextLog_Close(FILE* file)
@@ -125,8 +136,17 @@ TextLog* TextLog_Init(
 
     txt = (TextLog*)snort_alloc(sizeof(TextLog)+maxBuf);
 
-    txt->name = name ? snort_strdup(name) : nullptr;
-    txt->file = TextLog_Open(txt->name);
+    // the name depends on the packet thread instance so it is resolved
+    // here, before the file may be rolled on the async writer thread
+    if ( name && !strcasecmp(name, "stdout") )
+        txt->path = nullptr;
+    else
+    {
+        std::string path;
+        txt->path = snort_strdup(get_instance_file(path, name ? name : "alert.txt"));
+    }
+
+    txt->file = TextLog_Open(txt->path);
     txt->size = TextLog_Size(txt->file);
     txt->last = time(nullptr);
     txt->maxFile = maxFile;
@@ -147,17 +167,19 @@ void TextLog_Term(TextLog* const txt)
         return;
 
     TextLog_Flush(txt);
+    AsyncLog::drain();
     TextLog_Close(txt->file);
 
-    if ( txt->name )
-        snort_free(txt->name);
+    if ( txt->path )
+        snort_free(txt->path);
     snort_free(txt);
 }
 
 /*-------------------------------------------------------------------
- * TextLog_Flush: start writing to new file
+ * TextLog_Roll: start writing to new file
  * but don't roll over stdout or any sooner
- * than resolution of filename discriminator
+ * than resolution of filename discriminator;
+ * only uses the stored path since it may run on the async writer thread
  *-------------------------------------------------------------------
  */
 static void TextLog_Roll(TextLog* const txt)
@@ -167,33 +189,66 @@ static void TextLog_Roll(TextLog* const txt)
     if ( txt->last >= time(nullptr) )
         return;
 
+    time_t now = time(nullptr);
+    std::string rolled = txt->path;
+    rolled += '.' + std::to_string((unsigned long)now);
+
     TextLog_Close(txt->file);
-    RollAlertFile(txt->name);
-    txt->file = TextLog_Open(txt->name);
 
-    txt->last = time(nullptr);
+    if ( rename(txt->path, rolled.c_str()) )
+    {
+        FatalError("TextLog_Roll() => rename(%s, %s) = %s\n",
+            txt->path, rolled.c_str(), get_error(errno));
+    }
+    txt->file = TextLog_Open(txt->path);
+
+    txt->last = now;
     txt->size = 0;
 }
 
+/*-------------------------------------------------------------------
+ * TextLog_Commit: write data to file, rolling it first if needed;
+ * runs on the async log writer thread when that is enabled
+ *-------------------------------------------------------------------
+ */
+static bool TextLog_Commit(TextLog* const txt, const char* data, unsigned len)
+{
+    if ( txt->maxFile and txt->size + len > txt->maxFile )
+        TextLog_Roll(txt);
+
+    if ( fwrite(data, len, 1, txt->file) != 1 )
+        return false;
+
+    txt->size += len;
+    return true;
+}
+
+static void TextLog_AsyncCommit(void* txt, const char* data, unsigned len)
+{
+    TextLog_Commit((TextLog*)txt, data, len);
+}
+
 /*-------------------------------------------------------------------
  * TextLog_Flush: write buffered stream to file
  *-------------------------------------------------------------------
  */
 bool TextLog_Flush(TextLog* const txt)
 {
-    int ok;
-
     if ( !txt->pos )
         return false;
 
-    if ( txt->maxFile and txt->size + txt->pos > txt->maxFile )
-        TextLog_Roll(txt);
+    if ( AsyncLog::active() )
+    {
+        char* data = (char*)snort_alloc(txt->pos);
+        memcpy(data, txt->buf, txt->pos);
 
-    ok = fwrite(txt->buf, txt->pos, 1, txt->file);
+        bool ok = AsyncLog::write(TextLog_AsyncCommit, txt, data, txt->pos);
+        TextLog_Reset(txt);
+        return ok;
+    }
 
-    if ( ok == 1 )
+    if ( TextLog_Commit(txt, txt->buf, txt->pos) )
     {
-        txt->size += txt->pos;
         TextLog_Reset(txt);
         return true;
     }
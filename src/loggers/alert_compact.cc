@@ -0,0 +1,491 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// alert_compact.cc author Cisco
+
+// alert_compact writes events and their payloads to the compact event log,
+// a columnar, block compressed format with an index by time and sid.  See
+// log/compact_log_format.h and tools/compact_reader.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "detection/signature.h"
+#include "events/event.h"
+#include "framework/logger.h"
+#include "framework/module.h"
+#include "log/async_log.h"
+#include "log/batch_log.h"
+#include "log/compact_log.h"
+#include "log/messages.h"
+#include "log/obfuscator.h"
+#include "main/snort_config.h"
+#include "packet_io/active.h"
+#include "packet_io/sfdaq.h"
+#include "protocols/icmp4.h"
+#include "protocols/packet.h"
+#include "time/packet_time.h"
+#include "utils/util.h"
+
+using namespace snort;
+using namespace std;
+
+#define S_NAME "alert_compact"
+#define F_NAME S_NAME ".log"
+
+//-------------------------------------------------------------------------
+// file stuff
+//-------------------------------------------------------------------------
+
+struct CompactConfig
+{
+    size_t limit;
+    unsigned block_events;
+    unsigned block_seconds;
+    int level;
+    bool payload;
+};
+
+// files are opened and written by the sinks, so only by the writer thread
+// when there is one, and a file is only created for its first block
+struct CompactFile
+{
+    int fd;
+    int index_fd;
+    uint32_t linktype;
+    string base;
+    string name;
+};
+
+// a block is written when it is full, when the thread is idle, and once
+// its first event has waited block_seconds
+struct CompactLog : public BatchLog
+{
+    CompactLog(const CompactConfig& c) : BatchLog(c.block_seconds) { }
+
+    void flush() override;
+
+    void added(time_t now)
+    {
+        hold(now);
+
+        if ( block->full() or due(now) )
+            flush();
+    }
+
+    CompactFile* file;
+    CompactConfig* config;
+    CompactBlock* block;
+    vector<uint8_t> out;
+    vector<CompactIndexEntry> index;
+    uint64_t offset;   // where the next block goes
+};
+
+static THREAD_LOCAL CompactLog* clog = nullptr;
+
+static void write_all(CompactFile* file, int fd, const void* data, size_t len)
+{
+    if ( int error = BatchLog::write_all(fd, data, len) )
+        FatalError("%s cannot write to %s: %s\n", S_NAME, file->name.c_str(), get_error(error));
+}
+
+// files rotate faster than the second in their name when the limit is small,
+// so a sequence number is added instead of replacing an existing file
+static void open_file(CompactFile* file)
+{
+    CompactFileHeader hdr;
+    hdr.magic = COMPACT_LOG_MAGIC;
+    hdr.version = COMPACT_LOG_VERSION;
+    hdr.header_size = sizeof(hdr);
+    hdr.linktype = file->linktype;
+    hdr.created = (uint32_t)time(nullptr);
+
+    const string stamped = file->base + "." + to_string(hdr.created);
+    file->name = stamped;
+
+    for ( unsigned seq = 1; ; ++seq )
+    {
+        if ( (file->fd = open(file->name.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666)) >= 0 )
+            break;
+
+        if ( errno != EEXIST )
+            FatalError("%s could not open %s: %s\n", S_NAME, file->name.c_str(), get_error(errno));
+
+        file->name = stamped + "." + to_string(seq);
+    }
+
+    const string index_name = file->name + COMPACT_LOG_INDEX_SUFFIX;
+
+    if ( (file->index_fd = open(index_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0 )
+        FatalError("%s could not open %s: %s\n", S_NAME, index_name.c_str(), get_error(errno));
+
+    write_all(file, file->fd, &hdr, sizeof(hdr));
+}
+
+// writer thread sinks
+// a block is followed by its index entry, which is only added to the index
+// file once the block is written so the entry never points past the data
+static void append_block(void* f, const char* data, unsigned len)
+{
+    CompactFile* file = (CompactFile*)f;
+
+    if ( file->fd < 0 )
+        open_file(file);
+
+    len -= sizeof(CompactIndexEntry);
+    write_all(file, file->fd, data, len);
+    write_all(file, file->index_fd, data + len, sizeof(CompactIndexEntry));
+}
+
+// the index in the file replaces the index file
+static void append_close(void* f, const char* data, unsigned len)
+{
+    CompactFile* file = (CompactFile*)f;
+    write_all(file, file->fd, data, len);
+
+    close(file->fd);
+    file->fd = -1;
+
+    close(file->index_fd);
+    file->index_fd = -1;
+
+    const string index_name = file->name + COMPACT_LOG_INDEX_SUFFIX;
+
+    if ( unlink(index_name.c_str()) )
+        ErrorMessage("%s could not remove %s: %s\n", S_NAME, index_name.c_str(), get_error(errno));
+}
+
+static void commit(AsyncLog::Sink sink, const vector<uint8_t>& buf, const void* tail = nullptr,
+    unsigned tail_len = 0)
+{
+    unsigned len = buf.size() + tail_len;
+    char* data = (char*)snort_alloc(len);
+
+    memcpy(data, buf.data(), buf.size());
+
+    if ( tail_len )
+        memcpy(data + buf.size(), tail, tail_len);
+
+    if ( !BatchLog::write(sink, clog->file, data, len) )
+        snort_free(data);
+}
+
+// the index and trailer end the file
+static void close_file()
+{
+    if ( clog->index.empty() )
+        return;
+
+    vector<uint8_t>& out = clog->out;
+    const uint8_t* index = (const uint8_t*)clog->index.data();
+
+    out.assign(index, index + clog->index.size() * sizeof(CompactIndexEntry));
+
+    CompactTrailer trailer;
+    trailer.index_offset = clog->offset;
+    trailer.blocks = clog->index.size();
+    trailer.magic = COMPACT_LOG_INDEX_MAGIC;
+
+    const uint8_t* t = (const uint8_t*)&trailer;
+    out.insert(out.end(), t, t + sizeof(trailer));
+
+    commit(append_close, out);
+    out.clear();
+
+    clog->index.clear();
+    clog->offset = sizeof(CompactFileHeader);
+}
+
+void CompactLog::flush()
+{
+    release();
+
+    if ( block->empty() )
+        return;
+
+    CompactIndexEntry entry;
+    entry.offset = offset;
+    entry.summary = block->get_summary();
+    index.emplace_back(entry);
+
+    block->finish(out, config->level);
+    offset += out.size();
+
+    commit(append_block, out, &entry, sizeof(entry));
+    out.clear();
+
+    if ( config->limit and offset >= config->limit )
+        close_file();
+}
+
+static BatchLog* get_batch()
+{ return clog; }
+
+//-------------------------------------------------------------------------
+// module stuff
+//-------------------------------------------------------------------------
+
+static const Parameter s_params[] =
+{
+    { "block_events", Parameter::PT_INT, "1:65535", "4096",
+      "maximum number of events in a block" },
+
+    { "block_seconds", Parameter::PT_INT, "0:3600", "10",
+      "maximum seconds of packet time before a block is written (0 is no limit)" },
+
+    { "compress", Parameter::PT_INT, "0:9", "1",
+      "zlib compression level of blocks (0 stores blocks as is)" },
+
+    { "limit", Parameter::PT_INT, "0:maxSZ", "0",
+      "set maximum size in MB before rollover (0 is unlimited)" },
+
+    { "payload", Parameter::PT_BOOL, nullptr, "true",
+      "log the packet payload with each event" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+#define s_help \
+    "output events and payloads in the indexed, columnar compact event log"
+
+class CompactModule : public Module
+{
+public:
+    CompactModule() : Module(S_NAME, s_help, s_params) { }
+
+    bool set(const char*, Value&, SnortConfig*) override;
+    bool begin(const char*, int, SnortConfig*) override;
+    bool end(const char*, int, SnortConfig*) override;
+
+    Usage get_usage() const override
+    { return GLOBAL; }
+
+public:
+    CompactConfig config;
+};
+
+bool CompactModule::set(const char*, Value& v, SnortConfig*)
+{
+    if ( v.is("block_events") )
+        config.block_events = v.get_uint32();
+
+    else if ( v.is("block_seconds") )
+        config.block_seconds = v.get_uint32();
+
+    else if ( v.is("compress") )
+        config.level = v.get_uint8();
+
+    else if ( v.is("limit") )
+        config.limit = v.get_size() * 1024 * 1024;
+
+    else if ( v.is("payload") )
+        config.payload = v.get_bool();
+
+    return true;
+}
+
+bool CompactModule::begin(const char*, int, SnortConfig*)
+{
+    config.limit = 0;
+    config.block_events = 4096;
+    config.block_seconds = 10;
+    config.level = 1;
+    config.payload = true;
+    return true;
+}
+
+bool CompactModule::end(const char*, int, SnortConfig* sc)
+{
+    BatchLog::subscribe(*sc, S_NAME, get_batch);
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// logger stuff
+//-------------------------------------------------------------------------
+
+class CompactLogger : public Logger
+{
+public:
+    CompactLogger(CompactModule* m) : config(m->config) { }
+
+    void open() override;
+    void close() override;
+
+    void alert(Packet*, const char* msg, const Event&) override;
+
+private:
+    CompactConfig config;
+};
+
+void CompactLogger::open()
+{
+    clog = new CompactLog(config);
+    clog->config = &config;
+    clog->block = new CompactBlock(config.block_events);
+    clog->offset = sizeof(CompactFileHeader);
+
+    clog->file = new CompactFile;
+    clog->file->fd = -1;
+    clog->file->index_fd = -1;
+    clog->file->linktype = SFDAQ::get_base_protocol();
+    get_instance_file(clog->file->base, F_NAME);
+}
+
+void CompactLogger::close()
+{
+    clog->flush();
+    close_file();
+
+    // the queued blocks and trailer refer to clog->file
+    AsyncLog::drain();
+
+    delete clog->file;
+    delete clog->block;
+    delete clog;
+    clog = nullptr;
+}
+
+static void copy_addrs(const Packet* p, CompactEvent& e)
+{
+    static const uint32_t none[4] = { };
+    e.src_ip = e.dst_ip = none;
+
+    if ( p->ptrs.ip_api.is_ip() )
+    {
+        e.src_ip = p->ptrs.ip_api.get_src()->get_ip6_ptr();
+        e.dst_ip = p->ptrs.ip_api.get_dst()->get_ip6_ptr();
+    }
+    else if ( p->flow )
+    {
+        if ( p->is_from_application_client() )
+        {
+            e.src_ip = p->flow->client_ip.get_ip6_ptr();
+            e.dst_ip = p->flow->server_ip.get_ip6_ptr();
+        }
+        else
+        {
+            e.src_ip = p->flow->server_ip.get_ip6_ptr();
+            e.dst_ip = p->flow->client_ip.get_ip6_ptr();
+        }
+    }
+}
+
+void CompactLogger::alert(Packet* p, const char*, const Event& event)
+{
+    CompactEvent e;
+
+    e.second = event.ref_time.tv_sec;
+    e.microsecond = event.ref_time.tv_usec;
+    e.event_id = event.get_event_id();
+    e.gid = event.sig_info->gid;
+    e.sid = event.sig_info->sid;
+    e.rev = event.sig_info->rev;
+    e.class_id = event.sig_info->class_id;
+    e.priority = event.sig_info->priority;
+
+    copy_addrs(p, e);
+
+    if ( p->type() == PktType::ICMP )
+    {
+        e.src_port = p->ptrs.icmph->type;
+        e.dst_port = p->ptrs.icmph->code;
+    }
+    else
+    {
+        e.src_port = p->ptrs.sp;
+        e.dst_port = p->ptrs.dp;
+    }
+
+    e.ip_proto = (uint8_t)p->get_ip_proto_next();
+    e.action = (uint8_t)p->active->get_action();
+
+    uint32_t len = 0;
+
+    if ( config.payload )
+        len = p->is_rebuilt() ? p->dsize : p->pktlen;
+
+    if ( uint8_t* start = clog->block->add(e, len) )
+    {
+        memcpy(start, p->is_data() ? p->data : p->pkt, len);
+
+        if ( p->obfuscator and p->obfuscator->select_buffer("pkt_data") )
+        {
+            off_t off = p->is_data() ? 0 : p->data - p->pkt;
+
+            for ( const auto& b : *p->obfuscator )
+                memset(&start[ off + b.offset ], p->obfuscator->get_mask_char(), b.length);
+        }
+    }
+
+    clog->added(packet_time());
+}
+
+//-------------------------------------------------------------------------
+// api stuff
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{ return new CompactModule; }
+
+static void mod_dtor(Module* m)
+{ delete m; }
+
+static Logger* compact_ctor(Module* mod)
+{ return new CompactLogger((CompactModule*)mod); }
+
+static void compact_dtor(Logger* p)
+{ delete p; }
+
+static LogApi compact_api
+{
+    {
+        PT_LOGGER,
+        sizeof(LogApi),
+        LOGAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        S_NAME,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OUTPUT_TYPE_FLAG__ALERT,
+    compact_ctor,
+    compact_dtor
+};
+
+#ifdef BUILDING_SO
+SO_PUBLIC const BaseApi* snort_plugins[] =
+#else
+const BaseApi* alert_compact[] =
+#endif
+{
+    &compact_api.base,
+    nullptr
+};
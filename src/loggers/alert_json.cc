@@ -40,6 +40,7 @@
 #include "log/log.h"
 #include "log/log_text.h"
 #include "log/text_log.h"
+#include "main/snort_config.h"
 #include "packet_io/active.h"
 #include "packet_io/sfdaq.h"
 #include "protocols/cisco_meta_data.h"
@@ -49,6 +50,9 @@
 #include "protocols/udp.h"
 #include "protocols/vlan.h"
 #include "utils/stats.h"
+#include "utils/util.h"
+
+#include "json_buffer.h"
 
 using namespace snort;
 using namespace std;
@@ -56,6 +60,7 @@ using namespace std;
 #define LOG_BUFFER (4*K_BYTES)
 
 static THREAD_LOCAL TextLog* json_log;
+static THREAD_LOCAL JsonBuffer* json_out = nullptr;
 
 #define S_NAME "alert_json"
 #define F_NAME S_NAME ".txt"
@@ -64,45 +69,122 @@ static THREAD_LOCAL TextLog* json_log;
 // field formatting functions
 //-------------------------------------------------------------------------
 
+// the configured fields are compiled into a list of writers, each with its
+// key already quoted and prefixed with the separator for its position, and
+// the record is built in a buffer without printf before it is logged
+
 struct Args
 {
     Packet* pkt;
     const char* msg;
     const Event& event;
-    bool comma;
+    JsonBuffer& out;
 };
 
-static void print_label(const Args& a, const char* label)
+static void put_key(const Args& a, const string& key)
+{ a.out.put(key.data(), key.size()); }
+
+static void put_uint(const Args& a, const string& key, uint64_t v)
 {
-    if ( a.comma )
-        TextLog_Print(json_log, ",");
+    put_key(a, key);
+    a.out.put_uint(v);
+}
 
-    TextLog_Print(json_log, " \"%s\" : ", label);
+static void put_quoted(const Args& a, const string& key, const char* s)
+{
+    put_key(a, key);
+    a.out.put_quoted(s);
 }
 
-static bool ff_action(const Args& a)
+static void put_mac(const Args& a, const string& key, const uint8_t* mac)
 {
-    print_label(a, "action");
-    TextLog_Quote(json_log, a.pkt->active->get_action_string());
-    return true;
+    put_key(a, key);
+    a.out.put('"');
+
+    for ( int i = 0; i < 6; ++i )
+    {
+        if ( i )
+            a.out.put(':');
+        a.out.put_hex2(mac[i]);
+    }
+    a.out.put('"');
+}
+
+static void put_ap(const Args& a, const string& key, const SfIp* ip, uint16_t port)
+{
+    SfIpString addr = "";
+    unsigned p = 0;
+
+    if ( a.pkt->has_ip() or a.pkt->is_data() )
+        ip->ntop(addr);
+
+    if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
+        p = port;
+
+    put_key(a, key);
+    a.out.put('"');
+    a.out.put(addr);
+    a.out.put(':');
+    a.out.put_uint(p);
+    a.out.put('"');
 }
 
-static bool ff_class(const Args& a)
+// the date and time only change once a second so they are formatted by
+// ts_print once and the usecs are appended
+struct TimestampCache
+{
+    const SnortConfig* sc = nullptr;
+    time_t sec = 0;
+    bool usecs = false;
+    unsigned len = 0;
+    char prefix[TIMEBUF_SIZE];
+};
+
+static THREAD_LOCAL TimestampCache* ts_cache = nullptr;
+
+static void put_timestamp(const Args& a)
+{
+    const struct timeval& ts = a.pkt->pkth->ts;
+    const SnortConfig* sc = SnortConfig::get_conf();
+    TimestampCache& c = *ts_cache;
+
+    if ( !c.len or c.sec != ts.tv_sec or c.sc != sc )
+    {
+        struct timeval tv = { ts.tv_sec, 0 };
+        ts_print(&tv, c.prefix);
+
+        const char* dot = strrchr(c.prefix, '.');
+        c.usecs = dot and !strcmp(dot, ".000000");
+        c.len = c.usecs ? dot + 1 - c.prefix : strlen(c.prefix);
+        c.sec = ts.tv_sec;
+        c.sc = sc;
+    }
+
+    a.out.put(c.prefix, c.len);
+
+    if ( c.usecs )
+        a.out.put_padded((uint32_t)ts.tv_usec, 6);
+}
+
+static void ff_action(const Args& a, const string& key)
+{
+    put_quoted(a, key, a.pkt->active->get_action_string());
+}
+
+static void ff_class(const Args& a, const string& key)
 {
     const char* cls = "none";
 
     if ( a.event.sig_info->class_type and !a.event.sig_info->class_type->text.empty() )
         cls = a.event.sig_info->class_type->text.c_str();
 
-    print_label(a, "class");
-    TextLog_Quote(json_log, cls);
-    return true;
+    put_quoted(a, key, cls);
 }
 
-static bool ff_b64_data(const Args& a)
+static void ff_b64_data(const Args& a, const string& key)
 {
     if ( !a.pkt->dsize )
-        return false;
+        return;
 
     const unsigned block_size = 2048;
     char out[2*block_size];
@@ -111,261 +193,169 @@ static bool ff_b64_data(const Args& a)
     unsigned nin = 0;
     Base64Encoder b64;
 
-    print_label(a, "b64_data");
-    TextLog_Putc(json_log, '"');
+    put_key(a, key);
+    a.out.put('"');
 
     while ( nin < a.pkt->dsize )
     {
         unsigned kin = min(a.pkt->dsize-nin, block_size);
         unsigned kout = b64.encode(in+nin, kin, out);
-        TextLog_Write(json_log, out, kout);
+        a.out.put(out, kout);
         nin += kin;
     }
 
     if ( unsigned kout = b64.finish(out) )
-        TextLog_Write(json_log, out, kout);
+        a.out.put(out, kout);
 
-    TextLog_Putc(json_log, '"');
-    return true;
+    a.out.put('"');
 }
 
-static bool ff_client_bytes(const Args& a)
+static void ff_client_bytes(const Args& a, const string& key)
 {
     if (a.pkt->flow)
-    {
-        print_label(a, "client_bytes");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.client_bytes);
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->flow->flowstats.client_bytes);
 }
 
-static bool ff_client_pkts(const Args& a)
+static void ff_client_pkts(const Args& a, const string& key)
 {
     if (a.pkt->flow)
-    {
-        print_label(a, "client_pkts");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.client_pkts);
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->flow->flowstats.client_pkts);
 }
 
-static bool ff_dir(const Args& a)
+static void ff_dir(const Args& a, const string& key)
 {
     const char* dir;
 
     if ( a.pkt->is_from_application_client() )
-        dir = "C2S";
+        dir = "\"C2S\"";
     else if ( a.pkt->is_from_application_server() )
-        dir = "S2C";
+        dir = "\"S2C\"";
     else
-        dir = "UNK";
+        dir = "\"UNK\"";
 
-    print_label(a, "dir");
-    TextLog_Quote(json_log, dir);
-    return true;
+    put_key(a, key);
+    a.out.put(dir, 5);
 }
 
-static bool ff_dst_addr(const Args& a)
+static void ff_dst_addr(const Args& a, const string& key)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
     {
         SfIpString ip_str;
-        print_label(a, "dst_addr");
-        TextLog_Quote(json_log, a.pkt->ptrs.ip_api.get_dst()->ntop(ip_str));
-        return true;
+        put_quoted(a, key, a.pkt->ptrs.ip_api.get_dst()->ntop(ip_str));
     }
-    return false;
 }
 
-static bool ff_dst_ap(const Args& a)
+static void ff_dst_ap(const Args& a, const string& key)
 {
-    SfIpString addr = "";
-    unsigned port = 0;
-
-    if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
-
-    if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
-        port = a.pkt->ptrs.dp;
-
-    print_label(a, "dst_ap");
-    TextLog_Print(json_log, "\"%s:%u\"", addr, port);
-    return true;
+    put_ap(a, key, a.pkt->ptrs.ip_api.get_dst(), a.pkt->ptrs.dp);
 }
 
-static bool ff_dst_port(const Args& a)
+static void ff_dst_port(const Args& a, const string& key)
 {
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
-    {
-        print_label(a, "dst_port");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.dp);
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->ptrs.dp);
 }
 
-static bool ff_eth_dst(const Args& a)
+static void ff_eth_dst(const Args& a, const string& key)
 {
-    if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
-        return false;
-
-    print_label(a, "eth_dst");
-    const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
-
-    TextLog_Print(json_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_dst[0],
-        eh->ether_dst[1], eh->ether_dst[2], eh->ether_dst[3],
-        eh->ether_dst[4], eh->ether_dst[5]);
-
-    return true;
+    if ( a.pkt->proto_bits & PROTO_BIT__ETH )
+        put_mac(a, key, layer::get_eth_layer(a.pkt)->ether_dst);
 }
 
-static bool ff_eth_len(const Args& a)
+static void ff_eth_len(const Args& a, const string& key)
 {
-    if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
-        return false;
-
-    print_label(a, "eth_len");
-    TextLog_Print(json_log, "%u", a.pkt->pkth->pktlen);
-    return true;
+    if ( a.pkt->proto_bits & PROTO_BIT__ETH )
+        put_uint(a, key, a.pkt->pkth->pktlen);
 }
 
-static bool ff_eth_src(const Args& a)
+static void ff_eth_src(const Args& a, const string& key)
 {
-    if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
-        return false;
-
-    print_label(a, "eth_src");
-    const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
-
-    TextLog_Print(json_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_src[0],
-        eh->ether_src[1], eh->ether_src[2], eh->ether_src[3],
-        eh->ether_src[4], eh->ether_src[5]);
-    return true;
+    if ( a.pkt->proto_bits & PROTO_BIT__ETH )
+        put_mac(a, key, layer::get_eth_layer(a.pkt)->ether_src);
 }
 
-static bool ff_eth_type(const Args& a)
+static void ff_eth_type(const Args& a, const string& key)
 {
     if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
-        return false;
+        return;
 
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    print_label(a, "eth_type");
-    TextLog_Print(json_log, "\"0x%X\"", ntohs(eh->ether_type));
-    return true;
+    put_key(a, key);
+    a.out.put("\"0x", 3);
+    a.out.put_hex(ntohs(eh->ether_type));
+    a.out.put('"');
 }
 
-static bool ff_flowstart_time(const Args& a)
+static void ff_flowstart_time(const Args& a, const string& key)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "flowstart_time");
-        TextLog_Print(json_log, "%ld", a.pkt->flow->flowstats.start_time.tv_sec);
-        return true;
+        put_key(a, key);
+        a.out.put_int(a.pkt->flow->flowstats.start_time.tv_sec);
     }
-    return false;
 }
 
-static bool ff_geneve_vni(const Args& a)
+static void ff_geneve_vni(const Args& a, const string& key)
 {
     if (a.pkt->proto_bits & PROTO_BIT__GENEVE)
-    {
-        print_label(a, "geneve_vni");
-        TextLog_Print(json_log, "%u", a.pkt->get_flow_geneve_vni());
-    }
-    return true;
+        put_uint(a, key, a.pkt->get_flow_geneve_vni());
 }
 
-static bool ff_gid(const Args& a)
+static void ff_gid(const Args& a, const string& key)
 {
-    print_label(a, "gid");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->gid);
-    return true;
+    put_uint(a, key, a.event.sig_info->gid);
 }
 
-static bool ff_icmp_code(const Args& a)
+static void ff_icmp_code(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.icmph )
-    {
-        print_label(a, "icmp_code");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.icmph->code);
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->ptrs.icmph->code);
 }
 
-static bool ff_icmp_id(const Args& a)
+static void ff_icmp_id(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.icmph )
-    {
-        print_label(a, "icmp_id");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_id));
-        return true;
-    }
-    return false;
+        put_uint(a, key, ntohs(a.pkt->ptrs.icmph->s_icmp_id));
 }
 
-static bool ff_icmp_seq(const Args& a)
+static void ff_icmp_seq(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.icmph )
-    {
-        print_label(a, "icmp_seq");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
-        return true;
-    }
-    return false;
+        put_uint(a, key, ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
 }
 
-static bool ff_icmp_type(const Args& a)
+static void ff_icmp_type(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.icmph )
-    {
-        print_label(a, "icmp_type");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.icmph->type);
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->ptrs.icmph->type);
 }
 
-static bool ff_iface(const Args& a)
+static void ff_iface(const Args& a, const string& key)
 {
-    print_label(a, "iface");
-    TextLog_Quote(json_log, SFDAQ::get_input_spec());
-    return true;
+    put_quoted(a, key, SFDAQ::get_input_spec());
 }
 
-static bool ff_ip_id(const Args& a)
+static void ff_ip_id(const Args& a, const string& key)
 {
     if (a.pkt->has_ip())
-    {
-        print_label(a, "ip_id");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.id());
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->ptrs.ip_api.id());
 }
 
-static bool ff_ip_len(const Args& a)
+static void ff_ip_len(const Args& a, const string& key)
 {
     if (a.pkt->has_ip())
-    {
-        print_label(a, "ip_len");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.pay_len());
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->ptrs.ip_api.pay_len());
 }
 
-static bool ff_msg(const Args& a)
+static void ff_msg(const Args& a, const string& key)
 {
-    print_label(a, "msg");
-    TextLog_Puts(json_log, a.msg);
-    return true;
+    put_key(a, key);
+    a.out.put(a.msg);
 }
 
-static bool ff_mpls(const Args& a)
+static void ff_mpls(const Args& a, const string& key)
 {
     uint32_t mpls;
 
@@ -376,170 +366,119 @@ static bool ff_mpls(const Args& a)
         mpls = a.pkt->ptrs.mplsHdr.label;
 
     else
-        return false;
+        return;
 
-    print_label(a, "mpls");
-    TextLog_Print(json_log, "%u", mpls);
-    return true;
+    put_uint(a, key, mpls);
 }
 
-static bool ff_pkt_gen(const Args& a)
+static void ff_pkt_gen(const Args& a, const string& key)
 {
-    print_label(a, "pkt_gen");
-    TextLog_Quote(json_log, a.pkt->get_pseudo_type());
-    return true;
+    put_quoted(a, key, a.pkt->get_pseudo_type());
 }
 
-static bool ff_pkt_len(const Args& a)
+static void ff_pkt_len(const Args& a, const string& key)
 {
-    print_label(a, "pkt_len");
-
     if (a.pkt->has_ip())
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.dgram_len());
+        put_uint(a, key, a.pkt->ptrs.ip_api.dgram_len());
     else
-        TextLog_Print(json_log, "%u", a.pkt->dsize);
-
-    return true;
+        put_uint(a, key, a.pkt->dsize);
 }
 
-static bool ff_pkt_num(const Args& a)
+static void ff_pkt_num(const Args& a, const string& key)
 {
-    print_label(a, "pkt_num");
-    TextLog_Print(json_log, STDu64, a.pkt->context->packet_number);
-    return true;
+    put_uint(a, key, a.pkt->context->packet_number);
 }
 
-static bool ff_priority(const Args& a)
+static void ff_priority(const Args& a, const string& key)
 {
-    print_label(a, "priority");
-    TextLog_Print(json_log, "%u", a.event.sig_info->priority);
-    return true;
+    put_uint(a, key, a.event.sig_info->priority);
 }
 
-static bool ff_proto(const Args& a)
+static void ff_proto(const Args& a, const string& key)
 {
-    print_label(a, "proto");
-    TextLog_Quote(json_log, a.pkt->get_type());
-    return true;
+    put_quoted(a, key, a.pkt->get_type());
 }
 
-static bool ff_rev(const Args& a)
+static void ff_rev(const Args& a, const string& key)
 {
-    print_label(a, "rev");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->rev);
-    return true;
+    put_uint(a, key, a.event.sig_info->rev);
 }
 
-static bool ff_rule(const Args& a)
+static void ff_rule(const Args& a, const string& key)
 {
-    print_label(a, "rule");
-
-    TextLog_Print(json_log, "\"%u:%u:%u\"",
-        a.event.sig_info->gid, a.event.sig_info->sid, a.event.sig_info->rev);
-
-    return true;
+    put_key(a, key);
+    a.out.put('"');
+    a.out.put_uint(a.event.sig_info->gid);
+    a.out.put(':');
+    a.out.put_uint(a.event.sig_info->sid);
+    a.out.put(':');
+    a.out.put_uint(a.event.sig_info->rev);
+    a.out.put('"');
 }
 
-static bool ff_seconds(const Args& a)
+static void ff_seconds(const Args& a, const string& key)
 {
-    print_label(a, "seconds");
-    TextLog_Print(json_log, "%ld",  a.pkt->pkth->ts.tv_sec);
-    return true;
+    put_key(a, key);
+    a.out.put_int(a.pkt->pkth->ts.tv_sec);
 }
 
-static bool ff_server_bytes(const Args& a)
+static void ff_server_bytes(const Args& a, const string& key)
 {
     if (a.pkt->flow)
-    {
-        print_label(a, "server_bytes");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.server_bytes);
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->flow->flowstats.server_bytes);
 }
 
-static bool ff_server_pkts(const Args& a)
+static void ff_server_pkts(const Args& a, const string& key)
 {
     if (a.pkt->flow)
-    {
-        print_label(a, "server_pkts");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.server_pkts);
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->flow->flowstats.server_pkts);
 }
 
-static bool ff_service(const Args& a)
+static void ff_service(const Args& a, const string& key)
 {
     const char* svc = "unknown";
 
     if ( a.pkt->flow and a.pkt->flow->service )
         svc = a.pkt->flow->service;
 
-    print_label(a, "service");
-    TextLog_Quote(json_log, svc);
-    return true;
+    put_quoted(a, key, svc);
 }
 
-static bool ff_sgt(const Args& a)
+static void ff_sgt(const Args& a, const string& key)
 {
     if (a.pkt->proto_bits & PROTO_BIT__CISCO_META_DATA)
     {
         const cisco_meta_data::CiscoMetaDataHdr* cmdh = layer::get_cisco_meta_data_layer(a.pkt);
-        print_label(a, "sgt");
-        TextLog_Print(json_log, "%hu", cmdh->sgt_val());
-        return true;
+        put_uint(a, key, cmdh->sgt_val());
     }
-    return false;
 }
 
-static bool ff_sid(const Args& a)
+static void ff_sid(const Args& a, const string& key)
 {
-    print_label(a, "sid");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->sid);
-    return true;
+    put_uint(a, key, a.event.sig_info->sid);
 }
 
-static bool ff_src_addr(const Args& a)
+static void ff_src_addr(const Args& a, const string& key)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
     {
         SfIpString ip_str;
-        print_label(a, "src_addr");
-        TextLog_Quote(json_log, a.pkt->ptrs.ip_api.get_src()->ntop(ip_str));
-        return true;
+        put_quoted(a, key, a.pkt->ptrs.ip_api.get_src()->ntop(ip_str));
     }
-    return false;
 }
 
-static bool ff_src_ap(const Args& a)
+static void ff_src_ap(const Args& a, const string& key)
 {
-    SfIpString addr = "";
-    unsigned port = 0;
-
-    if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
-
-    if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
-        port = a.pkt->ptrs.sp;
-
-    print_label(a, "src_ap");
-    TextLog_Print(json_log, "\"%s:%u\"", addr, port);
-    return true;
+    put_ap(a, key, a.pkt->ptrs.ip_api.get_src(), a.pkt->ptrs.sp);
 }
 
-static bool ff_src_port(const Args& a)
+static void ff_src_port(const Args& a, const string& key)
 {
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
-    {
-        print_label(a, "src_port");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.sp);
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->ptrs.sp);
 }
 
-static bool ff_target(const Args& a)
+static void ff_target(const Args& a, const string& key)
 {
     SfIpString addr = "";
 
@@ -550,125 +489,81 @@ static bool ff_target(const Args& a)
         a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
 
     else
-        return false;
+        return;
 
-    print_label(a, "target");
-    TextLog_Quote(json_log, addr);
-    return true;
+    put_quoted(a, key, addr);
 }
 
-static bool ff_tcp_ack(const Args& a)
+static void ff_tcp_ack(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.tcph )
-    {
-        print_label(a, "tcp_ack");
-        TextLog_Print(json_log, "%u", ntohl(a.pkt->ptrs.tcph->th_ack));
-        return true;
-    }
-    return false;
+        put_uint(a, key, ntohl(a.pkt->ptrs.tcph->th_ack));
 }
 
-static bool ff_tcp_flags(const Args& a)
+static void ff_tcp_flags(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.tcph )
     {
         char tcpFlags[9];
         CreateTCPFlagString(a.pkt->ptrs.tcph, tcpFlags);
-
-        print_label(a, "tcp_flags");
-        TextLog_Quote(json_log, tcpFlags);
-        return true;
+        put_quoted(a, key, tcpFlags);
     }
-    return false;
 }
 
-static bool ff_tcp_len(const Args& a)
+static void ff_tcp_len(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.tcph )
-    {
-        print_label(a, "tcp_len");
-        TextLog_Print(json_log, "%u", (a.pkt->ptrs.tcph->off()));
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->ptrs.tcph->off());
 }
 
-static bool ff_tcp_seq(const Args& a)
+static void ff_tcp_seq(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.tcph )
-    {
-        print_label(a, "tcp_seq");
-        TextLog_Print(json_log, "%u", ntohl(a.pkt->ptrs.tcph->th_seq));
-        return true;
-    }
-    return false;
+        put_uint(a, key, ntohl(a.pkt->ptrs.tcph->th_seq));
 }
 
-static bool ff_tcp_win(const Args& a)
+static void ff_tcp_win(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.tcph )
-    {
-        print_label(a, "tcp_win");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.tcph->th_win));
-        return true;
-    }
-    return false;
+        put_uint(a, key, ntohs(a.pkt->ptrs.tcph->th_win));
 }
 
-static bool ff_timestamp(const Args& a)
+static void ff_timestamp(const Args& a, const string& key)
 {
-    print_label(a, "timestamp");
-    TextLog_Putc(json_log, '"');
-    LogTimeStamp(json_log, a.pkt);
-    TextLog_Putc(json_log, '"');
-    return true;
+    put_key(a, key);
+    a.out.put('"');
+    put_timestamp(a);
+    a.out.put('"');
 }
 
-static bool ff_tos(const Args& a)
+static void ff_tos(const Args& a, const string& key)
 {
     if (a.pkt->has_ip())
-    {
-        print_label(a, "tos");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.tos());
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->ptrs.ip_api.tos());
 }
 
-static bool ff_ttl(const Args& a)
+static void ff_ttl(const Args& a, const string& key)
 {
     if (a.pkt->has_ip())
-    {
-        print_label(a, "ttl");
-        TextLog_Print(json_log, "%u",a.pkt->ptrs.ip_api.ttl());
-        return true;
-    }
-    return false;
+        put_uint(a, key, a.pkt->ptrs.ip_api.ttl());
 }
 
-static bool ff_udp_len(const Args& a)
+static void ff_udp_len(const Args& a, const string& key)
 {
     if (a.pkt->ptrs.udph )
-    {
-        print_label(a, "udp_len");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.udph->uh_len));
-        return true;
-    }
-    return false;
+        put_uint(a, key, ntohs(a.pkt->ptrs.udph->uh_len));
 }
 
-static bool ff_vlan(const Args& a)
+static void ff_vlan(const Args& a, const string& key)
 {
-    print_label(a, "vlan");
-    TextLog_Print(json_log, "%hu", a.pkt->get_flow_vlan_id());
-    return true;
+    put_uint(a, key, a.pkt->get_flow_vlan_id());
 }
 
 //-------------------------------------------------------------------------
 // module stuff
 //-------------------------------------------------------------------------
 
-typedef bool (*JsonFunc)(const Args&);
+typedef void (*JsonFunc)(const Args&, const string& key);
 
 static const JsonFunc json_func[] =
 {
@@ -682,6 +577,12 @@ static const JsonFunc json_func[] =
     ff_tos, ff_ttl, ff_udp_len, ff_vlan
 };
 
+struct JsonField
+{
+    JsonFunc func;
+    string key;     // with its separator and quotes
+};
+
 #define json_range \
     "action | class | b64_data | client_bytes | client_pkts | dir | " \
     "dst_addr | dst_ap | dst_port | eth_dst | eth_len | eth_src | " \
@@ -731,6 +632,7 @@ public:
     size_t limit = 0;
     string sep;
     vector<JsonFunc> fields;
+    vector<string> names;
 };
 
 bool JsonModule::set(const char*, Value& v, SnortConfig*)
@@ -743,12 +645,16 @@ bool JsonModule::set(const char*, Value& v, SnortConfig*)
         string tok;
         v.set_first_token();
         fields.clear();
+        names.clear();
 
         while ( v.get_next_token(tok) )
         {
             int i = Parameter::index(json_range, tok.c_str());
             if ( i >= 0 )
+            {
                 fields.emplace_back(json_func[i]);
+                names.emplace_back(tok);
+            }
         }
     }
 
@@ -777,7 +683,10 @@ bool JsonModule::begin(const char*, int, SnortConfig*)
         {
             int i = Parameter::index(json_range, tok.c_str());
             if ( i >= 0 )
+            {
                 fields.emplace_back(json_func[i]);
+                names.emplace_back(tok);
+            }
         }
     }
     return true;
@@ -800,36 +709,57 @@ public:
 public:
     string file;
     unsigned long limit;
-    vector<JsonFunc> fields;
+    vector<JsonField> fields;
     string sep;
 };
 
-JsonLogger::JsonLogger(JsonModule* m) : file(m->file ? F_NAME : "stdout"), limit(m->limit), fields(std::move(m->fields)), sep(m->sep)
-{ }
+// every field but the first is preceded by a comma, whether or not the
+// fields before it were written
+JsonLogger::JsonLogger(JsonModule* m) : file(m->file ? F_NAME : "stdout"), limit(m->limit),
+    sep(m->sep)
+{
+    for ( unsigned i = 0; i < m->fields.size(); ++i )
+    {
+        string key = string(i ? "," : "") + " \"" + m->names[i] + "\" : ";
+        fields.push_back({ m->fields[i], key });
+    }
+
+    m->fields.clear();
+    m->names.clear();
+}
 
 void JsonLogger::open()
 {
     json_log = TextLog_Init(file.c_str(), LOG_BUFFER, limit);
+    json_out = new JsonBuffer(LOG_BUFFER);
+    ts_cache = new TimestampCache;
 }
 
 void JsonLogger::close()
 {
     if ( json_log )
         TextLog_Term(json_log);
+
+    delete json_out;
+    json_out = nullptr;
+
+    delete ts_cache;
+    ts_cache = nullptr;
 }
 
 void JsonLogger::alert(Packet* p, const char* msg, const Event& event)
 {
-    Args a = { p, msg, event, false };
-    TextLog_Putc(json_log, '{');
+    Args a = { p, msg, event, *json_out };
 
-    for ( JsonFunc f : fields )
-    {
-        f(a);
-        a.comma = true;
-    }
+    json_out->clear();
+    json_out->put('{');
+
+    for ( const auto& f : fields )
+        f.func(a, f.key);
+
+    json_out->put(" }\n", 3);
 
-    TextLog_Print(json_log, " }\n");
+    TextLog_Write(json_log, json_out->data(), json_out->size());
     TextLog_Flush(json_log);
 }
 
@@ -878,3 +808,413 @@ const BaseApi* alert_json[] =
     nullptr
 };
 
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#if defined(UNIT_TEST) || defined(BENCHMARK_TEST)
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "catch/snort_catch.h"
+#include "detection/ips_context.h"
+#include "flow/flow.h"
+#include "main/policy.h"
+#include "protocols/ipv4.h"
+#include "protocols/ipv6.h"
+#include "protocols/layer.h"
+
+#include "test/alert_json_legacy.h"
+
+// the writers and the legacy formatting log the same alerts to these files
+// in the log directory, the tests are run by snort --catch-test without a
+// daq instance so the iface field is left out
+#define NEW_FILE S_NAME "_test_new.txt"
+#define OLD_FILE S_NAME "_test_old.txt"
+
+static const uint8_t eth_ip4_tcp[] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00, 0x06, 0x07, 0x08, 0x09, 0x0a,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x32, 0x00, 0x01, 0x00, 0x00, 0x40, 0x06,
+    0x5f, 0xb8, 0x0a, 0x01, 0x02, 0x03, 0x0a, 0x04, 0x05, 0x06, 0x9c, 0x40,
+    0x00, 0x50, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x50, 0x18,
+    0x20, 0x00, 0xa4, 0x18, 0x00, 0x00, 0x47, 0x45, 0x54, 0x20, 0x2f, 0x22,
+    0x5c, 0x78, 0x0d, 0x0a,
+};
+
+static const uint8_t eth_vlan_ip6_udp[] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00, 0x06, 0x07, 0x08, 0x09, 0x0a,
+    0x81, 0x00, 0x00, 0x64, 0x86, 0xdd, 0x60, 0x00, 0x00, 0x00, 0x00, 0x0d,
+    0x11, 0x40, 0x20, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x20, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x9c, 0x40,
+    0x00, 0x35, 0x00, 0x0d, 0xdf, 0x87, 0x68, 0x65, 0x6c, 0x6c, 0x6f,
+};
+
+static const uint8_t eth_ip4_icmp[] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00, 0x06, 0x07, 0x08, 0x09, 0x0a,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x20, 0x00, 0x01, 0x00, 0x00, 0x40, 0x01,
+    0x5f, 0xcf, 0x0a, 0x01, 0x02, 0x03, 0x0a, 0x04, 0x05, 0x06, 0x08, 0x00,
+    0x19, 0x2d, 0x00, 0x01, 0x00, 0x01, 0x70, 0x69, 0x6e, 0x67,
+};
+
+static const uint8_t eth_arp[] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00, 0x06, 0x07, 0x08, 0x09, 0x0a,
+    0x08, 0x06, 0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x01, 0x00, 0x01,
+    0x02, 0x03, 0x04, 0x05, 0x0a, 0x01, 0x02, 0x03, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x0a, 0x04, 0x05, 0x06,
+};
+class JsonTest
+{
+public:
+    JsonTest(const vector<string>& names)
+    {
+        JsonModule m;
+        m.begin(nullptr, 0, nullptr);
+        m.fields.clear();
+        m.names.clear();
+
+        for ( const auto& name : names )
+        {
+            int i = Parameter::index(json_range, name.c_str());
+            REQUIRE(i >= 0);
+
+            m.fields.emplace_back(json_func[i]);
+            m.names.emplace_back(name);
+            legacy.emplace_back(legacy_func[i]);
+        }
+
+        remove(get_instance_file(new_file, NEW_FILE));
+        remove(get_instance_file(old_file, OLD_FILE));
+
+        logger = new JsonLogger(&m);
+        logger->file = NEW_FILE;
+        logger->open();
+
+        legacy_log = TextLog_Init(OLD_FILE, LOG_BUFFER);
+    }
+
+    ~JsonTest()
+    {
+        close();
+        remove(new_file.c_str());
+        remove(old_file.c_str());
+    }
+
+    void alert(Packet* p, const char* msg, const Event& event)
+    {
+        alert_new(p, msg, event);
+        alert_old(p, msg, event);
+    }
+
+    void alert_new(Packet* p, const char* msg, const Event& event)
+    { logger->alert(p, msg, event); }
+
+    void alert_old(Packet* p, const char* msg, const Event& event)
+    {
+        LegacyArgs a = { p, msg, event, false };
+        TextLog_Putc(legacy_log, '{');
+
+        for ( LegacyFunc f : legacy )
+        {
+            f(a);
+            a.comma = true;
+        }
+
+        TextLog_Print(legacy_log, " }\n");
+        TextLog_Flush(legacy_log);
+    }
+
+    // compares the files line by line
+    void check()
+    {
+        close();
+
+        ifstream new_log(new_file);
+        ifstream old_log(old_file);
+        string new_line, old_line;
+        unsigned num = 0;
+
+        while ( getline(old_log, old_line) )
+        {
+            INFO("alert " << ++num);
+            REQUIRE(getline(new_log, new_line));
+            CHECK(new_line == old_line);
+        }
+        CHECK(num > 0);
+        CHECK(!getline(new_log, new_line));
+    }
+
+private:
+    void close()
+    {
+        if ( logger )
+        {
+            logger->close();
+            delete logger;
+            logger = nullptr;
+        }
+        if ( legacy_log )
+        {
+            TextLog_Term(legacy_log);
+            legacy_log = nullptr;
+        }
+    }
+
+    JsonLogger* logger = nullptr;
+    vector<LegacyFunc> legacy;
+    string new_file;
+    string old_file;
+};
+
+// packets with and without a flow and events with and without a
+// class and target, logged with timestamps which hit and miss the cache
+class JsonAlerts
+{
+public:
+    JsonAlerts() : cls("trojan-activity", "A Network Trojan was detected", 1, 1)
+    {
+        ctx.conf = SnortConfig::get_conf();
+        ctx.packet_number = 1234567;
+        set_default_policy(ctx.conf);
+
+        p.context = &ctx;
+        p.active = p.active_inst;
+        p.daq_msg = &msg;
+
+        msg.type = DAQ_MSG_TYPE_PACKET;
+        msg.hdr_len = sizeof(pkth);
+        msg.hdr = &pkth;
+
+        key.vlan_tag = 7;
+        key.mplsLabel = 12345;
+
+        flow.key = &key;
+        flow.service = "http";
+        flow.flowstats.client_bytes = 123456789012;
+        flow.flowstats.client_pkts = 100;
+        flow.flowstats.server_bytes = 4096;
+        flow.flowstats.server_pkts = 3;
+        flow.flowstats.start_time.tv_sec = 1697718890;
+
+        sigs[0].gid = 1;
+        sigs[0].sid = 2000001;
+        sigs[0].rev = 3;
+        sigs[0].priority = 1;
+        sigs[0].class_type = &cls;
+        sigs[0].target = TARGET_SRC;
+
+        sigs[1].gid = 116;
+        sigs[1].sid = 45;
+        sigs[1].rev = 1;
+        sigs[1].priority = 3;
+        sigs[1].target = TARGET_DST;
+
+        sigs[2].gid = 133;
+        sigs[2].sid = 2;
+        sigs[2].rev = 0;
+    }
+
+    ~JsonAlerts()
+    { p.flow = nullptr; }
+
+    template <typename Log>
+    void log_all(Log log)
+    {
+        static const struct { const uint8_t* data; size_t len; } pkts[] =
+        {
+            { eth_ip4_tcp, sizeof(eth_ip4_tcp) },
+            { eth_vlan_ip6_udp, sizeof(eth_vlan_ip6_udp) },
+            { eth_ip4_icmp, sizeof(eth_ip4_icmp) },
+            { eth_arp, sizeof(eth_arp) },
+        };
+        static const struct timeval times[] =
+        {
+            { 1697718896, 123456 }, { 1697718896, 0 }, { 1697718897, 999999 }, { 0, 5 }
+        };
+        static const char* msgs[] =
+        {
+            "\"ET POLICY \\\"quoted\\\" msg\"", "\"(decoder) plain\"", "\"\""
+        };
+
+        unsigned n = 0;
+
+        for ( const auto& pkt : pkts )
+        {
+            for ( Flow* f : { (Flow*)nullptr, &flow } )
+            {
+                for ( auto& si : sigs )
+                {
+                    pkth.ts = times[n % (sizeof(times) / sizeof(times[0]))];
+                    decode(pkt.data, pkt.len, f, n);
+
+                    Event event(si);
+                    log(&p, msgs[n % (sizeof(msgs) / sizeof(msgs[0]))], event);
+                    ++n;
+                }
+            }
+        }
+    }
+
+private:
+    // sets the layers and fields the codecs would for these fixtures
+    void decode(const uint8_t* data, size_t len, Flow* f, unsigned n)
+    {
+        pkth.pktlen = len;
+        msg.data = const_cast<uint8_t*>(data);
+        msg.data_len = len;
+
+        p.reset();
+        p.pkth = &pkth;
+        p.pkt = data;
+        p.pktlen = len;
+
+        unsigned off = 0;
+        push(ProtocolId::ETHERNET_802_3, data, off, eth::ETH_HEADER_LEN, PROTO_BIT__ETH);
+        uint16_t type = (data[off - 2] << 8) | data[off - 1];
+
+        if ( type == to_utype(ProtocolId::ETHERTYPE_8021Q) )
+        {
+            push(ProtocolId::ETHERTYPE_8021Q, data, off, 4, PROTO_BIT__VLAN);
+            type = (data[off - 2] << 8) | data[off - 1];
+        }
+
+        IpProtocol next = IpProtocol::PROTO_NOT_SET;
+
+        if ( type == to_utype(ProtocolId::ETHERTYPE_IPV4) )
+        {
+            const ip::IP4Hdr* h = (const ip::IP4Hdr*)(data + off);
+            p.ptrs.ip_api.set(h);
+            p.ptrs.set_pkt_type(PktType::IP);
+            push(ProtocolId::ETHERTYPE_IPV4, data, off, h->hlen(), PROTO_BIT__IP);
+            next = h->proto();
+        }
+        else if ( type == to_utype(ProtocolId::ETHERTYPE_IPV6) )
+        {
+            const ip::IP6Hdr* h = (const ip::IP6Hdr*)(data + off);
+            p.ptrs.ip_api.set(data + off);
+            p.ptrs.set_pkt_type(PktType::IP);
+            push(ProtocolId::ETHERTYPE_IPV6, data, off, ip::IP6_HEADER_LEN, PROTO_BIT__IP);
+            next = h->next();
+        }
+        else if ( type == to_utype(ProtocolId::ETHERTYPE_ARP) )
+            push(ProtocolId::ETHERTYPE_ARP, data, off, len - off, PROTO_BIT__ARP);
+
+        if ( next == IpProtocol::TCP )
+        {
+            p.ptrs.tcph = (const tcp::TCPHdr*)(data + off);
+            p.ptrs.sp = p.ptrs.tcph->src_port();
+            p.ptrs.dp = p.ptrs.tcph->dst_port();
+            p.ptrs.set_pkt_type(PktType::TCP);
+            push(ProtocolId::TCP, data, off, p.ptrs.tcph->hlen(), PROTO_BIT__TCP);
+        }
+        else if ( next == IpProtocol::UDP )
+        {
+            p.ptrs.udph = (const udp::UDPHdr*)(data + off);
+            p.ptrs.sp = p.ptrs.udph->src_port();
+            p.ptrs.dp = p.ptrs.udph->dst_port();
+            p.ptrs.set_pkt_type(PktType::UDP);
+            push(ProtocolId::UDP, data, off, udp::UDP_HEADER_LEN, PROTO_BIT__UDP);
+        }
+        else if ( next == IpProtocol::ICMPV4 )
+        {
+            p.ptrs.icmph = (const icmp::ICMPHdr*)(data + off);
+            p.ptrs.set_pkt_type(PktType::ICMP);
+            push(ProtocolId::ICMPV4, data, off, icmp::ICMP_BASE_LEN, PROTO_BIT__ICMP);
+        }
+
+        p.data = data + off;
+        p.dsize = len - off;
+
+        p.flow = f;
+        p.packet_flags |= (n & 1) ? PKT_FROM_CLIENT : PKT_FROM_SERVER;
+    }
+
+    void push(ProtocolId id, const uint8_t* data, unsigned& off, unsigned len, uint32_t bit)
+    {
+        Layer& lyr = p.layers[p.num_layers++];
+        lyr.prot_id = id;
+        lyr.start = data + off;
+        lyr.length = len;
+        p.proto_bits |= bit;
+        off += len;
+    }
+
+    IpsContext ctx;
+    Packet p { false };
+    DAQ_Msg_t msg = { };
+    DAQ_PktHdr_t pkth = { };
+    FlowKey key = { };
+    Flow flow;
+    ClassType cls;
+    SigInfo sigs[3];
+};
+
+static vector<string> get_fields(const char* range)
+{
+    vector<string> names;
+    stringstream ss(range);
+    string tok;
+
+    while ( ss >> tok )
+    {
+        if ( tok != "|" and tok != "iface" )
+            names.emplace_back(tok.back() == '|' ? tok.substr(0, tok.size() - 1) : tok);
+    }
+    return names;
+}
+#endif
+
+#ifdef UNIT_TEST
+TEST_CASE("alert_json legacy format", "[alert_json]")
+{
+    vector<string> names;
+
+    SECTION("default fields")
+    { names = get_fields(json_deflt); }
+
+    SECTION("all fields")
+    { names = get_fields(json_range); }
+
+    SECTION("reversed")
+    {
+        names = get_fields(json_range);
+        std::reverse(names.begin(), names.end());
+    }
+
+    SECTION("one field")
+    { names = { "b64_data" }; }
+
+    JsonTest test(names);
+    JsonAlerts alerts;
+
+    alerts.log_all([&](Packet* p, const char* msg, const Event& e)
+        { test.alert(p, msg, e); });
+
+    test.check();
+}
+#endif
+
+#ifdef BENCHMARK_TEST
+TEST_CASE("alert_json benchmark", "[alert_json]")
+{
+    JsonTest test(get_fields(json_deflt));
+    JsonAlerts alerts;
+
+    BENCHMARK("legacy printf")
+    {
+        alerts.log_all([&](Packet* p, const char* msg, const Event& e)
+            { test.alert_old(p, msg, e); });
+    };
+
+    BENCHMARK("writers")
+    {
+        alerts.log_all([&](Packet* p, const char* msg, const Event& e)
+            { test.alert_new(p, msg, e); });
+    };
+}
+#endif
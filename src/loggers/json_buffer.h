@@ -0,0 +1,208 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// json_buffer.h author Cisco
+
+#ifndef JSON_BUFFER_H
+#define JSON_BUFFER_H
+
+// Growable output buffer with the appends needed to format alerts as JSON
+// without printf.  Integers are converted two digits at a time from a
+// table and strings are quoted the same way as TextLog_Quote.
+//
+// Header only since the loggers may be built as dynamic plugins.
+
+#include <cstdint>
+#include <cstring>
+
+#include "utils/util.h"
+
+class JsonBuffer
+{
+public:
+    JsonBuffer(size_t size = 4096) : cap(size ? size : 1)
+    { buf = (char*)snort_alloc(cap); }
+
+    ~JsonBuffer()
+    { snort_free(buf); }
+
+    JsonBuffer(const JsonBuffer&) = delete;
+    JsonBuffer& operator=(const JsonBuffer&) = delete;
+
+    const char* data() const
+    { return buf; }
+
+    size_t size() const
+    { return len; }
+
+    void clear()
+    { len = 0; }
+
+    void put(char c)
+    {
+        reserve(1);
+        buf[len++] = c;
+    }
+
+    void put(const char* s, size_t n)
+    {
+        reserve(n);
+        memcpy(buf + len, s, n);
+        len += n;
+    }
+
+    void put(const char* s)
+    { put(s, strlen(s)); }
+
+    void put_uint(uint64_t v)
+    {
+        char tmp[20];
+        char* end = tmp + sizeof(tmp);
+        char* p = end;
+
+        while ( v >= 100 )
+        {
+            p -= 2;
+            memcpy(p, digit_pairs() + (v % 100) * 2, 2);
+            v /= 100;
+        }
+
+        if ( v >= 10 )
+        {
+            p -= 2;
+            memcpy(p, digit_pairs() + v * 2, 2);
+        }
+        else
+            *--p = '0' + (char)v;
+
+        put(p, end - p);
+    }
+
+    void put_int(int64_t v)
+    {
+        if ( v < 0 )
+        {
+            put('-');
+            put_uint(-(uint64_t)v);
+        }
+        else
+            put_uint((uint64_t)v);
+    }
+
+    // zero padded to width digits, v must fit
+    void put_padded(uint32_t v, unsigned width)
+    {
+        reserve(width);
+        char* p = buf + len + width;
+
+        for ( unsigned i = 0; i < width; ++i )
+        {
+            *--p = '0' + (char)(v % 10);
+            v /= 10;
+        }
+        len += width;
+    }
+
+    // upper case, no leading zeros
+    void put_hex(uint32_t v)
+    {
+        char tmp[8];
+        char* end = tmp + sizeof(tmp);
+        char* p = end;
+
+        do
+        {
+            *--p = hex_digits()[v & 0xf];
+            v >>= 4;
+        }
+        while ( v );
+
+        put(p, end - p);
+    }
+
+    // upper case, 2 digits
+    void put_hex2(uint8_t v)
+    {
+        reserve(2);
+        buf[len++] = hex_digits()[v >> 4];
+        buf[len++] = hex_digits()[v & 0xf];
+    }
+
+    // escapes quote and backslash with a backslash
+    void put_quoted(const char* s)
+    {
+        put('"');
+
+        while ( *s )
+        {
+            size_t n = strcspn(s, "\"\\");
+            put(s, n);
+            s += n;
+
+            if ( *s )
+            {
+                char esc[2] = { '\\', *s++ };
+                put(esc, 2);
+            }
+        }
+        put('"');
+    }
+
+private:
+    // like snort_alloc, throws if the memory is not available
+    void reserve(size_t n)
+    {
+        if ( len + n <= cap )
+            return;
+
+        size_t new_cap = cap;
+
+        while ( new_cap < len + n )
+            new_cap *= 2;
+
+        char* new_buf = (char*)snort_alloc(new_cap);
+        memcpy(new_buf, buf, len);
+        snort_free(buf);
+
+        buf = new_buf;
+        cap = new_cap;
+    }
+
+    static const char* digit_pairs()
+    {
+        return
+            "00010203040506070809"
+            "10111213141516171819"
+            "20212223242526272829"
+            "30313233343536373839"
+            "40414243444546474849"
+            "50515253545556575859"
+            "60616263646566676869"
+            "70717273747576777879"
+            "80818283848586878889"
+            "90919293949596979899";
+    }
+
+    static const char* hex_digits()
+    { return "0123456789ABCDEF"; }
+
+    char* buf;
+    size_t cap;
+    size_t len = 0;
+};
+
+#endif
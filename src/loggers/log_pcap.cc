@@ -24,14 +24,17 @@
 
 #include <pcap.h>
 
-#include "detection/ips_context.h"
+#include "framework/data_bus.h"
 #include "framework/logger.h"
 #include "framework/module.h"
+#include "log/async_log.h"
+#include "log/batch_log.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "packet_io/sfdaq.h"
 #include "packet_io/sfdaq_config.h"
 #include "protocols/packet.h"
+#include "pub_sub/intrinsic_event_ids.h"
 #include "utils/util.h"
 
 using namespace snort;
@@ -48,33 +51,180 @@ using namespace std;
 #define PCAP_FILE_HDR_SZ (24)
 #define PCAP_PKT_HDR_SZ  (16)
 
+// the packet header as dumped
+struct PcapPktHdr
+{
+    uint32_t sec;
+    uint32_t usec;
+    uint32_t caplen;
+    uint32_t len;
+};
+
 struct LtdConfig
 {
     size_t limit;
+    size_t recorder;
+    unsigned buffer;
 };
 
-struct LtdContext
+struct LtdFile
 {
+    string base;
     char* file;
     pcap_dumper_t* dumpd;
     time_t lastTime;
-    size_t size;
-    int log_cnt;
+    int dlt;
+    int snaplen;
+    bool flush;          // after each write, unless -f
 };
 
-static THREAD_LOCAL LtdContext context;
+// packets are collected in batch[0] until it is written, or in flight
+// recorder mode in both batches, dropping the older one when the newer one
+// fills, until an alert has them written
+struct LtdContext
+{
+    LtdConfig* config;
+    LtdFile* out;
+    BatchBuffer* batch[2];
+    unsigned cur;
+    size_t size;         // of the current file including what is buffered
+    int log_cnt;
+    bool roll;           // the next recorder write starts a new file
+};
 
-static void TcpdumpRollLogFile(LtdConfig*);
+static THREAD_LOCAL LtdContext* context = nullptr;
 
 #define S_NAME "log_pcap"
 #define F_NAME "log.pcap"
 
+//-------------------------------------------------------------------------
+// file stuff
+//-------------------------------------------------------------------------
+
+static void TcpdumpInitLogFile(LtdFile* out, bool no_timestamp)
+{
+    string file = out->base;
+
+    out->lastTime = time(nullptr);
+
+    if(!no_timestamp)
+    {
+        char timestamp[16];
+        snprintf(timestamp, sizeof(timestamp), ".%lu", (unsigned long)out->lastTime);
+        file += timestamp;
+    }
+
+    pcap_t* pcap;
+    pcap = pcap_open_dead(out->dlt, out->snaplen);
+
+    if ( !pcap )
+        FatalError("%s: can't get pcap context\n", S_NAME);
+
+    out->dumpd = pcap ? pcap_dump_open(pcap, file.c_str()) : nullptr;
+
+    if (out->dumpd == nullptr)
+    {
+        FatalError("%s: can't open %s: %s\n",
+            S_NAME, file.c_str(), pcap_geterr(pcap));
+    }
+    pcap_close(pcap);
+
+    out->file = snort_strdup(file.c_str());
+}
+
+static void TcpdumpRollLogFile(LtdFile* out)
+{
+    time_t now = time(nullptr);
+
+    /* don't roll over any sooner than resolution
+     * of filename discriminator
+     */
+    if ( now <= out->lastTime )
+        return;
+
+    /* close the output file */
+    if ( out->dumpd != nullptr )
+    {
+        pcap_dump_close(out->dumpd);
+        out->dumpd = nullptr;
+        snort_free(out->file);
+        out->file = nullptr;
+    }
+
+    /* Have to add stamps now to distinguish files */
+    TcpdumpInitLogFile(out, false);
+}
+
+// the records are already in dump format so they are written as is
+static void TcpdumpWrite(LtdFile* out, const uint8_t* data, size_t len)
+{
+    FILE* fh = pcap_dump_file(out->dumpd);
+
+    if ( fwrite(data, len, 1, fh) != 1 or (out->flush and fflush(fh)) )
+        ErrorMessage("%s: can't write %s: %s\n", S_NAME, out->file, get_error(errno));
+}
+
+// writer thread sinks
+static void TcpdumpWriteBuffer(void* out, const char* data, unsigned len)
+{
+    TcpdumpWrite((LtdFile*)out, (const uint8_t*)data, len);
+}
+
+static void TcpdumpRollWriteBuffer(void* out, const char* data, unsigned len)
+{
+    TcpdumpRollLogFile((LtdFile*)out);
+    TcpdumpWrite((LtdFile*)out, (const uint8_t*)data, len);
+}
+
+static inline size_t SizeOf(const Packet* p)
+{
+    return PCAP_PKT_HDR_SZ + p->pktlen;
+}
+
+static void TcpdumpAppend(BatchBuffer* batch, const Packet* p)
+{
+    PcapPktHdr hdr;
+    hdr.sec = (uint32_t)p->pkth->ts.tv_sec;
+    hdr.usec = (uint32_t)p->pkth->ts.tv_usec;
+    hdr.caplen = p->pktlen;
+    hdr.len = p->pkth->pktlen;
+
+    size_t len = SizeOf(p);
+    uint8_t* rec = batch->reserve(len);
+
+    memcpy(rec, &hdr, PCAP_PKT_HDR_SZ);
+    memcpy(rec + PCAP_PKT_HDR_SZ, p->pkt, p->pktlen);
+
+    batch->commit(len);
+}
+
+// the roll goes with the first recorder batch that has packets
+static void TcpdumpFlushRecorder(BatchBuffer* batch)
+{
+    if ( context->roll and batch->get_used() )
+    {
+        batch->roll();
+        context->roll = false;
+    }
+    batch->flush();
+}
+
+static BatchLog* get_batch()
+{ return context ? context->batch[0] : nullptr; }
+
 //-------------------------------------------------------------------------
 // module stuff
 //-------------------------------------------------------------------------
 
 static const Parameter s_params[] =
 {
+    { "buffer", Parameter::PT_INT, "0:65536", "256",
+      "set size in KB of the per thread buffer of packets written together (0 writes each packet)" },
+
+    { "flight_recorder", Parameter::PT_INT, "0:4096", "0",
+      "keep the last 1/2 to 1 times this many MB of packets per thread and only write them "
+      "when a packet is logged (0 is disabled)" },
+
     { "limit", Parameter::PT_INT, "0:maxSZ", "0",
       "set maximum size in MB before rollover (0 is unlimited)" },
 
@@ -91,147 +241,148 @@ public:
 
     bool set(const char*, Value&, SnortConfig*) override;
     bool begin(const char*, int, SnortConfig*) override;
+    bool end(const char*, int, SnortConfig*) override;
 
     Usage get_usage() const override
     { return GLOBAL; }
 
 public:
     size_t limit = 0;
+    size_t recorder = 0;
+    unsigned buffer = 256 * 1024;
 };
 
 bool TcpdumpModule::set(const char*, Value& v, SnortConfig*)
 {
-    assert(v.is("limit"));
-    limit = v.get_size() * 1024 * 1024;
+    if ( v.is("buffer") )
+        buffer = v.get_uint32() * 1024;
+
+    else if ( v.is("flight_recorder") )
+        recorder = v.get_size() * 1024 * 1024;
+
+    else if ( v.is("limit") )
+        limit = v.get_size() * 1024 * 1024;
+
     return true;
 }
 
 bool TcpdumpModule::begin(const char*, int, SnortConfig*)
 {
     limit = 0;
+    recorder = 0;
+    buffer = 256 * 1024;
     return true;
 }
 
-//-------------------------------------------------------------------------
-// api stuff
-//-------------------------------------------------------------------------
-
-static inline size_t SizeOf(const Packet* p)
-{
-    return PCAP_PKT_HDR_SZ + p->pktlen;
-}
-
-static void LogTcpdumpSingle(
-    LtdConfig* data, Packet* p, const char*, Event*)
+// the flight recorder sees every packet as it is received
+class TcpdumpRecordHandler : public DataHandler
 {
-    size_t dumpSize = SizeOf(p);
-
-    if ( data->limit && (context.size + dumpSize > data->limit) )
-        TcpdumpRollLogFile(data);
-
-    struct pcap_pkthdr pcaphdr;
-    pcaphdr.ts = p->pkth->ts;
-    pcaphdr.caplen = p->pktlen;
-    pcaphdr.len = p->pkth->pktlen;
-    pcap_dump((uint8_t*)context.dumpd, &pcaphdr, p->pkt);
-    context.size += dumpSize;
+public:
+    TcpdumpRecordHandler(SnortConfig& sc) : DataHandler(S_NAME)
+    { DataBus::subscribe_global(intrinsic_pub_key, IntrinsicEventIds::WIRE_PACKET, this, sc); }
 
-    if (!p->context->conf->line_buffered_logging())  // FIXIT-L misnomer
+    void handle(DataEvent& e, Flow*) override
     {
-        pcap_dump_flush(context.dumpd);
+        if ( !context or !context->config->recorder )
+            return;
+
+        const Packet* p = e.get_packet();
+        size_t len = SizeOf(p);
+        BatchBuffer* batch = context->batch[context->cur];
+
+        if ( len > batch->get_size() )
+            return;
+
+        if ( batch->get_used() + len > batch->get_size() )
+        {
+            context->cur ^= 1;
+            batch = context->batch[context->cur];
+            batch->discard();
+        }
+        TcpdumpAppend(batch, p);
     }
-}
-
-static void LogTcpdumpStream(
-    LtdConfig*, Packet*, const char*, Event*)
-{
-// FIXIT-L log reassembled stream data with original packet?
-// (take original packet headers and append reassembled data)
-}
+};
 
-static void TcpdumpInitLogFile(LtdConfig*, bool no_timestamp)
+bool TcpdumpModule::end(const char*, int, SnortConfig* sc)
 {
-    string file;
-    string filename = F_NAME;
+    if ( recorder )
+        new TcpdumpRecordHandler(*sc);
 
-    context.lastTime = time(nullptr);
-    context.log_cnt = 0;
+    else if ( buffer )
+        BatchLog::subscribe(*sc, S_NAME, get_batch);
 
-    if(!no_timestamp)
-    {
-        char timestamp[16];
-        snprintf(timestamp, sizeof(timestamp), ".%lu", (unsigned long)context.lastTime);
-        filename += timestamp;
-    }
+    return true;
+}
 
-    get_instance_file(file, filename.c_str());
+//-------------------------------------------------------------------------
+// api stuff
+//-------------------------------------------------------------------------
 
-    int dlt = SFDAQ::get_base_protocol();
+// true if the next len bytes go to a new file
+static bool TcpdumpCheckLimit(size_t len)
+{
+    bool roll = context->config->limit && (context->size + len > context->config->limit);
 
-    // convert these flavors of raw to the generic
-    // for compatibility with libpcap 1.0.0
-    if ( dlt == DLT_IPV4 || dlt == DLT_IPV6 )
-        dlt = DLT_RAW;
+    if ( roll )
+        context->size = PCAP_FILE_HDR_SZ;
 
-    pcap_t* pcap;
-    pcap = pcap_open_dead(dlt, SnortConfig::get_conf()->daq_config->get_mru_size());
+    context->size += len;
+    return roll;
+}
 
-    if ( !pcap )
-        FatalError("%s: can't get pcap context\n", S_NAME);
+static void LogTcpdumpSingle(
+    LtdConfig*, Packet* p, const char*, Event*)
+{
+    size_t dumpSize = SizeOf(p);
+    BatchBuffer* batch = context->batch[0];
 
-    context.dumpd = pcap ? pcap_dump_open(pcap, file.c_str()) : nullptr;
+    if ( dumpSize > batch->get_size() )
+        return;
 
-    if (context.dumpd == nullptr)
+    if ( TcpdumpCheckLimit(dumpSize) )
     {
-        FatalError("%s: can't open %s: %s\n",
-            S_NAME, file.c_str(), pcap_geterr(pcap));
+        batch->flush();
+        batch->roll();
     }
-    pcap_close(pcap);
-
-    context.file = snort_strdup(file.c_str());
-    context.size = PCAP_FILE_HDR_SZ;
+    TcpdumpAppend(batch, p);
 }
 
-static void TcpdumpRollLogFile(LtdConfig* data)
+// an alert writes what the flight recorder has, oldest first
+static void LogTcpdumpRecorder()
 {
-    time_t now = time(nullptr);
+    BatchBuffer* older = context->batch[context->cur ^ 1];
+    BatchBuffer* newer = context->batch[context->cur];
 
-    /* don't roll over any sooner than resolution
-     * of filename discriminator
-     */
-    if ( now <= context.lastTime )
-        return;
+    if ( TcpdumpCheckLimit(older->get_used() + newer->get_used()) )
+        context->roll = true;
 
-    /* close the output file */
-    if ( context.dumpd != nullptr )
-    {
-        pcap_dump_close(context.dumpd);
-        context.dumpd = nullptr;
-        context.size = 0;
-        snort_free(context.file);
-        context.file = nullptr;
-    }
+    TcpdumpFlushRecorder(older);
+    TcpdumpFlushRecorder(newer);
+}
 
-    /* Have to add stamps now to distinguish files */
-    TcpdumpInitLogFile(data, false);
+static void LogTcpdumpStream(
+    LtdConfig*, Packet*, const char*, Event*)
+{
+// FIXIT-L log reassembled stream data with original packet?
+// (take original packet headers and append reassembled data)
 }
 
-static void SpoLogTcpdumpCleanup(LtdConfig*)
+static void SpoLogTcpdumpCleanup(LtdFile* out)
 {
     /*
      * if we haven't written any data, dump the output file so there aren't
      * fragments all over the disk
      */
-    if (context.file && !context.log_cnt)
+    if (out->file && !context->log_cnt)
     {
-        int ret = unlink(context.file);
+        int ret = unlink(out->file);
 
         if ( ret )
             ErrorMessage("Could not remove tcpdump output file %s: %s\n",
-                context.file, get_error(errno));
+                out->file, get_error(errno));
 
-        snort_free(context.file);
-        context.file = nullptr;
+        snort_free(out->file);
+        out->file = nullptr;
     }
 }
 
@@ -259,6 +410,8 @@ PcapLogger::PcapLogger(TcpdumpModule* m)
 {
     config = new LtdConfig;
     config->limit = m->limit;
+    config->recorder = m->recorder;
+    config->buffer = m->buffer;
 }
 
 PcapLogger::~PcapLogger()
@@ -268,29 +421,91 @@ PcapLogger::~PcapLogger()
 
 void PcapLogger::open()
 {
-    TcpdumpInitLogFile(config, SnortConfig::get_conf()->output_no_timestamp());
+    const SnortConfig* sc = SnortConfig::get_conf();
+
+    LtdFile* out = new LtdFile;
+    get_instance_file(out->base, F_NAME);
+
+    out->dlt = SFDAQ::get_base_protocol();
+
+    // convert these flavors of raw to the generic
+    // for compatibility with libpcap 1.0.0
+    if ( out->dlt == DLT_IPV4 || out->dlt == DLT_IPV6 )
+        out->dlt = DLT_RAW;
+
+    out->snaplen = sc->daq_config->get_mru_size();
+    out->flush = !sc->line_buffered_logging();
+
+    TcpdumpInitLogFile(out, sc->output_no_timestamp());
+
+    context = new LtdContext;
+    context->config = config;
+    context->out = out;
+
+    // each recorder batch takes half of the flight recorder and is only
+    // written for alerts; otherwise packets are written within a second
+    size_t max_rec = PCAP_PKT_HDR_SZ + out->snaplen;
+
+    if ( config->recorder )
+    {
+        for ( unsigned i = 0; i < 2; ++i )
+            context->batch[i] = new BatchBuffer(config->recorder / 2, max_rec, 0,
+                out, TcpdumpWriteBuffer, TcpdumpRollWriteBuffer);
+    }
+    else
+    {
+        context->batch[0] = new BatchBuffer(config->buffer, max_rec, 1,
+            out, TcpdumpWriteBuffer, TcpdumpRollWriteBuffer);
+        context->batch[1] = nullptr;
+    }
+
+    context->cur = 0;
+    context->size = PCAP_FILE_HDR_SZ;
+    context->log_cnt = 0;
+    context->roll = false;
 }
 
 void PcapLogger::close()
 {
-    SpoLogTcpdumpCleanup(nullptr);
+    if ( !context )
+        return;
 
-    if ( context.dumpd )
-    {
-        pcap_dump_close(context.dumpd);
-        context.dumpd = nullptr;
-    }
-    if ( context.file )
-        snort_free(context.file);
+    // the flight recorder is only written for alerts
+    if ( !config->recorder )
+        context->batch[0]->flush();
+
+    // queued batches must be written before the dumper is closed
+    AsyncLog::drain();
+
+    LtdFile* out = context->out;
+    SpoLogTcpdumpCleanup(out);
+
+    if ( out->dumpd )
+        pcap_dump_close(out->dumpd);
+
+    if ( out->file )
+        snort_free(out->file);
+
+    delete out;
+
+    delete context->batch[0];
+    delete context->batch[1];
+
+    delete context;
+    context = nullptr;
 }
 
 void PcapLogger::log(Packet* p, const char* msg, Event* event)
 {
-    if(!context.dumpd)
+    if(!context)
         open();
 
-    context.log_cnt++;
-    if (p->packet_flags & PKT_REBUILT_STREAM)
+    context->log_cnt++;
+
+    if ( config->recorder )
+        LogTcpdumpRecorder();
+
+    else if (p->packet_flags & PKT_REBUILT_STREAM)
         LogTcpdumpStream(config, p, msg, event);
     else
         LogTcpdumpSingle(config, p, msg, event);
@@ -298,10 +513,21 @@ void PcapLogger::log(Packet* p, const char* msg, Event* event)
 
 void PcapLogger::reset()
 {
-    if(!context.dumpd)
+    if(!context)
+    {
         open();
+        return;
+    }
+
+    if ( config->recorder )
+        context->roll = true;
     else
-        TcpdumpRollLogFile(config);
+    {
+        context->batch[0]->flush();
+        context->batch[0]->roll();
+    }
+
+    context->size = PCAP_FILE_HDR_SZ;
 }
 
 //-------------------------------------------------------------------------
@@ -348,4 +574,3 @@ const BaseApi* log_pcap[] =
     &tcpdump_api.base,
     nullptr
 };
-
@@ -31,6 +31,7 @@ using namespace snort;
 extern const BaseApi* log_codecs[];
 
 #ifdef STATIC_LOGGERS
+extern const BaseApi* alert_compact[];
 extern const BaseApi* alert_csv[];
 extern const BaseApi* alert_fast[];
 extern const BaseApi* alert_full[];
@@ -50,6 +51,7 @@ void load_loggers()
 
 #ifdef STATIC_LOGGERS
     // alerters
+    PluginManager::load_plugins(alert_compact);
     PluginManager::load_plugins(alert_csv);
     PluginManager::load_plugins(alert_fast);
     PluginManager::load_plugins(alert_full);
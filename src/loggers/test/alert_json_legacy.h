@@ -0,0 +1,645 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// alert_json_legacy.h author Cisco
+
+#ifndef ALERT_JSON_LEGACY_H
+#define ALERT_JSON_LEGACY_H
+
+// the printf formatting alert_json used before the JsonBuffer writers, kept
+// unchanged so the tests can check the writers against it byte for byte.
+// included by alert_json.cc for its unit and benchmark tests only.
+
+static THREAD_LOCAL TextLog* legacy_log;
+
+struct LegacyArgs
+{
+    Packet* pkt;
+    const char* msg;
+    const Event& event;
+    bool comma;
+};
+
+static void legacy_label(const LegacyArgs& a, const char* label)
+{
+    if ( a.comma )
+        TextLog_Print(legacy_log, ",");
+
+    TextLog_Print(legacy_log, " \"%s\" : ", label);
+}
+
+static bool legacy_action(const LegacyArgs& a)
+{
+    legacy_label(a, "action");
+    TextLog_Quote(legacy_log, a.pkt->active->get_action_string());
+    return true;
+}
+
+static bool legacy_class(const LegacyArgs& a)
+{
+    const char* cls = "none";
+
+    if ( a.event.sig_info->class_type and !a.event.sig_info->class_type->text.empty() )
+        cls = a.event.sig_info->class_type->text.c_str();
+
+    legacy_label(a, "class");
+    TextLog_Quote(legacy_log, cls);
+    return true;
+}
+
+static bool legacy_b64_data(const LegacyArgs& a)
+{
+    if ( !a.pkt->dsize )
+        return false;
+
+    const unsigned block_size = 2048;
+    char out[2*block_size];
+    const uint8_t* in = a.pkt->data;
+
+    unsigned nin = 0;
+    Base64Encoder b64;
+
+    legacy_label(a, "b64_data");
+    TextLog_Putc(legacy_log, '"');
+
+    while ( nin < a.pkt->dsize )
+    {
+        unsigned kin = min(a.pkt->dsize-nin, block_size);
+        unsigned kout = b64.encode(in+nin, kin, out);
+        TextLog_Write(legacy_log, out, kout);
+        nin += kin;
+    }
+
+    if ( unsigned kout = b64.finish(out) )
+        TextLog_Write(legacy_log, out, kout);
+
+    TextLog_Putc(legacy_log, '"');
+    return true;
+}
+
+static bool legacy_client_bytes(const LegacyArgs& a)
+{
+    if (a.pkt->flow)
+    {
+        legacy_label(a, "client_bytes");
+        TextLog_Print(legacy_log, "%" PRIu64, a.pkt->flow->flowstats.client_bytes);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_client_pkts(const LegacyArgs& a)
+{
+    if (a.pkt->flow)
+    {
+        legacy_label(a, "client_pkts");
+        TextLog_Print(legacy_log, "%" PRIu64, a.pkt->flow->flowstats.client_pkts);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_dir(const LegacyArgs& a)
+{
+    const char* dir;
+
+    if ( a.pkt->is_from_application_client() )
+        dir = "C2S";
+    else if ( a.pkt->is_from_application_server() )
+        dir = "S2C";
+    else
+        dir = "UNK";
+
+    legacy_label(a, "dir");
+    TextLog_Quote(legacy_log, dir);
+    return true;
+}
+
+static bool legacy_dst_addr(const LegacyArgs& a)
+{
+    if ( a.pkt->has_ip() or a.pkt->is_data() )
+    {
+        SfIpString ip_str;
+        legacy_label(a, "dst_addr");
+        TextLog_Quote(legacy_log, a.pkt->ptrs.ip_api.get_dst()->ntop(ip_str));
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_dst_ap(const LegacyArgs& a)
+{
+    SfIpString addr = "";
+    unsigned port = 0;
+
+    if ( a.pkt->has_ip() or a.pkt->is_data() )
+        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
+
+    if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
+        port = a.pkt->ptrs.dp;
+
+    legacy_label(a, "dst_ap");
+    TextLog_Print(legacy_log, "\"%s:%u\"", addr, port);
+    return true;
+}
+
+static bool legacy_dst_port(const LegacyArgs& a)
+{
+    if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
+    {
+        legacy_label(a, "dst_port");
+        TextLog_Print(legacy_log, "%u", a.pkt->ptrs.dp);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_eth_dst(const LegacyArgs& a)
+{
+    if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
+        return false;
+
+    legacy_label(a, "eth_dst");
+    const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
+
+    TextLog_Print(legacy_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_dst[0],
+        eh->ether_dst[1], eh->ether_dst[2], eh->ether_dst[3],
+        eh->ether_dst[4], eh->ether_dst[5]);
+
+    return true;
+}
+
+static bool legacy_eth_len(const LegacyArgs& a)
+{
+    if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
+        return false;
+
+    legacy_label(a, "eth_len");
+    TextLog_Print(legacy_log, "%u", a.pkt->pkth->pktlen);
+    return true;
+}
+
+static bool legacy_eth_src(const LegacyArgs& a)
+{
+    if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
+        return false;
+
+    legacy_label(a, "eth_src");
+    const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
+
+    TextLog_Print(legacy_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_src[0],
+        eh->ether_src[1], eh->ether_src[2], eh->ether_src[3],
+        eh->ether_src[4], eh->ether_src[5]);
+    return true;
+}
+
+static bool legacy_eth_type(const LegacyArgs& a)
+{
+    if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
+        return false;
+
+    const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
+
+    legacy_label(a, "eth_type");
+    TextLog_Print(legacy_log, "\"0x%X\"", ntohs(eh->ether_type));
+    return true;
+}
+
+static bool legacy_flowstart_time(const LegacyArgs& a)
+{
+    if (a.pkt->flow)
+    {
+        legacy_label(a, "flowstart_time");
+        TextLog_Print(legacy_log, "%ld", a.pkt->flow->flowstats.start_time.tv_sec);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_geneve_vni(const LegacyArgs& a)
+{
+    if (a.pkt->proto_bits & PROTO_BIT__GENEVE)
+    {
+        legacy_label(a, "geneve_vni");
+        TextLog_Print(legacy_log, "%u", a.pkt->get_flow_geneve_vni());
+    }
+    return true;
+}
+
+static bool legacy_gid(const LegacyArgs& a)
+{
+    legacy_label(a, "gid");
+    TextLog_Print(legacy_log, "%u",  a.event.sig_info->gid);
+    return true;
+}
+
+static bool legacy_icmp_code(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.icmph )
+    {
+        legacy_label(a, "icmp_code");
+        TextLog_Print(legacy_log, "%u", a.pkt->ptrs.icmph->code);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_icmp_id(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.icmph )
+    {
+        legacy_label(a, "icmp_id");
+        TextLog_Print(legacy_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_id));
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_icmp_seq(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.icmph )
+    {
+        legacy_label(a, "icmp_seq");
+        TextLog_Print(legacy_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_icmp_type(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.icmph )
+    {
+        legacy_label(a, "icmp_type");
+        TextLog_Print(legacy_log, "%u", a.pkt->ptrs.icmph->type);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_iface(const LegacyArgs& a)
+{
+    legacy_label(a, "iface");
+    TextLog_Quote(legacy_log, SFDAQ::get_input_spec());
+    return true;
+}
+
+static bool legacy_ip_id(const LegacyArgs& a)
+{
+    if (a.pkt->has_ip())
+    {
+        legacy_label(a, "ip_id");
+        TextLog_Print(legacy_log, "%u", a.pkt->ptrs.ip_api.id());
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_ip_len(const LegacyArgs& a)
+{
+    if (a.pkt->has_ip())
+    {
+        legacy_label(a, "ip_len");
+        TextLog_Print(legacy_log, "%u", a.pkt->ptrs.ip_api.pay_len());
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_msg(const LegacyArgs& a)
+{
+    legacy_label(a, "msg");
+    TextLog_Puts(legacy_log, a.msg);
+    return true;
+}
+
+static bool legacy_mpls(const LegacyArgs& a)
+{
+    uint32_t mpls;
+
+    if (a.pkt->flow)
+        mpls = a.pkt->flow->key->mplsLabel;
+
+    else if ( a.pkt->proto_bits & PROTO_BIT__MPLS )
+        mpls = a.pkt->ptrs.mplsHdr.label;
+
+    else
+        return false;
+
+    legacy_label(a, "mpls");
+    TextLog_Print(legacy_log, "%u", mpls);
+    return true;
+}
+
+static bool legacy_pkt_gen(const LegacyArgs& a)
+{
+    legacy_label(a, "pkt_gen");
+    TextLog_Quote(legacy_log, a.pkt->get_pseudo_type());
+    return true;
+}
+
+static bool legacy_pkt_len(const LegacyArgs& a)
+{
+    legacy_label(a, "pkt_len");
+
+    if (a.pkt->has_ip())
+        TextLog_Print(legacy_log, "%u", a.pkt->ptrs.ip_api.dgram_len());
+    else
+        TextLog_Print(legacy_log, "%u", a.pkt->dsize);
+
+    return true;
+}
+
+static bool legacy_pkt_num(const LegacyArgs& a)
+{
+    legacy_label(a, "pkt_num");
+    TextLog_Print(legacy_log, STDu64, a.pkt->context->packet_number);
+    return true;
+}
+
+static bool legacy_priority(const LegacyArgs& a)
+{
+    legacy_label(a, "priority");
+    TextLog_Print(legacy_log, "%u", a.event.sig_info->priority);
+    return true;
+}
+
+static bool legacy_proto(const LegacyArgs& a)
+{
+    legacy_label(a, "proto");
+    TextLog_Quote(legacy_log, a.pkt->get_type());
+    return true;
+}
+
+static bool legacy_rev(const LegacyArgs& a)
+{
+    legacy_label(a, "rev");
+    TextLog_Print(legacy_log, "%u",  a.event.sig_info->rev);
+    return true;
+}
+
+static bool legacy_rule(const LegacyArgs& a)
+{
+    legacy_label(a, "rule");
+
+    TextLog_Print(legacy_log, "\"%u:%u:%u\"",
+        a.event.sig_info->gid, a.event.sig_info->sid, a.event.sig_info->rev);
+
+    return true;
+}
+
+static bool legacy_seconds(const LegacyArgs& a)
+{
+    legacy_label(a, "seconds");
+    TextLog_Print(legacy_log, "%ld",  a.pkt->pkth->ts.tv_sec);
+    return true;
+}
+
+static bool legacy_server_bytes(const LegacyArgs& a)
+{
+    if (a.pkt->flow)
+    {
+        legacy_label(a, "server_bytes");
+        TextLog_Print(legacy_log, "%" PRIu64, a.pkt->flow->flowstats.server_bytes);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_server_pkts(const LegacyArgs& a)
+{
+    if (a.pkt->flow)
+    {
+        legacy_label(a, "server_pkts");
+        TextLog_Print(legacy_log, "%" PRIu64, a.pkt->flow->flowstats.server_pkts);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_service(const LegacyArgs& a)
+{
+    const char* svc = "unknown";
+
+    if ( a.pkt->flow and a.pkt->flow->service )
+        svc = a.pkt->flow->service;
+
+    legacy_label(a, "service");
+    TextLog_Quote(legacy_log, svc);
+    return true;
+}
+
+static bool legacy_sgt(const LegacyArgs& a)
+{
+    if (a.pkt->proto_bits & PROTO_BIT__CISCO_META_DATA)
+    {
+        const cisco_meta_data::CiscoMetaDataHdr* cmdh = layer::get_cisco_meta_data_layer(a.pkt);
+        legacy_label(a, "sgt");
+        TextLog_Print(legacy_log, "%hu", cmdh->sgt_val());
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_sid(const LegacyArgs& a)
+{
+    legacy_label(a, "sid");
+    TextLog_Print(legacy_log, "%u",  a.event.sig_info->sid);
+    return true;
+}
+
+static bool legacy_src_addr(const LegacyArgs& a)
+{
+    if ( a.pkt->has_ip() or a.pkt->is_data() )
+    {
+        SfIpString ip_str;
+        legacy_label(a, "src_addr");
+        TextLog_Quote(legacy_log, a.pkt->ptrs.ip_api.get_src()->ntop(ip_str));
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_src_ap(const LegacyArgs& a)
+{
+    SfIpString addr = "";
+    unsigned port = 0;
+
+    if ( a.pkt->has_ip() or a.pkt->is_data() )
+        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
+
+    if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
+        port = a.pkt->ptrs.sp;
+
+    legacy_label(a, "src_ap");
+    TextLog_Print(legacy_log, "\"%s:%u\"", addr, port);
+    return true;
+}
+
+static bool legacy_src_port(const LegacyArgs& a)
+{
+    if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
+    {
+        legacy_label(a, "src_port");
+        TextLog_Print(legacy_log, "%u", a.pkt->ptrs.sp);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_target(const LegacyArgs& a)
+{
+    SfIpString addr = "";
+
+    if ( a.event.sig_info->target == TARGET_SRC )
+        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
+
+    else if ( a.event.sig_info->target == TARGET_DST )
+        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
+
+    else
+        return false;
+
+    legacy_label(a, "target");
+    TextLog_Quote(legacy_log, addr);
+    return true;
+}
+
+static bool legacy_tcp_ack(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.tcph )
+    {
+        legacy_label(a, "tcp_ack");
+        TextLog_Print(legacy_log, "%u", ntohl(a.pkt->ptrs.tcph->th_ack));
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_tcp_flags(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.tcph )
+    {
+        char tcpFlags[9];
+        CreateTCPFlagString(a.pkt->ptrs.tcph, tcpFlags);
+
+        legacy_label(a, "tcp_flags");
+        TextLog_Quote(legacy_log, tcpFlags);
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_tcp_len(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.tcph )
+    {
+        legacy_label(a, "tcp_len");
+        TextLog_Print(legacy_log, "%u", (a.pkt->ptrs.tcph->off()));
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_tcp_seq(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.tcph )
+    {
+        legacy_label(a, "tcp_seq");
+        TextLog_Print(legacy_log, "%u", ntohl(a.pkt->ptrs.tcph->th_seq));
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_tcp_win(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.tcph )
+    {
+        legacy_label(a, "tcp_win");
+        TextLog_Print(legacy_log, "%u", ntohs(a.pkt->ptrs.tcph->th_win));
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_timestamp(const LegacyArgs& a)
+{
+    legacy_label(a, "timestamp");
+    TextLog_Putc(legacy_log, '"');
+    LogTimeStamp(legacy_log, a.pkt);
+    TextLog_Putc(legacy_log, '"');
+    return true;
+}
+
+static bool legacy_tos(const LegacyArgs& a)
+{
+    if (a.pkt->has_ip())
+    {
+        legacy_label(a, "tos");
+        TextLog_Print(legacy_log, "%u", a.pkt->ptrs.ip_api.tos());
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_ttl(const LegacyArgs& a)
+{
+    if (a.pkt->has_ip())
+    {
+        legacy_label(a, "ttl");
+        TextLog_Print(legacy_log, "%u",a.pkt->ptrs.ip_api.ttl());
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_udp_len(const LegacyArgs& a)
+{
+    if (a.pkt->ptrs.udph )
+    {
+        legacy_label(a, "udp_len");
+        TextLog_Print(legacy_log, "%u", ntohs(a.pkt->ptrs.udph->uh_len));
+        return true;
+    }
+    return false;
+}
+
+static bool legacy_vlan(const LegacyArgs& a)
+{
+    legacy_label(a, "vlan");
+    TextLog_Print(legacy_log, "%hu", a.pkt->get_flow_vlan_id());
+    return true;
+}
+
+typedef bool (*LegacyFunc)(const LegacyArgs&);
+
+static const LegacyFunc legacy_func[] =
+{
+    legacy_action, legacy_class, legacy_b64_data, legacy_client_bytes, legacy_client_pkts,
+    legacy_dir, legacy_dst_addr, legacy_dst_ap, legacy_dst_port, legacy_eth_dst, legacy_eth_len,
+    legacy_eth_src, legacy_eth_type, legacy_flowstart_time, legacy_geneve_vni, legacy_gid,
+    legacy_icmp_code, legacy_icmp_id, legacy_icmp_seq, legacy_icmp_type, legacy_iface,
+    legacy_ip_id, legacy_ip_len, legacy_msg, legacy_mpls, legacy_pkt_gen, legacy_pkt_len,
+    legacy_pkt_num, legacy_priority, legacy_proto, legacy_rev, legacy_rule, legacy_seconds,
+    legacy_server_bytes, legacy_server_pkts, legacy_service, legacy_sgt, legacy_sid,
+    legacy_src_addr, legacy_src_ap, legacy_src_port, legacy_target, legacy_tcp_ack,
+    legacy_tcp_flags, legacy_tcp_len, legacy_tcp_seq, legacy_tcp_win, legacy_timestamp, legacy_tos,
+    legacy_ttl, legacy_udp_len, legacy_vlan
+};
+
+#endif
@@ -0,0 +1,373 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// log_pcap_test.cc author Cisco
+
+// unit test main
+
+#include "../log_pcap.cc"
+
+#include <sys/stat.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+static time_t now = 0;
+static DataHandler* handlers[IntrinsicEventIds::num_ids];
+
+static SFDAQConfig daq_config;
+static SnortConfig snort_conf;
+
+static char dir[] = "/tmp/log_pcap_test.XXXXXX";
+static vector<string> opened;
+
+SFDAQConfig::SFDAQConfig()
+{ mru_size = 256; }
+
+SFDAQConfig::~SFDAQConfig() = default;
+
+void show_stats(PegCount*, const PegInfo*, unsigned, const char*) { }
+void show_stats(PegCount*, const PegInfo*, const IndexVec&, const char*, FILE*) { }
+
+namespace snort
+{
+SnortConfig::SnortConfig(const SnortConfig* const, const char*)
+{
+    daq_config = &::daq_config;
+    output_flags = 0;
+}
+
+SnortConfig::~SnortConfig() = default;
+
+const SnortConfig* SnortConfig::get_conf() { return &snort_conf; }
+
+Packet::Packet(bool) { }
+Packet::~Packet() = default;
+
+int SFDAQ::get_base_protocol() { return DLT_EN10MB; }
+
+time_t packet_time() { return now; }
+
+const char* get_error(int) { return ""; }
+void ErrorMessage(const char*, ...) { }
+void FatalError(const char*, ...) { FAIL("fatal"); exit(1); }
+
+const char* get_instance_file(string& file, const char* name)
+{
+    file = string(dir) + "/" + name;
+    return file.c_str();
+}
+
+char* snort_strdup(const char* s)
+{
+    char* p = (char*)snort_alloc(strlen(s) + 1);
+    strcpy(p, s);
+    return p;
+}
+
+void DataBus::subscribe_global(const PubKey&, unsigned id, DataHandler* h, SnortConfig&)
+{
+    delete handlers[id];
+    handlers[id] = h;
+}
+}
+
+bool AsyncLog::active() { return false; }
+bool AsyncLog::write(Sink, void*, char*, unsigned) { return false; }
+void AsyncLog::drain() { }
+
+// the dumpers are just files with a pcap file header; the tests roll
+// within a second so the names get a count
+pcap_t* pcap_open_dead(int, int)
+{ return (pcap_t*)&opened; }
+
+pcap_dumper_t* pcap_dump_open(pcap_t*, const char* name)
+{
+    opened.emplace_back(string(name) + "-" + to_string(opened.size()));
+
+    FILE* fh = fopen(opened.back().c_str(), "w");
+    uint8_t hdr[PCAP_FILE_HDR_SZ] = { };
+    fwrite(hdr, sizeof(hdr), 1, fh);
+    fflush(fh);
+
+    return (pcap_dumper_t*)fh;
+}
+
+FILE* pcap_dump_file(pcap_dumper_t* d)
+{ return (FILE*)d; }
+
+void pcap_dump_close(pcap_dumper_t* d)
+{ fclose((FILE*)d); }
+
+void pcap_close(pcap_t*) { }
+char* pcap_geterr(pcap_t*) { return nullptr; }
+
+//--------------------------------------------------------------------------
+// packets
+//--------------------------------------------------------------------------
+
+class WireEvent : public DataEvent
+{
+public:
+    WireEvent(Packet* p) : packet(p) { }
+
+    const Packet* get_packet() const override
+    { return packet; }
+
+private:
+    const Packet* packet;
+};
+
+struct TestPacket
+{
+    TestPacket(uint8_t id, uint32_t len)
+    {
+        memset(data, id, sizeof(data));
+        hdr.ts.tv_sec = now;
+        hdr.ts.tv_usec = id;
+        hdr.pktlen = len;
+
+        pkt.pkth = &hdr;
+        pkt.pkt = data;
+        pkt.pktlen = len;
+        pkt.packet_flags = 0;
+    }
+
+    DAQ_PktHdr_t hdr;
+    uint8_t data[256];
+    Packet pkt;
+};
+
+static void wire(uint8_t id, uint32_t len = 100)
+{
+    TestPacket tp(id, len);
+    WireEvent e(&tp.pkt);
+    handlers[IntrinsicEventIds::WIRE_PACKET]->handle(e, nullptr);
+}
+
+static void idle()
+{
+    BareDataEvent e;
+
+    if ( handlers[IntrinsicEventIds::THREAD_IDLE] )
+        handlers[IntrinsicEventIds::THREAD_IDLE]->handle(e, nullptr);
+}
+
+// each test has a new config
+static void unsubscribe()
+{
+    for ( auto*& h : handlers )
+    {
+        delete h;
+        h = nullptr;
+    }
+}
+
+static long on_disk(unsigned i = 0)
+{
+    struct stat st;
+    CHECK(i < opened.size());
+    stat(opened[i].c_str(), &st);
+    return st.st_size;
+}
+
+// the ids of the packets in file i, in order
+static vector<uint8_t> ids(unsigned i = 0)
+{
+    vector<uint8_t> v;
+    FILE* fh = fopen(opened[i].c_str(), "r");
+    fseek(fh, PCAP_FILE_HDR_SZ, SEEK_SET);
+
+    PcapPktHdr hdr;
+    uint8_t data[256];
+
+    while ( fread(&hdr, PCAP_PKT_HDR_SZ, 1, fh) == 1 and fread(data, hdr.caplen, 1, fh) == 1 )
+    {
+        CHECK(hdr.usec == data[0]);
+        v.emplace_back(data[0]);
+    }
+    fclose(fh);
+    return v;
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(log_pcap)
+{
+    TcpdumpModule mod;
+    PcapLogger* logger = nullptr;
+
+    void setup() override
+    {
+        mod.begin(nullptr, 0, nullptr);
+        snort_conf.output_flags = 0;
+        opened.clear();
+        unsubscribe();
+        now = 100;
+    }
+
+    void start()
+    {
+        mod.end(nullptr, 0, &snort_conf);
+        logger = new PcapLogger(&mod);
+        logger->open();
+    }
+
+    void log(uint8_t id, uint32_t len = 100)
+    {
+        TestPacket tp(id, len);
+        logger->log(&tp.pkt, nullptr, nullptr);
+    }
+
+    void teardown() override
+    {
+        logger->close();
+        delete logger;
+
+        for ( const auto& f : opened )
+            unlink(f.c_str());
+    }
+};
+
+TEST(log_pcap, buffered_until_due)
+{
+    start();
+
+    log(1);
+    log(2);
+    LONGS_EQUAL(PCAP_FILE_HDR_SZ, on_disk());
+
+    // more traffic but nothing more to log
+    now = 101;
+    wire(3);
+
+    LONGS_EQUAL(PCAP_FILE_HDR_SZ + 2 * (PCAP_PKT_HDR_SZ + 100), on_disk());
+    CHECK((vector<uint8_t>{ 1, 2 }) == ids());
+}
+
+TEST(log_pcap, buffered_until_idle)
+{
+    start();
+
+    log(1);
+    idle();
+    CHECK((vector<uint8_t>{ 1 }) == ids());
+}
+
+TEST(log_pcap, unbuffered)
+{
+    mod.buffer = 0;
+    start();
+
+    log(1);
+    LONGS_EQUAL(PCAP_FILE_HDR_SZ + PCAP_PKT_HDR_SZ + 100, on_disk());
+}
+
+TEST(log_pcap, line_buffered)
+{
+    // -f leaves the packets in the stdio buffer
+    snort_conf.output_flags = OUTPUT_FLAG__LINE_BUFFER;
+    mod.buffer = 0;
+    start();
+
+    log(1);
+    LONGS_EQUAL(PCAP_FILE_HDR_SZ, on_disk());
+}
+
+TEST(log_pcap, limit_rolls_file)
+{
+    mod.buffer = 0;
+    mod.limit = PCAP_FILE_HDR_SZ + 2 * (PCAP_PKT_HDR_SZ + 100);
+    start();
+
+    // rolls are limited to one per second of the file name
+    context->out->lastTime = 0;
+
+    log(1);
+    log(2);
+    LONGS_EQUAL(1, opened.size());
+
+    log(3);
+    LONGS_EQUAL(2, opened.size());
+    CHECK((vector<uint8_t>{ 1, 2 }) == ids(0));
+    CHECK((vector<uint8_t>{ 3 }) == ids(1));
+}
+
+TEST(log_pcap, recorder_written_for_alert)
+{
+    // each half holds 5 packets
+    mod.recorder = 5 * (PCAP_PKT_HDR_SZ + 100) * 2;
+    start();
+
+    for ( uint8_t id = 1; id <= 12; ++id )
+        wire(id);
+
+    now = 200;
+    wire(13);
+    idle();
+    LONGS_EQUAL(PCAP_FILE_HDR_SZ, on_disk());
+
+    // the older half was started over at 11
+    log(13);
+    CHECK((vector<uint8_t>{ 6, 7, 8, 9, 10, 11, 12, 13 }) == ids());
+
+    // and both are empty after
+    wire(14);
+    log(14);
+    CHECK((vector<uint8_t>{ 6, 7, 8, 9, 10, 11, 12, 13, 14 }) == ids());
+}
+
+TEST(log_pcap, recorder_roll_with_empty_older_half)
+{
+    mod.recorder = 5 * (PCAP_PKT_HDR_SZ + 100) * 2;
+    mod.limit = PCAP_FILE_HDR_SZ + 3 * (PCAP_PKT_HDR_SZ + 100);
+    start();
+    context->out->lastTime = 0;
+
+    wire(1);
+    wire(2);
+    log(2);
+
+    wire(3);
+    wire(4);
+    log(4);
+
+    LONGS_EQUAL(2, opened.size());
+    CHECK((vector<uint8_t>{ 1, 2 }) == ids(0));
+    CHECK((vector<uint8_t>{ 3, 4 }) == ids(1));
+}
+
+int main(int argc, char** argv)
+{
+    if ( !mkdtemp(dir) )
+        return -1;
+
+    int ret = CommandLineTestRunner::RunAllTests(argc, argv);
+    unsubscribe();
+
+    rmdir(dir);
+    return ret;
+}
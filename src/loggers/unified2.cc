@@ -29,6 +29,9 @@
 #include "config.h"
 #endif
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cassert>
 
 #include "detection/signature.h"
@@ -37,6 +40,8 @@
 #include "events/event.h"
 #include "framework/logger.h"
 #include "framework/module.h"
+#include "log/async_log.h"
+#include "log/batch_log.h"
 #include "log/messages.h"
 #include "log/obfuscator.h"
 #include "log/unified2.h"
@@ -64,59 +69,61 @@ using namespace std;
 struct Unified2Config
 {
     size_t limit;
+    unsigned batch;
     int nostamp;
     bool legacy_events;
 };
 
-struct U2
+// with async logging the file is only touched by the writer thread
+struct U2File
 {
-    FILE* stream;
-    unsigned int current;
-    int base_proto;
+    int fd;
+    int nostamp;
     uint32_t timestamp;
     char filepath[STD_BUF];
 };
 
+// records are built in place in the batch, which is written at least once
+// a second of packet time so spoolers still get whole records without much
+// delay
+struct U2
+{
+    U2File* file;
+    Unified2Config* config;
+    BatchBuffer* batch;
+    size_t current;    // size of the current file including the batch
+    int base_proto;
+};
+
 /* -------------------- Global Variables ----------------------*/
 
 static THREAD_LOCAL U2 u2;
 
-/* Used for buffering header and payload of unified records so only one
- * write is necessary. */
+/* the largest record, which must fit in a block */
 constexpr unsigned u2_buf_sz =
     sizeof(Serial_Unified2_Header) + sizeof(Unified2Event) + IP_MAXPACKET;
 
-static THREAD_LOCAL uint8_t* write_pkt_buffer = nullptr;
-
 #define MAX_XDATA_WRITE_BUF_LEN \
     (MAX_XFF_WRITE_BUF_LENGTH - \
     sizeof(struct in6_addr) + DECODE_BLEN)
 
-/* This buffer is used in lieu of the underlying default stream buf to
- * prevent flushing in the middle of a record.  Every write is force
- * flushed to disk immediately after the entire record is written so
- * spoolers get an entire record */
-
-/* use the size of the buffer we copy record data into */
-static THREAD_LOCAL char* io_buffer = nullptr;
-
 /* -------------------- Local Functions -----------------------*/
 
-static void Unified2Write(uint8_t*, uint32_t, Unified2Config*);
+static void Unified2Write(U2File*, const uint8_t*, uint32_t);
 
-static void Unified2InitFile(Unified2Config* config)
+static void Unified2InitFile(U2File* file)
 {
-    assert(config);
+    assert(file);
 
     char filepath[STD_BUF];
     char* fname_ptr;
 
-    u2.timestamp = (uint32_t)time(nullptr);
+    file->timestamp = (uint32_t)time(nullptr);
 
-    if (!config->nostamp)
+    if (!file->nostamp)
     {
         if (SnortSnprintf(filepath, sizeof(filepath), "%s.%u",
-            u2.filepath, u2.timestamp) != SNORT_SNPRINTF_SUCCESS)
+            file->filepath, file->timestamp) != SNORT_SNPRINTF_SUCCESS)
         {
             FatalError("unified2 failed to copy file path.\n");
         }
@@ -125,28 +132,50 @@ static void Unified2InitFile(Unified2Config* config)
     }
     else
     {
-        fname_ptr = u2.filepath;
+        fname_ptr = file->filepath;
     }
 
-    if ((u2.stream = fopen(fname_ptr, "wb")) == nullptr)
+    if ((file->fd = open(fname_ptr, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
     {
         FatalError("unified2 could not open %s: %s\n", fname_ptr, get_error(errno));
     }
+}
+
+static inline void Unified2RotateFile(U2File* file)
+{
+    close(file->fd);
+    Unified2InitFile(file);
+}
+
+// writer thread sinks
+static void Unified2WriteBlock(void* file, const char* data, unsigned len)
+{
+    Unified2Write((U2File*)file, (const uint8_t*)data, len);
+}
+
+static void Unified2RotateWriteBlock(void* file, const char* data, unsigned len)
+{
+    Unified2RotateFile((U2File*)file);
+    Unified2Write((U2File*)file, (const uint8_t*)data, len);
+}
 
-    /* Set buffer to size of record buffer so the system doesn't flush
-     * part of a record if it's greater than BUFSIZ */
-    if (setvbuf(u2.stream, io_buffer, _IOFBF, u2_buf_sz) != 0)
+// returns where to build a record of len bytes, which is added with
+// Unified2Commit(); records never span blocks or files
+static uint8_t* Unified2Reserve(uint32_t len)
+{
+    if ( u2.config->limit && (u2.current + len) > u2.config->limit )
     {
-        ErrorMessage("unified2 could not set I/O buffer: %s. "
-            "Using system default.\n", get_error(errno));
+        u2.batch->flush();
+        u2.batch->roll();
+        u2.current = 0;
     }
+    return u2.batch->reserve(len);
 }
 
-static inline void Unified2RotateFile(Unified2Config* config)
+static void Unified2Commit(uint32_t len)
 {
-    fclose(u2.stream);
-    u2.current = 0;
-    Unified2InitFile(config);
+    u2.current += len;
+    u2.batch->commit(len);
 }
 
 static inline unsigned get_version(const SfIp& addr)
@@ -162,7 +191,7 @@ static inline void copy_addr(const SfIp& src, const SfIp& dst, Unified2Event& e)
     e.pkt_ip_ver = (get_version(src) << 4) | get_version(dst);
 }
 
-static void alert_event(Packet* p, const char*, Unified2Config* config, const Event* event)
+static void alert_event(Packet* p, const char*, const Event* event)
 {
     Unified2Event u2_event;
     memset(&u2_event, 0, sizeof(u2_event));
@@ -229,20 +258,18 @@ static void alert_event(Packet* p, const char*, Unified2Config* config, const Ev
 
     Serial_Unified2_Header hdr;
     uint32_t write_len = sizeof(hdr) + sizeof(u2_event);
-
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
+    uint8_t* write_buffer = Unified2Reserve(write_len);
 
     hdr.length = htonl(sizeof(Unified2Event));
     hdr.type = htonl(UNIFIED2_EVENT3);
 
-    memcpy_s(write_pkt_buffer, u2_buf_sz, &hdr, sizeof(hdr));
+    memcpy_s(write_buffer, write_len, &hdr, sizeof(hdr));
 
     size_t offset = sizeof(hdr);
 
-    memcpy_s(write_pkt_buffer + offset, u2_buf_sz - offset, &u2_event, sizeof(u2_event));
+    memcpy_s(write_buffer + offset, write_len - offset, &u2_event, sizeof(u2_event));
 
-    Unified2Write(write_pkt_buffer, write_len, config);
+    Unified2Commit(write_len);
 }
 
 static void apply_mask(Obfuscator* obf, uint8_t* buf, const char* buf_key)
@@ -267,7 +294,7 @@ static void obfuscate(uint8_t* buf, Obfuscator* obf, uint32_t type)
     }
 }
 
-static void _WriteExtraData(Unified2Config* config,
+static void _WriteExtraData(
     Obfuscator* obf,
     uint32_t event_id,
     uint32_t tenant_id,
@@ -279,7 +306,6 @@ static void _WriteExtraData(Unified2Config* config,
     Serial_Unified2_Header hdr;
     SerialUnified2ExtraData alertdata;
     Unified2ExtraDataHdr alertHdr;
-    uint8_t write_buffer[MAX_XDATA_WRITE_BUF_LEN];
     uint8_t* ptr = nullptr;
 
     uint32_t write_len = sizeof(hdr) + sizeof(alertHdr);
@@ -297,35 +323,32 @@ static void _WriteExtraData(Unified2Config* config,
     alertHdr.event_type = htonl(EVENT_TYPE_EXTRA_DATA);
     alertHdr.event_length = htonl(write_len - sizeof(hdr));
 
-    if (write_len > sizeof(write_buffer))
+    if (write_len > MAX_XDATA_WRITE_BUF_LEN)
         return;
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
-
     hdr.length = htonl(write_len - sizeof(hdr));
     hdr.type = htonl(UNIFIED2_EXTRA_DATA);
 
-    ptr = write_buffer;
+    ptr = Unified2Reserve(write_len);
 
-    memcpy_s(ptr, sizeof(write_buffer), &hdr, sizeof(hdr));
+    memcpy_s(ptr, write_len, &hdr, sizeof(hdr));
 
     size_t offset = sizeof(hdr);
 
-    memcpy_s(ptr + offset, sizeof(write_buffer) - offset, &alertHdr, sizeof(alertHdr));
+    memcpy_s(ptr + offset, write_len - offset, &alertHdr, sizeof(alertHdr));
 
     offset += sizeof(alertHdr);
 
-    memcpy_s(ptr + offset, sizeof(write_buffer) - offset, &alertdata, sizeof(alertdata));
+    memcpy_s(ptr + offset, write_len - offset, &alertdata, sizeof(alertdata));
 
     offset += sizeof(alertdata);
 
-    memcpy_s(ptr + offset, sizeof(write_buffer) - offset, buffer, len);
+    memcpy_s(ptr + offset, write_len - offset, buffer, len);
 
     if (obf)
         obfuscate(ptr + offset, obf, type);
 
-    Unified2Write(write_buffer, write_len, config);
+    Unified2Commit(write_len);
 }
 
 static void AlertExtraData(
@@ -358,7 +381,7 @@ static void AlertExtraData(
 
         if ( log_func(flow, &write_buffer, &len, &type) && (len > 0) )
         {
-            _WriteExtraData(config, obf, alert_info.event_id, tenant_id, alert_info.event_second, write_buffer, len, type);
+            _WriteExtraData(obf, alert_info.event_id, tenant_id, alert_info.event_second, write_buffer, len, type);
         }
         xtradata_mask ^= BIT(xid);
         xid = ffs(xtradata_mask);
@@ -366,7 +389,7 @@ static void AlertExtraData(
 }
 
 static void _Unified2LogPacketAlert(
-    Packet* p, const char*, Unified2Config* config, const Event* event,
+    Packet* p, const char*, const Event* event,
     unsigned u2_type, U2PseudoHeader* u2h = nullptr)
 {
     Serial_Unified2_Header hdr;
@@ -388,33 +411,31 @@ static void _Unified2LogPacketAlert(
     logheader.packet_length = htonl(pkt_length + u2h_len);
     write_len += pkt_length + u2h_len;
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
+    if ( write_len > u2_buf_sz )
+        return;
+
+    uint8_t* write_buffer = Unified2Reserve(write_len);
 
     hdr.length = htonl(sizeof(Serial_Unified2Packet) - 4 + pkt_length + u2h_len);
     hdr.type = htonl(u2_type);
 
-    memcpy_s(write_pkt_buffer, u2_buf_sz, &hdr, sizeof(hdr));
+    memcpy_s(write_buffer, write_len, &hdr, sizeof(hdr));
     size_t offset = sizeof(hdr);
 
-    memcpy_s(write_pkt_buffer + offset, u2_buf_sz - offset, &logheader, sizeof(logheader) - 4);
+    memcpy_s(write_buffer + offset, write_len - offset, &logheader, sizeof(logheader) - 4);
     offset += sizeof(logheader) - 4;
 
     if ( u2h_len > 0 )
     {
-        assert(u2_buf_sz - offset > u2h_len);
-        memcpy_s(write_pkt_buffer + offset, u2_buf_sz - offset, u2h->get_data(), u2h_len);
+        memcpy_s(write_buffer + offset, write_len - offset, u2h->get_data(), u2h_len);
         offset += u2h_len;
     }
 
     if (pkt_length != 0)
     {
-        if (pkt_length > u2_buf_sz - offset)
-            return;
-
-        uint8_t *start = write_pkt_buffer + offset;
+        uint8_t *start = write_buffer + offset;
 
-        memcpy_s(start, u2_buf_sz - offset, p->is_data() ? p->data : p->pkt, pkt_length);
+        memcpy_s(start, write_len - offset, p->is_data() ? p->data : p->pkt, pkt_length);
 
         if ( p->obfuscator )
         {
@@ -429,13 +450,29 @@ static void _Unified2LogPacketAlert(
         }
     }
 
-    Unified2Write(write_pkt_buffer, write_len, config);
+    Unified2Commit(write_len);
+}
+
+static void Unified2WriteError(const U2File* file, int error)
+{
+    if (file->nostamp)
+    {
+        ErrorMessage("unified2 failed to write to file (%s): %s\n",
+            file->filepath, get_error(error));
+    }
+    else
+    {
+        ErrorMessage("unified2 failed to write to file (%s.%u): %s\n",
+            file->filepath, file->timestamp, get_error(error));
+    }
 }
 
 /******************************************************************************
  * Function: Unified2Write()
  *
- * Main function for writing to the unified2 file.
+ * Main function for writing to the unified2 file.  Called with a block of
+ * whole records by the packet thread or, with async logging, by the writer
+ * thread.
  *
  * For low level I/O errors, the current unified2 file is closed and a new
  * one created and a write to the new unified2 file is done.  It was found
@@ -448,152 +485,71 @@ static void _Unified2LogPacketAlert(
  *
  * All other errors are treated as non-recoverable and Snort will fatal error.
  *
- * Upon successful completion of write, the length of the data written is
- * added to the current amount of total data written thus far to the
- * unified2 file.
- *
  * Arguments
+ *  U2File *
+ *      The file to write to
  *  uint8_t *
  *      The buffer containing the data to write
  *  uint32_t
  *      The length of the data to write
- *  Unified2Config *
- *      A pointer to the unified2 configuration data
  *
  * Returns: None
  *
  ******************************************************************************/
-static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config)
+static void Unified2Write(U2File* file, const uint8_t* buf, uint32_t buf_len)
 {
-    size_t fwcount = 0;
-
     /* Nothing to write or nothing to write to */
-    if ((buf == nullptr) || (config == nullptr) || (u2.stream == nullptr))
+    if ((buf == nullptr) || (file == nullptr) || (file->fd < 0))
         return;
 
-    /* Don't use fsync().  It is a total performance killer */
-    if (((fwcount = fwrite(buf, (size_t)buf_len, 1, u2.stream)) != 1) ||
-        (fflush(u2.stream) != 0))
+    int error = BatchLog::write_all(file->fd, buf, buf_len);
+
+    if ( !error )
+        return;
+
+    Unified2WriteError(file, error);
+
+    switch (error)
     {
-        /* errno is saved just to avoid other intervening calls
-         * (e.g. ErrorMessage) potentially resetting it to something else. */
-        int error = errno;
-        int max_retries = 3;
-
-        /* On iterations other than the first, the only non-zero error will be
-         * EINTR or interrupt.  Only iterate a maximum of max_retries times so
-         * there is no chance of infinite looping if for some reason the write
-         * is constantly interrupted */
-        while ((error != 0) && (max_retries != 0))
-        {
-            if (config->nostamp)
-            {
-                ErrorMessage("unified2 failed to write to file (%s): %s\n",
-                    u2.filepath, get_error(error));
-            }
-            else
-            {
-                ErrorMessage("unified2 failed to write to file (%s.%u): %s\n",
-                    u2.filepath, u2.timestamp, get_error(error));
-            }
+    case EINTR:
+        FatalError("unified2 cannot write to device. "
+            "Maximum number of interrupts exceeded.\n");
 
-            while ((error == EINTR) && (max_retries != 0))
-            {
-                max_retries--;
-
-                /* Supposedly an interrupt can only occur before anything
-                 * has been written.  Try again */
-                if (fwcount != 1)
-                {
-                    /* fwrite() failed.  Redo fwrite and fflush */
-                    if (((fwcount = fwrite(buf, (size_t)buf_len, 1, u2.stream)) == 1) &&
-                        fflush(u2.stream) == 0)
-                    {
-                        error = 0;
-                        break;
-                    }
-                }
-                else if (fflush(u2.stream) == 0)
-                {
-                    error = 0;
-                    break;
-                }
-
-                error = errno;
-            }
+    case EIO:
+        ErrorMessage("unified2 file is possibly corrupt. "
+            "Closing this unified2 file and creating a new one.\n");
 
-            /* If we've reached the maximum number of interrupt retries,
-             * just bail out of the main while loop */
-            if (max_retries == 0)
-                continue;
+        Unified2RotateFile(file);
 
-            switch (error)
-            {
-            case 0:
-                break;
-
-            case EIO:
-                ErrorMessage("unified2 file is possibly corrupt. "
-                    "Closing this unified2 file and creating a new one.\n");
-
-                Unified2RotateFile(config);
-
-                if (config->nostamp)
-                {
-                    ErrorMessage("unified2 rotated file: %s\n", u2.filepath);
-                }
-                else
-                {
-                    ErrorMessage("unified2 rotated file: %s.%u\n", u2.filepath, u2.timestamp);
-                }
-
-                if (((fwcount = fwrite(buf, (size_t)buf_len, 1, u2.stream)) == 1) &&
-                    fflush(u2.stream) == 0)
-                {
-                    error = 0;
-                    break;
-                }
-
-                error = errno;
-
-                /* Loop again if interrupt */
-                if (error == EINTR)
-                    break;
-
-                /* Write out error message again, then fall through and fatal */
-                if (config->nostamp)
-                {
-                    ErrorMessage("unified2 failed to write to file (%s): %s\n",
-                        u2.filepath, get_error(error));
-                }
-                else
-                {
-                    ErrorMessage("unified2 failed to write to file (%s.%u): %s\n",
-                        u2.filepath, u2.timestamp, get_error(error));
-                }
-
-            /* Fall through */
-
-            case EAGAIN:      /* We're not in non-blocking mode */
-            case EBADF:
-            case EFAULT:
-            case EFBIG:
-            case EINVAL:
-            case ENOSPC:
-            case EPIPE:
-            default:
-                FatalError("unified2 cannot write to device.\n");
-            }
+        if (file->nostamp)
+        {
+            ErrorMessage("unified2 rotated file: %s\n", file->filepath);
         }
-
-        if ((max_retries == 0) && (error != 0))
+        else
         {
-            FatalError("unified2 cannot write to device. "
-                "Maximum number of interrupts exceeded.\n");
+            ErrorMessage("unified2 rotated file: %s.%u\n", file->filepath, file->timestamp);
         }
-    }
 
-    u2.current += buf_len;
+        error = BatchLog::write_all(file->fd, buf, buf_len);
+
+        if ( !error )
+            return;
+
+        /* Write out error message again, then fall through and fatal */
+        Unified2WriteError(file, error);
+
+    /* Fall through */
+
+    case EAGAIN:      /* We're not in non-blocking mode */
+    case EBADF:
+    case EFAULT:
+    case EFBIG:
+    case EINVAL:
+    case ENOSPC:
+    case EPIPE:
+    default:
+        FatalError("unified2 cannot write to device.\n");
+    }
 }
 
 //--------------------------------------------------------------------------
@@ -628,7 +584,7 @@ static int GetU2Flags(const Packet* p, uint8_t* pimpact)
     return s_blocked_flag[dispos];
 }
 
-static void _AlertIP4_v2(Packet* p, const char*, Unified2Config* config, const Event* event)
+static void _AlertIP4_v2(Packet* p, const char*, const Event* event)
 {
     Serial_Unified2_Header hdr;
     Unified2IDSEvent alertdata;
@@ -700,22 +656,21 @@ static void _AlertIP4_v2(Packet* p, const char*, Unified2Config* config, const E
                 app_name, strlen(app_name) + 1);
     }
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
+    uint8_t* write_buffer = Unified2Reserve(write_len);
 
     hdr.length = htonl(sizeof(alertdata));
     hdr.type = htonl(UNIFIED2_IDS_EVENT_VLAN);
 
-    memcpy_s(write_pkt_buffer, u2_buf_sz, &hdr, sizeof(hdr));
+    memcpy_s(write_buffer, write_len, &hdr, sizeof(hdr));
 
     size_t offset = sizeof(hdr);
 
-    memcpy_s(write_pkt_buffer + offset, u2_buf_sz - offset, &alertdata, sizeof(alertdata));
+    memcpy_s(write_buffer + offset, write_len - offset, &alertdata, sizeof(alertdata));
 
-    Unified2Write(write_pkt_buffer, write_len, config);
+    Unified2Commit(write_len);
 }
 
-static void _AlertIP6_v2(Packet* p, const char*, Unified2Config* config, const Event* event)
+static void _AlertIP6_v2(Packet* p, const char*, const Event* event)
 {
     Serial_Unified2_Header hdr;
     Unified2IDSEventIPv6 alertdata;
@@ -789,19 +744,18 @@ static void _AlertIP6_v2(Packet* p, const char*, Unified2Config* config, const E
                 app_name, strlen(app_name) + 1);
     }
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
+    uint8_t* write_buffer = Unified2Reserve(write_len);
 
     hdr.length = htonl(sizeof(Unified2IDSEventIPv6));
     hdr.type = htonl(UNIFIED2_IDS_EVENT_IPV6_VLAN);
 
-    memcpy_s(write_pkt_buffer, u2_buf_sz, &hdr, sizeof(hdr));
+    memcpy_s(write_buffer, write_len, &hdr, sizeof(hdr));
 
     size_t offset = sizeof(hdr);
 
-    memcpy_s(write_pkt_buffer + offset, u2_buf_sz - offset, &alertdata, sizeof(alertdata));
+    memcpy_s(write_buffer + offset, write_len - offset, &alertdata, sizeof(alertdata));
 
-    Unified2Write(write_pkt_buffer, write_len, config);
+    Unified2Commit(write_len);
 }
 
 //-------------------------------------------------------------------------
@@ -810,6 +764,9 @@ static void _AlertIP6_v2(Packet* p, const char*, Unified2Config* config, const E
 
 static const Parameter s_params[] =
 {
+    { "batch", Parameter::PT_INT, "0:65536", "256",
+      "set size in KB of the per thread buffer of records written together (0 writes each record)" },
+
     { "legacy_events", Parameter::PT_BOOL, nullptr, "false",
       "generate Snort 2.X style events for barnyard2 compatibility" },
 
@@ -832,12 +789,14 @@ public:
 
     bool set(const char*, Value&, SnortConfig*) override;
     bool begin(const char*, int, SnortConfig*) override;
+    bool end(const char*, int, SnortConfig*) override;
 
     Usage get_usage() const override
     { return GLOBAL; }
 
 public:
     size_t limit = 0;
+    unsigned batch = 256 * 1024;
     bool nostamp = true;
     bool legacy_events = false;
 };
@@ -853,17 +812,32 @@ bool U2Module::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("legacy_events") )
         legacy_events = v.get_bool();
 
+    else if ( v.is("batch") )
+        batch = v.get_uint32() * 1024;
+
     return true;
 }
 
 bool U2Module::begin(const char*, int, SnortConfig* sc)
 {
     limit = 0;
+    batch = 256 * 1024;
     nostamp = sc->output_no_timestamp();
     legacy_events = false;
     return true;
 }
 
+static BatchLog* get_batch()
+{ return u2.batch; }
+
+bool U2Module::end(const char*, int, SnortConfig* sc)
+{
+    if ( batch )
+        BatchLog::subscribe(*sc, S_NAME, get_batch);
+
+    return true;
+}
+
 //-------------------------------------------------------------------------
 // logger stuff
 //-------------------------------------------------------------------------
@@ -890,6 +864,7 @@ private:
 U2Logger::U2Logger(U2Module* m)
 {
     config.limit = m->limit;
+    config.batch = m->batch;
     config.nostamp = m->nostamp;
     config.legacy_events = m->legacy_events;
 }
@@ -902,8 +877,11 @@ void U2Logger::open()
     std::string name;
     get_instance_file(name, F_NAME);
 
+    u2.file = (U2File*)snort_calloc(sizeof(U2File));
+    u2.file->nostamp = config.nostamp;
+
     status = SnortSnprintf(
-        u2.filepath, sizeof(u2.filepath), "%s", name.c_str());
+        u2.file->filepath, sizeof(u2.file->filepath), "%s", name.c_str());
 
     if (status != SNORT_SNPRINTF_SUCCESS)
     {
@@ -911,46 +889,56 @@ void U2Logger::open()
     }
     u2.base_proto = htonl(SFDAQ::get_base_protocol());
 
-    write_pkt_buffer = new uint8_t[u2_buf_sz];
-    io_buffer = new char[u2_buf_sz];
+    u2.config = &config;
+    u2.batch = new BatchBuffer(config.batch, u2_buf_sz, 1, u2.file,
+        Unified2WriteBlock, Unified2RotateWriteBlock);
+    u2.current = 0;
 
-    Unified2InitFile(&config);
+    Unified2InitFile(u2.file);
 
     Stream::reg_xtra_data_log(AlertExtraData, &config);
 }
 
 void U2Logger::close()
 {
-    if ( u2.stream )
-        fclose(u2.stream);
+    if ( u2.file )
+    {
+        u2.batch->flush();
+
+        // the writer thread may still be using the file
+        AsyncLog::drain();
 
-    delete[] write_pkt_buffer;
-    delete[] io_buffer;
+        if ( u2.file->fd >= 0 )
+            ::close(u2.file->fd);
+
+        snort_free(u2.file);
+        u2.file = nullptr;
+    }
 
-    write_pkt_buffer = nullptr;
-    io_buffer = nullptr;
+    delete u2.batch;
+    u2.batch = nullptr;
 }
 
 void U2Logger::alert_legacy(Packet* p, const char* msg, const Event& event)
 {
     if (p->ptrs.ip_api.is_ip6())
     {
-        _AlertIP6_v2(p, msg, &config, &event);
+        _AlertIP6_v2(p, msg, &event);
 
         if (p->ptrs.ip_api.is_ip6())
         {
             uint32_t tenant_id = p->pkth->tenant_id;
             const SfIp* ip = p->ptrs.ip_api.get_src();
-            _WriteExtraData(&config, p->obfuscator, event.get_event_id(), tenant_id, event.ref_time.tv_sec,
+            _WriteExtraData(p->obfuscator, event.get_event_id(), tenant_id, event.ref_time.tv_sec,
                 (const uint8_t*) ip->get_ip6_ptr(), sizeof(struct in6_addr), EVENT_INFO_IPV6_SRC);
             ip = p->ptrs.ip_api.get_dst();
-            _WriteExtraData(&config, p->obfuscator, event.get_event_id(), tenant_id, event.ref_time.tv_sec,
+            _WriteExtraData(p->obfuscator, event.get_event_id(), tenant_id, event.ref_time.tv_sec,
                 (const uint8_t*) ip->get_ip6_ptr(), sizeof(struct in6_addr), EVENT_INFO_IPV6_DST);
         }
     }
     else // ip4 or data
     {
-        _AlertIP4_v2(p, msg, &config, &event);
+        _AlertIP4_v2(p, msg, &event);
     }
 
     if ( p->flow )
@@ -976,7 +964,7 @@ void U2Logger::alert(Packet* p, const char* msg, const Event& event)
         alert_legacy(p, msg, event);
         return;
     }
-    alert_event(p, msg, &config, &event);
+    alert_event(p, msg, &event);
 
     if ( p->flow )
         Stream::update_flow_alert(
@@ -1000,15 +988,15 @@ void U2Logger::log(Packet* p, const char* msg, Event* event)
 
     // FIXIT-L convert to packet method
     if ( !p->is_cooked() or p->pseudo_type == PSEUDO_PKT_IP )
-        _Unified2LogPacketAlert(p, msg, &config, event, UNIFIED2_PACKET);
+        _Unified2LogPacketAlert(p, msg, event, UNIFIED2_PACKET);
 
     else if ( !config.legacy_events )
-        _Unified2LogPacketAlert(p, msg, &config, event, UNIFIED2_BUFFER);
+        _Unified2LogPacketAlert(p, msg, event, UNIFIED2_BUFFER);
 
     else
     {
         U2PseudoHeader u2h(p);
-        _Unified2LogPacketAlert(p, msg, &config, event, UNIFIED2_PACKET, &u2h);
+        _Unified2LogPacketAlert(p, msg, event, UNIFIED2_PACKET, &u2h);
     }
 }
 
@@ -27,9 +27,11 @@
 
 #include "control/control.h"
 #include "detection/signature.h"
+#include "framework/epoch.h"
 #include "framework/module.h"
 #include "helpers/process.h"
 #include "helpers/ring.h"
+#include "log/async_log.h"
 #include "log/messages.h"
 #include "lua/lua.h"
 #include "main/analyzer.h"
@@ -450,6 +452,14 @@ int main_show_config_generation(lua_State* L)
     return 0;
 }
 
+int main_show_mem_placement(lua_State* L)
+{
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    send_response(ctrlcon, "== showing memory placement\n");
+    main_broadcast_command(new ACShowMemPlacement(ctrlcon), ctrlcon);
+    return 0;
+}
+
 int main_reload_config(lua_State* L)
 {
     ControlConn* ctrlcon = ControlConn::query_from_lua(L);
@@ -883,6 +893,8 @@ static bool house_keeping()
 
     InspectorManager::empty_trash();
 
+    Epoch::reclaim();
+
     return false;
 }
 
@@ -1167,6 +1179,8 @@ static void snort_main()
     max_pigs = ThreadConfig::get_instance_max();
     assert(max_pigs > 0);
     ThreadConfig::start_watchdog();
+    Epoch::init();
+    AsyncLog::start(SnortConfig::get_conf());
 
     // maximum number of state change notifications per pig
     constexpr unsigned max_grunts = static_cast<unsigned>(Analyzer::State::NUM_STATES);
@@ -1184,6 +1198,9 @@ static void snort_main()
 
     main_loop();
 
+    AsyncLog::stop();
+    Epoch::term();
+
     delete pig_poke;
     delete[] pigs;
     pigs = nullptr;
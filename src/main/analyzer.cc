@@ -44,8 +44,12 @@
 #include "flow/flow.h"
 #include "flow/ha.h"
 #include "framework/data_bus.h"
+#include "framework/epoch.h"
+#include "js_norm/js_norm_cache.h"
 #include "latency/packet_latency.h"
+#include "latency/phase_latency.h"
 #include "latency/rule_latency.h"
+#include "log/async_log.h"
 #include "log/messages.h"
 #include "main/swapper.h"
 #include "main.h"
@@ -428,7 +432,14 @@ void Analyzer::process_daq_pkt_msg(DAQ_Msg_h msg, bool retry)
     ASAN_POISON_MEMORY_REGION(data_end, size);
 #endif
 
-    PacketManager::decode(p, pkthdr, data, data_len, false, retry);
+    {
+        PhaseLatency::Context decode_latency_ctx { PhaseLatency::DECODE };
+        PacketManager::decode(p, pkthdr, data, data_len, false, retry);
+    }
+
+    // every packet, so only when something like the pcap flight recorder wants it
+    if (!retry and DataBus::has_global_subscriber(intrinsic_pub_id, IntrinsicEventIds::WIRE_PACKET))
+        DataBus::publish(intrinsic_pub_id, IntrinsicEventIds::WIRE_PACKET, p);
 
     if (process_packet(p))
     {
@@ -641,6 +652,7 @@ void Analyzer::init_unprivileged()
     EventTrace_Init();
 
     memory::MemoryCap::thread_init();
+    AsyncLog::thread_init();
     EventManager::open_outputs();
     IpsManager::setup_options(sc);
     ActionManager::thread_init(sc);
@@ -658,11 +670,13 @@ void Analyzer::init_unprivileged()
     PacketManager::thread_init();
 
     // init filters hash tables that depend on alerts
-    sfthreshold_alloc(sc->threshold_config->memcap, sc->threshold_config->memcap);
-    SFRF_Alloc(sc->rate_filter_config->memcap);
+    sfthreshold_alloc(sc->threshold_config->memcap, sc->threshold_config->memcap,
+        sc->threshold_config->shared);
+    SFRF_Alloc(sc->rate_filter_config->memcap, sc->rate_filter_config->shared);
 }
 
-void Analyzer::reinit(const SnortConfig* sc)
+// thread local state for a new config, set up a step before it is current
+void Analyzer::prepare(const SnortConfig* sc)
 {
     InspectorManager::thread_reinit(sc);
     ActionManager::thread_reinit(sc);
@@ -702,6 +716,7 @@ void Analyzer::term()
 
     IpsManager::clear_options(sc);
     EventManager::close_outputs();
+    AsyncLog::thread_term();
     CodecManager::thread_term();
     HighAvailabilityManager::thread_term();
     SideChannelManager::thread_term();
@@ -712,6 +727,7 @@ void Analyzer::term()
     SFDAQ::set_local_instance(nullptr);
 
     PacketLatency::tterm();
+    PhaseLatency::tterm();
     RuleLatency::tterm();
 
     Profiler::consolidate_stats();
@@ -720,6 +736,7 @@ void Analyzer::term()
     EventTrace_Term();
     CleanupTag();
     FileService::thread_term();
+    jsn::JSNormCache::thread_term();
     PacketTracer::thread_term();
     PacketManager::thread_term();
 
@@ -758,12 +775,17 @@ void Analyzer::operator()(Swapper* ps, uint16_t run_num)
     set_instance_id(id);
     set_run_num(run_num);
     local_analyzer = this;
+    Epoch::thread_init();
 
     ps->apply(*this);
 
     if (SnortConfig::get_conf()->pcap_show())
         show_source();
 
+    // before anything is allocated so this thread's state is on its node
+    SnortConfig::get_conf()->thread_config->apply_thread_mempolicy(
+        STHREAD_TYPE_PACKET, get_instance_id());
+
     // init here to pin separately from packet threads
     DetectionEngine::thread_init();
     SnortConfig::get_conf()->thread_config->set_instance_tid(id);
@@ -786,6 +808,7 @@ void Analyzer::operator()(Swapper* ps, uint16_t run_num)
     if (state != State::FAILED)
         set_state(State::STOPPED);
 
+    Epoch::thread_term();
     oops_handler->tterm();
 }
 
@@ -868,11 +891,61 @@ void Analyzer::handle_uncompleted_commands()
     }
 }
 
+// Add the elapsed time to a usecs peg once it amounts to at least a microsecond,
+// so the time of short batches is not truncated away.
+static inline void update_batch_usecs(Stopwatch<SnortClock>& sw, PegCount& usecs)
+{
+    PegCount elapsed = clock_usecs(TO_USECS(sw.get()));
+
+    if ( elapsed )
+    {
+        usecs += elapsed;
+        sw.reset();
+    }
+}
+
+// With adaptive batching the batch size doubles while batches come back full,
+// which happens under load, and halves when they come back mostly empty.
+void Analyzer::update_batch_stats(unsigned max_recv, unsigned num_recv)
+{
+    const unsigned max_batch = daq_instance->get_batch_size();
+
+    if ( num_recv )
+    {
+        daq_stats.batches++;
+
+        if ( num_recv > daq_stats.batch_size_max )
+            daq_stats.batch_size_max = num_recv;
+
+        if ( num_recv == max_recv )
+            daq_stats.batches_full++;
+    }
+
+    if ( !daq_instance->get_adaptive_batch() )
+    {
+        daq_stats.batch_size = max_batch;
+        return;
+    }
+
+    if ( num_recv == batch_size and batch_size < max_batch )
+    {
+        batch_size = std::min(batch_size * 2, max_batch);
+        daq_stats.batch_grows++;
+    }
+    else if ( num_recv < batch_size / 4 )
+    {
+        batch_size /= 2;
+        daq_stats.batch_shrinks++;
+    }
+
+    daq_stats.batch_size = batch_size;
+}
+
 DAQ_RecvStatus Analyzer::process_messages()
 {
-    // Max receive becomes the minimum of the configured batch size, the remaining exit_after
-    // count (if requested), and the remaining pause_after count (if requested).
-    unsigned max_recv = daq_instance->get_batch_size();
+    // Max receive becomes the minimum of the configured (or adapted) batch size, the remaining
+    // exit_after count (if requested), and the remaining pause_after count (if requested).
+    unsigned max_recv = daq_instance->get_adaptive_batch() ? batch_size : daq_instance->get_batch_size();
     if (exit_after_cnt && exit_after_cnt < max_recv)
         max_recv = exit_after_cnt;
     if (pause_after_cnt && pause_after_cnt < max_recv)
@@ -882,13 +955,27 @@ DAQ_RecvStatus Analyzer::process_messages()
     {
         // cppcheck-suppress unreadVariable
         Profile profile(daqPerfStats);
+        receive_sw.start();
         rstat = daq_instance->receive_messages(max_recv);
+        receive_sw.stop();
     }
+    update_batch_usecs(receive_sw, daq_stats.receive_usecs);
+
+    const unsigned batch_count = daq_instance->get_batch_count();
+    update_batch_stats(max_recv, batch_count);
 
     // Preemptively service available onloads to potentially unblock processing the first message.
     // This conveniently handles servicing offloads in the no messages received case as well.
     DetectionEngine::onload();
 
+    if ( !batch_count )
+        return rstat;
+
+    // Processing is staged over the batch: first bring the messages into cache, then
+    // process them one by one.
+    process_sw.start();
+    daq_instance->prefetch_messages();
+
     unsigned num_recv = 0;
     DAQ_Msg_h msg;
     while ((msg = daq_instance->next_message()) != nullptr)
@@ -911,6 +998,9 @@ DAQ_RecvStatus Analyzer::process_messages()
         handle_uncompleted_commands();
     }
 
+    process_sw.stop();
+    update_batch_usecs(process_sw, daq_stats.process_usecs);
+
     if (exit_after_cnt && (exit_after_cnt -= num_recv) == 0)
         stop();
     if (pause_after_cnt && (pause_after_cnt -= num_recv) == 0)
@@ -922,6 +1012,9 @@ void Analyzer::analyze()
 {
     while (!exit_requested)
     {
+        // No references to shared data are held between batches.
+        Epoch::quiescent();
+
         // If we're not in the running state (usually either pre-start or paused),
         // just keep stalling until something else comes up.
         if (state != State::RUNNING)
@@ -33,6 +33,8 @@
 #include <string>
 
 #include "main/snort_types.h"
+#include "time/clock_defs.h"
+#include "time/stopwatch.h"
 #include "thread.h"
 
 class ContextSwitcher;
@@ -108,7 +110,7 @@ public:
     void pause();
     void resume(uint64_t msg_cnt);
     void reload_daq();
-    void reinit(const snort::SnortConfig*);
+    void prepare(const snort::SnortConfig*);
     void stop_removed(const snort::SnortConfig*);
     void rotate();
     snort::SFDAQInstance* get_daq_instance() { return daq_instance; }
@@ -122,6 +124,7 @@ private:
     void handle_commands();
     void handle_uncompleted_commands();
     DAQ_RecvStatus process_messages();
+    void update_batch_stats(unsigned max_recv, unsigned num_recv);
     void process_daq_msg(DAQ_Msg_h, bool retry);
     void process_daq_pkt_msg(DAQ_Msg_h, bool retry);
     void post_process_daq_pkt_msg(snort::Packet*);
@@ -148,6 +151,9 @@ private:
     uint64_t exit_after_cnt;
     uint64_t pause_after_cnt = 0;
     uint64_t skip_cnt = 0;
+    unsigned batch_size = 1;
+    Stopwatch<SnortClock> receive_sw;
+    Stopwatch<SnortClock> process_sw;
     std::string source;
     snort::SFDAQInstance* daq_instance;
     RetryQueue* retry_queue;
@@ -29,8 +29,10 @@
 #include "framework/module.h"
 #include "log/messages.h"
 #include "managers/module_manager.h"
+#include "packet_io/sfdaq_module.h"
 #include "protocols/packet_manager.h"
 #include "target_based/host_attributes.h"
+#include "time/clock_defs.h"
 #include "utils/stats.h"
 
 #include "analyzer.h"
@@ -39,6 +41,7 @@
 #include "snort.h"
 #include "snort_config.h"
 #include "swapper.h"
+#include "thread_config.h"
 
 using namespace snort;
 
@@ -137,65 +140,144 @@ bool ACResetStats::execute(Analyzer&, void**)
 ACResetStats::ACResetStats(clear_counter_type_t requested_type_l) : requested_type(
         requested_type_l) { }
 
+// Per thread progress of a swap, kept as the command state between calls.
+// The swap is done in steps: thread local init for the new config (prepare),
+// the config pointer swap (apply), and one reload tuner step per call, so
+// packets are held up by one step at a time.
+struct SwapState
+{
+    std::list<ReloadResourceTuner*> reload_tuners;
+    hr_time queued;
+    bool prepared = false;
+    bool swapped = false;
+};
+
+// a running thread prepares when idle unless it has waited this long
+static constexpr long max_prepare_wait_usecs = 100000;
+
+static long usecs_since(const hr_time& t)
+{ return clock_usecs(TO_USECS(SnortClock::now() - t)); }
+
+static void count_stall(long usecs)
+{
+    if ( usecs < 100 )
+        daq_stats.reload_stalls_lt_100us++;
+    else if ( usecs < 1000 )
+        daq_stats.reload_stalls_lt_1ms++;
+    else if ( usecs < 10000 )
+        daq_stats.reload_stalls_lt_10ms++;
+    else
+        daq_stats.reload_stalls_ge_10ms++;
+
+    if ( (PegCount)usecs > daq_stats.reload_stall_max )
+        daq_stats.reload_stall_max = usecs;
+}
+
+ACSwap::ACSwap(Swapper* ps, ControlConn* conn) : AnalyzerCommand(conn), ps(ps),
+    latency(ThreadConfig::get_instance_max())
+{ }
+
 bool ACSwap::execute(Analyzer& analyzer, void** ac_state)
 {
     if (analyzer.get_state() != Analyzer::State::PAUSED and
         analyzer.get_state() != Analyzer::State::RUNNING)
         return false;
 
-    if (ps)
+    if (!ps)
+        return true;
+
+    const SnortConfig* sc = ps->get_new_conf();
+
+    if ( !sc )
     {
         ps->apply(analyzer);
+        return true;
+    }
 
-        const SnortConfig* sc = ps->get_new_conf();
-        if ( sc )
-        {
-            std::list<ReloadResourceTuner*>* reload_tuners;
-
-            if ( !*ac_state )
-            {
-                reload_tuners = new std::list<ReloadResourceTuner*>(sc->get_reload_resource_tuners());
-                std::list<ReloadResourceTuner*>::iterator rtt = reload_tuners->begin();
-                while ( rtt != reload_tuners->end() )
-                {
-                    if ( (*rtt)->tinit() )
-                        ++rtt;
-                    else
-                        rtt = reload_tuners->erase(rtt);
-                }
-                *ac_state = reload_tuners;
-            }
-            else
-                reload_tuners = (std::list<ReloadResourceTuner*>*)*ac_state;
-
-            if ( !reload_tuners->empty() )
-            {
-                auto rrt = reload_tuners->front();
-                if ( analyzer.is_idling() )
-                {
-                    if ( rrt->tune_idle_context() )
-                        reload_tuners->pop_front();
-                }
-                else
-                {
-                    if ( rrt->tune_packet_context() )
-                        reload_tuners->pop_front();
-                }
-            }
-
-            // check for empty again and free list instance if we are done
-            if ( reload_tuners->empty() )
-            {
-                delete reload_tuners;
-                ps->finish(analyzer);
-                return true;
-            }
+    SwapState* ss = (SwapState*)*ac_state;
 
+    if ( !ss )
+    {
+        ss = new SwapState;
+        ss->queued = SnortClock::now();
+        *ac_state = ss;
+    }
+
+    assert(get_instance_id() < latency.size());
+    Latency& lat = latency[get_instance_id()];
+    const bool running = analyzer.get_state() == Analyzer::State::RUNNING;
+    const hr_time call_start = SnortClock::now();
+    hr_time start = call_start;
+
+    if ( !ss->prepared )
+    {
+        long waited = usecs_since(ss->queued);
+
+        if ( running and !analyzer.is_idling() and waited < max_prepare_wait_usecs )
+            return false;
+
+        ps->prepare(analyzer);
+        ss->prepared = true;
+
+        lat.wait = waited;
+        lat.prepare = usecs_since(start);
+        daq_stats.reload_prepare_usecs += lat.prepare;
+
+        // swap on a later call so packets are held up by one step at a time;
+        // a paused thread isn't holding up packets and may not call again
+        if ( running )
+        {
+            count_stall(lat.prepare);
             return false;
         }
+        start = SnortClock::now();
     }
 
-    return true;
+    if ( !ss->swapped )
+    {
+        ps->apply(analyzer);
+
+        for ( auto* rrt : sc->get_reload_resource_tuners() )
+        {
+            if ( rrt->tinit() )
+                ss->reload_tuners.emplace_back(rrt);
+        }
+        ss->swapped = true;
+
+        lat.swap = usecs_since(start);
+        daq_stats.reload_swap_usecs += lat.swap;
+    }
+    else if ( !ss->reload_tuners.empty() )
+    {
+        auto rrt = ss->reload_tuners.front();
+
+        if ( analyzer.is_idling() )
+        {
+            if ( rrt->tune_idle_context() )
+                ss->reload_tuners.pop_front();
+        }
+        else
+        {
+            if ( rrt->tune_packet_context() )
+                ss->reload_tuners.pop_front();
+        }
+        lat.tune += usecs_since(start);
+    }
+
+    // check for empty again and free the state if we are done
+    bool done = ss->reload_tuners.empty();
+
+    if ( done )
+    {
+        delete ss;
+        *ac_state = nullptr;
+        lat.done = true;
+        ps->finish(analyzer);
+    }
+
+    // one stall per call, whatever was done in it
+    count_stall(usecs_since(call_start));
+    return done;
 }
 
 ACSwap::~ACSwap()
@@ -209,6 +291,15 @@ ACSwap::~ACSwap()
     delete ps;
     HostAttributesManager::swap_cleanup();
 
+    for ( unsigned i = 0; i < latency.size(); ++i )
+    {
+        const Latency& lat = latency[i];
+
+        if ( lat.done )
+            log_message("== reload thread %u: waited %ld, prepare %ld, swap %ld, tune %ld usecs\n",
+                i, lat.wait, lat.prepare, lat.swap, lat.tune);
+    }
+
     ReloadTracker::end(ctrlcon);
     log_message("== reload complete\n");
 }
@@ -253,6 +344,29 @@ ACScratchUpdate::~ACScratchUpdate()
     ReloadTracker::end(ctrlcon, true);
 }
 
+ACShowMemPlacement::ACShowMemPlacement(ControlConn* conn) : AnalyzerCommand(conn),
+    placement(ThreadConfig::get_instance_max())
+{ }
+
+bool ACShowMemPlacement::execute(Analyzer&, void**)
+{
+    unsigned id = get_instance_id();
+
+    if ( id < placement.size() )
+        placement[id] = ThreadConfig::get_mem_placement(id);
+
+    return true;
+}
+
+ACShowMemPlacement::~ACShowMemPlacement()
+{
+    for ( const auto& s : placement )
+    {
+        if ( !s.empty() )
+            log_message("%s", s.c_str());
+    }
+}
+
 SFDAQInstance* AnalyzerCommand::get_daq_instance(Analyzer& analyzer)
 {
     return analyzer.get_daq_instance();
@@ -21,6 +21,7 @@
 #define ANALYZER_COMMANDS_H
 
 #include <cstdarg>
+#include <string>
 #include <vector>
 
 #include "main/snort_types.h"
@@ -160,15 +161,25 @@ class ACSwap : public snort::AnalyzerCommand
 {
 public:
     ACSwap() = delete;
-    ACSwap(Swapper* ps, ControlConn* conn) : AnalyzerCommand(conn), ps(ps)
-    { }
+    ACSwap(Swapper* ps, ControlConn* conn);
     bool execute(Analyzer&, void**) override;
     bool need_update_reload_id() const override
     { return true; }
     const char* stringify() override { return "SWAP"; }
     ~ACSwap() override;
 private:
+    // usecs each packet thread waited for an idle moment and was held up
+    struct Latency
+    {
+        long wait = 0;
+        long prepare = 0;
+        long swap = 0;
+        long tune = 0;
+        bool done = false;
+    };
+
     Swapper *ps;
+    std::vector<Latency> latency;  // one per packet thread, written by that thread
 };
 
 class ACHostAttributesSwap : public snort::AnalyzerCommand
@@ -203,6 +214,18 @@ private:
     std::vector<snort::ScratchAllocator*>& handlers;
 };
 
+class ACShowMemPlacement : public snort::AnalyzerCommand
+{
+public:
+    explicit ACShowMemPlacement(ControlConn*);
+    bool execute(Analyzer&, void**) override;
+    const char* stringify() override { return "SHOW_MEM_PLACEMENT"; }
+    ~ACShowMemPlacement() override;
+private:
+    // one per packet thread, each only written by its thread
+    std::vector<std::string> placement;
+};
+
 namespace snort
 {
 // from main.cc
@@ -44,6 +44,7 @@
 #include "host_tracker/host_cache_module.h"
 #include "js_norm/js_norm_module.h"
 #include "latency/latency_module.h"
+#include "log/async_log.h"
 #include "log/messages.h"
 #include "managers/module_manager.h"
 #include "managers/plugin_manager.h"
@@ -465,6 +466,9 @@ static const Parameter alerts_params[] =
     { "event_filter_memcap", Parameter::PT_INT, "0:max32", "1048576",
       "set available MB of memory for event_filters" },
 
+    { "event_filter_shared", Parameter::PT_BOOL, nullptr, "false",
+      "track event_filters across all packet threads instead of per thread" },
+
     { "log_references", Parameter::PT_BOOL, nullptr, "false",
       "include rule references in alert info (full only)" },
 
@@ -474,6 +478,9 @@ static const Parameter alerts_params[] =
     { "rate_filter_memcap", Parameter::PT_INT, "0:max32", "1048576",
       "set available MB of memory for rate_filters" },
 
+    { "rate_filter_shared", Parameter::PT_BOOL, nullptr, "false",
+      "track rate_filters across all packet threads instead of per thread" },
+
     { "reference_net", Parameter::PT_STRING, nullptr, nullptr,
       "set the CIDR for homenet "
       "(for use with -l or -B, does NOT change $HOME_NET in IDS mode)" },
@@ -508,6 +515,9 @@ bool AlertsModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("event_filter_memcap") )
         sc->threshold_config->memcap = v.get_uint32();
 
+    else if ( v.is("event_filter_shared") )
+        sc->threshold_config->shared = v.get_bool();
+
     else if ( v.is("log_references") )
         v.update_mask(sc->output_flags, OUTPUT_FLAG__ALERT_REFS);
 
@@ -517,6 +527,9 @@ bool AlertsModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("rate_filter_memcap") )
         sc->rate_filter_config->memcap = v.get_uint32();
 
+    else if ( v.is("rate_filter_shared") )
+        sc->rate_filter_config->shared = v.get_bool();
+
     else if ( v.is("reference_net") )
         return ( sc->homenet.set(v.get_string()) == SFIP_SUCCESS );
 
@@ -538,8 +551,23 @@ static const Parameter output_event_trace_params[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
+static const Parameter output_async_params[] =
+{
+    { "queue_size", Parameter::PT_INT, "0:65536", "0",
+      "buffers each packet thread can queue for the log writer thread, rounded up to a power "
+      "of 2 (0 to write directly)" },
+
+    { "overflow", Parameter::PT_ENUM, "block | drop", "block",
+      "wait for the writer or drop the buffer when the queue is full" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 static const Parameter output_params[] =
 {
+    { "async", Parameter::PT_TABLE, output_async_params, nullptr,
+      "write log files from a dedicated thread (requires restart)" },
+
     { "dump_chars_only", Parameter::PT_BOOL, nullptr, "false",
       "turns on character dumps (same as -C)" },
 
@@ -589,6 +617,15 @@ static const RuleMap output_rules[] =
     { 0, nullptr }
 };
 
+static const PegInfo output_pegs[] =
+{
+    { CountType::SUM, "async_queued", "log buffers queued for the writer thread" },
+    { CountType::SUM, "async_dropped", "log buffers dropped because the queue was full" },
+    { CountType::SUM, "async_blocked", "times a packet thread waited for queue space" },
+    { CountType::MAX, "async_max_queued", "maximum log buffers queued by a packet thread" },
+    { CountType::END, nullptr, nullptr }
+};
+
 class OutputModule : public Module
 {
 public:
@@ -603,11 +640,23 @@ public:
 
     const RuleMap* get_rules() const override
     { return output_rules; }
+
+    const PegInfo* get_pegs() const override
+    { return output_pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&async_log_stats; }
 };
 
 bool OutputModule::set(const char*, Value& v, SnortConfig* sc)
 {
-    if ( v.is("dump_chars_only") )
+    if ( v.is("queue_size") )
+        sc->async_log_queue = v.get_uint32();
+
+    else if ( v.is("overflow") )
+        sc->async_log_drop = v.get_uint8() == 1;
+
+    else if ( v.is("dump_chars_only") )
         v.update_mask(sc->output_flags, OUTPUT_FLAG__CHAR_DATA);
 
     else if ( v.is("dump_payload") )
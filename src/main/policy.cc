@@ -110,6 +110,7 @@ void NetworkPolicy::init(NetworkPolicy* other_network_policy, const char* exclud
 
         checksum_eval = other_network_policy->checksum_eval;
         checksum_drop = other_network_policy->checksum_drop;
+        checksum_offload = other_network_policy->checksum_offload;
         normal_mask = other_network_policy->normal_mask;
     }
     InspectorManager::new_policy(this, other_network_policy);
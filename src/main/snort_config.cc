@@ -427,6 +427,10 @@ void SnortConfig::merge(const SnortConfig* cmd_line_conf)
     if (!cmd_line_conf->rule_db_dir.empty())
         rule_db_dir = cmd_line_conf->rule_db_dir;
 
+    // --dump-reputation-snapshot
+    if (!cmd_line_conf->reputation_snapshot.empty())
+        reputation_snapshot = cmd_line_conf->reputation_snapshot;
+
     // --id-offset
     id_offset = cmd_line_conf->id_offset;
     // --id-subdir
@@ -505,6 +509,12 @@ bool SnortConfig::verify() const
     else if (sc->orig_log_dir != orig_log_dir)
         ReloadError("Changing output.logdir requires a restart.\n");
 
+    else if (sc->async_log_queue != async_log_queue)
+        ReloadError("Changing output.async.queue_size requires a restart.\n");
+
+    else if (sc->async_log_drop != async_log_drop)
+        ReloadError("Changing output.async.overflow requires a restart.\n");
+
     else if (sc->group_id != group_id)
         ReloadError("Changing process.setgid requires a restart.\n");
 
@@ -517,9 +527,15 @@ bool SnortConfig::verify() const
     else if (sc->threshold_config->memcap != threshold_config->memcap)
         ReloadError("Changing alerts.event_filter_memcap requires a restart.\n");
 
+    else if (sc->threshold_config->shared != threshold_config->shared)
+        ReloadError("Changing alerts.event_filter_shared requires a restart.\n");
+
     else  if (sc->rate_filter_config->memcap != rate_filter_config->memcap)
         ReloadError("Changing alerts.rate_filter_memcap requires a restart.\n");
 
+    else if (sc->rate_filter_config->shared != rate_filter_config->shared)
+        ReloadError("Changing alerts.rate_filter_shared requires a restart.\n");
+
     else if (sc->detection_filter_config->memcap != detection_filter_config->memcap)
         ReloadError("Changing alerts.detection_filter_memcap requires a restart.\n");
 
@@ -682,6 +698,12 @@ void SnortConfig::set_rule_db_dir(const char* directory)
     rule_db_dir = directory;
 }
 
+void SnortConfig::set_reputation_snapshot(const char* file)
+{
+    assert(file);
+    reputation_snapshot = file;
+}
+
 void SnortConfig::set_gid(const char* args)
 {
     struct group* gr;
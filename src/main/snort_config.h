@@ -204,7 +204,9 @@ public:
     uint32_t output_flags = 0;
 #endif
     uint32_t tagged_packet_limit = 256;
+    uint32_t async_log_queue = 0;   // 0 writes logs on the packet threads
     uint16_t event_trace_max = 0;
+    bool async_log_drop = false;
 
     std::string log_dir;
 
@@ -257,6 +259,7 @@ public:
     std::string include_path;
     std::string plugin_path;
     std::string rule_db_dir;
+    std::string reputation_snapshot;
     std::vector<std::string> script_paths;
 
     mode_t file_mask = 0;
@@ -462,6 +465,7 @@ public:
     void set_include_path(const char*);
     void set_process_all_events(bool);
     void set_rule_db_dir(const char*);
+    void set_reputation_snapshot(const char*);
     void set_show_year(bool);
     void set_tunnel_verdicts(const char*);
     void set_tweaks(const char*);
@@ -143,6 +143,8 @@ static const Command snort_cmds[] =
     { "reload_hosts", main_reload_hosts, s_reload, "load a new hosts table" },
     { "log_command", main_log_command,main_log_command_param, "enable or disable command logging"},
     { "show_config_generation", main_show_config_generation, nullptr, "show loaded configuration ID"},
+    { "show_mem_placement", main_show_mem_placement, nullptr,
+      "show the numa nodes of packet thread memory" },
 
     // FIXIT-M rewrite trough to permit updates on the fly
     //{ "process", main_process, nullptr, "process given pcap" },
@@ -396,6 +398,9 @@ static const Parameter s_params[] =
     { "--dump-defaults", Parameter::PT_STRING, "(optional)", nullptr,
       "[<module prefix>] output module defaults in Lua format" },
 
+    { "--dump-reputation-snapshot", Parameter::PT_STRING, nullptr, nullptr,
+      "dump the reputation lists to the given file for reputation.snapshot" },
+
     { "--dump-rule-databases", Parameter::PT_STRING, nullptr, nullptr,
       "dump rule databases to given directory (hyperscan only)" },
 
@@ -953,6 +958,11 @@ bool SnortModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( is(v, "--dump-defaults") )
         dump_defaults(sc, v.get_string());
 
+    else if ( is(v, "--dump-reputation-snapshot") )
+    {
+        sc->set_reputation_snapshot(v.get_string());
+        sc->run_flags |= RUN_FLAG__TEST;
+    }
     else if ( is(v, "--dump-rule-databases") )
     {
         sc->set_rule_db_dir(v.get_string());
@@ -26,6 +26,7 @@
 #include "managers/inspector_manager.h"
 
 #include "analyzer.h"
+#include "policy.h"
 #include "snort.h"
 #include "snort_config.h"
 
@@ -59,15 +60,40 @@ Swapper::~Swapper()
         delete old_conf;
 }
 
-void Swapper::apply(Analyzer& analyzer)
+// Thread local initialization for the new config, done while the old one
+// is still in use so that apply() is just the pointer swap.  The new config
+// is current only for the duration of the call; thread_reinit() sets the
+// policies to those of the new config so they are restored too.
+void Swapper::prepare(Analyzer& analyzer)
+{
+    const SnortConfig* cur_conf = SnortConfig::get_conf();
+
+    if ( !new_conf or !cur_conf )
+        return;
+
+    NetworkPolicy* cur_network = get_network_policy();
+    InspectionPolicy* cur_inspection = get_inspection_policy();
+
+    SnortConfig::set_conf(new_conf);
+    analyzer.prepare(new_conf);
+
+    SnortConfig::set_conf(cur_conf);
+    set_network_policy(cur_network);
+    set_inspection_policy(cur_inspection);
+    SnortConfig::update_thread_reload_id();
+}
+
+// on reload the thread state for the new config was set up by prepare()
+void Swapper::apply(Analyzer&)
 {
     if ( new_conf )
     {
         const bool reload = (SnortConfig::get_conf() != nullptr);
         SnortConfig::set_conf(new_conf);
-        // FIXIT-M Determine whether we really want to do this before or after the set_conf
+
+        // the old policies go with the old config
         if ( reload )
-            analyzer.reinit(new_conf);
+            set_default_policy(new_conf);
     }
 }
 
@@ -0,0 +1,217 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// analyzer_command_test.cc author Cisco
+// unit test main
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "main/analyzer_command.h"
+
+#include <cstring>
+
+#include "control/control.h"
+#include "main/analyzer.h"
+#include "main/reload_tracker.h"
+#include "main/reload_tuner.h"
+#include "main/snort_config.h"
+#include "main/swapper.h"
+#include "main/thread_config.h"
+#include "managers/module_manager.h"
+#include "packet_io/sfdaq_module.h"
+#include "protocols/packet_manager.h"
+#include "target_based/host_attributes.h"
+#include "utils/stats.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+THREAD_LOCAL DAQStats daq_stats;
+
+//-------------------------------------------------------------------------
+// what the swap does, in order
+//-------------------------------------------------------------------------
+
+static std::string steps;
+
+namespace snort
+{
+unsigned get_instance_id() { return 0; }
+void LogMessage(const char*, va_list&) { }
+void LogMessage(const char*, ...) { }
+void PacketManager::accumulate() { }
+void ModuleManager::accumulate(const char*) { }
+void ModuleManager::reset_stats(clear_counter_type_t) { }
+void ModuleManager::clear_global_active_counters() { }
+
+SnortConfig::SnortConfig(const SnortConfig* const, const char*) : daq_config(nullptr), thread_config(nullptr)
+{ }
+
+SnortConfig::~SnortConfig() = default;
+void SnortConfig::clear_reload_resource_tuner_list() { reload_tuners.clear(); }
+void SnortConfig::register_reload_handler(ReloadResourceTuner* rrt) { reload_tuners.push_back(rrt); }
+}
+
+void DropStats(ControlConn*) { }
+bool ControlConn::respond(const char*, va_list&) { return true; }
+bool ControlConn::respond(const char*, ...) { return true; }
+unsigned ThreadConfig::get_instance_max() { return 1; }
+std::string ThreadConfig::get_mem_placement(unsigned) { return ""; }
+void HostAttributesManager::initialize() { }
+void HostAttributesManager::swap_cleanup() { }
+void ReloadTracker::end(const ControlConn*, bool) { }
+
+// the analyzer state the commands check is set directly by these
+Analyzer::Analyzer(SFDAQInstance*, unsigned i, const char*, uint64_t) : id(i)
+{ state = State::RUNNING; }
+
+Analyzer::~Analyzer() = default;
+void Analyzer::start() { }
+void Analyzer::stop() { }
+void Analyzer::rotate() { }
+void Analyzer::reload_daq() { }
+void Analyzer::pause() { state = State::PAUSED; }
+void Analyzer::run(bool) { state = State::RUNNING; idling = false; }
+void Analyzer::resume(uint64_t) { idling = true; }
+
+Swapper::Swapper(SnortConfig* s) : old_conf(nullptr), new_conf(s) { }
+Swapper::~Swapper() { delete new_conf; }
+void Swapper::prepare(Analyzer&) { steps += "prepare "; }
+void Swapper::apply(Analyzer&) { steps += "apply "; }
+void Swapper::finish(Analyzer&) { steps += "finish "; }
+
+class TestTuner : public ReloadResourceTuner
+{
+public:
+    TestTuner(unsigned n) : work(n) { }
+
+    bool tinit() override
+    { return work > 0; }
+
+    bool tune_packet_context() override
+    {
+        steps += "tune ";
+        return --work == 0;
+    }
+
+    bool tune_idle_context() override
+    { return tune_packet_context(); }
+
+private:
+    unsigned work;
+};
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+static PegCount stalls()
+{
+    return daq_stats.reload_stalls_lt_100us + daq_stats.reload_stalls_lt_1ms +
+        daq_stats.reload_stalls_lt_10ms + daq_stats.reload_stalls_ge_10ms;
+}
+
+// runs the command as the analyzer does until it completes
+static unsigned run(Analyzer& analyzer, AnalyzerCommand& ac)
+{
+    void* state = nullptr;
+    unsigned calls = 1;
+
+    while ( !ac.execute(analyzer, &state) )
+        ++calls;
+
+    return calls;
+}
+
+TEST_GROUP(acswap)
+{
+    Analyzer* analyzer = nullptr;
+    SnortConfig* sc = nullptr;
+
+    void setup() override
+    {
+        steps.clear();
+        memset(&daq_stats, 0, sizeof(daq_stats));
+        analyzer = new Analyzer(nullptr, 0, "test");
+        sc = new SnortConfig;
+    }
+
+    void teardown() override
+    {
+        delete analyzer;
+    }
+};
+
+TEST(acswap, running_steps_are_split)
+{
+    ACSwap ac(new Swapper(sc), nullptr);
+    analyzer->resume(0);
+
+    UNSIGNED_LONGS_EQUAL(2, run(*analyzer, ac));
+    STRCMP_EQUAL("prepare apply finish ", steps.c_str());
+    UNSIGNED_LONGS_EQUAL(2, stalls());
+}
+
+TEST(acswap, tuners_step_per_call)
+{
+    TestTuner tuner(2);
+    sc->register_reload_handler(&tuner);
+
+    ACSwap ac(new Swapper(sc), nullptr);
+    analyzer->resume(0);
+
+    UNSIGNED_LONGS_EQUAL(4, run(*analyzer, ac));
+    STRCMP_EQUAL("prepare apply tune tune finish ", steps.c_str());
+    UNSIGNED_LONGS_EQUAL(4, stalls());
+}
+
+TEST(acswap, busy_thread_waits_to_prepare)
+{
+    ACSwap ac(new Swapper(sc), nullptr);
+    void* state = nullptr;
+
+    CHECK_FALSE(ac.execute(*analyzer, &state));
+    STRCMP_EQUAL("", steps.c_str());
+    UNSIGNED_LONGS_EQUAL(0, stalls());
+
+    analyzer->resume(0);
+    CHECK_FALSE(ac.execute(*analyzer, &state));
+    STRCMP_EQUAL("prepare ", steps.c_str());
+
+    CHECK_TRUE(ac.execute(*analyzer, &state));
+    STRCMP_EQUAL("prepare apply finish ", steps.c_str());
+}
+
+TEST(acswap, paused_thread_swaps_at_once)
+{
+    ACSwap ac(new Swapper(sc), nullptr);
+    analyzer->pause();
+
+    UNSIGNED_LONGS_EQUAL(1, run(*analyzer, ac));
+    STRCMP_EQUAL("prepare apply finish ", steps.c_str());
+    UNSIGNED_LONGS_EQUAL(1, stalls());
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
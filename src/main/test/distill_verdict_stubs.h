@@ -29,8 +29,11 @@
 #include "filters/sfthreshold.h"
 #include "flow/ha.h"
 #include "framework/data_bus.h"
+#include "framework/epoch.h"
 #include "latency/packet_latency.h"
+#include "latency/phase_latency.h"
 #include "latency/rule_latency.h"
+#include "log/async_log.h"
 #include "log/messages.h"
 #include "managers/action_manager.h"
 #include "managers/codec_manager.h"
@@ -86,7 +89,7 @@ void ContextSwitcher::start() { }
 void InitTag() { }
 void CleanupTag() { }
 void RateFilter_Cleanup() { }
-int sfthreshold_alloc(unsigned int, unsigned int) { return -1; }
+int sfthreshold_alloc(unsigned int, unsigned int, bool) { return -1; }
 void sfthreshold_reset() { }
 void sfthreshold_free() { }
 void EventTrace_Init() { }
@@ -95,6 +98,11 @@ void detection_filter_init(DetectionFilterConfig*) { }
 void detection_filter_term() { }
 void RuleLatency::tterm() { }
 void PacketLatency::tterm() { }
+void AsyncLog::thread_init() { }
+void AsyncLog::thread_term() { }
+bool PhaseLatency::enabled() { return false; }
+void PhaseLatency::record(Phase, uint64_t) { }
+void PhaseLatency::tterm() { }
 void SideChannelManager::thread_init() { }
 void SideChannelManager::thread_term() { }
 void CodecManager::thread_init(const snort::SnortConfig*) { }
@@ -107,7 +115,7 @@ void IpsManager::clear_options(const snort::SnortConfig*) { }
 void ActionManager::thread_init(const snort::SnortConfig*) { }
 void ActionManager::thread_term() { }
 void ActionManager::thread_reinit(const snort::SnortConfig*) { }
-int SFRF_Alloc(unsigned int) { return -1; }
+int SFRF_Alloc(unsigned int, bool) { return -1; }
 void packet_time_update(const struct timeval*) { }
 void main_poke(unsigned) { }
 void set_default_policy(const snort::SnortConfig*) { }
@@ -131,6 +139,9 @@ THREAD_LOCAL TimeContext* ProfileContext::curr_time = nullptr;
 THREAD_LOCAL bool TimeProfilerStats::enabled = false;
 THREAD_LOCAL PacketCount pc;
 
+void Epoch::thread_init() { }
+void Epoch::thread_term() { }
+void Epoch::quiescent() { }
 void packet_gettimeofday(struct timeval* tv) { *tv = s_packet_time; }
 MemoryContext::MemoryContext(MemoryTracker&) : saved(nullptr) { }
 MemoryContext::~MemoryContext() = default;
@@ -153,6 +164,7 @@ const char* SFDAQInstance::get_error() { return nullptr; }
 bool SFDAQInstance::interrupt() { return false; }
 int SFDAQInstance::inject(DAQ_Msg_h, int, const uint8_t*, uint32_t) { return -1; }
 DAQ_RecvStatus SFDAQInstance::receive_messages(unsigned) { return DAQ_RSTAT_ERROR; }
+void SFDAQInstance::prefetch_messages() const { }
 int SFDAQInstance::ioctl(DAQ_IoctlCmd, void*, size_t) { return -4; }
 void SFDAQ::set_local_instance(SFDAQInstance*) { }
 const char* SFDAQ::verdict_to_string(DAQ_Verdict) { return nullptr; }
@@ -226,6 +238,7 @@ InspectionPolicy* get_inspection_policy() { return nullptr; }
 Flow::~Flow() = default;
 void ThreadConfig::implement_thread_affinity(SThreadType, unsigned) { }
 void ThreadConfig::apply_thread_policy(SThreadType , unsigned ) { }
+void ThreadConfig::apply_thread_mempolicy(SThreadType , unsigned ) { }
 void ThreadConfig::set_instance_tid(int) { }
 }
 
@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// swapper_test.cc author Cisco
+// unit test main
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "main/swapper.h"
+
+#include "main/analyzer.h"
+#include "main/policy.h"
+#include "main/snort_config.h"
+#include "managers/inspector_manager.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// the policies are only compared, never used
+//-------------------------------------------------------------------------
+
+static char old_policies[2];
+static char new_policies[2];
+
+static NetworkPolicy* const old_network = (NetworkPolicy*)&old_policies[0];
+static InspectionPolicy* const old_inspection = (InspectionPolicy*)&old_policies[1];
+static NetworkPolicy* const new_network = (NetworkPolicy*)&new_policies[0];
+static InspectionPolicy* const new_inspection = (InspectionPolicy*)&new_policies[1];
+
+static const SnortConfig* conf = nullptr;
+static NetworkPolicy* network = nullptr;
+static InspectionPolicy* inspection = nullptr;
+
+namespace snort
+{
+SnortConfig::SnortConfig(const SnortConfig* const, const char*) { }
+SnortConfig::~SnortConfig() = default;
+const SnortConfig* SnortConfig::get_conf() { return conf; }
+void SnortConfig::set_conf(const SnortConfig* sc) { conf = sc; }
+void SnortConfig::update_thread_reload_id() { }
+
+NetworkPolicy* get_network_policy() { return network; }
+InspectionPolicy* get_inspection_policy() { return inspection; }
+void set_network_policy(NetworkPolicy* p) { network = p; }
+void set_inspection_policy(InspectionPolicy* p) { inspection = p; }
+}
+
+void set_default_policy(const SnortConfig*)
+{
+    network = new_network;
+    inspection = new_inspection;
+}
+
+void InspectorManager::clear_removed_inspectors(SnortConfig*) { }
+
+Analyzer::Analyzer(SFDAQInstance*, unsigned i, const char*, uint64_t) : id(i) { }
+Analyzer::~Analyzer() = default;
+
+// like thread_reinit(), which leaves the policies of the new config set
+void Analyzer::prepare(const SnortConfig*)
+{
+    network = new_network;
+    inspection = new_inspection;
+}
+
+void Analyzer::stop_removed(const SnortConfig*) { }
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_GROUP(swapper)
+{
+    SnortConfig old_conf;
+    SnortConfig new_conf;
+    Analyzer analyzer { nullptr, 0, nullptr };
+
+    void setup() override
+    {
+        conf = &old_conf;
+        network = old_network;
+        inspection = old_inspection;
+    }
+};
+
+TEST(swapper, prepare_keeps_current_policies)
+{
+    Swapper swapper(&new_conf);
+    swapper.prepare(analyzer);
+
+    POINTERS_EQUAL(&old_conf, conf);
+    POINTERS_EQUAL(old_network, network);
+    POINTERS_EQUAL(old_inspection, inspection);
+}
+
+TEST(swapper, apply_sets_new_policies)
+{
+    Swapper swapper(&new_conf);
+    swapper.prepare(analyzer);
+    swapper.apply(analyzer);
+
+    POINTERS_EQUAL(&new_conf, conf);
+    POINTERS_EQUAL(new_network, network);
+    POINTERS_EQUAL(new_inspection, inspection);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -223,17 +223,25 @@ static inline string stringify_thread(const SThreadType& type, const unsigned& i
 void ThreadConfig::apply_thread_policy(SThreadType type, unsigned id)
 {
     implement_thread_affinity( type, id );
+}
 
+// called before the thread allocates its state, unlike the affinity which
+// is applied after any helper threads are started so they are not pinned
+void ThreadConfig::apply_thread_mempolicy(SThreadType type, unsigned id)
+{
 #ifdef HAVE_NUMA
 
     implement_thread_mempolicy( type, id );
 
+#else
+    UNUSED(type);
+    UNUSED(id);
 #endif
 }
 
 #ifdef HAVE_NUMA
 
-int ThreadConfig::get_numa_node(hwloc_topology_t topology, hwloc_cpuset_t cpuset)
+int ThreadConfig::get_numa_node(hwloc_topology_t topology, hwloc_cpuset_t cpuset) const
 {
     int depth = hwloc->get_type_depth(topology, HWLOC_OBJ_NODE);
     if (depth == HWLOC_TYPE_DEPTH_UNKNOWN)
@@ -250,7 +258,7 @@ int ThreadConfig::get_numa_node(hwloc_topology_t topology, hwloc_cpuset_t cpuset
 
 bool ThreadConfig::set_preferred_mempolicy(int node)
 {
-    if (node < 0)
+    if (node < 0 or node >= (int)(sizeof(unsigned long) * 8))
         return false;
 
     unsigned long nodemask = 1UL << (unsigned long)node;
@@ -290,6 +298,100 @@ bool ThreadConfig::implement_thread_mempolicy(SThreadType type, unsigned id)
     return true;
 }
 
+int ThreadConfig::get_thread_node(SThreadType type, unsigned id) const
+{
+    if (!numa or numa->available() < 0 or numa->max_node() <= 0)
+        return -1;
+
+    TypeIdPair key { type, id };
+    auto iter = thread_affinity.find(key);
+
+    if (iter == thread_affinity.end())
+        return -1;
+
+    return get_numa_node(topology, iter->second->cpuset);
+}
+
+static int get_addr_node(void* addr)
+{
+    int node = -1;
+
+    if (numa->get_mem_policy(&node, nullptr, 0, addr, MPOL_F_NODE | MPOL_F_ADDR))
+        return -1;
+
+    return node;
+}
+
+string ThreadConfig::get_mem_placement(unsigned id)
+{
+    string info = "packet thread " + to_string(id) + ":";
+
+    if (!numa or numa->available() < 0)
+        return info + " numa not available\n";
+
+    int cpu = sched_getcpu();
+    info += " cpu node " + to_string(cpu < 0 ? -1 : numa->node_of_cpu(cpu));
+    info += ", preferred node " + to_string(numa->preferred());
+
+    const SnortConfig* sc = SnortConfig::get_conf();
+
+    if (id < sc->num_slots)
+    {
+        info += ", scratch nodes";
+        bool none = true;
+
+        for (void* ss : sc->state[id])
+        {
+            if (ss)
+            {
+                info += " " + to_string(get_addr_node(ss));
+                none = false;
+            }
+        }
+        if (none)
+            info += " none";
+    }
+    return info + "\n";
+}
+
+ThreadMemPlacement::ThreadMemPlacement(const ThreadConfig* tc, SThreadType type, unsigned id)
+{
+    int node = tc ? tc->get_thread_node(type, id) : -1;
+
+    if (node < 0 or node >= (int)(sizeof(nodemask) * 8))
+        return;
+
+    if (numa->get_mem_policy(&mode, &nodemask, sizeof(nodemask) * 8, nullptr, 0))
+    {
+        mode = -1;
+        return;
+    }
+
+    unsigned long mask = 1UL << (unsigned long)node;
+
+    if (numa->set_mem_policy(MPOL_PREFERRED, &mask, sizeof(mask) * 8))
+        mode = -1;
+}
+
+ThreadMemPlacement::~ThreadMemPlacement()
+{
+    if (mode >= 0)
+        numa->set_mem_policy(mode, &nodemask, sizeof(nodemask) * 8);
+}
+
+#else
+
+int ThreadConfig::get_thread_node(SThreadType, unsigned) const
+{ return -1; }
+
+string ThreadConfig::get_mem_placement(unsigned id)
+{ return "packet thread " + to_string(id) + ": numa not supported\n"; }
+
+ThreadMemPlacement::ThreadMemPlacement(const ThreadConfig*, SThreadType, unsigned)
+{ }
+
+ThreadMemPlacement::~ThreadMemPlacement() = default;
+
 #endif
 
 void ThreadConfig::implement_thread_affinity(SThreadType type, unsigned id)
@@ -584,9 +686,26 @@ public:
     int available() override { return numa_avail; }
     int max_node() override { return max_n; }
     int preferred() override { return pref; }
-    int set_mem_policy(int , const unsigned long *,
+    int set_mem_policy(int mode, const unsigned long* nodemask,
                               unsigned long ) override
-    { return mem_policy; }
+    {
+        if ( !mem_policy )
+        {
+            cur_mode = mode;
+            cur_mask = *nodemask;
+        }
+        return mem_policy;
+    }
+    int get_mem_policy(int* mode, unsigned long* nodemask,
+                              unsigned long, void*, unsigned long) override
+    {
+        *mode = cur_mode;
+        *nodemask = cur_mask;
+        return 0;
+    }
+
+    int cur_mode = MPOL_DEFAULT;
+    unsigned long cur_mask = 0;
 };
 
 class HwlocWrapperMock : public HwlocWrapper
@@ -631,6 +750,43 @@ TEST_CASE("set node for thread", "[ThreadConfig]")
     CHECK(true == tc.implement_thread_mempolicy(STHREAD_TYPE_PACKET, 1));
 }
 
+TEST_CASE("placement of memory for another thread", "[ThreadConfig]")
+{
+    CpuSet* cpuset = new CpuSet(hwloc_bitmap_dup(process_cpuset));
+    ThreadConfig tc;
+
+    std::shared_ptr<NumaWrapperMock> numa_mock = std::make_shared<NumaWrapperMock>();
+    std::shared_ptr<HwlocWrapperMock> hwloc_mock = std::make_shared<HwlocWrapperMock>();
+
+    hwloc_mock->node.os_index = 1;
+    numa = numa_mock;
+    hwloc = hwloc_mock;
+
+    tc.set_thread_affinity(STHREAD_TYPE_PACKET, 0, cpuset);
+
+    SECTION("pinned thread")
+    {
+        {
+            ThreadMemPlacement place(&tc, STHREAD_TYPE_PACKET, 0);
+            CHECK(numa_mock->cur_mode == MPOL_PREFERRED);
+            CHECK(numa_mock->cur_mask == 2);
+        }
+        CHECK(numa_mock->cur_mode == MPOL_DEFAULT);
+        CHECK(numa_mock->cur_mask == 0);
+    }
+    SECTION("thread not pinned")
+    {
+        ThreadMemPlacement place(&tc, STHREAD_TYPE_PACKET, 1);
+        CHECK(numa_mock->cur_mode == MPOL_DEFAULT);
+    }
+    SECTION("no numa")
+    {
+        numa_mock->numa_avail = -1;
+        ThreadMemPlacement place(&tc, STHREAD_TYPE_PACKET, 0);
+        CHECK(numa_mock->cur_mode == MPOL_DEFAULT);
+    }
+}
+
 TEST_CASE("numa_available negative test", "[ThreadConfig]")
 {
     CpuSet* cpuset = new CpuSet(hwloc_bitmap_dup(process_cpuset));
@@ -44,13 +44,18 @@ public:
     static void set_instance_tid(int);
     static int get_instance_tid(int);
 
+    // packet thread memory placement for the control shell
+    static std::string get_mem_placement(unsigned id);
+
     ~ThreadConfig();
     void apply_thread_policy(SThreadType type, unsigned id);
+    void apply_thread_mempolicy(SThreadType type, unsigned id);
     void set_thread_affinity(SThreadType, unsigned id, CpuSet*);
     void set_named_thread_affinity(const std::string&, CpuSet*);
     void implement_thread_affinity(SThreadType, unsigned id);
     void implement_named_thread_affinity(const std::string& name);
     bool implement_thread_mempolicy(SThreadType type, unsigned id);
+    int get_thread_node(SThreadType, unsigned id) const;
 
     static constexpr unsigned int DEFAULT_THREAD_ID = 0;
 
@@ -75,7 +80,23 @@ private:
     std::map<std::string, CpuSet*> named_thread_affinity;
 
     bool set_preferred_mempolicy(int node);
-    int get_numa_node(hwloc_topology_t, hwloc_cpuset_t);
+    int get_numa_node(hwloc_topology_t, hwloc_cpuset_t) const;
+};
+
+// Memory first touched by the calling thread while in scope is preferably
+// placed on the numa node of the given thread.  This is for per thread state
+// allocated on the main thread, eg scratch, which would otherwise all end up
+// on the main thread's node.  Nothing is done without numa support or when
+// the thread is not pinned.
+class SO_PUBLIC ThreadMemPlacement
+{
+public:
+    ThreadMemPlacement(const ThreadConfig*, SThreadType, unsigned id);
+    ~ThreadMemPlacement();
+
+private:
+    int mode = -1;
+    unsigned long nodemask = 0;
 };
 }
 #endif
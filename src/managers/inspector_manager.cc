@@ -34,6 +34,7 @@
 #include "flow/expect_cache.h"
 #include "flow/flow.h"
 #include "flow/session.h"
+#include "latency/phase_latency.h"
 #include "log/messages.h"
 #include "main/shell.h"
 #include "main/snort.h"
@@ -2145,7 +2146,10 @@ inline void InspectorManager::internal_execute(Packet* p)
     {
         SingleInstanceInspectorPolicy* ft = sc->policy_map->get_flow_tracking();
         if (ft->instance )
+        {
+            PhaseLatency::Context stream_latency_ctx { PhaseLatency::STREAM };
             ::execute<T>(p, &ft->instance, 1);
+        }
     }
 
     // must check between each ::execute()
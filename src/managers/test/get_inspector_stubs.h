@@ -19,6 +19,7 @@
 
 #include "detection/detection_engine.h"
 #include "flow/expect_cache.h"
+#include "latency/phase_latency.h"
 #include "main/policy.h"
 #include "main/snort.h"
 #include "main/snort_config.h"
@@ -40,6 +41,9 @@ void BinderModule::add(unsigned, const char*) { }
 void set_default_policy(const snort::SnortConfig*) { }
 void update_buffer_map(const char**, const char*) { }
 
+bool PhaseLatency::enabled() { return false; }
+void PhaseLatency::record(Phase, uint64_t) { }
+
 namespace snort
 {
 unsigned THREAD_LOCAL Inspector::slot = 0;
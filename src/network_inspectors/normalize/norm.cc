@@ -24,6 +24,10 @@
 #include "norm.h"
 #include "norm_stats.h"
 
+#include <algorithm>
+#include <cstddef>
+
+#include "codecs/ip/checksum.h"
 #include "detection/ips_context.h"
 #include "main/snort_config.h"
 #include "packet_io/sfdaq.h"
@@ -51,24 +55,132 @@ static const uint8_t MAX_EOL_PAD[TCP_OPTLENMAX] =
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
+// the largest header rewritten by a normalizer, ip4 or tcp with options
+#define NORM_MAX_HDR_LEN 60
+
+// offset of the checksum covering the header a normalizer rewrites,
+// -1 if the header is not covered by a checksum.  ip6 headers and options
+// are not part of the upper layer pseudo header.
+static int Norm_CksumOffset(NormalFunc n)
+{
+    if ( n == Norm_IP4 )
+        return offsetof(ip::IP4Hdr, ip_csum);
+
+    if ( n == Norm_TCP )
+        return offsetof(tcp::TCPHdr, th_sum);
+
+    if ( n == Norm_ICMP4 or n == Norm_ICMP6 )
+        return offsetof(ICMPHdr, csum);
+
+    return -1;
+}
+
+// true if the layer is in the payload of an outer layer with a checksum,
+// as with tunnels over udp or the ip header inside an icmp error
+static bool Norm_IsCksumCovered(const Packet* p, uint8_t layer)
+{
+    for ( uint8_t i = 0; i < layer; ++i )
+    {
+        switch ( p->layers[i].prot_id )
+        {
+        case ProtocolId::TCP:
+        case ProtocolId::UDP:
+        case ProtocolId::ICMPV4:
+        case ProtocolId::ICMPV6:
+        case ProtocolId::GRE:
+            return true;
+
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+// update the checksum of a rewritten header incrementally from the
+// bytes it had before the rewrite
+static void Norm_UpdateCksum(NormalFunc n, const Layer& lyr, const uint8_t* orig, unsigned len)
+{
+    const int off = Norm_CksumOffset(n);
+
+    if ( off < 0 )
+        return;
+
+    uint8_t* hdr = const_cast<uint8_t*>(lyr.start);
+    unsigned first = 0;
+
+    while ( first < len and hdr[first] == orig[first] )
+        ++first;
+
+    if ( first == len )
+        return;
+
+    unsigned last = len;
+
+    while ( hdr[last - 1] == orig[last - 1] )
+        --last;
+
+    // the checksum is summed over 16 bit words from the start of the header
+    first &= ~1u;
+
+    uint16_t cksum;
+    memcpy(&cksum, hdr + off, sizeof(cksum));
+    cksum = checksum::cksum_update(cksum, orig + first, hdr + first, last - first);
+    memcpy(hdr + off, &cksum, sizeof(cksum));
+}
+
 // go from inner to outer
 int Norm_Packet(NormalizerConfig* c, Packet* p)
 {
     uint8_t lyr = p->num_layers;
     int changes = 0;
 
+    // checksums are updated as headers are rewritten unless they were
+    // already wrong, in which case they are recomputed by encode_update()
+    bool update_cksums = !(p->packet_flags & PKT_MODIFIED) and
+        !(p->ptrs.decode_flags & DECODE_ERR_CKSUM_ALL);
+
     while ( lyr > 0 )
     {
-        ProtocolId proto_id = p->layers[--lyr].prot_id;
-        NormalFunc n = c->normalizers[PacketManager::proto_idx(proto_id)];
+        const Layer& l = p->layers[--lyr];
+        NormalFunc n = c->normalizers[PacketManager::proto_idx(l.prot_id)];
+
+        if ( !n )
+            continue;
 
-        if ( n )
-            changes = n(c, p, lyr, changes);
+        uint8_t orig[NORM_MAX_HDR_LEN];
+        unsigned len = 0;
+
+        if ( update_cksums and Norm_CksumOffset(n) >= 0 )
+        {
+            len = std::min((unsigned)(p->pkt + p->pktlen - l.start), (unsigned)sizeof(orig));
+
+            // the checksum field must be in the copy
+            if ( len < l.length )
+                update_cksums = false;
+            else
+                memcpy(orig, l.start, len);
+        }
+
+        int prev = changes;
+        changes = n(c, p, lyr, changes);
+
+        if ( update_cksums and changes > prev )
+        {
+            if ( Norm_IsCksumCovered(p, lyr) )
+                update_cksums = false;
+            else
+                Norm_UpdateCksum(n, l, orig, len);
+        }
     }
 
     if ( changes > 0 )
     {
         p->packet_flags |= PKT_MODIFIED;
+
+        if ( update_cksums )
+            p->set_cksums_current();
+
         return 1;
     }
     if ( p->packet_flags & (PKT_RESIZED|PKT_MODIFIED) )
@@ -84,9 +196,10 @@ int Norm_Packet(NormalizerConfig* c, Packet* p)
 // avoided to ensure that we don't get tripped up by nested protocols.
 // TCP options count and length are a notable exception.
 //
-// also note that checksums are not calculated here.  they are only
-// calculated once after all normalizations are done (here, stream)
-// and any replacements are made.
+// also note that checksums are not calculated here.  they are updated
+// by Norm_Packet() from the bytes rewritten or, if something else changes
+// the packet, calculated once after all normalizations are done (here,
+// stream) and any replacements are made.
 //-----------------------------------------------------------------------
 
 #if 0
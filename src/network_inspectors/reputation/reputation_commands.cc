@@ -33,22 +33,27 @@
 
 using namespace snort;
 
+// The new data is published to the packet threads at once, they switch to
+// it on their next lookup and the old data is freed when they are all past it.
+// The command only gets each packet thread to take the new reload id so flows
+// set up before the reload are checked again against the new data.
 class ReputationReload : public AnalyzerCommand
 {
 public:
     ReputationReload(ControlConn*, Reputation&);
     ~ReputationReload() override;
 
-    bool execute(Analyzer&, void**) override;
+    bool execute(Analyzer&, void**) override
+    { return true; }
+
     bool need_update_reload_id() const override
     { return true; }
 
     const char* stringify() override
     { return "REPUTATION_RELOAD"; }
 
-protected:
+private:
     Reputation& ins;
-    ReputationData* data;
 };
 
 ReputationReload::ReputationReload(ControlConn* conn, Reputation& ins)
@@ -56,22 +61,15 @@ ReputationReload::ReputationReload(ControlConn* conn, Reputation& ins)
 {
     ins.add_global_ref();
     log_message(".. reputation reloading\n");
-    data = ins.load_data();
+    ins.publish_data(ins.load_data());
 }
 
 ReputationReload::~ReputationReload()
 {
-    ins.swap_data(data);
     log_message("== Reputation reload complete\n");
     ins.rem_global_ref();
 }
 
-bool ReputationReload::execute(Analyzer&, void**)
-{
-    ins.swap_thread_data(data);
-    return true;
-}
-
 static int reload(lua_State* L)
 {
     ControlConn* ctrlcon = ControlConn::query_from_lua(L);
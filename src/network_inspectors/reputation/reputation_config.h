@@ -45,6 +45,12 @@ enum AllowAction
     TRUST
 };
 
+enum LookupMethod
+{
+    LOOKUP_DIR,
+    LOOKUP_POPTRIE
+};
+
 enum IPdecision
 {
     DECISION_NULL,
@@ -73,6 +79,8 @@ struct ListFile
     std::set<unsigned int> intfs;
     uint8_t list_index;
     uint8_t list_type;
+    uint64_t file_size = 0;
+    int64_t file_mtime = 0;
 };
 
 typedef std::vector<ListFile*> ListFiles;
@@ -80,13 +88,17 @@ typedef std::vector<ListFile*> ListFiles;
 struct ReputationConfig
 {
     uint32_t memcap = 500;
+    unsigned load_threads = 0;
+    unsigned prefilter_bits = 0;
     bool scanlocal = false;
     IPdecision priority = TRUSTED;
     NestedIP nested_ip = INNER;
     AllowAction allow_action = DO_NOT_BLOCK;
+    LookupMethod lookup = LOOKUP_DIR;
     std::string blocklist_path;
     std::string allowlist_path;
     std::string list_dir;
+    std::string snapshot;
 };
 
 struct IPrepInfo
@@ -105,6 +117,10 @@ struct ReputationStats
     PegCount aux_ip_blocked;
     PegCount aux_ip_trusted;
     PegCount aux_ip_monitored;
+    PegCount trie_memory;
+    PegCount prefilter_memory;
+    PegCount prefilter_skipped;
+    PegCount prefilter_false_positives;
 };
 
 extern const PegInfo reputation_peg_names[];
@@ -25,9 +25,12 @@
 
 #include "reputation_inspect.h"
 
+#include <sys/mman.h>
+
 #include "detection/detect.h"
 #include "detection/detection_engine.h"
 #include "events/event_queue.h"
+#include "framework/epoch.h"
 #include "log/messages.h"
 #include "main/snort.h"
 #include "main/snort_config.h"
@@ -38,9 +41,14 @@
 #include "protocols/packet.h"
 #include "pub_sub/auxiliary_ip_event.h"
 #include "pub_sub/reputation_events.h"
+#include "time/clock_defs.h"
+#include "time/stopwatch.h"
+#include "sfrt/sfrt_poptrie.h"
+#include "sfrt/sfrt_prefix_filter.h"
 #include "utils/util.h"
 
 #include "reputation_parse.h"
+#include "reputation_snapshot.h"
 
 using namespace snort;
 
@@ -59,6 +67,10 @@ const PegInfo reputation_peg_names[] =
 { CountType::SUM, "aux_ip_blocked", "number of auxiliary ip packets blocked" },
 { CountType::SUM, "aux_ip_trusted", "number of auxiliary ip packets trusted" },
 { CountType::SUM, "aux_ip_monitored", "number of auxiliary ip packets monitored" },
+{ CountType::SUM, "trie_memory", "memory used by the poptrie lookup" },
+{ CountType::SUM, "prefilter_memory", "memory used by the lookup prefilter" },
+{ CountType::SUM, "prefilter_skipped", "number of IP lookups skipped by the prefilter" },
+{ CountType::SUM, "prefilter_false_positives", "number of IP lookups passed by the prefilter which found nothing" },
 { CountType::END, nullptr, nullptr }
 };
 
@@ -73,7 +85,49 @@ static inline IPrepInfo* reputation_lookup(const ReputationConfig& config,
             return nullptr;
     }
 
-    return (IPrepInfo*)sfrt_flat_dir8x_lookup(ip, data.ip_list);
+    if (data.prefilter and !data.prefilter->maybe(ip))
+    {
+        reputationstats.prefilter_skipped++;
+        return nullptr;
+    }
+
+    IPrepInfo* info;
+
+    if (data.ip_trie)
+        info = (IPrepInfo*)data.ip_trie->lookup(ip);
+    else
+        info = (IPrepInfo*)sfrt_flat_dir8x_lookup(ip, data.ip_list);
+
+    if (!info and data.prefilter)
+        reputationstats.prefilter_false_positives++;
+
+    return info;
+}
+
+// the trie looks up src and dst together so their cache misses overlap,
+// with the prefilter most lookups are skipped and the rest are done singly
+static inline void reputation_lookup(const ReputationConfig& config,
+    ReputationData& data, const ip::IpApi& ip_api, IPrepInfo* results[2])
+{
+    if (!data.ip_trie or data.prefilter)
+    {
+        results[0] = reputation_lookup(config, data, ip_api.get_src());
+        results[1] = reputation_lookup(config, data, ip_api.get_dst());
+        return;
+    }
+
+    const SfIp* ips[2] = { ip_api.get_src(), ip_api.get_dst() };
+    GENERIC found[2];
+
+    data.ip_trie->lookup(ips, 2, found);
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (!config.scanlocal and ips[i]->is_private())
+            results[i] = nullptr;
+        else
+            results[i] = (IPrepInfo*)found[i];
+    }
 }
 
 static inline IPdecision get_reputation(const ReputationConfig& config, ReputationData& data,
@@ -125,11 +179,12 @@ static bool decision_per_layer(const ReputationConfig& config, ReputationData& d
     uint32_t& iplist_id, uint32_t ingress_intf, uint32_t egress_intf, const ip::IpApi& ip_api,
     IPdecision* decision_final)
 {
-    const SfIp* ip = ip_api.get_src();
-    IPrepInfo* result = reputation_lookup(config, data, ip);
-    if (result)
+    IPrepInfo* results[2];
+    reputation_lookup(config, data, ip_api, results);
+
+    if (results[0])
     {
-        IPdecision decision = get_reputation(config, data, result, iplist_id, ingress_intf,
+        IPdecision decision = get_reputation(config, data, results[0], iplist_id, ingress_intf,
             egress_intf);
 
         if (decision == BLOCKED)
@@ -145,11 +200,9 @@ static bool decision_per_layer(const ReputationConfig& config, ReputationData& d
             return true;
     }
 
-    ip = ip_api.get_dst();
-    result = reputation_lookup(config, data, ip);
-    if (result)
+    if (results[1])
     {
-        IPdecision decision = get_reputation(config, data, result, iplist_id, ingress_intf,
+        IPdecision decision = get_reputation(config, data, results[1], iplist_id, ingress_intf,
             egress_intf);
 
         if (decision == BLOCKED)
@@ -460,6 +513,19 @@ static const char* to_string(AllowAction aa)
     return "";
 }
 
+static const char* to_string(LookupMethod lm)
+{
+    switch (lm)
+    {
+    case LOOKUP_DIR:
+        return "dir";
+    case LOOKUP_POPTRIE:
+        return "poptrie";
+    }
+
+    return "";
+}
+
 class IpRepHandler : public DataHandler
 {
 public:
@@ -484,9 +550,7 @@ void IpRepHandler::handle(DataEvent& event, Flow*)
     if (PacketTracer::is_daq_activated())
         PacketTracer::pt_timer_start();
 
-    ReputationData* data = static_cast<ReputationData*>(inspector.get_thread_specific_data());
-    assert(data);
-    snort_reputation(inspector.get_config(), *data, p);
+    snort_reputation(inspector.get_config(), inspector.get_data(), p);
     ++reputationstats.packets;
 }
 
@@ -506,9 +570,8 @@ void AuxiliaryIpRepHandler::handle(DataEvent& event, Flow*)
 {
     // cppcheck-suppress unreadVariable
     Profile profile(reputation_perf_stats);
-    ReputationData* data = static_cast<ReputationData*>(inspector.get_thread_specific_data());
-    assert(data);
-    snort_reputation_aux_ip(inspector.get_config(), *data, DetectionEngine::get_current_packet(),
+    snort_reputation_aux_ip(inspector.get_config(), inspector.get_data(),
+        DetectionEngine::get_current_packet(),
         static_cast<AuxiliaryIpEvent*>(&event)->get_ip());
 }
 
@@ -518,7 +581,12 @@ void AuxiliaryIpRepHandler::handle(DataEvent& event, Flow*)
 
 ReputationData::~ReputationData()
 {
-    if (reputation_segment)
+    delete ip_trie;
+    delete prefilter;
+
+    if (snapshot)
+        munmap(snapshot, snapshot_size);
+    else if (reputation_segment)
         snort_free(reputation_segment);
 
     for (auto& file : list_files)
@@ -529,15 +597,40 @@ Reputation::Reputation(ReputationConfig* pc) : config(*pc)
 { rep_data = load_data(); }
 
 Reputation::~Reputation()
-{ delete rep_data; }
+{ delete rep_data.load(); }
+
+static void log_load_time(const ReputationData& data, const Stopwatch<SnortClock>& timer,
+    const char* source)
+{
+    if ( !SnortConfig::log_verbose() )
+        return;
+
+    long usecs = clock_usecs(TO_USECS(timer.get()));
+
+    LogMessage("reputation: loaded %zu bytes of IP lists from %s in %ld.%06ld seconds\n",
+        data.segment_used, source, usecs / 1000000, usecs % 1000000);
+}
 
 ReputationData* Reputation::load_data()
 {
     ReputationData* data = new ReputationData();
+    Stopwatch<SnortClock> timer;
+    timer.start();
+
     if (!config.list_dir.empty())
         ReputationParser::read_manifest(MANIFEST_FILENAME, config, *data);
 
     ReputationParser::add_block_allow_List(config, *data);
+
+    if (!config.snapshot.empty() and ReputationSnapshot::load(config.snapshot.c_str(), config, *data))
+    {
+        ReputationParser::set_list_types(config, *data);
+        reputationstats.memory_allocated = data->segment_used;
+        build_lookups(*data);
+        log_load_time(*data, timer, "snapshot");
+        return data;
+    }
+
     ReputationParser::estimate_num_entries(*data);
     if (0 >= data->num_entries)
     {
@@ -549,25 +642,36 @@ ReputationData* Reputation::load_data()
         ReputationParser parser;
         parser.ip_list_init(data->num_entries + 1, config, *data);
         reputationstats.memory_allocated = parser.get_usage();
+        build_lookups(*data);
+        log_load_time(*data, timer, "lists");
     }
 
     return data;
 }
 
-void Reputation::swap_thread_data(ReputationData* data)
-{ set_thread_specific_data(data); }
-
-void Reputation::swap_data(ReputationData* data)
+void Reputation::build_lookups(ReputationData& data)
 {
-    delete rep_data;
-    rep_data = data;
-}
+    if (!data.ip_list)
+        return;
+
+    if (config.lookup == LOOKUP_POPTRIE)
+    {
+        data.ip_trie = new Poptrie(data.ip_list);
+        reputationstats.trie_memory = data.ip_trie->get_memory();
+    }
 
-void Reputation::tinit()
-{ set_thread_specific_data(rep_data); }
+    if (config.prefilter_bits)
+    {
+        data.prefilter = new PrefixFilter(data.ip_list, config.prefilter_bits);
+        reputationstats.prefilter_memory = data.prefilter->get_memory();
+    }
+}
 
-void Reputation::tterm()
-{ set_thread_specific_data(nullptr); }
+void Reputation::publish_data(ReputationData* data)
+{
+    ReputationData* old = rep_data.exchange(data);
+    Epoch::retire(old);
+}
 
 void Reputation::show(const SnortConfig*) const
 {
@@ -579,10 +683,18 @@ void Reputation::show(const SnortConfig*) const
     ConfigLogger::log_flag("scan_local", config.scanlocal);
     ConfigLogger::log_value("allow (action)", to_string(config.allow_action));
     ConfigLogger::log_value("allowlist", config.allowlist_path.c_str());
+    ConfigLogger::log_value("lookup", to_string(config.lookup));
+    ConfigLogger::log_value("load_threads", config.load_threads);
+    ConfigLogger::log_value("prefilter_bits", config.prefilter_bits);
+    ConfigLogger::log_value("snapshot", config.snapshot.c_str());
 }
 
-bool Reputation::configure(SnortConfig*)
+bool Reputation::configure(SnortConfig* sc)
 {
+    if (!sc->reputation_snapshot.empty() and
+        !ReputationSnapshot::save(sc->reputation_snapshot.c_str(), config, get_data()))
+        return false;
+
     DataBus::subscribe_network(intrinsic_pub_key, IntrinsicEventIds::FLOW_STATE_SETUP, new IpRepHandler(*this));
     DataBus::subscribe_network(intrinsic_pub_key, IntrinsicEventIds::FLOW_STATE_RELOADED, new IpRepHandler(*this));
     DataBus::subscribe_network(intrinsic_pub_key, IntrinsicEventIds::AUXILIARY_IP, new AuxiliaryIpRepHandler(*this));
@@ -592,9 +704,6 @@ bool Reputation::configure(SnortConfig*)
     return true;
 }
 
-void Reputation::install_reload_handler(SnortConfig* sc)
-{ sc->register_reload_handler(new ReputationReloadSwapper(*this)); }
-
 //-------------------------------------------------------------------------
 // api stuff
 //-------------------------------------------------------------------------
@@ -19,11 +19,16 @@
 #ifndef REPUTATION_INSPECT_H
 #define REPUTATION_INSPECT_H
 
+#include <atomic>
+
 #include "framework/inspector.h"
 
 #include "reputation_module.h"
 
 struct table_flat_t;
+class Poptrie;
+class PrefixFilter;
+
 class ReputationData
 {
 public:
@@ -32,7 +37,12 @@ public:
 
     ListFiles list_files;
     uint8_t* reputation_segment = nullptr;
+    size_t segment_used = 0;
+    void* snapshot = nullptr;    // mapped file holding the segment
+    size_t snapshot_size = 0;
     table_flat_t* ip_list = nullptr;
+    Poptrie* ip_trie = nullptr;  // compiled from ip_list if configured
+    PrefixFilter* prefilter = nullptr;  // checked before the lookup if configured
     int num_entries = 0;
     bool memcap_reached = false;
 };
@@ -43,27 +53,26 @@ public:
     explicit Reputation(ReputationConfig*);
     ~Reputation() override;
 
-    void tinit() override;
-    void tterm() override;
-
     void show(const snort::SnortConfig*) const override;
     void eval(snort::Packet*) override
     { }
     bool configure(snort::SnortConfig*) override;
-    void install_reload_handler(snort::SnortConfig*) override;
 
+    // packet threads read the current data without locks, the data replaced
+    // by publish_data() is freed once they are all done with it
     ReputationData& get_data()
-    { return *rep_data; }
+    { return *rep_data.load(std::memory_order_acquire); }
     const ReputationConfig& get_config()
     { return config; }
     ReputationData* load_data();
 
-    void swap_thread_data(ReputationData*);
-    void swap_data(ReputationData*);
+    void publish_data(ReputationData*);
 
 private:
+    void build_lookups(ReputationData&);
+
     ReputationConfig config;
-    ReputationData* rep_data;
+    std::atomic<ReputationData*> rep_data;
 };
 
 #endif
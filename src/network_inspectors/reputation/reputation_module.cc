@@ -59,24 +59,36 @@ static const Parameter s_params[] =
     { "list_dir", Parameter::PT_STRING, nullptr, nullptr,
       "directory for IP lists and manifest file" },
 
+    { "load_threads", Parameter::PT_INT, "0:64", "0",
+      "threads used to parse the list files, 0 for one per CPU up to 8" },
+
     { "memcap", Parameter::PT_INT, "1:4095", "500",
       "maximum total MB of memory allocated" },
 
     { "nested_ip", Parameter::PT_ENUM, "inner|outer|all", "inner",
       "IP to use when there is IP encapsulation" },
 
+    { "prefilter_bits", Parameter::PT_INT, "0:32", "0",
+      "bits per list entry of a bloom filter checked before the IP lookups, 0 to disable" },
+
     { "priority", Parameter::PT_ENUM, "blocklist|allowlist", "allowlist",
       "defines priority when there is a decision conflict during run-time" },
 
     { "scan_local", Parameter::PT_BOOL, nullptr, "false",
       "inspect local address defined in RFC 1918" },
 
+    { "snapshot", Parameter::PT_STRING, nullptr, nullptr,
+      "prebuilt snapshot of the lists to map instead of parsing them while they are unchanged, see --dump-reputation-snapshot" },
+
     { "allow", Parameter::PT_ENUM, "do_not_block|trust", "do_not_block",
       "specify the meaning of allowlist" },
 
     { "allowlist", Parameter::PT_STRING, nullptr, nullptr,
       "allowlist file name with IP lists" },
 
+    { "lookup", Parameter::PT_ENUM, "dir|poptrie", "dir",
+      "IP lookup method, poptrie adds a compressed copy of the lists for faster lookups" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -131,24 +143,36 @@ bool ReputationModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("list_dir") )
         conf->list_dir = v.get_string();
 
+    else if ( v.is("load_threads") )
+        conf->load_threads = v.get_uint8();
+
     else if ( v.is("memcap") )
         conf->memcap = v.get_uint32();
 
     else if ( v.is("nested_ip") )
         conf->nested_ip = (NestedIP)v.get_uint8();
 
+    else if ( v.is("prefilter_bits") )
+        conf->prefilter_bits = v.get_uint8();
+
     else if ( v.is("priority") )
         conf->priority = (IPdecision)(v.get_uint8() + 1);
 
     else if ( v.is("scan_local") )
         conf->scanlocal = v.get_bool();
 
+    else if ( v.is("snapshot") )
+        conf->snapshot = v.get_string();
+
     else if ( v.is("allow") )
         conf->allow_action = (AllowAction)v.get_uint8();
 
     else if ( v.is("allowlist") )
         conf->allowlist_path = v.get_string();
 
+    else if ( v.is("lookup") )
+        conf->lookup = (LookupMethod)v.get_uint8();
+
     return true;
 }
 
@@ -181,6 +205,3 @@ bool ReputationModule::end(const char*, int, SnortConfig*)
     return true;
 }
 
-void ReputationReloadSwapper::tswap()
-{ inspector.set_thread_specific_data(&inspector.get_data()); }
-
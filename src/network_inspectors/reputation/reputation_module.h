@@ -24,7 +24,6 @@
 // Interface to the REPUTATION network inspector
 
 #include "framework/module.h"
-#include "main/reload_tuner.h"
 
 #include "reputation_config.h"
 #include "reputation_common.h"
@@ -38,21 +37,6 @@ extern THREAD_LOCAL snort::ProfileStats reputation_perf_stats;
 extern unsigned long total_duplicates;
 extern unsigned long total_invalids;
 
-class Reputation;
-
-class ReputationReloadSwapper : public snort::ReloadSwapper
-{
-public:
-    explicit ReputationReloadSwapper(Reputation& ins) : inspector(ins)
-    { }
-    ~ReputationReloadSwapper() override = default;
-
-    void tswap() override;
-
-private:
-    Reputation& inspector;
-};
-
 class ReputationModule : public snort::Module
 {
 public:
@@ -24,11 +24,17 @@
 #include "reputation_parse.h"
 
 #include <netinet/in.h>
+#include <sys/stat.h>
 
+#include <algorithm>
 #include <cassert>
 #include <climits>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <limits>
+#include <thread>
+#include <vector>
 
 #include "main/snort_config.h"
 #include "log/messages.h"
@@ -40,6 +46,10 @@
 #include "reputation_config.h"
 #include "reputation_inspect.h"
 
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 using namespace std;
 
@@ -442,17 +452,176 @@ static int snort_pton(char const* src, SfCidr* dest)
     return 1;
 }
 
-int ReputationParser::process_line(char* line, INFO info, const ReputationConfig& config)
+namespace
 {
+enum LineType
+{
+    LINE_EMPTY,
+    LINE_INVALID,
+    LINE_ADDRESS
+};
+
+struct ParsedLine
+{
+    const char* text;  // without comments and newline
+    LineType type;
     SfCidr address;
+};
+}
+
+// text from each file is read into a buffer of up to this much per thread,
+// and no more than PARSE_BUFFER_MAX in all, whose lines are parsed by the
+// threads and then inserted in file order on the calling thread
+#define PARSE_BATCH_SIZE (1 << 20)
+#define PARSE_BUFFER_MAX (1 << 24)
+#define MIN_PARSE_CHUNK  (1 << 16)
+
+// with load_threads 0, the parse is mostly memory bound past this many
+#define MAX_DEFAULT_LOAD_THREADS 8
+
+// splits [begin, end) into nul terminated lines, end must be writable
+static void parse_lines(char* begin, char* end, std::vector<ParsedLine>& lines)
+{
+    while ( begin < end )
+    {
+        char* eol = (char*)memchr(begin, '\n', end - begin);
 
-    if ( !line || *line == '\0' )
-        return IP_INSERT_SUCCESS;
+        if ( !eol )
+            eol = end;
 
-    if ( snort_pton(line, &address) < 1 )
-        return IP_INVALID;
+        *eol = '\0';
 
-    return add_ip(&address, info, config);
+        // Remove comments
+        if ( char* cmt = strchr(begin, '#') )
+            *cmt = '\0';
+
+        ParsedLine line;
+        line.text = begin;
+
+        if ( !*begin )
+            line.type = LINE_EMPTY;
+        else if ( snort_pton(begin, &line.address) < 1 )
+            line.type = LINE_INVALID;
+        else
+            line.type = LINE_ADDRESS;
+
+        lines.emplace_back(line);
+        begin = eol + 1;
+    }
+}
+
+// each thread gets about the same amount of whole lines, but at least
+// min_chunk bytes
+static void parse_batch(char* begin, char* end, unsigned threads, size_t min_chunk,
+    std::vector<std::vector<ParsedLine>>& batches)
+{
+    size_t chunk = (end - begin) / threads + 1;
+
+    if ( chunk < min_chunk )
+        chunk = min_chunk;
+
+    std::vector<std::thread> workers;
+    unsigned n = 0;
+
+    // no more than one chunk per thread, sized before the workers get refs
+    batches.resize(threads);
+
+    while ( begin < end )
+    {
+        char* stop = end;
+
+        if ( n + 1 < threads and (size_t)(end - begin) > chunk )
+        {
+            stop = (char*)memchr(begin + chunk, '\n', end - begin - chunk);
+            stop = stop ? stop + 1 : end;
+        }
+
+        batches[n].clear();
+
+        // the last chunk is done by this thread
+        if ( stop == end )
+            parse_lines(begin, stop, batches[n]);
+        else
+            workers.emplace_back(parse_lines, begin, stop, std::ref(batches[n]));
+
+        begin = stop;
+        ++n;
+    }
+
+    for ( auto& w : workers )
+        w.join();
+
+    batches.resize(n);
+}
+
+// calls handler with the number and parsed text of each line of fp in file
+// order until it returns false; buffer_size bytes are read at a time and
+// lines longer than that are split like fgets would
+static void read_lines(FILE* fp, unsigned threads, size_t buffer_size,
+    const std::function<bool(int, const ParsedLine&)>& handler)
+{
+    std::vector<char> buf(buffer_size + 1);
+    std::vector<std::vector<ParsedLine>> batches;
+    size_t min_chunk = std::min<size_t>(MIN_PARSE_CHUNK, buffer_size / threads);
+    size_t have = 0;
+    int line_num = 0;
+
+    while ( true )
+    {
+        have += fread(buf.data() + have, 1, buffer_size - have, fp);
+
+        if ( !have )
+            return;
+
+        // parse up to the last complete line, the rest goes with the next batch
+        char* end = buf.data() + have;
+        bool eof = have < buffer_size;
+
+        if ( !eof )
+        {
+            while ( end > buf.data() and end[-1] != '\n' )
+                --end;
+
+            if ( end == buf.data() )
+                end = buf.data() + have;
+        }
+
+        parse_batch(buf.data(), end, threads, min_chunk, batches);
+
+        for ( const auto& lines : batches )
+        {
+            for ( const auto& line : lines )
+            {
+                if ( !handler(++line_num, line) )
+                    return;
+            }
+        }
+
+        if ( eof )
+            return;
+
+        have = buf.data() + have - end;
+        memmove(buf.data(), end, have);
+    }
+}
+
+static unsigned get_load_threads(const ReputationConfig& config)
+{
+    if ( config.load_threads )
+        return config.load_threads;
+
+    unsigned n = std::thread::hardware_concurrency();
+
+    if ( n > MAX_DEFAULT_LOAD_THREADS )
+        return MAX_DEFAULT_LOAD_THREADS;
+
+    return n ? n : 1;
+}
+
+static size_t get_parse_buffer_size(unsigned threads, size_t max)
+{
+    size_t size = (size_t)threads * PARSE_BATCH_SIZE;
+    return size < max ? size : max;
 }
 
 static int update_path_to_file(char* full_filename, unsigned int max_size, const char* filename)
@@ -514,14 +683,28 @@ static char* get_list_type_name(ListFile* list_info)
     }
 }
 
+ReputationParser::ReputationParser() : max_parse_buffer(PARSE_BUFFER_MAX)
+{ }
+
+bool ReputationParser::stat_list_file(const ListFile& list_info, uint64_t& size, int64_t& mtime)
+{
+    char full_path_filename[PATH_MAX+1];
+    struct stat st;
+
+    if ( !update_path_to_file(full_path_filename, PATH_MAX, list_info.file_name.c_str()) or
+        stat(full_path_filename, &st) )
+        return false;
+
+    size = st.st_size;
+    mtime = st.st_mtime;
+    return true;
+}
+
 void ReputationParser::load_list_file(ListFile* list_info, const ReputationConfig& config,
     ReputationData& data)
 {
-    char linebuf[MAX_ADDR_LINE_LENGTH];
     char full_path_filename[PATH_MAX+1];
-    int addrline = 0;
     FILE* fp = nullptr;
-    char* cmt = nullptr;
     char* list_type_name;
     IPrepInfo* ip_info;
     MEM_OFFSET ip_info_ptr;
@@ -563,49 +746,63 @@ void ReputationParser::load_list_file(ListFile* list_info, const ReputationConfi
         return;
     }
 
-    num_loaded_before = table.sfrt_flat_num_entries();
-    while ( fgets(linebuf, MAX_ADDR_LINE_LENGTH, fp) )
+    // the snapshot is only used while the files are unchanged
+    struct stat st;
+
+    if ( !fstat(fileno(fp), &st) )
     {
-        int ret;
-        addrline++;
+        list_info->file_size = st.st_size;
+        list_info->file_mtime = st.st_mtime;
+    }
 
-        // Remove comments
-        if ( (cmt = strchr(linebuf, '#')) )
-            *cmt = '\0';
+    unsigned threads = get_load_threads(config);
+    size_t buffer_size = get_parse_buffer_size(threads, max_parse_buffer);
 
-        // Remove newline as well, prevent double newline in logging.
-        if ( (cmt = strchr(linebuf, '\n')) )
-            *cmt = '\0';
+    num_loaded_before = table.sfrt_flat_num_entries();
+
+    read_lines(fp, threads, buffer_size, [&](int addrline, const ParsedLine& line)
+    {
+        int ret;
 
         /* process the line */
-        ret = process_line(linebuf, ip_info_ptr, config);
+        if ( line.type == LINE_EMPTY )
+            return true;
+
+        if ( line.type == LINE_INVALID )
+            ret = IP_INVALID;
+        else
+        {
+            SfCidr address = line.address;
+            ret = add_ip(&address, ip_info_ptr, config);
+        }
 
         if (IP_INSERT_SUCCESS == ret)
         {
-            continue;
+            return true;
         }
         else if (IP_INSERT_FAILURE == ret && fail_count++ < MAX_MSGS_TO_PRINT)
         {
-            ErrorMessage("      (%d) => Failed to insert address: \'%s\'\n", addrline, linebuf);
+            ErrorMessage("      (%d) => Failed to insert address: \'%s\'\n", addrline, line.text);
         }
         else if (IP_INVALID == ret && invalid_count++ < MAX_MSGS_TO_PRINT)
         {
-            ErrorMessage("      (%d) => Invalid address: \'%s\'\n", addrline, linebuf);
+            ErrorMessage("      (%d) => Invalid address: \'%s\'\n", addrline, line.text);
         }
         else if (IP_INSERT_DUPLICATE == ret && duplicate_count++ < MAX_MSGS_TO_PRINT)
         {
-            ErrorMessage("      (%d) => Re-defined address: '%s'\n", addrline, linebuf);
+            ErrorMessage("      (%d) => Re-defined address: '%s'\n", addrline, line.text);
         }
         else if (IP_MEM_ALLOC_FAILURE == ret)
         {
             ErrorMessage(
                 "WARNING: %s(%d) => Memcap %u Mbytes reached when inserting IP Address: %s\n",
-                full_path_filename, addrline, config.memcap,linebuf);
+                full_path_filename, addrline, config.memcap, line.text);
 
             data.memcap_reached = true;
-            break;
+            return false;
         }
-    }
+        return true;
+    });
 
     total_duplicates += duplicate_count;
     total_invalids += invalid_count;
@@ -633,7 +830,8 @@ void ReputationParser::ip_list_init(uint32_t max_entries, const ReputationConfig
     {
         uint32_t mem_size;
         mem_size = estimate_size(max_entries, config.memcap);
-        data.reputation_segment = (uint8_t*)snort_alloc(mem_size);
+        // zeroed so unused fields and padding don't leak into snapshots
+        data.reputation_segment = (uint8_t*)snort_calloc(mem_size);
 
         table.segment_meminit(data.reputation_segment, mem_size);
 
@@ -651,23 +849,31 @@ void ReputationParser::ip_list_init(uint32_t max_entries, const ReputationConfig
         }
 
         total_duplicates = 0;
-        for (size_t i = 0; i < data.list_files.size(); i++)
-        {
-            data.list_files[i]->list_index = (uint8_t)i + 1;
-            if (data.list_files[i]->file_type == ALLOW_LIST)
-            {
-                if (config.allow_action == DO_NOT_BLOCK)
-                    data.list_files[i]->list_type = TRUSTED_DO_NOT_BLOCK;
-                else
-                    data.list_files[i]->list_type = TRUSTED;
-            }
-            else if (data.list_files[i]->file_type == BLOCK_LIST)
-                data.list_files[i]->list_type = BLOCKED;
-            else if (data.list_files[i]->file_type == MONITOR_LIST)
-                data.list_files[i]->list_type = MONITORED;
+        set_list_types(config, data);
 
-            load_list_file(data.list_files[i], config, data);
+        for (auto& file : data.list_files)
+            load_list_file(file, config, data);
+
+        data.segment_used = table.segment_used();
+    }
+}
+
+void ReputationParser::set_list_types(const ReputationConfig& config, ReputationData& data)
+{
+    for (size_t i = 0; i < data.list_files.size(); i++)
+    {
+        data.list_files[i]->list_index = (uint8_t)i + 1;
+        if (data.list_files[i]->file_type == ALLOW_LIST)
+        {
+            if (config.allow_action == DO_NOT_BLOCK)
+                data.list_files[i]->list_type = TRUSTED_DO_NOT_BLOCK;
+            else
+                data.list_files[i]->list_type = TRUSTED;
         }
+        else if (data.list_files[i]->file_type == BLOCK_LIST)
+            data.list_files[i]->list_type = BLOCKED;
+        else if (data.list_files[i]->file_type == MONITOR_LIST)
+            data.list_files[i]->list_type = MONITORED;
     }
 }
 
@@ -954,3 +1160,266 @@ void ReputationParser::read_manifest(const char* manifest_file, const Reputation
     fs.close();
 }
 
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+namespace
+{
+struct ReadLine
+{
+    int num;
+    LineType type;
+    std::string text;
+    std::string address;
+
+    bool operator==(const ReadLine& r) const
+    { return num == r.num and type == r.type and text == r.text and address == r.address; }
+};
+
+class TestParser : public ReputationParser
+{
+public:
+    TestParser(size_t max_buffer)
+    { max_parse_buffer = max_buffer; }
+};
+
+struct ListDir
+{
+    ListDir()
+    {
+        strcpy(dir, "/tmp/reputation_parse_XXXXXX");
+        REQUIRE(mkdtemp(dir));
+    }
+
+    ~ListDir()
+    {
+        for ( const auto& f : files )
+            remove(f.c_str());
+
+        rmdir(dir);
+    }
+
+    std::string add(const char* name, const std::string& text)
+    {
+        std::string path = std::string(dir) + '/' + name;
+        std::ofstream(path) << text;
+        files.emplace_back(path);
+        return path;
+    }
+
+    char dir[32];
+    std::vector<std::string> files;
+};
+}
+
+static std::string to_string(const SfCidr& a)
+{
+    SfIpString s;
+    a.get_addr()->ntop(s);
+    return std::string(s) + '/' + std::to_string(a.get_bits());
+}
+
+static ReadLine get_line(int num, const ParsedLine& line)
+{
+    ReadLine r = { num, line.type, line.text, "" };
+
+    if ( line.type == LINE_ADDRESS )
+        r.address = to_string(line.address);
+
+    return r;
+}
+
+// the lines as the sequential parse read them with fgets
+static std::vector<ReadLine> fgets_lines(const std::string& path)
+{
+    std::vector<ReadLine> lines;
+    char buf[MAX_ADDR_LINE_LENGTH];
+    FILE* fp = fopen(path.c_str(), "r");
+    int num = 0;
+
+    while ( fgets(buf, sizeof(buf), fp) )
+    {
+        if ( char* cmt = strchr(buf, '#') )
+            *cmt = '\0';
+
+        if ( char* eol = strchr(buf, '\n') )
+            *eol = '\0';
+
+        ParsedLine line;
+        line.text = buf;
+
+        if ( !*buf )
+            line.type = LINE_EMPTY;
+        else if ( snort_pton(buf, &line.address) < 1 )
+            line.type = LINE_INVALID;
+        else
+            line.type = LINE_ADDRESS;
+
+        lines.emplace_back(get_line(++num, line));
+    }
+    fclose(fp);
+    return lines;
+}
+
+static std::vector<ReadLine> read_all(const std::string& path, unsigned threads, size_t buffer,
+    int stop = 0)
+{
+    std::vector<ReadLine> lines;
+    FILE* fp = fopen(path.c_str(), "r");
+
+    read_lines(fp, threads, buffer, [&](int num, const ParsedLine& line)
+    {
+        lines.emplace_back(get_line(num, line));
+        return num != stop;
+    });
+
+    fclose(fp);
+    return lines;
+}
+
+static std::string make_list(unsigned n, unsigned seed)
+{
+    std::string s = "# generated list\n\n";
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        unsigned v = (i * 2654435761u) ^ seed;
+
+        switch ( v % 8 )
+        {
+        case 0:
+            s += "bogus.address\n";
+            break;
+        case 1:
+            s += "# just a comment\n";
+            break;
+        case 2:
+            s += "2001:db8:" + std::to_string(v % 97) + "::/48  # v6\n";
+            break;
+        case 3:
+            s += "10." + std::to_string(v % 5) + ".0.0/16\n";
+            break;
+        default:
+            s += "10." + std::to_string(v % 5) + '.' + std::to_string((v >> 8) % 7) + '.' +
+                std::to_string((v >> 16) % 251) + '\n';
+        }
+    }
+    // no newline at the end
+    s += "192.168.1.1";
+    return s;
+}
+
+TEST_CASE("reputation read lines", "[reputation]")
+{
+    ListDir dir;
+    std::string path = dir.add("list", make_list(2000, 0));
+    std::vector<ReadLine> expected = fgets_lines(path);
+    REQUIRE(expected.size() == 2003);
+
+    for ( unsigned threads : { 1, 2, 4, 7 } )
+    {
+        for ( size_t buffer : { 64, 256, 4096, PARSE_BUFFER_MAX } )
+        {
+            CAPTURE(threads);
+            CAPTURE(buffer);
+            CHECK(read_all(path, threads, buffer) == expected);
+        }
+    }
+
+    // stopping at a line, as for the memcap
+    std::vector<ReadLine> part = read_all(path, 4, 256, 1000);
+    REQUIRE(part.size() == 1000);
+    CHECK(std::equal(part.begin(), part.end(), expected.begin()));
+}
+
+static void load_lists(ListDir& dir, const ReputationConfig& config, unsigned threads,
+    size_t buffer, ReputationData& data, unsigned long& invalids)
+{
+    ListFile* block = new ListFile;
+    block->file_name = dir.files[0];
+    block->file_type = BLOCK_LIST;
+    block->all_intfs_enabled = true;
+    data.list_files.emplace_back(block);
+
+    ListFile* allow = new ListFile;
+    allow->file_name = dir.files[1];
+    allow->file_type = ALLOW_LIST;
+    allow->all_intfs_enabled = true;
+    data.list_files.emplace_back(allow);
+
+    ReputationParser::estimate_num_entries(data);
+
+    ReputationConfig cfg = config;
+    cfg.load_threads = threads;
+
+    unsigned long before = total_invalids;
+    TestParser parser(buffer);
+    parser.ip_list_init(data.num_entries + 1, cfg, data);
+    invalids = total_invalids - before;
+    REQUIRE(data.ip_list);
+}
+
+// the flat table is built by inserting in file order, so the same
+// inserts produce the same bytes
+static void check_same(const ReputationData& seq, const ReputationData& par)
+{
+    CHECK(seq.segment_used == par.segment_used);
+    CHECK(seq.memcap_reached == par.memcap_reached);
+    CHECK(!memcmp(seq.reputation_segment, par.reputation_segment, seq.segment_used));
+}
+
+TEST_CASE("reputation parallel load", "[reputation]")
+{
+    ListDir dir;
+    dir.add("block", make_list(20000, 1));
+    dir.add("allow", make_list(5000, 2));
+
+    ReputationConfig config;
+    ReputationData seq;
+    unsigned long seq_invalids;
+    load_lists(dir, config, 1, PARSE_BUFFER_MAX, seq, seq_invalids);
+    unsigned long seq_duplicates = total_duplicates;
+
+    CHECK(!seq.memcap_reached);
+    CHECK(seq_invalids > 0);
+    CHECK(seq_duplicates > 0);
+
+    ReputationData par;
+    unsigned long par_invalids;
+    load_lists(dir, config, 4, 1024, par, par_invalids);
+
+    check_same(seq, par);
+    CHECK(seq_invalids == par_invalids);
+    CHECK(seq_duplicates == total_duplicates);
+}
+
+TEST_CASE("reputation parallel load memcap", "[reputation]")
+{
+    // each address needs new sub tables until the memcap is reached
+    std::string block;
+
+    for ( unsigned i = 0; i < 20000; ++i )
+        block += std::to_string(i / 256 % 200 + 1) + '.' + std::to_string(i % 256) + ".7.7\n";
+
+    ListDir dir;
+    dir.add("block", block);
+    dir.add("allow", "10.1.1.1\n");
+
+    ReputationConfig config;
+    config.memcap = 2;
+
+    ReputationData seq;
+    unsigned long invalids;
+    load_lists(dir, config, 1, PARSE_BUFFER_MAX, seq, invalids);
+    CHECK(seq.memcap_reached);
+
+    ReputationData par;
+    load_lists(dir, config, 3, 512, par, invalids);
+    check_same(seq, par);
+}
+
+#endif
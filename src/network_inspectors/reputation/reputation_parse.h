@@ -32,9 +32,13 @@ class ReputationData;
 class ReputationParser
 {
 public:
+    ReputationParser();
+
     static void read_manifest(const char* filename, const ReputationConfig&, ReputationData&);
     static void add_block_allow_List(const ReputationConfig&, ReputationData&);
     static void estimate_num_entries(ReputationData&);
+    static void set_list_types(const ReputationConfig&, ReputationData&);
+    static bool stat_list_file(const ListFile&, uint64_t& size, int64_t& mtime);
 
     void load_list_file(ListFile* list_info, const ReputationConfig& config,
         ReputationData& data);
@@ -47,11 +51,11 @@ protected:
     int duplicate_info(IPrepInfo* dest_info, IPrepInfo* current_info, uint8_t* base);
     int64_t update_entry_info_impl(INFO* current, INFO new_entry, SaveDest save_dest, uint8_t* base);
     int add_ip(snort::SfCidr* ip_addr,INFO info_ptr, const ReputationConfig& config);
-    int process_line(char* line, INFO info, const ReputationConfig& config);
 
     static int64_t update_entry_info(INFO* current, INFO new_entry, SaveDest save_dest, uint8_t* base, void* data);
 
     RtTable table;
+    size_t max_parse_buffer;
 };
 
 #endif
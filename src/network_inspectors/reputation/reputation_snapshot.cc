@@ -0,0 +1,769 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// reputation_snapshot.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "reputation_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "log/messages.h"
+#include "sfrt/sfrt_flat.h"
+#include "utils/util.h"
+
+#include "reputation_config.h"
+#include "reputation_inspect.h"
+#include "reputation_parse.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#include "sfip/sf_cidr.h"
+#endif
+
+using namespace snort;
+
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_ALIGN 64
+
+static const char snapshot_magic[8] = { 'S', 'N', 'O', 'R', 'T', 'R', 'E', 'P' };
+
+namespace
+{
+// followed by the list files and then the segment at segment_offset; the
+// checksum covers both
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t layout;
+    uint32_t num_lists;
+    uint64_t lists_offset;
+    uint64_t lists_size;
+    uint64_t segment_offset;
+    uint64_t segment_size;
+    int32_t num_entries;
+    uint32_t memcap;
+    uint32_t checksum;
+    uint32_t reserved;
+};
+
+class ListReader
+{
+public:
+    ListReader(const uint8_t* p, size_t n) : next(p), end(p + n)
+    { }
+
+    template <typename T>
+    bool get(T& v)
+    {
+        if ( (size_t)(end - next) < sizeof(v) )
+            return false;
+
+        memcpy(&v, next, sizeof(v));
+        next += sizeof(v);
+        return true;
+    }
+
+    bool get(std::string& s)
+    {
+        uint32_t len;
+
+        if ( !get(len) or (size_t)(end - next) < len )
+            return false;
+
+        s.assign((const char*)next, len);
+        next += len;
+        return true;
+    }
+
+private:
+    const uint8_t* next;
+    const uint8_t* end;
+};
+}
+
+// the segment is only usable by a build with the same structures
+static uint32_t get_layout()
+{
+    return (sizeof(table_flat_t) << 20) ^ (sizeof(dir_table_flat_t) << 10) ^
+        (sizeof(dir_sub_table_flat_t) << 5) ^ (sizeof(DIR_Entry) << 3) ^ sizeof(IPrepInfo);
+}
+
+static uint32_t get_checksum(const uint8_t* p, uint64_t n, uint32_t crc)
+{
+    // crc32 takes an unsigned length
+    const uint64_t max_len = 1 << 30;
+
+    while ( n > max_len )
+    {
+        crc = crc32(crc, p, max_len);
+        p += max_len;
+        n -= max_len;
+    }
+    return crc32(crc, p, n);
+}
+
+template <typename T>
+static void put(std::string& s, const T& v)
+{ s.append((const char*)&v, sizeof(v)); }
+
+static void put(std::string& s, const std::string& str)
+{
+    put(s, (uint32_t)str.size());
+    s.append(str);
+}
+
+static std::string get_lists(const ReputationData& data)
+{
+    std::string s;
+
+    for ( const auto* file : data.list_files )
+    {
+        put(s, file->file_name);
+        put(s, (int32_t)file->file_type);
+        put(s, file->list_id);
+        put(s, (uint8_t)file->all_intfs_enabled);
+        put(s, (uint32_t)file->intfs.size());
+
+        for ( auto intf : file->intfs )
+            put(s, (uint32_t)intf);
+
+        put(s, file->file_size);
+        put(s, file->file_mtime);
+    }
+    return s;
+}
+
+// the snapshot lists must be the configured ones, unchanged since the
+// snapshot was built
+static bool check_lists(const char* snapshot, const uint8_t* p, size_t n, unsigned num,
+    ReputationData& data)
+{
+    if ( num != data.list_files.size() )
+    {
+        WarningMessage("reputation: snapshot %s has %u list files, %zu are configured\n",
+            snapshot, num, data.list_files.size());
+        return false;
+    }
+
+    ListReader reader(p, n);
+
+    for ( auto* file : data.list_files )
+    {
+        std::string name;
+        int32_t type;
+        uint32_t list_id;
+        uint8_t all;
+        uint32_t num_intfs;
+        std::set<unsigned int> intfs;
+        uint64_t size, cur_size;
+        int64_t mtime, cur_mtime;
+
+        if ( !reader.get(name) or !reader.get(type) or !reader.get(list_id) or
+            !reader.get(all) or !reader.get(num_intfs) )
+            return false;
+
+        for ( unsigned j = 0; j < num_intfs; ++j )
+        {
+            uint32_t intf;
+
+            if ( !reader.get(intf) )
+                return false;
+
+            intfs.emplace(intf);
+        }
+
+        if ( !reader.get(size) or !reader.get(mtime) )
+            return false;
+
+        if ( name != file->file_name or type != file->file_type or list_id != file->list_id or
+            (bool)all != file->all_intfs_enabled or intfs != file->intfs )
+        {
+            WarningMessage("reputation: snapshot %s lists %s, %s is configured\n",
+                snapshot, name.c_str(), file->file_name.c_str());
+            return false;
+        }
+
+        if ( !ReputationParser::stat_list_file(*file, cur_size, cur_mtime) or
+            cur_size != size or cur_mtime != mtime )
+        {
+            WarningMessage("reputation: %s has changed since snapshot %s was built\n",
+                file->file_name.c_str(), snapshot);
+            return false;
+        }
+
+        file->file_size = size;
+        file->file_mtime = mtime;
+    }
+    return true;
+}
+
+namespace
+{
+// checks that every offset the lookups and the lookup builders may follow
+// stays within the segment, so a corrupt snapshot can't send them outside
+class SegmentChecker
+{
+public:
+    SegmentChecker(const uint8_t* b, uint64_t n, unsigned lists) :
+        base(b), size(n), num_lists(lists)
+    {
+        // entry arrays of a valid table don't overlap
+        max_entries = size / sizeof(DIR_Entry);
+    }
+
+    bool check();
+
+private:
+    template <typename T>
+    bool in_segment(MEM_OFFSET off, uint64_t num = 1) const
+    { return off and off < size and num <= (size - off) / sizeof(T); }
+
+    bool check_dir(TABLE_PTR, const std::vector<int>& dims);
+    bool check_sub(SUB_TABLE_PTR, const std::vector<int>& dims, unsigned depth);
+    bool check_value(MEM_OFFSET) const;
+    bool check_info(MEM_OFFSET) const;
+
+    const uint8_t* base;
+    uint64_t size;
+    unsigned num_lists;
+    uint64_t max_entries;
+    uint64_t num_entries = 0;
+    const table_flat_t* table = nullptr;
+    const INFO* data = nullptr;
+};
+}
+
+bool SegmentChecker::check()
+{
+    table = (const table_flat_t*)base;
+
+    // the lookups assume the DIR_8x16 widths
+    if ( table->table_flat_type != DIR_8x16 or !table->max_size or
+        !in_segment<INFO>(table->data, table->max_size) )
+        return false;
+
+    data = (const INFO*)(base + table->data);
+
+    for ( unsigned i = 0; i < table->max_size; ++i )
+    {
+        if ( data[i] and !check_info(data[i]) )
+            return false;
+    }
+
+    return check_dir(table->rt, { 16, 8, 4, 4 }) and
+        check_dir(table->rt6, std::vector<int>(16, 8));
+}
+
+bool SegmentChecker::check_dir(TABLE_PTR off, const std::vector<int>& dims)
+{
+    if ( !in_segment<dir_table_flat_t>(off) )
+        return false;
+
+    const dir_table_flat_t* dir = (const dir_table_flat_t*)(base + off);
+
+    if ( dir->dim_size != (int)dims.size() )
+        return false;
+
+    for ( unsigned i = 0; i < dims.size(); ++i )
+    {
+        if ( dir->dimensions[i] != dims[i] )
+            return false;
+    }
+
+    return check_sub(dir->sub_table, dims, 0);
+}
+
+bool SegmentChecker::check_sub(SUB_TABLE_PTR off, const std::vector<int>& dims, unsigned depth)
+{
+    if ( depth >= dims.size() or !in_segment<dir_sub_table_flat_t>(off) )
+        return false;
+
+    const dir_sub_table_flat_t* sub = (const dir_sub_table_flat_t*)(base + off);
+    uint64_t num = (uint64_t)1 << dims[depth];
+
+    if ( sub->width != dims[depth] or sub->num_entries != (int)num or
+        !in_segment<DIR_Entry>(sub->entries, num) )
+        return false;
+
+    // also bounds the walk of sub tables linked more than once
+    num_entries += num;
+
+    if ( num_entries > max_entries )
+        return false;
+
+    const DIR_Entry* entries = (const DIR_Entry*)(base + sub->entries);
+
+    for ( uint64_t i = 0; i < num; ++i )
+    {
+        const DIR_Entry& e = entries[i];
+
+        if ( !e.value or e.length )
+        {
+            if ( !check_value(e.value) )
+                return false;
+        }
+        else if ( !check_sub(e.value, dims, depth + 1) )
+            return false;
+    }
+    return true;
+}
+
+bool SegmentChecker::check_value(MEM_OFFSET index) const
+{ return index < table->max_size; }
+
+bool SegmentChecker::check_info(MEM_OFFSET off) const
+{
+    // each list adds at most one index to a chain
+    for ( unsigned n = 0; n <= num_lists; ++n )
+    {
+        if ( !in_segment<IPrepInfo>(off) )
+            return false;
+
+        const IPrepInfo* info = (const IPrepInfo*)(base + off);
+
+        for ( auto index : info->list_indexes )
+        {
+            if ( (uint8_t)index > num_lists )
+                return false;
+        }
+
+        if ( !info->next )
+            return true;
+
+        off = info->next;
+    }
+    return false;
+}
+
+bool ReputationSnapshot::save(const char* file, const ReputationConfig& config,
+    const ReputationData& data)
+{
+    if ( !data.ip_list or !data.segment_used )
+    {
+        ErrorMessage("reputation: no IP list to save to snapshot %s\n", file);
+        return false;
+    }
+
+    // the table is allocated first so the segment starts with it
+    assert((const uint8_t*)data.ip_list == data.reputation_segment);
+
+    std::string lists = get_lists(data);
+
+    SnapshotHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, snapshot_magic, sizeof(h.magic));
+    h.version = SNAPSHOT_VERSION;
+    h.byte_order = SNAPSHOT_BYTE_ORDER;
+    h.layout = get_layout();
+    h.num_lists = data.list_files.size();
+    h.lists_offset = sizeof(h);
+    h.lists_size = lists.size();
+    h.segment_offset = (h.lists_offset + h.lists_size + SNAPSHOT_ALIGN - 1) & ~(uint64_t)(SNAPSHOT_ALIGN - 1);
+    h.segment_size = data.segment_used;
+    h.num_entries = data.num_entries;
+    h.memcap = config.memcap;
+
+    h.checksum = get_checksum((const uint8_t*)lists.data(), lists.size(), crc32(0, nullptr, 0));
+    h.checksum = get_checksum(data.reputation_segment, h.segment_size, h.checksum);
+
+    // written aside and renamed so a reload never maps a partial snapshot
+    std::string tmp = std::string(file) + ".tmp";
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+
+    if ( out )
+    {
+        char pad[SNAPSHOT_ALIGN] = { };
+        out.write((const char*)&h, sizeof(h));
+        out.write(lists.data(), lists.size());
+        out.write(pad, h.segment_offset - h.lists_offset - h.lists_size);
+        out.write((const char*)data.reputation_segment, h.segment_size);
+        out.close();
+    }
+
+    if ( !out or rename(tmp.c_str(), file) )
+    {
+        ErrorMessage("reputation: can't write snapshot %s: %s\n", file, get_error(errno));
+        remove(tmp.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_header(const SnapshotHeader& h, size_t size)
+{
+    if ( memcmp(h.magic, snapshot_magic, sizeof(h.magic)) or h.version != SNAPSHOT_VERSION or
+        h.byte_order != SNAPSHOT_BYTE_ORDER or h.layout != get_layout() )
+        return false;
+
+    if ( h.lists_offset > size or h.lists_size > size - h.lists_offset )
+        return false;
+
+    // offsets in the segment are 32 bits
+    if ( h.segment_offset > size or h.segment_size > size - h.segment_offset or
+        h.segment_offset % SNAPSHOT_ALIGN or h.segment_size < sizeof(table_flat_t) or
+        h.segment_size > UINT32_MAX or h.num_lists > UINT8_MAX )
+        return false;
+
+    return true;
+}
+
+static bool check_data(const uint8_t* base, const SnapshotHeader& h)
+{
+    uint32_t crc = get_checksum(base + h.lists_offset, h.lists_size, crc32(0, nullptr, 0));
+    crc = get_checksum(base + h.segment_offset, h.segment_size, crc);
+
+    if ( crc != h.checksum )
+        return false;
+
+    SegmentChecker checker(base + h.segment_offset, h.segment_size, h.num_lists);
+    return checker.check();
+}
+
+bool ReputationSnapshot::load(const char* file, const ReputationConfig& config,
+    ReputationData& data)
+{
+    assert(!data.ip_list);
+
+    int fd = open(file, O_RDONLY);
+
+    if ( fd < 0 )
+    {
+        ErrorMessage("reputation: can't open snapshot %s: %s\n", file, get_error(errno));
+        return false;
+    }
+
+    struct stat st;
+
+    if ( fstat(fd, &st) or (size_t)st.st_size < sizeof(SnapshotHeader) )
+    {
+        ErrorMessage("reputation: snapshot %s is truncated\n", file);
+        close(fd);
+        return false;
+    }
+
+    int flags = MAP_PRIVATE;
+
+#ifdef MAP_POPULATE
+    // fault it in here rather than on the packet threads
+    flags |= MAP_POPULATE;
+#endif
+
+    size_t size = st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+    close(fd);
+
+    if ( map == MAP_FAILED )
+    {
+        ErrorMessage("reputation: can't map snapshot %s: %s\n", file, get_error(errno));
+        return false;
+    }
+
+    const uint8_t* base = (const uint8_t*)map;
+    const SnapshotHeader* h = (const SnapshotHeader*)base;
+
+    if ( !check_header(*h, size) or !check_data(base, *h) )
+    {
+        ErrorMessage("reputation: snapshot %s is invalid or from another build\n", file);
+        munmap(map, size);
+        return false;
+    }
+
+    if ( h->memcap != config.memcap or
+        !check_lists(file, base + h->lists_offset, h->lists_size, h->num_lists, data) )
+    {
+        WarningMessage("reputation: snapshot %s is out of date, parsing the lists\n", file);
+        munmap(map, size);
+        return false;
+    }
+
+    data.snapshot = map;
+    data.snapshot_size = size;
+    data.reputation_segment = const_cast<uint8_t*>(base + h->segment_offset);
+    data.segment_used = h->segment_size;
+    data.ip_list = (table_flat_t*)data.reputation_segment;
+    data.num_entries = h->num_entries;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static int64_t update_entry(INFO* current, INFO new_entry, SaveDest, uint8_t*, void*)
+{
+    *current = new_entry;
+    return 0;
+}
+
+namespace
+{
+// a small table with one network from a list file
+struct SnapshotTest
+{
+    SnapshotTest()
+    {
+        strcpy(list_name, "/tmp/reputation_list_XXXXXX");
+        int fd = mkstemp(list_name);
+        REQUIRE(fd >= 0);
+        CHECK(write(fd, "10.1.0.0/16\n", 12) == 12);
+        close(fd);
+
+        strcpy(file, "/tmp/reputation_snapshot_XXXXXX");
+        fd = mkstemp(file);
+        REQUIRE(fd >= 0);
+        close(fd);
+
+        data.num_entries = 2;
+        data.list_files.emplace_back(get_list());
+        REQUIRE(ReputationParser::stat_list_file(
+            *data.list_files[0], data.list_files[0]->file_size, data.list_files[0]->file_mtime));
+
+        size_t size = 1 << 20;
+        data.reputation_segment = (uint8_t*)snort_calloc(size);
+
+        table.segment_meminit(data.reputation_segment, size);
+        table.sfrt_flat_new(DIR_8x16, IPv6, 8, 1);
+        data.ip_list = table.get_table();
+        REQUIRE(data.ip_list);
+
+        SfCidr net;
+        net.set("10.1.0.0/16");
+        info = table.segment_snort_calloc(1, sizeof(IPrepInfo));
+        ((IPrepInfo*)(data.reputation_segment + info))->list_indexes[0] = 1;
+
+        REQUIRE(table.sfrt_flat_insert(&net, (unsigned char)net.get_bits(), info, RT_FAVOR_ALL,
+            update_entry, nullptr) == RT_SUCCESS);
+        data.segment_used = table.segment_used();
+    }
+
+    ~SnapshotTest()
+    {
+        remove(list_name);
+        remove(file);
+    }
+
+    ListFile* get_list() const
+    {
+        ListFile* list = new ListFile;
+        list->file_name = list_name;
+        list->file_type = 2;
+        list->list_id = 7;
+        list->intfs = { 1, 5 };
+        return list;
+    }
+
+    // the configured lists, as the snapshot is loaded
+    void add_lists(ReputationData& copy) const
+    { copy.list_files.emplace_back(get_list()); }
+
+    char list_name[32];
+    char file[32];
+    ReputationConfig config;
+    ReputationData data;
+    RtTable table;
+    MEM_OFFSET info;
+};
+}
+
+TEST_CASE("reputation snapshot", "[reputation]")
+{
+    SnapshotTest t;
+    REQUIRE(ReputationSnapshot::save(t.file, t.config, t.data));
+
+    ReputationData copy;
+    t.add_lists(copy);
+    REQUIRE(ReputationSnapshot::load(t.file, t.config, copy));
+
+    CHECK(copy.snapshot);
+    CHECK(copy.num_entries == 2);
+    CHECK(copy.segment_used == t.data.segment_used);
+
+    REQUIRE(copy.list_files.size() == 1);
+    CHECK(copy.list_files[0]->file_size == 12);
+    CHECK(copy.list_files[0]->file_mtime == t.data.list_files[0]->file_mtime);
+
+    SfIp in, out;
+    in.set("10.1.2.3");
+    out.set("10.2.0.1");
+
+    const uint8_t* rep = (const uint8_t*)sfrt_flat_dir8x_lookup(&in, copy.ip_list);
+    REQUIRE(rep);
+    CHECK(rep - (const uint8_t*)copy.ip_list == t.info);
+    CHECK(!sfrt_flat_dir8x_lookup(&out, copy.ip_list));
+}
+
+TEST_CASE("reputation snapshot out of date", "[reputation]")
+{
+    SnapshotTest t;
+    REQUIRE(ReputationSnapshot::save(t.file, t.config, t.data));
+
+    SECTION("other lists")
+    {
+        ReputationData copy;
+        t.add_lists(copy);
+        copy.list_files[0]->list_id = 8;
+        CHECK(!ReputationSnapshot::load(t.file, t.config, copy));
+        CHECK(!copy.ip_list);
+        CHECK(copy.list_files.size() == 1);
+    }
+    SECTION("more lists")
+    {
+        ReputationData copy;
+        t.add_lists(copy);
+        t.add_lists(copy);
+        CHECK(!ReputationSnapshot::load(t.file, t.config, copy));
+    }
+    SECTION("list changed")
+    {
+        FILE* f = fopen(t.list_name, "a");
+        REQUIRE(f);
+        fputs("10.2.0.0/16\n", f);
+        fclose(f);
+
+        ReputationData copy;
+        t.add_lists(copy);
+        CHECK(!ReputationSnapshot::load(t.file, t.config, copy));
+        CHECK(!copy.ip_list);
+    }
+    SECTION("other memcap")
+    {
+        ReputationConfig config;
+        config.memcap = t.config.memcap + 1;
+
+        ReputationData copy;
+        t.add_lists(copy);
+        CHECK(!ReputationSnapshot::load(t.file, config, copy));
+    }
+}
+
+static bool load_bad_segment(SnapshotTest& t)
+{
+    REQUIRE(ReputationSnapshot::save(t.file, t.config, t.data));
+
+    ReputationData copy;
+    t.add_lists(copy);
+    return ReputationSnapshot::load(t.file, t.config, copy);
+}
+
+TEST_CASE("reputation snapshot corrupt segment", "[reputation]")
+{
+    SnapshotTest t;
+    table_flat_t* table = t.data.ip_list;
+    uint8_t* base = t.data.reputation_segment;
+    const dir_table_flat_t* rt = (const dir_table_flat_t*)(base + table->rt);
+    const dir_sub_table_flat_t* sub = (const dir_sub_table_flat_t*)(base + rt->sub_table);
+    DIR_Entry* entries = (DIR_Entry*)(base + sub->entries);
+    IPrepInfo* info = (IPrepInfo*)(base + t.info);
+
+    // each of these has a valid checksum, so only the segment checks catch them
+    SECTION("table data")
+    {
+        table->data = t.data.segment_used - 4;
+        CHECK(!load_bad_segment(t));
+    }
+    SECTION("routing table")
+    {
+        table->rt6 = t.data.segment_used;
+        CHECK(!load_bad_segment(t));
+    }
+    SECTION("sub table")
+    {
+        entries[0x0a01].value = t.data.segment_used + 64;
+        entries[0x0a01].length = 0;
+        CHECK(!load_bad_segment(t));
+    }
+    SECTION("data index")
+    {
+        entries[0].value = table->max_size;
+        entries[0].length = 8;
+        CHECK(!load_bad_segment(t));
+    }
+    SECTION("list index")
+    {
+        info->list_indexes[1] = 2;
+        CHECK(!load_bad_segment(t));
+    }
+    SECTION("info chain")
+    {
+        info->next = t.info;
+        CHECK(!load_bad_segment(t));
+    }
+    SECTION("valid")
+    {
+        CHECK(load_bad_segment(t));
+    }
+}
+
+TEST_CASE("reputation snapshot checksum", "[reputation]")
+{
+    SnapshotTest t;
+    REQUIRE(ReputationSnapshot::save(t.file, t.config, t.data));
+
+    FILE* f = fopen(t.file, "r+b");
+    REQUIRE(f);
+    fseek(f, -1, SEEK_END);
+    int c = fgetc(f);
+    fseek(f, -1, SEEK_END);
+    fputc(c ^ 1, f);
+    fclose(f);
+
+    ReputationData copy;
+    t.add_lists(copy);
+    CHECK(!ReputationSnapshot::load(t.file, t.config, copy));
+}
+
+TEST_CASE("reputation snapshot invalid", "[reputation]")
+{
+    char file[] = "/tmp/reputation_snapshot_XXXXXX";
+    int fd = mkstemp(file);
+    REQUIRE(fd >= 0);
+
+    char junk[sizeof(SnapshotHeader) * 2] = "SNORTREP";
+    CHECK(write(fd, junk, sizeof(junk)) == sizeof(junk));
+    close(fd);
+
+    ReputationConfig config;
+    ReputationData data;
+    CHECK(!ReputationSnapshot::load(file, config, data));
+    CHECK(!data.ip_list);
+    remove(file);
+}
+
+#endif
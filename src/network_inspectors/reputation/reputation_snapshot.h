@@ -0,0 +1,44 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// reputation_snapshot.h author Cisco
+
+#ifndef REPUTATION_SNAPSHOT_H
+#define REPUTATION_SNAPSHOT_H
+
+// Binary snapshot of the reputation data: the list files from the config or
+// manifest and the flat segment with the IP table built from them.  The
+// segment only holds offsets, so a snapshot is mapped read only and used as
+// is instead of parsing the lists.  snort --dump-reputation-snapshot writes
+// one from the configured lists, so large feeds can be built offline and
+// reloaded in about the time it takes to read the file.
+
+class ReputationData;
+struct ReputationConfig;
+
+class ReputationSnapshot
+{
+public:
+    static bool save(const char* file, const ReputationConfig&, const ReputationData&);
+
+    // data has the configured list files, the snapshot is only used if it
+    // was built from the same files with the same memcap
+    static bool load(const char* file, const ReputationConfig&, ReputationData&);
+};
+
+#endif
+
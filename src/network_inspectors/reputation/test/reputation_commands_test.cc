@@ -0,0 +1,191 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// reputation_commands_test.cc author Cisco
+// unit test main
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/reputation/reputation_commands.h"
+
+#include "control/control.h"
+#include "main/analyzer_command.h"
+#include "managers/inspector_manager.h"
+#include "network_inspectors/reputation/reputation_inspect.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// the main and packet thread sides of a broadcast as in main.cc and
+// analyzer.cc: the main reload id is bumped when the command is broadcast
+// and each packet thread takes it before executing the command
+//-------------------------------------------------------------------------
+
+static unsigned main_reload_id = 1;
+static unsigned thread_reload_id = 1;
+
+static unsigned broadcasts = 0;
+static unsigned published = 0;
+static unsigned published_reload_id = 0;
+static int global_refs = 0;
+
+static ReputationData* loaded = reinterpret_cast<ReputationData*>(0x1000);
+static ReputationData* current = nullptr;
+
+void snort::main_broadcast_command(AnalyzerCommand* ac, ControlConn*)
+{
+    ++broadcasts;
+
+    if ( ac->need_update_reload_id() )
+    {
+        ++main_reload_id;
+        thread_reload_id = main_reload_id;
+    }
+
+    // the command doesn't use the analyzer
+    static uint64_t analyzer;
+    void* state = nullptr;
+    CHECK(ac->execute(*reinterpret_cast<Analyzer*>(&analyzer), &state));
+    delete ac;
+}
+
+void AnalyzerCommand::log_message(ControlConn*, const char*, va_list&) { }
+void AnalyzerCommand::log_message(ControlConn*, const char*, ...) { }
+void AnalyzerCommand::log_message(const char*, ...) { }
+
+ControlConn* ControlConn::query_from_lua(const lua_State*) { return nullptr; }
+
+//-------------------------------------------------------------------------
+// inspector stubs
+//-------------------------------------------------------------------------
+
+namespace snort
+{
+Inspector::Inspector() : ref_count(nullptr)
+{ set_api(nullptr); }
+
+Inspector::~Inspector() = default;
+bool Inspector::likes(Packet*) { return true; }
+bool Inspector::get_buf(const char*, Packet*, InspectionBuffer&) { return true; }
+class StreamSplitter* Inspector::get_splitter(bool) { return nullptr; }
+void Inspector::add_global_ref() { ++global_refs; }
+void Inspector::rem_global_ref() { --global_refs; }
+}
+
+static ReputationConfig rep_config;
+static Reputation* rep_inspector = nullptr;
+
+Inspector* InspectorManager::get_inspector(const char*, bool, const SnortConfig*)
+{ return rep_inspector; }
+
+Reputation::Reputation(ReputationConfig* pc) : config(*pc)
+{ rep_data = nullptr; }
+
+Reputation::~Reputation() = default;
+void Reputation::show(const SnortConfig*) const { }
+bool Reputation::configure(SnortConfig*) { return true; }
+
+ReputationData* Reputation::load_data()
+{ return loaded; }
+
+void Reputation::publish_data(ReputationData* data)
+{
+    ++published;
+    published_reload_id = thread_reload_id;
+    current = data;
+}
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+static void reload()
+{
+    const Command& cmd = reputation_cmds[0];
+    STRCMP_EQUAL("reload", cmd.name);
+    cmd.func(nullptr);
+}
+
+TEST_GROUP(reputation_reload)
+{
+    void setup() override
+    {
+        broadcasts = published = published_reload_id = 0;
+        global_refs = 0;
+        current = nullptr;
+        rep_inspector = new Reputation(&rep_config);
+    }
+
+    void teardown() override
+    {
+        delete rep_inspector;
+        rep_inspector = nullptr;
+    }
+};
+
+TEST(reputation_reload, publishes_and_updates_reload_id)
+{
+    unsigned before = thread_reload_id;
+
+    reload();
+
+    UNSIGNED_LONGS_EQUAL(1, broadcasts);
+    UNSIGNED_LONGS_EQUAL(1, published);
+    POINTERS_EQUAL(loaded, current);
+    CHECK(thread_reload_id != before);
+    LONGS_EQUAL(0, global_refs);
+}
+
+// flows are only checked again by FLOW_STATE_RELOADED when their reload id
+// differs from the thread's, and that must see the new data
+TEST(reputation_reload, flow_set_up_before_reload_is_reevaluated)
+{
+    unsigned flow_reload_id = thread_reload_id;
+    CHECK(flow_reload_id == thread_reload_id);
+
+    reload();
+
+    CHECK(flow_reload_id != thread_reload_id);
+    CHECK(published_reload_id == flow_reload_id);
+    POINTERS_EQUAL(loaded, current);
+
+    // a flow set up after the reload is not checked again
+    flow_reload_id = thread_reload_id;
+    CHECK(flow_reload_id == thread_reload_id);
+}
+
+TEST(reputation_reload, no_inspector)
+{
+    delete rep_inspector;
+    rep_inspector = nullptr;
+
+    reload();
+
+    UNSIGNED_LONGS_EQUAL(0, broadcasts);
+    UNSIGNED_LONGS_EQUAL(0, published);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
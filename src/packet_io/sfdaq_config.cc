@@ -65,6 +65,7 @@ void SFDAQModuleConfig::set_variable(const char* varkvp)
 SFDAQConfig::SFDAQConfig()
 {
     batch_size = BATCH_SIZE_UNSET;
+    adaptive_batch = false;
     mru_size = SNAPLEN_UNSET;
     timeout = TIMEOUT_DEFAULT;
 }
@@ -125,6 +126,8 @@ void SFDAQConfig::overlay(const SFDAQConfig* other)
 
     if (other->batch_size != BATCH_SIZE_UNSET)
         batch_size = other->batch_size;
+    if (other->adaptive_batch)
+        adaptive_batch = true;
     if (other->mru_size != SNAPLEN_UNSET)
         mru_size = other->mru_size;
     timeout = other->timeout;
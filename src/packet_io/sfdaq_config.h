@@ -70,6 +70,7 @@ struct SFDAQConfig
     /* Instance configuration */
     std::vector<std::string> inputs;
     uint32_t batch_size;
+    bool adaptive_batch;
     int mru_size;
     unsigned int timeout;
     std::vector<SFDAQModuleConfig*> module_configs;
@@ -43,6 +43,7 @@ SFDAQInstance::SFDAQInstance(const char* input, unsigned id, const SFDAQConfig*
     // The Snort instance ID is 0-based while the DAQ ID is 1-based, so adjust accordingly.
     instance_id = id + 1;
     batch_size = cfg->get_batch_size();
+    adaptive_batch = cfg->adaptive_batch;
     daq_msgs = new DAQ_Msg_h[batch_size];
 }
 
@@ -198,6 +199,17 @@ DAQ_RecvStatus SFDAQInstance::receive_messages(unsigned max_recv)
     return rstat;
 }
 
+// Touch the headers and data of the messages left in the batch so they are
+// in cache by the time each one is processed.
+void SFDAQInstance::prefetch_messages() const
+{
+    for (unsigned i = curr_batch_idx; i < curr_batch_size; i++)
+    {
+        __builtin_prefetch(daq_msg_get_hdr(daq_msgs[i]));
+        __builtin_prefetch(daq_msg_get_data(daq_msgs[i]));
+    }
+}
+
 int SFDAQInstance::finalize_message(DAQ_Msg_h msg, DAQ_Verdict verdict)
 {
     int rval = daq_instance_msg_finalize(instance, msg, verdict);
@@ -56,11 +56,14 @@ public:
             return daq_msgs[curr_batch_idx++];
         return nullptr;
     }
+    void prefetch_messages() const;
+    unsigned get_batch_count() const { return curr_batch_size; }
     int finalize_message(DAQ_Msg_h msg, DAQ_Verdict verdict);
     const char* get_error();
 
     int get_base_protocol() const;
     uint32_t get_batch_size() const { return batch_size; }
+    bool get_adaptive_batch() const { return adaptive_batch; }
     uint32_t get_pool_available() const { return pool_available; }
     const char* get_input_spec() const;
     const DAQ_Stats_t* get_stats();
@@ -93,6 +96,7 @@ private:
     unsigned curr_batch_size = 0;
     unsigned curr_batch_idx = 0;
     uint32_t batch_size;
+    bool adaptive_batch;
     uint32_t pool_size = 0;
     uint32_t pool_available = 0;
     int dlt = -1;
@@ -78,6 +78,7 @@ static const Parameter s_params[] =
     { "inputs", Parameter::PT_LIST, input_list_param, nullptr, "input sources" },
     { "snaplen", Parameter::PT_INT, "0:65535", "1518", "set snap length (same as -s)" },
     { "batch_size", Parameter::PT_INT, "1:", "64", "set receive batch size (same as --daq-batch-size)" },
+    { "adaptive_batch", Parameter::PT_BOOL, nullptr, "false", "grow the receive batch up to batch_size under load and shrink it when idle" },
     { "modules", Parameter::PT_LIST, daq_module_param, nullptr, "DAQ modules to use" },
 
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
@@ -122,6 +123,10 @@ bool SFDAQModule::set(const char* fqn, Value& v, SnortConfig*)
     {
         config->set_batch_size(v.get_uint32());
     }
+    else if (!strcmp(fqn, "daq.adaptive_batch"))
+    {
+        config->adaptive_batch = v.get_bool();
+    }
     else if (!strcmp(fqn, "daq.modules.name"))
     {
         module_config->name = v.get_string();
@@ -206,6 +211,21 @@ const PegInfo daq_names[] =
     { CountType::SUM, "sof_messages", "start of flow messages received from DAQ" },
     { CountType::SUM, "eof_messages", "end of flow messages received from DAQ" },
     { CountType::SUM, "other_messages", "messages received from DAQ with unrecognized message type" },
+    { CountType::SUM, "batches", "receive calls returning messages" },
+    { CountType::NOW, "batch_size", "current receive batch size" },
+    { CountType::MAX, "batch_size_max", "largest batch received" },
+    { CountType::SUM, "batches_full", "batches filled up to the batch size" },
+    { CountType::SUM, "batch_grows", "adaptive batch size increases" },
+    { CountType::SUM, "batch_shrinks", "adaptive batch size decreases" },
+    { CountType::SUM, "receive_usecs", "time spent receiving batches from DAQ in microseconds" },
+    { CountType::SUM, "process_usecs", "time spent processing received batches in microseconds" },
+    { CountType::SUM, "reload_prepare_usecs", "time spent preparing for new configs in microseconds" },
+    { CountType::SUM, "reload_swap_usecs", "time spent swapping to new configs in microseconds" },
+    { CountType::MAX, "reload_stall_max", "longest time a reload step held up packets in microseconds" },
+    { CountType::SUM, "reload_stalls_lt_100us", "reload steps holding up packets less than 100 usecs" },
+    { CountType::SUM, "reload_stalls_lt_1ms", "reload steps holding up packets 100 usecs to 1 msec" },
+    { CountType::SUM, "reload_stalls_lt_10ms", "reload steps holding up packets 1 to 10 msecs" },
+    { CountType::SUM, "reload_stalls_ge_10ms", "reload steps holding up packets 10 msecs or more" },
     { CountType::END, nullptr, nullptr }
 };
 
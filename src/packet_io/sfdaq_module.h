@@ -79,6 +79,21 @@ struct DAQStats
     PegCount sof_messages;
     PegCount eof_messages;
     PegCount other_messages;
+    PegCount batches;
+    PegCount batch_size;
+    PegCount batch_size_max;
+    PegCount batches_full;
+    PegCount batch_grows;
+    PegCount batch_shrinks;
+    PegCount receive_usecs;
+    PegCount process_usecs;
+    PegCount reload_prepare_usecs;
+    PegCount reload_swap_usecs;
+    PegCount reload_stall_max;
+    PegCount reload_stalls_lt_100us;
+    PegCount reload_stalls_lt_1ms;
+    PegCount reload_stalls_lt_10ms;
+    PegCount reload_stalls_ge_10ms;
 };
 
 extern THREAD_LOCAL DAQStats daq_stats;
@@ -87,6 +87,7 @@ class SFDAQInstance;
 #define PKT_TCP_PSEUDO_EST        0x80000000 // A one-sided or bidirectional without LWS TCP session was detected
 
 #define TS_PKT_OFFLOADED          0x01
+#define TS_PKT_CKSUM_CURRENT      0x02  // modifications so far updated the checksums
 
 #define PKT_PDU_FULL (PKT_PDU_HEAD | PKT_PDU_TAIL)
 
@@ -324,6 +325,18 @@ struct SO_PUBLIC Packet
     void clear_offloaded()
     { ts_packet_flags &= (~TS_PKT_OFFLOADED); }
 
+    // set when header rewrites updated the checksums incrementally so that
+    // encode_update() need not recompute them; anything else modifying
+    // the packet must clear it
+    bool cksums_current() const
+    { return (ts_packet_flags & TS_PKT_CKSUM_CURRENT) != 0; }
+
+    void set_cksums_current()
+    { ts_packet_flags |= TS_PKT_CKSUM_CURRENT; }
+
+    void clear_cksums_current()
+    { ts_packet_flags &= (~TS_PKT_CKSUM_CURRENT); }
+
     bool has_parent() const
     { return (packet_flags & PKT_HAS_PARENT) != 0; }
 
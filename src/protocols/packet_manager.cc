@@ -835,6 +835,10 @@ static inline void add_flag(
 
 void PacketManager::encode_update(Packet* p)
 {
+    // header rewrites already updated the checksums and the lengths are unchanged
+    if ( p->cksums_current() and !(p->packet_flags & PKT_RESIZED) )
+        return;
+
     uint32_t len = p->dsize;
 
     UpdateFlags flags = 0;
@@ -39,6 +39,7 @@ struct IntrinsicEventIds
     DETAINED_PACKET,
     FINALIZE_PACKET,
     RETRY_PACKET,
+    WIRE_PACKET,          // global subscribers only
 
     THREAD_IDLE,
     THREAD_ROTATE,
@@ -32,6 +32,7 @@
 #include "framework/mpse_batch.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "main/thread_config.h"
 #include "managers/mpse_manager.h"
 #include "search_engines/pat_stats.h"
 #include "utils/stats.h"
@@ -73,6 +74,9 @@ void SnortConfig::release_scratch(int)
     s_state.shrink_to_fit();
 }
 
+ThreadMemPlacement::ThreadMemPlacement(const ThreadConfig*, SThreadType, unsigned) { }
+ThreadMemPlacement::~ThreadMemPlacement() = default;
+
 DataBus::DataBus() = default;
 DataBus::~DataBus() = default;
 
@@ -51,7 +51,8 @@ enum HTTP2_BUFFER { HTTP2_BUFFER_FRAME_HEADER = 1, HTTP2_BUFFER_DECODED_HEADER,
 // This enum must remain synchronized with Http2Module::peg_names[] in http2_tables.cc
 enum PEG_COUNT { PEG_FLOW = 0, PEG_CONCURRENT_SESSIONS, PEG_MAX_CONCURRENT_SESSIONS,
     PEG_MAX_TABLE_ENTRIES, PEG_MAX_CONCURRENT_FILES, PEG_TOTAL_BYTES, PEG_MAX_CONCURRENT_STREAMS,
-    PEG_FLOWS_OVER_STREAM_LIMIT, PEG_COUNT__MAX };
+    PEG_FLOWS_OVER_STREAM_LIMIT, PEG_BYTES_IN_USE, PEG_MAX_BYTES_IN_USE, PEG_STREAMS_EVICTED,
+    PEG_FLOWS_OVER_MEMCAP, PEG_COUNT__MAX };
 
 enum EventSid
 {
@@ -163,6 +164,7 @@ enum Infraction
     INF_BAD_GOAWAY_FRAME_R_BIT = 54,
     INF_SETTINGS_QUEUE_OVERFLOW = 55,
     INF_SETTINGS_QUEUE_UNDERFLOW = 56,
+    INF_MEMCAP_EXCEEDED = 57,
     INF__MAX_VALUE
 };
 
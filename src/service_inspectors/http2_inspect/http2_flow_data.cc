@@ -24,6 +24,7 @@
 #include "http2_flow_data.h"
 
 #include "main/snort_types.h"
+#include "service_inspectors/http_inspect/http_flow_data.h"
 #include "service_inspectors/http_inspect/http_inspect.h"
 #include "service_inspectors/http_inspect/http_msg_section.h"
 #include "service_inspectors/http_inspect/http_test_manager.h"
@@ -41,6 +42,18 @@ using namespace HttpCommon;
 
 unsigned Http2FlowData::inspector_id = 0;
 
+// Memory charged against the memcap for each stream, including the list node that holds it.
+// The http_inspect flow data of a stream is charged separately once there is one.
+static const size_t STREAM_MEMORY = sizeof(Http2Stream) + 2 * sizeof(void*);
+
+// Memory charged for remembering an evicted stream id: the hash node and its bucket
+static const size_t EVICTED_ID_MEMORY = sizeof(uint32_t) + 2 * sizeof(void*);
+
+static size_t stream_memory(const Http2Stream& stream)
+{
+    return STREAM_MEMORY + ((stream.get_hi_flow_data() != nullptr) ? sizeof(HttpFlowData) : 0);
+}
+
 #ifdef REG_TEST
 uint64_t Http2FlowData::instance_count = 0;
 #endif
@@ -76,6 +89,8 @@ Http2FlowData::Http2FlowData(Flow* flow_) :
         Http2Module::get_peg_counts(PEG_CONCURRENT_SESSIONS))
         Http2Module::increment_peg_counts(PEG_MAX_CONCURRENT_SESSIONS);
 
+    update_allocations(sizeof(*this));
+
     flow->stream_intf = &h2_stream;
 }
 
@@ -92,11 +107,14 @@ Http2FlowData::~Http2FlowData()
     if (Http2Module::get_peg_counts(PEG_CONCURRENT_SESSIONS) > 0)
         Http2Module::decrement_peg_counts(PEG_CONCURRENT_SESSIONS);
 
+    update_deallocations(memory_in_use);
+
     for (int k=0; k <= 1; k++)
     {
         delete infractions[k];
         delete events[k];
-        hi_ss[k]->go_away();
+        if (hi_ss[k] != nullptr)
+            hi_ss[k]->go_away();
         delete[] frame_data[k];
     }
 
@@ -124,12 +142,17 @@ Http2Stream* Http2FlowData::find_stream(const uint32_t key)
     return (it != streams.end()) ? &(*it) : nullptr;
 }
 
-Http2Stream* Http2FlowData::get_processing_stream(const SourceId source_id, uint32_t concurrent_streams_limit)
+Http2Stream* Http2FlowData::get_processing_stream(const SourceId source_id,
+    uint32_t concurrent_streams_limit, size_t memcap)
 {
     const uint32_t key = processing_stream_id;
     class Http2Stream* stream = find_stream(key);
     if (!stream)
     {
+        // Frames for streams evicted under memory pressure are not inspected
+        if (evicted_streams.count(key) != 0)
+            return nullptr;
+
         if (concurrent_streams >= concurrent_streams_limit)
         {
             *infractions[source_id] += INF_TOO_MANY_STREAMS;
@@ -174,9 +197,21 @@ Http2Stream* Http2FlowData::get_processing_stream(const SourceId source_id, uint
             }
         }
 
+        // stream 0 is needed to keep the connection in sync and is never refused for memory
+        if ((key > 0) && (memcap > 0) && !evict_streams(memcap))
+        {
+            *infractions[source_id] += INF_MEMCAP_EXCEEDED;
+            events[source_id]->create_event(EVENT_LOSS_OF_SYNC);
+            Http2Module::increment_peg_counts(PEG_FLOWS_OVER_MEMCAP);
+            abort_flow[SRC_CLIENT] = true;
+            abort_flow[SRC_SERVER] = true;
+            return nullptr;
+        }
+
         // Allocate new stream
         streams.emplace_front(key, this);
         stream = &streams.front();
+        update_allocations(STREAM_MEMORY);
 
         // stream 0 does not count against stream limit
         if (key > 0)
@@ -197,7 +232,9 @@ void Http2FlowData::delete_processing_stream()
     {
         if (it->get_stream_id() == processing_stream_id)
         {
+            const size_t freed = stream_memory(*it);
             streams.erase(it);
+            update_deallocations(freed);
             delete_stream = false;
             assert(concurrent_streams > 0);
             concurrent_streams -= 1;
@@ -207,6 +244,67 @@ void Http2FlowData::delete_processing_stream()
     assert(false);
 }
 
+// Make room for a new stream. The memcap is for the whole packet thread but a flow only evicts its
+// own streams, so once the thread is over the memcap a flow using more than its share (the memcap
+// divided among the current HTTP/2 flows) evicts its oldest streams until it is back within its
+// share. A flow within its share is not made to pay for the others. Streams that are currently
+// being scanned or have a frame in detection are left alone. Returns false if the flow is still
+// over its share.
+bool Http2FlowData::evict_streams(size_t memcap)
+{
+    const PegCount flows = std::max<PegCount>(
+        Http2Module::get_peg_counts(PEG_CONCURRENT_SESSIONS), 1);
+    const size_t share = memcap / flows;
+
+    auto it = streams.end();
+    while ((Http2Module::get_peg_counts(PEG_BYTES_IN_USE) + STREAM_MEMORY > memcap) &&
+        (memory_in_use + STREAM_MEMORY > share))
+    {
+        if (it == streams.begin())
+            return false;
+        --it;
+
+        const uint32_t key = it->get_stream_id();
+        if ((key == 0) || (key == stream_in_hi) || (key == current_stream[SRC_CLIENT]) ||
+            (key == current_stream[SRC_SERVER]) || (it->get_current_frame() != nullptr))
+            continue;
+
+        const size_t freed = stream_memory(*it);
+        it = streams.erase(it);
+        update_deallocations(freed);
+        assert(concurrent_streams > 0);
+        concurrent_streams -= 1;
+        evicted_streams.insert(key);
+        update_allocations(EVICTED_ID_MEMORY);
+        Http2Module::increment_peg_counts(PEG_STREAMS_EVICTED);
+    }
+    return true;
+}
+
+void Http2FlowData::release_frame_buffer(const SourceId source_id)
+{
+    update_deallocations(frame_buffer_size[source_id]);
+    frame_buffer_size[source_id] = 0;
+}
+
+void Http2FlowData::update_allocations(size_t size)
+{
+    memory_in_use += size;
+    Http2Module::increment_peg_counts(PEG_BYTES_IN_USE, size);
+    const PegCount in_use = Http2Module::get_peg_counts(PEG_BYTES_IN_USE);
+    if (in_use > Http2Module::get_peg_counts(PEG_MAX_BYTES_IN_USE))
+        Http2Module::increment_peg_counts(PEG_MAX_BYTES_IN_USE,
+            in_use - Http2Module::get_peg_counts(PEG_MAX_BYTES_IN_USE));
+}
+
+void Http2FlowData::update_deallocations(size_t size)
+{
+    assert(size <= memory_in_use);
+    assert(size <= Http2Module::get_peg_counts(PEG_BYTES_IN_USE));
+    memory_in_use -= size;
+    Http2Module::decrement_peg_counts(PEG_BYTES_IN_USE, size);
+}
+
 Http2Stream* Http2FlowData::get_hi_stream()
 {
     return find_stream(stream_in_hi);
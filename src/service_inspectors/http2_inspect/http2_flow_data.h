@@ -21,6 +21,7 @@
 #define HTTP2_FLOW_DATA_H
 
 #include <queue>
+#include <unordered_set>
 #include <vector>
 
 #include "main/snort_types.h"
@@ -88,7 +89,8 @@ public:
 
     Http2Stream* find_current_stream(const HttpCommon::SourceId source_id);
     uint32_t get_current_stream_id(const HttpCommon::SourceId source_id) const;
-    Http2Stream* get_processing_stream(const HttpCommon::SourceId source_id, uint32_t concurrent_streams_limit);
+    Http2Stream* get_processing_stream(const HttpCommon::SourceId source_id,
+        uint32_t concurrent_streams_limit, size_t memcap);
     Http2Stream* find_processing_stream();
     uint32_t get_processing_stream_id() const;
     void set_processing_stream_id(const HttpCommon::SourceId source_id);
@@ -113,6 +115,12 @@ public:
     void set_server_settings_received()
     { server_settings_frame_received = true; }
 
+    // Memory accounting for streams and their http_inspect flow data, HPACK dynamic tables and
+    // frame buffers. Everything still charged to a flow is released when the flow data is
+    // deleted.
+    void update_allocations(size_t size);
+    void update_deallocations(size_t size);
+
 #ifdef UNIT_TEST
     void set_mid_frame(bool); // Not implemented outside of unit tests
 #endif
@@ -158,6 +166,8 @@ protected:
     uint32_t max_stream_id[2] = {0, 0};
     bool frame_in_detection = false;
     bool delete_stream = false;
+    size_t memory_in_use = 0;
+    std::unordered_set<uint32_t> evicted_streams;
 
     // Internal to scan()
     bool preface[2] = { true, false };
@@ -195,6 +205,7 @@ protected:
     bool continuation_frame[2] = { false, false };
     bool read_padding_len[2] = { false, false };
     uint8_t* frame_reassemble[2] = { nullptr, nullptr };
+    uint32_t frame_buffer_size[2] = { 0, 0 };
 
 #ifdef REG_TEST
     static uint64_t instance_count;
@@ -205,6 +216,8 @@ private:
     Http2Stream* get_hi_stream();
     Http2Stream* find_stream(const uint32_t key);
     void delete_processing_stream();
+    bool evict_streams(size_t memcap);
+    void release_frame_buffer(HttpCommon::SourceId source_id);
 };
 
 class Http2FlowStreamIntf : public snort::StreamFlowIntf
@@ -26,6 +26,7 @@
 
 #include <cstring>
 
+#include "http2_flow_data.h"
 #include "http2_hpack_table.h"
 
 using namespace Http2Enums;
@@ -67,6 +68,7 @@ bool HpackDynamicTable::add_entry(const Field& name, const Field& value)
     circular_buf[start] = new_entry;
 
     num_entries++;
+    session_data->update_allocations(entry_memory(new_entry));
     if (num_entries > Http2Module::get_peg_counts(PEG_MAX_TABLE_ENTRIES))
         Http2Module::increment_peg_counts(PEG_MAX_TABLE_ENTRIES);
 
@@ -99,6 +101,7 @@ void HpackDynamicTable::prune_to_size(uint32_t new_max_size)
         num_entries--;
         rfc_table_size -= circular_buf[last_index]->name.length() +
             circular_buf[last_index]->value.length() + RFC_ENTRY_OVERHEAD;
+        session_data->update_deallocations(entry_memory(circular_buf[last_index]));
         delete circular_buf[last_index];
         circular_buf[last_index] = nullptr;
     }
@@ -112,3 +115,8 @@ void HpackDynamicTable::update_size(uint32_t new_size)
     }
     max_size = new_size;
 }
+
+size_t HpackDynamicTable::entry_memory(const HpackTableEntry* entry)
+{
+    return sizeof(HpackTableEntry) + entry->name.length() + entry->value.length();
+}
@@ -34,7 +34,8 @@ class HpackDynamicTable
 {
 public:
     // FIXIT-P This array can be optimized to start smaller and grow on demand
-    HpackDynamicTable() : circular_buf(ARRAY_CAPACITY, nullptr) {}
+    HpackDynamicTable(Http2FlowData* flow_data) :
+        session_data(flow_data), circular_buf(ARRAY_CAPACITY, nullptr) {}
     ~HpackDynamicTable();
     const HpackTableEntry* get_entry(uint32_t index) const;
     bool add_entry(const Field& name, const Field& value);
@@ -46,6 +47,7 @@ private:
 
     const static uint32_t DEFAULT_MAX_SIZE = 4096;
     const static uint32_t ARRAY_CAPACITY = 512;
+    Http2FlowData* const session_data;
     uint32_t max_size = DEFAULT_MAX_SIZE;
 
     uint32_t start = 0;
@@ -54,5 +56,6 @@ private:
     std::vector<HpackTableEntry*> circular_buf;
 
     void prune_to_size(uint32_t new_max_size);
+    static size_t entry_memory(const HpackTableEntry* entry);
 };
 #endif
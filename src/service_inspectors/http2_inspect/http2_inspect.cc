@@ -126,12 +126,13 @@ void Http2Inspect::eval(Packet* p)
 
     session_data->set_processing_stream_id(source_id);
     Http2Stream* const stream = session_data->get_processing_stream(source_id,
-        params->concurrent_streams_limit);
+        params->concurrent_streams_limit, params->memcap);
     if (!stream)
     {
         delete[] session_data->frame_data[source_id];
         session_data->frame_data[source_id] = nullptr;
         session_data->frame_data_size[source_id] = 0;
+        session_data->release_frame_buffer(source_id);
         session_data->processing_stream_id = NO_STREAM_ID;
         return;
     }
@@ -193,6 +194,7 @@ void Http2Inspect::clear(Packet* p)
     Http2Stream* stream = session_data->find_processing_stream();
     assert(stream != nullptr);
     stream->clear_frame(p);
+    session_data->release_frame_buffer(p->is_from_client() ? SRC_CLIENT : SRC_SERVER);
     if (session_data->delete_stream)
         session_data->delete_processing_stream();
     session_data->stream_in_hi = NO_STREAM_ID;
@@ -205,6 +207,7 @@ void Http2Inspect::show(const SnortConfig*) const
 {
     assert(params);
     ConfigLogger::log_value("concurrent_streams_limit", params->concurrent_streams_limit);
+    ConfigLogger::log_limit("memcap", params->memcap, 0u);
 }
 
 #ifdef REG_TEST
@@ -30,6 +30,10 @@ const Parameter Http2Module::http2_params[] =
 {
     { "concurrent_streams_limit", Parameter::PT_INT, "100:1000", "100",
       "Maximum number of concurrent streams allowed in a single HTTP/2 flow" },
+
+    { "memcap", Parameter::PT_INT, "0:maxSZ", "0",
+      "maximum bytes of HTTP/2 stream, HPACK table and frame buffer memory per packet thread "
+      "(0 is unlimited)" },
 #ifdef REG_TEST
     { "test_input", Parameter::PT_BOOL, nullptr, "false",
       "read HTTP/2 messages from text file" },
@@ -61,6 +65,10 @@ bool Http2Module::set(const char*, Value& val, SnortConfig*)
     {
         params->concurrent_streams_limit = val.get_uint32();
     }
+    else if (val.is("memcap"))
+    {
+        params->memcap = val.get_size();
+    }
 #ifdef REG_TEST
     else if (val.is("test_input"))
     {
@@ -35,6 +35,7 @@ struct Http2ParaList
 {
 public:
     uint32_t concurrent_streams_limit;
+    size_t memcap;
 #ifdef REG_TEST
 
     bool test_input;
@@ -67,6 +68,8 @@ public:
         { peg_counts[counter] += value; }
     static void decrement_peg_counts(Http2Enums::PEG_COUNT counter)
         { peg_counts[counter]--; }
+    static void decrement_peg_counts(Http2Enums::PEG_COUNT counter, uint64_t value)
+        { peg_counts[counter] -= value; }
     static PegCount get_peg_counts(Http2Enums::PEG_COUNT counter)
         { return peg_counts[counter]; }
 
@@ -75,6 +75,7 @@ void Http2Stream::check_and_cleanup_completed()
         {
             delete hi_flow_data;
             hi_flow_data = nullptr;
+            session_data->update_deallocations(sizeof(HttpFlowData));
         }
         session_data->delete_stream = true;
     }
@@ -103,6 +104,7 @@ void Http2Stream::set_hi_flow_data(HttpFlowData* flow_data)
 {
     assert(hi_flow_data == nullptr);
     hi_flow_data = flow_data;
+    session_data->update_allocations(sizeof(HttpFlowData));
 }
 
 const Field& Http2Stream::get_buf(unsigned id)
@@ -369,8 +369,13 @@ const StreamBuffer Http2StreamSplitter::implement_reassemble(Http2FlowData* sess
             session_data->frame_data_size[source_id] =
                 total - (session_data->frame_lengths[source_id].size() * FRAME_HEADER_LENGTH);
             if (session_data->frame_data_size[source_id] > 0)
+            {
                 session_data->frame_reassemble[source_id] = new uint8_t[
                     session_data->frame_data_size[source_id]];
+                session_data->frame_buffer_size[source_id] +=
+                    session_data->frame_data_size[source_id];
+                session_data->update_allocations(session_data->frame_data_size[source_id]);
+            }
 
             session_data->frame_data_offset[source_id] = 0;
             session_data->remaining_frame_octets[source_id] = 0;
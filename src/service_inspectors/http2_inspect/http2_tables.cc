@@ -90,6 +90,10 @@ const PegInfo Http2Module::peg_names[PEG_COUNT__MAX+1] =
     { CountType::SUM, "total_bytes", "total HTTP/2 data bytes inspected" },
     { CountType::MAX, "max_concurrent_streams", "maximum concurrent streams per HTTP/2 connection" },
     { CountType::SUM, "flows_over_stream_limit", "HTTP/2 flows exceeding 100 concurrent streams" },
+    { CountType::NOW, "bytes_in_use", "HTTP/2 stream, HPACK table and frame buffer memory in use" },
+    { CountType::MAX, "max_bytes_in_use", "maximum HTTP/2 memory in use" },
+    { CountType::SUM, "streams_evicted", "HTTP/2 streams evicted to stay under the memcap" },
+    { CountType::SUM, "flows_over_memcap", "HTTP/2 flows aborted because the memcap was reached" },
     { CountType::END, nullptr, nullptr }
 };
 
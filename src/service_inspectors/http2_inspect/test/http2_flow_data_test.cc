@@ -0,0 +1,225 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http2_flow_data_test.cc author Cisco
+// unit test main
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "service_inspectors/http2_inspect/http2_flow_data.h"
+#include "service_inspectors/http2_inspect/http2_module.h"
+#include "service_inspectors/http2_inspect/http2_push_promise_frame.h"
+#include "service_inspectors/http_inspect/http_flow_data.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+#include <CppUTestExt/MockSupport.h>
+
+using namespace snort;
+using namespace HttpCommon;
+using namespace Http2Enums;
+
+namespace snort
+{
+// Stubs whose sole purpose is to make the test code link
+FlowData::FlowData(unsigned, Inspector*) : next(nullptr), prev(nullptr), handler(nullptr), id(0)
+{}
+FlowData::~FlowData() = default;
+int DetectionEngine::queue_event(unsigned int, unsigned int) { return 0; }
+FlowData* Flow::get_flow_data(uint32_t) const { return nullptr; }
+Flow::~Flow() = default;
+}
+
+const Field Field::FIELD_NULL { STAT_NO_SOURCE };
+Http2DataCutter::Http2DataCutter(Http2FlowData* flow_data, SourceId src_id) :
+    session_data(flow_data), source_id(src_id) {}
+HpackDynamicTable::~HpackDynamicTable() = default;
+uint32_t Http2PushPromiseFrame::get_promised_stream_id(Http2EventGen*, Http2Infractions*,
+    const uint8_t*, const uint32_t) { return NO_STREAM_ID; }
+Http2Frame* Http2Frame::new_frame(const uint8_t*, const uint32_t, const uint8_t*, const uint32_t,
+    Http2FlowData*, SourceId, Http2Stream*) { return nullptr; }
+void HttpFlowData::finish_hx_body(SourceId, HXBodyState, bool) {}
+
+THREAD_LOCAL PegCount Http2Module::peg_counts[PEG_COUNT__MAX] = { };
+
+// Stands in for the http_inspect flow data a stream owns; only its size is charged
+class HiFlowData : public FlowData
+{
+public:
+    HiFlowData() : FlowData(0) {}
+};
+
+static const size_t STREAM_SIZE = sizeof(Http2Stream) + 2 * sizeof(void*);
+static const uint32_t STREAM_LIMIT = 1000;
+
+class Http2FlowDataTest : public Http2FlowData
+{
+public:
+    Http2FlowDataTest(Flow* flow_, size_t memcap_) : Http2FlowData(flow_), memcap(memcap_) {}
+
+    // A client HEADERS frame on a stream
+    Http2Stream* headers(uint32_t stream_id)
+    {
+        current_stream[SRC_CLIENT] = stream_id;
+        frame_type[SRC_CLIENT] = FT_HEADERS;
+        set_processing_stream_id(SRC_CLIENT);
+        Http2Stream* const stream = get_processing_stream(SRC_CLIENT, STREAM_LIMIT, memcap);
+        processing_stream_id = NO_STREAM_ID;
+        current_stream[SRC_CLIENT] = NO_STREAM_ID;
+        return stream;
+    }
+
+    bool invalid_stream_id() const
+    { return *infractions[SRC_CLIENT] & Http2Infractions(INF_INVALID_STREAM_ID); }
+
+    size_t memory() const { return memory_in_use; }
+    uint32_t stream_count() const { return concurrent_streams; }
+
+    bool aborted() const
+    { return abort_flow[SRC_CLIENT] and abort_flow[SRC_SERVER]; }
+
+    size_t memcap;
+};
+
+static PegCount in_use()
+{ return Http2Module::get_peg_counts(PEG_BYTES_IN_USE); }
+
+TEST_GROUP(http2_memcap)
+{
+    Flow* const flow = new Flow;
+
+    void setup() override
+    {
+        for (int peg = 0; peg < PEG_COUNT__MAX; peg++)
+            Http2Module::decrement_peg_counts((PEG_COUNT)peg,
+                Http2Module::get_peg_counts((PEG_COUNT)peg));
+    }
+
+    void teardown() override
+    {
+        delete flow;
+        LONGS_EQUAL(0, in_use());
+    }
+};
+
+TEST(http2_memcap, accounting)
+{
+    Http2FlowDataTest* const fd = new Http2FlowDataTest(flow, 0);
+    const PegCount base = in_use();
+    CHECK(base >= sizeof(Http2FlowData));
+    UNSIGNED_LONGS_EQUAL(base, fd->memory());
+
+    CHECK(fd->headers(1) != nullptr);
+    CHECK(fd->headers(3) != nullptr);
+    UNSIGNED_LONGS_EQUAL(base + 2 * STREAM_SIZE, in_use());
+
+    // the http_inspect flow data of a stream is charged to the flow too
+    Http2Stream* const stream = fd->headers(5);
+    stream->set_hi_flow_data((HttpFlowData*)new HiFlowData);
+    UNSIGNED_LONGS_EQUAL(base + 3 * STREAM_SIZE + sizeof(HttpFlowData), in_use());
+
+    stream->set_state(SRC_CLIENT, STREAM_COMPLETE);
+    stream->set_state(SRC_SERVER, STREAM_COMPLETE);
+    stream->check_and_cleanup_completed();
+    UNSIGNED_LONGS_EQUAL(base + 3 * STREAM_SIZE, in_use());
+
+    stream->set_hi_flow_data((HttpFlowData*)new HiFlowData);
+    UNSIGNED_LONGS_EQUAL(fd->memory(), in_use());
+    CHECK(Http2Module::get_peg_counts(PEG_MAX_BYTES_IN_USE) >= in_use());
+
+    // everything still charged is released with the flow
+    delete fd;
+}
+
+TEST(http2_memcap, evicted_stream_frames_ignored)
+{
+    Http2FlowDataTest* const fd = new Http2FlowDataTest(flow, 0);
+    // room for three streams and what it takes to remember an evicted one
+    fd->memcap = in_use() + 3 * STREAM_SIZE + STREAM_SIZE / 2;
+
+    CHECK(fd->headers(1) != nullptr);
+    CHECK(fd->headers(3) != nullptr);
+    CHECK(fd->headers(5) != nullptr);
+    LONGS_EQUAL(0, Http2Module::get_peg_counts(PEG_STREAMS_EVICTED));
+
+    // stream 1 is the oldest and makes room for stream 9
+    CHECK(fd->headers(9) != nullptr);
+    LONGS_EQUAL(1, Http2Module::get_peg_counts(PEG_STREAMS_EVICTED));
+    LONGS_EQUAL(3, fd->stream_count());
+    CHECK(fd->memory() <= fd->memcap);
+
+    // later frames for the evicted stream are dropped quietly
+    CHECK(fd->headers(1) == nullptr);
+    CHECK_FALSE(fd->invalid_stream_id());
+
+    // a stream that was never evicted still gets the invalid stream id infraction
+    CHECK(fd->headers(7) == nullptr);
+    CHECK_TRUE(fd->invalid_stream_id());
+    CHECK_FALSE(fd->aborted());
+
+    delete fd;
+}
+
+TEST(http2_memcap, over_share_evicts_own_streams)
+{
+    Http2FlowDataTest* const big = new Http2FlowDataTest(flow, 0);
+    Http2FlowDataTest* const small = new Http2FlowDataTest(flow, 0);
+    const size_t flow_size = big->memory();
+    const size_t memcap = 2 * flow_size + 8 * STREAM_SIZE;
+    big->memcap = memcap;
+    small->memcap = memcap;
+
+    for (uint32_t id = 1; id <= 15; id += 2)
+        CHECK(big->headers(id) != nullptr);
+    LONGS_EQUAL(0, Http2Module::get_peg_counts(PEG_STREAMS_EVICTED));
+
+    // the thread is at the memcap but the small flow is within its share
+    CHECK(small->headers(1) != nullptr);
+    LONGS_EQUAL(0, Http2Module::get_peg_counts(PEG_STREAMS_EVICTED));
+    CHECK(in_use() > memcap);
+
+    // the big flow is over its share so it evicts its own streams to add another
+    CHECK(big->headers(17) != nullptr);
+    CHECK(Http2Module::get_peg_counts(PEG_STREAMS_EVICTED) > 0);
+    CHECK(big->memory() <= memcap / 2 or in_use() <= memcap);
+    LONGS_EQUAL(1, small->stream_count());
+    CHECK_FALSE(big->aborted());
+    CHECK_FALSE(small->aborted());
+
+    delete big;
+    delete small;
+}
+
+TEST(http2_memcap, abort_when_nothing_to_evict)
+{
+    Http2FlowDataTest* const fd = new Http2FlowDataTest(flow, 0);
+    fd->memcap = in_use();
+
+    CHECK(fd->headers(1) == nullptr);
+    CHECK_TRUE(fd->aborted());
+    LONGS_EQUAL(1, Http2Module::get_peg_counts(PEG_FLOWS_OVER_MEMCAP));
+
+    delete fd;
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -90,6 +90,10 @@ struct RtTable
     }
     MEM_OFFSET segment_snort_calloc(size_t num, size_t size);
 
+    // the segment is allocated from the start, so this is all it holds
+    size_t segment_used() const
+    { return unused_ptr; }
+
 protected:
     TABLE_PTR sfrt_dir_flat_new(uint32_t mem_cap, int count, ...);
     tuple_flat_t sfrt_dir_flat_lookup(const uint32_t* addr, int numAddrDwords, TABLE_PTR table_ptr);
@@ -0,0 +1,453 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_poptrie.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "sfrt_poptrie.h"
+
+#include <arpa/inet.h>
+
+#include "sfrt/sfrt_flat.h"
+
+using namespace snort;
+
+// bits [pos, pos + len) of the key, zero past the end of the address
+inline unsigned Poptrie::get_bits(const Key& k, unsigned pos, unsigned len)
+{
+    if ( !len )
+        return 0;
+
+    uint64_t v;
+    unsigned end = pos + len;
+
+    if ( end <= 64 )
+        v = k.w[0] >> (64 - end);
+
+    else if ( pos >= 64 )
+        v = (end <= 128) ? k.w[1] >> (128 - end) : k.w[1] << (end - 128);
+
+    else
+        v = (k.w[0] << (end - 64)) | (k.w[1] >> (128 - end));
+
+    return (unsigned)(v & ((1u << len) - 1));
+}
+
+inline void Poptrie::set_bits(Key& k, unsigned pos, unsigned len, unsigned val)
+{
+    for ( unsigned i = 0; i < len; ++i )
+    {
+        unsigned b = pos + i;
+
+        if ( b >= 128 )
+            break;
+
+        if ( val & (1u << (len - i - 1)) )
+            k.w[b / 64] |= (uint64_t)1 << (63 - b % 64);
+    }
+}
+
+inline bool Poptrie::get_key(const SfIp* ip, Key& k)
+{
+    if ( ip->is_ip4() )
+    {
+        k.w[0] = (uint64_t)ntohl(*ip->get_ip4_ptr()) << 32;
+        k.w[1] = 0;
+        return true;
+    }
+    if ( ip->is_ip6() )
+    {
+        const uint32_t* a = ip->get_ip6_ptr();
+        k.w[0] = ((uint64_t)ntohl(a[0]) << 32) | ntohl(a[1]);
+        k.w[1] = ((uint64_t)ntohl(a[2]) << 32) | ntohl(a[3]);
+        return true;
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------
+// compile the DIR tables
+//-------------------------------------------------------------------------
+
+class PoptrieBuilder
+{
+public:
+    PoptrieBuilder(const table_flat_t* table, Poptrie::Trie& t) : trie(t)
+    {
+        base = (const uint8_t*)table;
+        data = (const INFO*)(base + table->data);
+    }
+
+    void build(TABLE_PTR);
+
+private:
+    const DIR_Entry* get_entries(SUB_TABLE_PTR sub, unsigned& width) const
+    {
+        const dir_sub_table_flat_t* t = (const dir_sub_table_flat_t*)(base + sub);
+        width = t->width;
+        return (const DIR_Entry*)(base + t->entries);
+    }
+
+    static bool is_leaf(const DIR_Entry& e)
+    { return !e.value or e.length; }
+
+    void descend(const Poptrie::Key&, unsigned len, SUB_TABLE_PTR& sub, unsigned& pos) const;
+    bool probe(const Poptrie::Key&, unsigned len, SUB_TABLE_PTR sub, unsigned pos,
+        MEM_OFFSET& value) const;
+    void build_node(uint32_t idx, const Poptrie::Key&, unsigned depth, SUB_TABLE_PTR, unsigned);
+
+    const uint8_t* base;
+    const INFO* data;
+    Poptrie::Trie& trie;
+};
+
+// move down to the deepest sub table which holds all of key/len
+void PoptrieBuilder::descend(
+    const Poptrie::Key& k, unsigned len, SUB_TABLE_PTR& sub, unsigned& pos) const
+{
+    while ( true )
+    {
+        unsigned width;
+        const DIR_Entry* entries = get_entries(sub, width);
+
+        if ( len < pos + width )
+            return;
+
+        const DIR_Entry& e = entries[Poptrie::get_bits(k, pos, width)];
+
+        if ( is_leaf(e) )
+            return;
+
+        sub = e.value;
+        pos += width;
+    }
+}
+
+// true with the data if all addresses in key/len map to the same data
+bool PoptrieBuilder::probe(
+    const Poptrie::Key& k, unsigned len, SUB_TABLE_PTR sub, unsigned pos, MEM_OFFSET& value) const
+{
+    while ( true )
+    {
+        unsigned width;
+        const DIR_Entry* entries = get_entries(sub, width);
+
+        if ( len >= pos + width )
+        {
+            const DIR_Entry& e = entries[Poptrie::get_bits(k, pos, width)];
+
+            if ( is_leaf(e) )
+            {
+                value = data[e.value];
+                return true;
+            }
+            sub = e.value;
+            pos += width;
+            continue;
+        }
+
+        // the block spans several entries of this table
+        unsigned span = pos + width - len;
+        unsigned first = Poptrie::get_bits(k, pos, len - pos) << span;
+
+        for ( unsigned i = 0; i < (1u << span); ++i )
+        {
+            const DIR_Entry& e = entries[first + i];
+
+            if ( !is_leaf(e) )
+                return false;
+
+            MEM_OFFSET v = data[e.value];
+
+            if ( i and v != value )
+                return false;
+
+            value = v;
+        }
+        return true;
+    }
+}
+
+void PoptrieBuilder::build_node(
+    uint32_t idx, const Poptrie::Key& k, unsigned depth, SUB_TABLE_PTR sub, unsigned pos)
+{
+    descend(k, depth, sub, pos);
+
+    const unsigned fanout = 1 << Poptrie::node_bits;
+    MEM_OFFSET values[fanout];
+    Poptrie::Node node = { 0, 0, 0, 0, 0 };
+
+    for ( unsigned c = 0; c < fanout; ++c )
+    {
+        Poptrie::Key ck = k;
+        Poptrie::set_bits(ck, depth, Poptrie::node_bits, c);
+
+        if ( !probe(ck, depth + Poptrie::node_bits, sub, pos, values[c]) )
+            node.vector |= (uint64_t)1 << c;
+    }
+
+    node.base0 = trie.leaves.size();
+    bool run = false;
+
+    for ( unsigned c = 0; c < fanout; ++c )
+    {
+        uint64_t bit = (uint64_t)1 << c;
+
+        if ( node.vector & bit )
+            run = false;
+
+        else if ( !values[c] )
+        {
+            node.emptyvec |= bit;
+            run = false;
+        }
+        else if ( !run or trie.leaves.back() != values[c] )
+        {
+            node.leafvec |= bit;
+            trie.leaves.emplace_back(values[c]);
+            run = true;
+        }
+    }
+
+    node.base1 = trie.nodes.size();
+    trie.nodes.resize(trie.nodes.size() + __builtin_popcountll(node.vector));
+    trie.nodes[idx] = node;
+
+    uint32_t child = node.base1;
+
+    for ( unsigned c = 0; c < fanout; ++c )
+    {
+        if ( !(node.vector & ((uint64_t)1 << c)) )
+            continue;
+
+        Poptrie::Key ck = k;
+        Poptrie::set_bits(ck, depth, Poptrie::node_bits, c);
+        build_node(child++, ck, depth + Poptrie::node_bits, sub, pos);
+    }
+}
+
+void PoptrieBuilder::build(TABLE_PTR rt)
+{
+    const unsigned size = 1 << Poptrie::dir_bits;
+    trie.dir.resize(size);
+
+    // leaf 0 is no data
+    trie.leaves.emplace_back(0);
+
+    if ( !rt )
+        return;
+
+    SUB_TABLE_PTR root = ((const dir_table_flat_t*)(base + rt))->sub_table;
+
+    if ( !root )
+        return;
+
+    for ( unsigned i = 0; i < size; ++i )
+    {
+        Poptrie::Key k = { { (uint64_t)i << (64 - Poptrie::dir_bits), 0 } };
+        MEM_OFFSET value;
+
+        if ( probe(k, Poptrie::dir_bits, root, 0, value) )
+        {
+            if ( value and value != trie.leaves.back() )
+                trie.leaves.emplace_back(value);
+
+            trie.dir[i] = value ? trie.leaves.size() - 1 : 0;
+            continue;
+        }
+
+        uint32_t idx = trie.nodes.size();
+        trie.nodes.emplace_back();
+        trie.dir[i] = idx | Poptrie::node_flag;
+        build_node(idx, k, Poptrie::dir_bits, root, 0);
+    }
+
+    trie.dir.shrink_to_fit();
+    trie.nodes.shrink_to_fit();
+    trie.leaves.shrink_to_fit();
+}
+
+//-------------------------------------------------------------------------
+// lookups
+//-------------------------------------------------------------------------
+
+Poptrie::Poptrie(const table_flat_t* table)
+{
+    base = (const uint8_t*)table;
+    PoptrieBuilder(table, v4).build(table->rt);
+    PoptrieBuilder(table, v6).build(table->rt6);
+}
+
+// the leaf of the child for the bits at depth, or the next node
+inline bool Poptrie::step(const Trie& t, const Key& k, uint32_t& n, unsigned& depth)
+{
+    const auto& node = t.nodes[n];
+    unsigned c = get_bits(k, depth, node_bits);
+    uint64_t bit = (uint64_t)1 << c;
+    uint64_t mask = (bit << 1) - 1;
+
+    if ( node.vector & bit )
+    {
+        n = node.base1 + __builtin_popcountll(node.vector & mask) - 1;
+        depth += node_bits;
+        return false;
+    }
+    if ( node.emptyvec & bit )
+        n = 0;
+    else
+        n = node.base0 + __builtin_popcountll(node.leafvec & mask) - 1;
+
+    return true;
+}
+
+inline __attribute__((always_inline)) GENERIC Poptrie::find(const SfIp* ip) const
+{
+    Key k;
+
+    if ( !get_key(ip, k) )
+        return nullptr;
+
+    const Trie& t = ip->is_ip4() ? v4 : v6;
+    uint32_t n = t.dir[k.w[0] >> (64 - dir_bits)];
+
+    if ( n & node_flag )
+    {
+        n &= ~node_flag;
+        unsigned depth = dir_bits;
+
+        while ( !step(t, k, n, depth) )
+            ;
+    }
+    return get_data(t.leaves[n]);
+}
+
+inline __attribute__((always_inline))
+void Poptrie::find(const SfIp* const* ips, unsigned num, GENERIC* results) const
+{
+    const unsigned group = 8;
+
+    for ( unsigned i = 0; i < num; i += group )
+    {
+        unsigned m = (num - i < group) ? num - i : group;
+        Key keys[group];
+        const Trie* tries[group];
+        uint32_t idx[group];
+        unsigned depths[group];
+        unsigned active = 0;
+
+        for ( unsigned j = 0; j < m; ++j )
+        {
+            const SfIp* ip = ips[i + j];
+            results[i + j] = nullptr;
+
+            if ( !get_key(ip, keys[j]) )
+            {
+                tries[j] = nullptr;
+                continue;
+            }
+            tries[j] = ip->is_ip4() ? &v4 : &v6;
+            idx[j] = tries[j]->dir[keys[j].w[0] >> (64 - dir_bits)];
+
+            if ( !(idx[j] & node_flag) )
+            {
+                results[i + j] = get_data(tries[j]->leaves[idx[j]]);
+                tries[j] = nullptr;
+                continue;
+            }
+            idx[j] &= ~node_flag;
+            depths[j] = dir_bits;
+            __builtin_prefetch(&tries[j]->nodes[idx[j]]);
+            ++active;
+        }
+
+        while ( active )
+        {
+            for ( unsigned j = 0; j < m; ++j )
+            {
+                if ( !tries[j] )
+                    continue;
+
+                if ( step(*tries[j], keys[j], idx[j], depths[j]) )
+                {
+                    results[i + j] = get_data(tries[j]->leaves[idx[j]]);
+                    tries[j] = nullptr;
+                    --active;
+                }
+                else
+                    __builtin_prefetch(&tries[j]->nodes[idx[j]]);
+            }
+        }
+    }
+}
+
+// the lookups are mostly popcounts, which are a libgcc call unless the
+// target has the instruction
+#if defined(__x86_64__) && defined(__GNUC__)
+#define POPCNT_TARGET __attribute__((target("popcnt")))
+
+static bool has_popcnt()
+{
+    static const bool popcnt = __builtin_cpu_supports("popcnt");
+    return popcnt;
+}
+
+#else
+#define POPCNT_TARGET
+
+static bool has_popcnt()
+{ return false; }
+#endif
+
+POPCNT_TARGET GENERIC Poptrie::find_popcnt(const SfIp* ip) const
+{ return find(ip); }
+
+POPCNT_TARGET void Poptrie::find_popcnt(const SfIp* const* ips, unsigned num, GENERIC* results) const
+{ find(ips, num, results); }
+
+GENERIC Poptrie::lookup(const SfIp* ip) const
+{ return has_popcnt() ? find_popcnt(ip) : find(ip); }
+
+void Poptrie::lookup(const SfIp* const* ips, unsigned num, GENERIC* results) const
+{
+    if ( has_popcnt() )
+        find_popcnt(ips, num, results);
+    else
+        find(ips, num, results);
+}
+
+size_t Poptrie::get_memory() const
+{
+    size_t size = sizeof(*this);
+
+    for ( const Trie* t : { &v4, &v6 } )
+    {
+        size += t->dir.capacity() * sizeof(t->dir[0]);
+        size += t->nodes.capacity() * sizeof(t->nodes[0]);
+        size += t->leaves.capacity() * sizeof(t->leaves[0]);
+    }
+    return size;
+}
+
+size_t Poptrie::get_nodes() const
+{ return v4.nodes.size() + v6.nodes.size(); }
+
+size_t Poptrie::get_leaves() const
+{ return v4.leaves.size() + v6.leaves.size(); }
+
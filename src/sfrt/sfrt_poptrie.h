@@ -0,0 +1,104 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_poptrie.h author Cisco
+
+#ifndef SFRT_POPTRIE_H
+#define SFRT_POPTRIE_H
+
+// Read only longest prefix match compiled from the DIR tables of a flat
+// table, after Asai and Ohara's poptrie.  The top 16 bits index a direct
+// table and each node below covers 6 bits with two 64 bit vectors: one marks
+// the children which are nodes and one the start of each run of equal
+// leaves, so children and leaves are stored contiguously and found with a
+// popcount instead of a 64 entry array per node.  This is much smaller than
+// the DIR tables for large lists so more of it stays in cache.  Children
+// without data are flagged in the node so most lookups of addresses not in
+// the list never touch the leaves.
+//
+// The leaves hold the same data as the DIR tables so lookups return the
+// same results.  The trie must be rebuilt if the flat table changes.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sfrt/sfrt.h"
+
+struct table_flat_t;
+
+class Poptrie
+{
+public:
+    explicit Poptrie(const table_flat_t*);
+
+    GENERIC lookup(const snort::SfIp*) const;
+
+    // lookups of n addresses are interleaved a level at a time so their
+    // cache misses overlap
+    void lookup(const snort::SfIp* const* ips, unsigned n, GENERIC* results) const;
+
+    size_t get_memory() const;
+    size_t get_nodes() const;
+    size_t get_leaves() const;
+
+private:
+    friend class PoptrieBuilder;
+
+    struct Key
+    { uint64_t w[2]; };
+
+    struct Node
+    {
+        uint64_t vector;   // children which are nodes
+        uint64_t leafvec;  // children which start a run of leaves
+        uint64_t emptyvec; // children with no data, which have no leaf
+        uint32_t base0;    // first leaf
+        uint32_t base1;    // first node
+    };
+
+    struct Trie
+    {
+        std::vector<uint32_t> dir;  // leaf index or node index | node_flag
+        std::vector<Node> nodes;
+        std::vector<MEM_OFFSET> leaves;
+    };
+
+    static constexpr unsigned dir_bits = 16;
+    static constexpr unsigned node_bits = 6;
+    static constexpr uint32_t node_flag = 0x80000000;
+
+    static unsigned get_bits(const Key&, unsigned pos, unsigned len);
+    static void set_bits(Key&, unsigned pos, unsigned len, unsigned val);
+    static bool get_key(const snort::SfIp*, Key&);
+    static bool step(const Trie&, const Key&, uint32_t& node, unsigned& depth);
+
+    GENERIC find(const snort::SfIp*) const;
+    void find(const snort::SfIp* const*, unsigned, GENERIC*) const;
+    GENERIC find_popcnt(const snort::SfIp*) const;
+    void find_popcnt(const snort::SfIp* const*, unsigned, GENERIC*) const;
+
+    GENERIC get_data(MEM_OFFSET off) const
+    { return off ? (GENERIC)(base + off) : nullptr; }
+
+    const uint8_t* base;
+    Trie v4;
+    Trie v6;
+};
+
+#endif
+
@@ -0,0 +1,305 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_prefix_filter.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "sfrt_prefix_filter.h"
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+
+#include "sfip/sf_ip.h"
+#include "sfrt/sfrt_flat.h"
+
+using namespace snort;
+
+// key lengths by family, the bits of Family::lengths
+static const unsigned v4_lengths[] = { 8, 16, 24, 32 };
+static const unsigned v6_lengths[] = { 16, 32, 48, 64, 128 };
+
+namespace
+{
+struct Key
+{ uint64_t w[2]; };
+}
+
+static void set_bits(Key& k, unsigned pos, unsigned len, unsigned val)
+{
+    for ( unsigned i = 0; i < len; ++i )
+    {
+        unsigned b = pos + i;
+
+        if ( b >= 128 )
+            break;
+
+        if ( val & (1u << (len - i - 1)) )
+            k.w[b / 64] |= (uint64_t)1 << (63 - b % 64);
+    }
+}
+
+static Key mask_key(const Key& k, unsigned len)
+{
+    Key m = k;
+
+    if ( len < 64 )
+    {
+        m.w[0] &= len ? ~(uint64_t)0 << (64 - len) : 0;
+        m.w[1] = 0;
+    }
+    else if ( len < 128 )
+        m.w[1] &= len > 64 ? ~(uint64_t)0 << (128 - len) : 0;
+
+    return m;
+}
+
+// a multiply and shifts is enough for the filter and keeps the probes cheap;
+// the family is in the tag so eg 10.0.0.0/8 and a00::/8 are different keys
+inline uint64_t PrefixFilter::hash(uint64_t hi, uint64_t lo, unsigned tag)
+{
+    uint64_t x = (hi ^ (lo * 0x9e3779b97f4a7c15ull)) + tag;
+    x ^= x >> 32;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 29;
+    return x;
+}
+
+// the block comes from the high half and the bits from the rest of the hash
+// multiplied out so they are independent of the block
+void PrefixFilter::add(uint64_t h)
+{
+    Block& b = blocks[((h >> 32) * blocks.size()) >> 32];
+    uint64_t bits = h * 0x9e3779b97f4a7c15ull;
+
+    for ( unsigned i = 0; i < num_hashes; ++i )
+    {
+        unsigned bit = (bits >> (55 - 9 * i)) & 511;
+        b.w[bit / 64] |= (uint64_t)1 << (bit % 64);
+    }
+}
+
+// without branches since most tests of addresses not in the list fail at a
+// random bit, which would be a mispredict for each one
+inline bool PrefixFilter::test(uint64_t h) const
+{
+    const Block& b = get_block(h);
+    uint64_t bits = h * 0x9e3779b97f4a7c15ull;
+    uint64_t missing = 0;
+
+    for ( unsigned i = 0; i < num_hashes; ++i )
+    {
+        unsigned bit = (bits >> (55 - 9 * i)) & 511;
+        missing |= ~b.w[bit / 64] & ((uint64_t)1 << (bit % 64));
+    }
+    return !missing;
+}
+
+//-------------------------------------------------------------------------
+// collect the keys from the DIR tables
+//-------------------------------------------------------------------------
+
+class PrefixFilterBuilder
+{
+public:
+    PrefixFilterBuilder(const table_flat_t* table, PrefixFilter& pf) : filter(pf)
+    {
+        base = (const uint8_t*)table;
+        data = (const INFO*)(base + table->data);
+    }
+
+    void walk(TABLE_PTR, bool ip6);
+    void build(unsigned bits_per_key);
+
+private:
+    void walk(SUB_TABLE_PTR, const Key&, unsigned pos);
+    void add(const Key&, unsigned len);
+
+    const uint8_t* base;
+    const INFO* data;
+    PrefixFilter& filter;
+
+    PrefixFilter::Family* family = nullptr;
+    const unsigned* lengths = nullptr;
+    unsigned num_lengths = 0;
+    unsigned tag = 0;
+
+    std::vector<uint64_t> hashes;
+};
+
+// the longest key length which fits in the prefix
+void PrefixFilterBuilder::add(const Key& k, unsigned len)
+{
+    unsigned i = num_lengths;
+
+    while ( i and lengths[i - 1] > len )
+        --i;
+
+    if ( !i )
+    {
+        family->all = true;
+        return;
+    }
+
+    unsigned n = lengths[--i];
+    Key m = mask_key(k, n);
+    uint64_t h = PrefixFilter::hash(m.w[0], m.w[1], tag + n);
+
+    // a short prefix fills runs of entries with the same key
+    if ( hashes.empty() or hashes.back() != h )
+        hashes.emplace_back(h);
+
+    family->lengths |= 1u << i;
+}
+
+void PrefixFilterBuilder::walk(SUB_TABLE_PTR sub, const Key& k, unsigned pos)
+{
+    const dir_sub_table_flat_t* t = (const dir_sub_table_flat_t*)(base + sub);
+    const DIR_Entry* entries = (const DIR_Entry*)(base + t->entries);
+
+    for ( int i = 0; i < t->num_entries; ++i )
+    {
+        const DIR_Entry& e = entries[i];
+
+        if ( !e.value )
+            continue;
+
+        Key ck = k;
+        set_bits(ck, pos, t->width, i);
+
+        if ( !e.length )
+            walk(e.value, ck, pos + t->width);
+
+        else if ( data[e.value] )
+            add(ck, e.length);
+    }
+}
+
+void PrefixFilterBuilder::walk(TABLE_PTR rt, bool ip6)
+{
+    if ( ip6 )
+    {
+        family = &filter.v6;
+        lengths = v6_lengths;
+        num_lengths = sizeof(v6_lengths) / sizeof(v6_lengths[0]);
+        tag = 256;
+    }
+    else
+    {
+        family = &filter.v4;
+        lengths = v4_lengths;
+        num_lengths = sizeof(v4_lengths) / sizeof(v4_lengths[0]);
+        tag = 0;
+    }
+
+    if ( !rt )
+        return;
+
+    SUB_TABLE_PTR root = ((const dir_table_flat_t*)(base + rt))->sub_table;
+
+    if ( root )
+        walk(root, { { 0, 0 } }, 0);
+}
+
+void PrefixFilterBuilder::build(unsigned bits_per_key)
+{
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    filter.keys = hashes.size();
+
+    if ( hashes.empty() )
+        return;
+
+    const unsigned block_bits = sizeof(PrefixFilter::Block) * 8;
+    size_t num_blocks = (hashes.size() * bits_per_key + block_bits - 1) / block_bits;
+
+    filter.blocks.resize(std::max(num_blocks, (size_t)1));
+
+    for ( auto h : hashes )
+        filter.add(h);
+}
+
+//-------------------------------------------------------------------------
+// lookups
+//-------------------------------------------------------------------------
+
+PrefixFilter::PrefixFilter(const table_flat_t* table, unsigned bits_per_key)
+{
+    static_assert(sizeof(v4_lengths) / sizeof(v4_lengths[0]) <= max_lengths and
+        sizeof(v6_lengths) / sizeof(v6_lengths[0]) <= max_lengths, "too many key lengths");
+
+    PrefixFilterBuilder builder(table, *this);
+    builder.walk(table->rt, false);
+    builder.walk(table->rt6, true);
+    builder.build(bits_per_key);
+}
+
+bool PrefixFilter::maybe(const SfIp* ip) const
+{
+    Key k;
+    const Family* f;
+    const unsigned* lengths;
+    unsigned tag;
+
+    if ( ip->is_ip4() )
+    {
+        k.w[0] = (uint64_t)ntohl(*ip->get_ip4_ptr()) << 32;
+        k.w[1] = 0;
+        f = &v4;
+        lengths = v4_lengths;
+        tag = 0;
+    }
+    else if ( ip->is_ip6() )
+    {
+        const uint32_t* a = ip->get_ip6_ptr();
+        k.w[0] = ((uint64_t)ntohl(a[0]) << 32) | ntohl(a[1]);
+        k.w[1] = ((uint64_t)ntohl(a[2]) << 32) | ntohl(a[3]);
+        f = &v6;
+        lengths = v6_lengths;
+        tag = 256;
+    }
+    else
+        return true;
+
+    if ( f->all )
+        return true;
+
+    // fetch the blocks of all lengths before testing so the misses overlap
+    uint64_t hashes[max_lengths];
+    unsigned num = 0;
+
+    for ( uint32_t set = f->lengths; set; set &= set - 1 )
+    {
+        unsigned n = lengths[__builtin_ctz(set)];
+        Key m = mask_key(k, n);
+        uint64_t h = hash(m.w[0], m.w[1], tag + n);
+        __builtin_prefetch(&get_block(h));
+        hashes[num++] = h;
+    }
+
+    bool found = false;
+
+    for ( unsigned i = 0; i < num; ++i )
+        found |= test(hashes[i]);
+
+    return found;
+}
+
@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_prefix_filter.h author Cisco
+
+#ifndef SFRT_PREFIX_FILTER_H
+#define SFRT_PREFIX_FILTER_H
+
+// Blocked bloom filter of the prefixes in a flat table, checked before the
+// lookup to skip it for addresses which can't be in the table.  Each prefix
+// is added as its first n bits for the longest of a few fixed lengths n that
+// fits in it, so an address is checked once for each length which has any
+// prefixes: one or two probes for typical lists of hosts and networks.  All
+// the bits of a key are in one 64 byte block so a probe is one cache line.
+//
+// There are no false negatives.  Keys shorter than the prefixes mean any
+// address sharing the key with a listed one passes, so false positives are
+// the filter rate plus addresses near listed ones.  Prefixes shorter than
+// the shortest length pass all addresses of that family.  The filter must be
+// rebuilt if the flat table changes.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sfrt/sfrt.h"
+
+struct table_flat_t;
+
+class PrefixFilter
+{
+public:
+    PrefixFilter(const table_flat_t*, unsigned bits_per_key);
+
+    // false if ip is certainly not in the table
+    bool maybe(const snort::SfIp*) const;
+
+    size_t get_memory() const
+    { return blocks.size() * sizeof(Block); }
+
+    size_t get_keys() const
+    { return keys; }
+
+private:
+    friend class PrefixFilterBuilder;
+
+    struct alignas(64) Block
+    { uint64_t w[8]; };
+
+    struct Family
+    {
+        uint32_t lengths = 0;  // bit i set if keys of lengths[i] were added
+        bool all = false;      // a prefix shorter than the shortest length
+    };
+
+    static constexpr unsigned num_hashes = 6;
+    static constexpr unsigned max_lengths = 5;
+
+    static uint64_t hash(uint64_t hi, uint64_t lo, unsigned len);
+
+    const Block& get_block(uint64_t h) const
+    { return blocks[((h >> 32) * blocks.size()) >> 32]; }
+
+    void add(uint64_t h);
+    bool test(uint64_t h) const;
+
+    std::vector<Block> blocks;
+    size_t keys = 0;
+    Family v4;
+    Family v6;
+};
+
+#endif
+
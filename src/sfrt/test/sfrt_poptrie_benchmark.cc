@@ -0,0 +1,196 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_poptrie_benchmark.cc author Cisco
+// lookups of a large reputation style list with the flat DIR tables against
+// the poptrie compiled from them, one at a time and in batches.  Each
+// iteration looks up LOOKUPS addresses so ns/lookup is the mean divided by
+// LOOKUPS.  The DIR tables need several GB for 10M prefixes or for a large
+// IPv6 list so the defaults are smaller; the trie stats are printed for
+// comparison with the segment size.
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <arpa/inet.h>
+
+#include <iostream>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "sfip/sf_cidr.h"
+#include "sfrt/sfrt_flat.h"
+#include "sfrt/sfrt_poptrie.h"
+
+using namespace snort;
+
+#define IP4_PREFIXES (1024 * 1024)
+#define IP6_PREFIXES (64 * 1024)
+#define SEGMENT_MB 2048
+#define LOOKUPS 4096
+
+static int64_t update_entry(INFO* current, INFO new_entry, SaveDest, uint8_t*, void*)
+{
+    *current = new_entry;
+    return 0;
+}
+
+static uint32_t next(uint32_t& seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) | (seed << 16);
+}
+
+struct List
+{
+    List() : segment((size_t)SEGMENT_MB << 20)
+    {
+        rt.segment_meminit(segment.data(), segment.size());
+        rt.sfrt_flat_new(DIR_8x16, IPv6, IP4_PREFIXES + IP6_PREFIXES + 1, SEGMENT_MB);
+
+        uint32_t seed = 1;
+
+        // mostly hosts with some /24s as in the block lists
+        for ( unsigned i = 0; i < IP4_PREFIXES; ++i )
+        {
+            uint32_t a = htonl(next(seed));
+            add(&a, AF_INET, (i % 8) ? 128 : 120);
+            ip4.emplace_back(a);
+        }
+
+        // /48 to /64 networks
+        for ( unsigned i = 0; i < IP6_PREFIXES; ++i )
+        {
+            uint32_t a[4] = { htonl(0x20010000 | (next(seed) & 0xffff)), next(seed), 0, 0 };
+            add(a, AF_INET6, 48 + next(seed) % 17);
+            ip6.emplace_back((uint64_t)a[0] << 32 | a[1]);
+        }
+    }
+
+    void add(const void* addr, int family, unsigned bits)
+    {
+        SfCidr ip;
+        ip.set(addr, family);
+        ip.set_bits(bits);
+
+        MEM_OFFSET info = rt.segment_snort_calloc(1, sizeof(uint32_t));
+        rt.sfrt_flat_insert(&ip, (unsigned char)bits, info, RT_FAVOR_ALL, update_entry, nullptr);
+    }
+
+    std::vector<uint8_t> segment;
+    RtTable rt;
+
+    std::vector<uint32_t> ip4;
+    std::vector<uint64_t> ip6;
+};
+
+// half of them in the list in random order, half random so mostly not
+static std::vector<SfIp> get_addrs(const List& list, int family)
+{
+    std::vector<SfIp> addrs(LOOKUPS);
+    uint32_t seed = 7;
+
+    for ( unsigned i = 0; i < LOOKUPS; ++i )
+    {
+        uint32_t r = next(seed);
+
+        if ( family == AF_INET )
+        {
+            uint32_t a = (i % 2) ? list.ip4[r % list.ip4.size()] : htonl(r);
+            addrs[i].set(&a, AF_INET);
+        }
+        else
+        {
+            uint64_t net = list.ip6[r % list.ip6.size()];
+            uint32_t a[4] = { (uint32_t)(net >> 32), (uint32_t)net, next(seed), next(seed) };
+
+            if ( i % 2 )
+                a[1] = next(seed);
+
+            addrs[i].set(a, AF_INET6);
+        }
+    }
+    return addrs;
+}
+
+static void run(const List& list, const Poptrie& trie, int family, const char* name)
+{
+    std::vector<SfIp> addrs = get_addrs(list, family);
+    std::vector<const SfIp*> ptrs;
+    std::vector<GENERIC> results(LOOKUPS);
+
+    for ( const auto& ip : addrs )
+        ptrs.emplace_back(&ip);
+
+    trie.lookup(ptrs.data(), LOOKUPS, results.data());
+
+    for ( unsigned i = 0; i < LOOKUPS; ++i )
+    {
+        GENERIC dir = sfrt_flat_dir8x_lookup(ptrs[i], list.rt.get_table());
+        REQUIRE(trie.lookup(ptrs[i]) == dir);
+        REQUIRE(results[i] == dir);
+    }
+
+    std::string n = std::string(name) + ", " + std::to_string(LOOKUPS) + " lookups";
+
+    BENCHMARK("dir " + n)
+    {
+        unsigned found = 0;
+        for ( auto ip : ptrs )
+            found += sfrt_flat_dir8x_lookup(ip, list.rt.get_table()) != nullptr;
+        return found;
+    };
+
+    BENCHMARK("poptrie " + n)
+    {
+        unsigned found = 0;
+        for ( auto ip : ptrs )
+            found += trie.lookup(ip) != nullptr;
+        return found;
+    };
+
+    BENCHMARK("poptrie batched " + n)
+    {
+        trie.lookup(ptrs.data(), LOOKUPS, results.data());
+        return results[0];
+    };
+}
+
+TEST_CASE("reputation list lookups", "[poptrie]")
+{
+    static List list;
+    static Poptrie trie(list.rt.get_table());
+
+    std::cout << "segment used " << list.rt.sfrt_flat_usage() << " bytes, poptrie " <<
+        trie.get_memory() << " bytes, " << trie.get_nodes() << " nodes, " <<
+        trie.get_leaves() << " leaves" << std::endl;
+
+    SECTION("ip4")
+    {
+        run(list, trie, AF_INET, "ip4");
+    }
+    SECTION("ip6")
+    {
+        run(list, trie, AF_INET6, "ip6");
+    }
+}
+
+#endif
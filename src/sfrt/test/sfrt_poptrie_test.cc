@@ -0,0 +1,196 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_poptrie_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "sfip/sf_cidr.h"
+#include "sfrt/sfrt_flat.h"
+#include "sfrt/sfrt_poptrie.h"
+
+using namespace snort;
+
+static int64_t update_entry(INFO* current, INFO new_entry, SaveDest, uint8_t*, void*)
+{
+    *current = new_entry;
+    return 0;
+}
+
+class TestTable
+{
+public:
+    TestTable(uint32_t max_entries = 1024, uint32_t memcap = 64) : segment(memcap << 20)
+    {
+        rt.segment_meminit(segment.data(), segment.size());
+        rt.sfrt_flat_new(DIR_8x16, IPv6, max_entries, memcap);
+    }
+
+    // the data is an offset into the segment, just a distinct value here
+    MEM_OFFSET add(const char* cidr)
+    {
+        SfCidr ip;
+        REQUIRE(ip.set(cidr) == SFIP_SUCCESS);
+
+        MEM_OFFSET info = rt.segment_snort_calloc(1, sizeof(uint32_t));
+        REQUIRE(rt.sfrt_flat_insert(&ip, (unsigned char)ip.get_bits(), info, RT_FAVOR_ALL,
+            update_entry, nullptr) == RT_SUCCESS);
+
+        return info;
+    }
+
+    GENERIC lookup(const char* addr)
+    {
+        SfIp ip;
+        REQUIRE(ip.set(addr) == SFIP_SUCCESS);
+        return sfrt_flat_dir8x_lookup(&ip, rt.get_table());
+    }
+
+    table_flat_t* get_table()
+    { return rt.get_table(); }
+
+private:
+    std::vector<uint8_t> segment;
+    RtTable rt;
+};
+
+static void check(const Poptrie& trie, TestTable& table, const char* addr)
+{
+    SfIp ip;
+    REQUIRE(ip.set(addr) == SFIP_SUCCESS);
+    CHECK(trie.lookup(&ip) == table.lookup(addr));
+}
+
+TEST_CASE("poptrie empty", "[poptrie]")
+{
+    TestTable table;
+    Poptrie trie(table.get_table());
+
+    SfIp ip;
+    ip.set("10.1.2.3");
+    CHECK(trie.lookup(&ip) == nullptr);
+
+    ip.set("2001:db8::1");
+    CHECK(trie.lookup(&ip) == nullptr);
+
+    CHECK(trie.get_nodes() == 0);
+}
+
+TEST_CASE("poptrie prefixes", "[poptrie]")
+{
+    TestTable table;
+
+    table.add("10.0.0.0/8");
+    table.add("10.1.0.0/16");
+    table.add("10.1.2.0/24");
+    table.add("10.1.2.3/32");
+    table.add("10.1.2.128/25");
+    table.add("192.168.1.1");
+    table.add("172.16.0.0/12");
+
+    table.add("2001:db8::/32");
+    table.add("2001:db8:1::/48");
+    table.add("2001:db8:1:2::/64");
+    table.add("2001:db8:1:2::1/128");
+    table.add("fe80::/10");
+
+    Poptrie trie(table.get_table());
+
+    const char* addrs[] =
+    {
+        "10.0.0.1", "10.1.0.1", "10.1.2.1", "10.1.2.3", "10.1.2.4", "10.1.2.129",
+        "10.1.2.255", "10.1.3.0", "10.2.0.0", "11.0.0.0", "9.255.255.255",
+        "192.168.1.1", "192.168.1.0", "192.168.1.2", "172.15.255.255", "172.16.0.0",
+        "172.31.255.255", "172.32.0.0", "0.0.0.0", "255.255.255.255",
+
+        "2001:db8::", "2001:db8:ffff::1", "2001:db8:1::1", "2001:db8:1:2::",
+        "2001:db8:1:2::1", "2001:db8:1:2::2", "2001:db8:1:3::1", "2001:db9::",
+        "fe80::1", "febf::1", "fec0::1", "::", "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff",
+    };
+
+    for ( auto a : addrs )
+        check(trie, table, a);
+
+    CHECK(table.lookup("10.1.2.3") != table.lookup("10.1.2.4"));
+    CHECK(trie.get_nodes() > 0);
+    CHECK(trie.get_memory() > 0);
+}
+
+TEST_CASE("poptrie random", "[poptrie]")
+{
+    const unsigned num = 512;
+    TestTable table(num + 1);
+    std::vector<SfIp> addrs;
+    uint32_t seed = 1;
+
+    auto next = [&seed]() { seed = seed * 1103515245 + 12345; return seed; };
+
+    // random prefixes clustered in a few /16s to get deep tries
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        char buf[64];
+
+        if ( i % 2 )
+        {
+            uint32_t a = next();
+            snprintf(buf, sizeof(buf), "10.%u.%u.%u/%u", a % 4, (a >> 8) & 0xff,
+                (a >> 16) & 0xff, 16 + (a >> 24) % 17);
+        }
+        else
+        {
+            uint32_t a = next();
+            snprintf(buf, sizeof(buf), "2001:db8:%x:%x::%x/%u", a % 4, (a >> 8) & 0xff,
+                (a >> 16) & 0xff, 32 + (a >> 24) % 97);
+        }
+
+        SfCidr ip;
+        REQUIRE(ip.set(buf) == SFIP_SUCCESS);
+        table.add(buf);
+        addrs.emplace_back(*ip.get_addr());
+    }
+
+    Poptrie trie(table.get_table());
+    std::vector<const SfIp*> batch;
+
+    for ( const auto& ip : addrs )
+    {
+        // the addresses around each prefix
+        for ( int d : { -1, 0, 1 } )
+        {
+            SfIp a = ip;
+            uint32_t* p = (uint32_t*)a.get_ip6_ptr();
+            p[3] = htonl(ntohl(p[3]) + d);
+
+            CHECK(trie.lookup(&a) == sfrt_flat_dir8x_lookup(&a, table.get_table()));
+        }
+        batch.emplace_back(&ip);
+    }
+
+    std::vector<GENERIC> results(batch.size());
+    trie.lookup(batch.data(), batch.size(), results.data());
+
+    for ( unsigned i = 0; i < batch.size(); ++i )
+        CHECK(results[i] == sfrt_flat_dir8x_lookup(batch[i], table.get_table()));
+}
+
@@ -0,0 +1,192 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_prefix_filter_test.cc author Cisco
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "sfip/sf_cidr.h"
+#include "sfrt/sfrt_flat.h"
+#include "sfrt/sfrt_prefix_filter.h"
+
+using namespace snort;
+
+static int64_t update_entry(INFO* current, INFO new_entry, SaveDest, uint8_t*, void*)
+{
+    *current = new_entry;
+    return 0;
+}
+
+class TestTable
+{
+public:
+    TestTable(uint32_t max_entries = 1024, uint32_t memcap = 64) : segment(memcap << 20)
+    {
+        rt.segment_meminit(segment.data(), segment.size());
+        rt.sfrt_flat_new(DIR_8x16, IPv6, max_entries, memcap);
+    }
+
+    void add(const char* cidr)
+    {
+        SfCidr ip;
+        REQUIRE(ip.set(cidr) == SFIP_SUCCESS);
+
+        MEM_OFFSET info = rt.segment_snort_calloc(1, sizeof(uint32_t));
+        REQUIRE(rt.sfrt_flat_insert(&ip, (unsigned char)ip.get_bits(), info, RT_FAVOR_ALL,
+            update_entry, nullptr) == RT_SUCCESS);
+    }
+
+    GENERIC lookup(const SfIp& ip)
+    { return sfrt_flat_dir8x_lookup(&ip, rt.get_table()); }
+
+    table_flat_t* get_table()
+    { return rt.get_table(); }
+
+private:
+    std::vector<uint8_t> segment;
+    RtTable rt;
+};
+
+static bool maybe(const PrefixFilter& pf, const char* addr)
+{
+    SfIp ip;
+    REQUIRE(ip.set(addr) == SFIP_SUCCESS);
+    return pf.maybe(&ip);
+}
+
+static void make_ip4(char* buf, size_t len, uint32_t a)
+{ snprintf(buf, len, "%u.%u.%u.%u", a >> 24, (a >> 16) & 0xff, (a >> 8) & 0xff, a & 0xff); }
+
+TEST_CASE("prefix filter empty", "[prefix_filter]")
+{
+    TestTable table;
+    PrefixFilter pf(table.get_table(), 12);
+
+    CHECK(pf.get_keys() == 0);
+    CHECK(!maybe(pf, "10.1.2.3"));
+    CHECK(!maybe(pf, "2001:db8::1"));
+}
+
+TEST_CASE("prefix filter prefixes", "[prefix_filter]")
+{
+    TestTable table;
+
+    table.add("10.0.0.0/8");
+    table.add("172.16.0.0/12");
+    table.add("192.168.1.0/24");
+    table.add("192.168.2.128/25");
+    table.add("198.51.100.7");
+
+    table.add("2001:db8::/32");
+    table.add("2001:db8:1:2::/64");
+    table.add("2001:db8:5::1/128");
+
+    PrefixFilter pf(table.get_table(), 16);
+
+    const char* in[] =
+    {
+        "10.0.0.1", "10.255.255.255", "172.16.0.1", "172.31.255.255", "192.168.1.77",
+        "192.168.2.200", "198.51.100.7", "2001:db8::1", "2001:db8:ffff::1",
+        "2001:db8:1:2::abcd", "2001:db8:5::1"
+    };
+
+    for ( auto addr : in )
+    {
+        INFO(addr);
+        CHECK(maybe(pf, addr));
+    }
+
+    // 172.16.0.0/12 is keyed as 172.0.0.0/8 so the rest of it may pass
+    const char* out[] =
+    {
+        "11.0.0.1", "173.16.0.1", "192.168.3.1", "198.51.101.7", "2001:db9::1", "fe80::1"
+    };
+
+    for ( auto addr : out )
+    {
+        INFO(addr);
+        CHECK(!maybe(pf, addr));
+    }
+}
+
+TEST_CASE("prefix filter short prefix", "[prefix_filter]")
+{
+    TestTable table;
+
+    table.add("64.0.0.0/4");
+    table.add("2001:db8::1");
+
+    PrefixFilter pf(table.get_table(), 12);
+
+    // shorter than all key lengths so any IPv4 address may match
+    CHECK(maybe(pf, "64.0.0.1"));
+    CHECK(maybe(pf, "10.0.0.1"));
+    CHECK(maybe(pf, "2001:db8::1"));
+    CHECK(!maybe(pf, "2001:db8::2"));
+}
+
+TEST_CASE("prefix filter hosts", "[prefix_filter]")
+{
+    TestTable table(16384);
+    uint32_t seed = 7;
+    char buf[32];
+
+    for ( unsigned i = 0; i < 10000; ++i )
+    {
+        seed = seed * 1103515245 + 12345;
+        make_ip4(buf, sizeof(buf), seed);
+        table.add(buf);
+    }
+
+    PrefixFilter pf(table.get_table(), 12);
+    CHECK(pf.get_keys() <= 10000);
+    CHECK(pf.get_memory() >= 10000 * 12 / 8);
+
+    unsigned listed = 0, passed = 0, fp = 0;
+
+    for ( unsigned i = 0; i < 100000; ++i )
+    {
+        seed = seed * 1103515245 + 12345;
+        SfIp ip;
+        ip.set(&seed, AF_INET);
+
+        bool found = table.lookup(ip) != nullptr;
+        bool pass = pf.maybe(&ip);
+
+        // no false negatives
+        REQUIRE((!found or pass));
+
+        if ( found )
+            ++listed;
+        else if ( pass )
+            ++fp;
+        else
+            ++passed;
+    }
+
+    // about 0.5% at 12 bits per key
+    CHECK(fp * 100 < (fp + passed) * 2);
+    CHECK(listed + fp + passed == 100000);
+}
+
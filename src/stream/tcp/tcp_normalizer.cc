@@ -60,7 +60,7 @@ bool TcpNormalizer::strip_tcp_timestamp(
     {
         // set raw option bytes to nops
         memset((void*)opt, (uint32_t)tcp::TcpOptCode::NOP, tcp::TCPOLEN_TIMESTAMP);
-        tsd.set_packet_flags(PKT_MODIFIED);
+        tsd.set_modified();
         return true;
     }
 
@@ -151,7 +151,7 @@ void TcpNormalizer::ecn_stripper(
         if (tns.strip_ecn == NORM_MODE_ON)
         {
             (const_cast<tcp::TCPHdr*>(tcph))->th_flags &= ~(TH_ECE | TH_CWR);
-            tsd.set_packet_flags(PKT_MODIFIED);
+            tsd.set_modified();
         }
 
         norm_stats[PC_TCP_ECN_SSN][tns.strip_ecn]++;
@@ -132,6 +132,13 @@ public:
     void set_packet_flags(uint32_t flags) const
     { pkt->packet_flags |= flags; }
 
+    // the checksums are recomputed when the packet is written back
+    void set_modified() const
+    {
+        pkt->packet_flags |= PKT_MODIFIED;
+        pkt->clear_cksums_current();
+    }
+
     bool are_packet_flags_set(uint32_t flags) const
     { return (pkt->packet_flags & flags) == flags; }
 
@@ -153,7 +160,7 @@ public:
     void rewrite_payload(uint16_t offset, uint8_t* from, uint16_t length)
     {
         memcpy(const_cast<uint8_t*>(pkt->data + offset), from, length);
-        set_packet_flags(PKT_MODIFIED);
+        set_modified();
     }
 
     void rewrite_payload(uint16_t offset, uint8_t* from)
@@ -25,6 +25,7 @@
 
 #include "host_attributes.h"
 
+#include "framework/epoch.h"
 #include "hash/lru_segmented_cache_shared.h"
 #include "main/reload_tuner.h"
 #include "main/shell.h"
@@ -81,60 +82,94 @@ static HostAttributesSegmentedCache* next_cache = nullptr;
 static HostAttributesSegmentedCache* old_cache = nullptr;
 static THREAD_LOCAL HostAttributeStats host_attribute_stats;
 
+void HostAttributesDescriptor::publish_services(ServiceList* list)
+{
+    ServiceList* old = services.exchange(list, std::memory_order_acq_rel);
+
+    if ( old )
+        Epoch::retire(old);
+}
+
 bool HostAttributesDescriptor::update_service
     (uint16_t port, uint16_t protocol, SnortProtocolId snort_protocol_id, bool& updated,
     bool is_appid_service)
 {
     std::lock_guard<std::mutex> lck(host_attributes_lock);
 
-    auto it = std::find_if(services.begin(), services.end(),
+    const ServiceList* cur = services.load(std::memory_order_acquire);
+    ServiceList* list = cur ? new ServiceList(*cur) : new ServiceList;
+
+    auto it = std::find_if(list->begin(), list->end(),
         [port, protocol](const HostServiceDescriptor& s){ return s.ipproto == protocol && s.port == port; });
-    if (it != services.cend())
+    if (it != list->end())
     {
         HostServiceDescriptor& s = *it;
         if ( s.snort_protocol_id != snort_protocol_id )
         {
             s.snort_protocol_id = snort_protocol_id;
             s.appid_service = is_appid_service;
+            publish_services(list);
         }
+        else
+            delete list;
+
         updated = true;
         return true;
     }
 
     // service not found, add it
-    if ( services.size() < SnortConfig::get_conf()->get_max_services_per_host() )
+    if ( list->size() < SnortConfig::get_conf()->get_max_services_per_host() )
     {
         updated = false;
-        services.emplace_back(HostServiceDescriptor(port, protocol, snort_protocol_id, is_appid_service));
+        list->emplace_back(HostServiceDescriptor(port, protocol, snort_protocol_id, is_appid_service));
+        publish_services(list);
         return true;
     }
 
+    delete list;
     return false;
 }
 
 void HostAttributesDescriptor::clear_appid_services()
 {
     std::lock_guard<std::mutex> lck(host_attributes_lock);
-    for ( auto s = services.begin(); s != services.end(); )
+
+    const ServiceList* cur = services.load(std::memory_order_acquire);
+
+    if ( !cur )
+        return;
+
+    ServiceList* list = new ServiceList;
+
+    for ( const auto& s : *cur )
     {
-        if ( s->appid_service and s->snort_protocol_id != UNKNOWN_PROTOCOL_ID )
-            s = services.erase(s);
-        else
-            s++;
+        if ( !s.appid_service or s.snort_protocol_id == UNKNOWN_PROTOCOL_ID )
+            list->emplace_back(s);
     }
+
+    if ( list->size() == cur->size() )
+        delete list;
+    else
+        publish_services(list);
 }
 
 void HostAttributesDescriptor::get_host_attributes(uint16_t port,HostAttriInfo* host_info) const
 {
-    std::lock_guard<std::mutex> slk(host_attributes_lock);
     host_info->frag_policy = policies.fragPolicy;
     host_info->stream_policy = policies.streamPolicy;
     host_info->snort_protocol_id = UNKNOWN_PROTOCOL_ID;
-    auto it = std::find_if(services.cbegin(), services.cend(),
+
+    const ServiceList* list = services.load(std::memory_order_acquire);
+
+    if ( !list )
+        return;
+
+    auto it = std::find_if(list->cbegin(), list->cend(),
         [port](const HostServiceDescriptor &s){ return s.port == port; });
-    if (it != services.cend())
+    if (it != list->cend())
         host_info->snort_protocol_id = (*it).snort_protocol_id;
 }
+
 bool HostAttributesManager::load_hosts_file(snort::SnortConfig* sc, const char* fname)
 {
     delete next_cache;
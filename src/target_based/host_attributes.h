@@ -24,6 +24,7 @@
 
 // Provides attribute table initialization, lookup, swap, and releasing.
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -88,7 +89,8 @@ class HostAttributesDescriptor
 {
 public:
     HostAttributesDescriptor() = default;
-    ~HostAttributesDescriptor() = default;
+    ~HostAttributesDescriptor()
+    { delete services.load(); }
 
     bool update_service(uint16_t port, uint16_t protocol, SnortProtocolId, bool& updated,
         bool is_appid_service = false);
@@ -115,10 +117,16 @@ public:
     }
 
 private:
-    mutable std::mutex host_attributes_lock; // ensure updates to this shared object are safe
+    typedef std::vector<HostServiceDescriptor> ServiceList;
+
+    // writers copy the services and publish the copy so the packet threads
+    // can look them up without locking; the lock only serializes writers
+    void publish_services(ServiceList*);
+
+    std::mutex host_attributes_lock;
     snort::SfIp ip_address;
     HostPolicyDescriptor policies;
-    std::vector<HostServiceDescriptor> services;
+    std::atomic<ServiceList*> services { nullptr };
 };
 
 typedef std::shared_ptr<HostAttributesDescriptor> HostAttributesEntry;
@@ -48,6 +48,15 @@ public:
     {
         return set_mempolicy(mode, nodemask, maxnode);
     }
+    virtual int get_mem_policy(int* mode, unsigned long* nodemask,
+                              unsigned long maxnode, void* addr, unsigned long flags)
+    {
+        return get_mempolicy(mode, nodemask, maxnode, addr, flags);
+    }
+    virtual int node_of_cpu(int cpu)
+    {
+        return numa_node_of_cpu(cpu);
+    }
 };
 class HwlocWrapper
 {
@@ -0,0 +1,407 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023-2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// compact_reader.cc author Cisco
+
+// dumps events from compact event logs written by alert_compact, using the
+// index to skip the blocks which can't match the given sids and time range
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "log/compact_log_format.h"
+
+struct Filter
+{
+    std::set<uint32_t> sids;
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+    bool payload = false;
+
+    bool match(const CompactBlockSummary& s) const
+    {
+        if ( !s.overlaps(from, to) )
+            return false;
+
+        if ( sids.empty() )
+            return true;
+
+        for ( auto sid : sids )
+            if ( s.may_have_sid(sid) )
+                return true;
+
+        return false;
+    }
+
+    bool match(uint32_t sid, uint32_t second) const
+    {
+        return second >= from and second <= to and
+            (sids.empty() or sids.count(sid));
+    }
+};
+
+struct Stats
+{
+    unsigned blocks = 0;
+    unsigned skipped = 0;
+    unsigned events = 0;
+};
+
+static void print_ip(const uint8_t* ip)
+{
+    static const uint8_t mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+    char buf[INET6_ADDRSTRLEN];
+
+    if ( !memcmp(ip, mapped, sizeof(mapped)) )
+        inet_ntop(AF_INET, ip + sizeof(mapped), buf, sizeof(buf));
+    else
+        inet_ntop(AF_INET6, ip, buf, sizeof(buf));
+
+    printf("%s", buf);
+}
+
+static void print_payload(const uint8_t* data, uint32_t len)
+{
+    for ( uint32_t i = 0; i < len; i += 16 )
+    {
+        printf("    %04x ", i);
+
+        for ( uint32_t j = i; j < i + 16; ++j )
+        {
+            if ( j < len )
+                printf(" %02x", data[j]);
+            else
+                printf("   ");
+        }
+
+        printf("  ");
+
+        for ( uint32_t j = i; j < i + 16 and j < len; ++j )
+            putchar(isprint(data[j]) ? data[j] : '.');
+
+        putchar('\n');
+    }
+}
+
+static bool dump_block(
+    const uint8_t* base, size_t size, uint64_t offset, const Filter& filter, Stats& stats)
+{
+    CompactBlockHeader hdr;
+
+    if ( offset + sizeof(hdr) > size )
+        return false;
+
+    memcpy(&hdr, base + offset, sizeof(hdr));
+
+    if ( hdr.magic != COMPACT_LOG_BLOCK_MAGIC or
+        offset + sizeof(hdr) + hdr.stored_size > size )
+    {
+        printf("ERROR: bad block at offset %" PRIu64 "\n", offset);
+        return false;
+    }
+
+    if ( !filter.match(hdr.summary) )
+    {
+        stats.skipped++;
+        return true;
+    }
+
+    stats.blocks++;
+
+    const uint8_t* data = base + offset + sizeof(hdr);
+    std::vector<uint8_t> raw;
+
+    if ( hdr.flags & COMPACT_BLOCK_DEFLATE )
+    {
+        raw.resize(hdr.raw_size);
+        uLongf len = raw.size();
+
+        if ( uncompress(raw.data(), &len, data, hdr.stored_size) != Z_OK or len != raw.size() )
+        {
+            printf("ERROR: can't inflate block at offset %" PRIu64 "\n", offset);
+            return false;
+        }
+        data = raw.data();
+    }
+    else
+    {
+        if ( hdr.stored_size != hdr.raw_size )
+        {
+            printf("ERROR: bad size of block at offset %" PRIu64 "\n", offset);
+            return false;
+        }
+
+        // the columns must be aligned
+        raw.assign(data, data + hdr.stored_size);
+        data = raw.data();
+    }
+
+    CompactColumns col;
+
+    if ( !col.map(data, hdr.raw_size, hdr.summary.events) )
+    {
+        printf("ERROR: bad columns in block at offset %" PRIu64 "\n", offset);
+        return false;
+    }
+
+    const uint8_t* payload = col.payload;
+
+    for ( uint32_t i = 0; i < hdr.summary.events; ++i )
+    {
+        const uint8_t* pkt = payload;
+        payload += col.payload_len[i];
+
+        if ( !filter.match(col.sid[i], col.second[i]) )
+            continue;
+
+        stats.events++;
+
+        printf("%u.%06u [%u:%u:%u] event %u class %u priority %u proto %u action %u ",
+            col.second[i], col.microsecond[i], col.gid[i], col.sid[i], col.rev[i],
+            col.event_id[i], col.class_id[i], col.priority[i], col.ip_proto[i], col.action[i]);
+
+        print_ip(col.src_ip + i * 16);
+        printf(":%u -> ", col.src_port[i]);
+        print_ip(col.dst_ip + i * 16);
+        printf(":%u payload %u\n", col.dst_port[i], col.payload_len[i]);
+
+        if ( filter.payload )
+            print_payload(pkt, col.payload_len[i]);
+    }
+    return true;
+}
+
+// the index entries of a log which was not closed, as far as they go; the
+// last entry may be partly written
+static void read_index_file(const char* name, std::vector<CompactIndexEntry>& index)
+{
+    std::string index_name = name;
+    index_name += COMPACT_LOG_INDEX_SUFFIX;
+
+    FILE* file = fopen(index_name.c_str(), "rb");
+
+    if ( !file )
+        return;
+
+    CompactIndexEntry e;
+
+    while ( fread(&e, sizeof(e), 1, file) == 1 )
+        index.emplace_back(e);
+
+    fclose(file);
+}
+
+static int dump_file(const char* name, const Filter& filter)
+{
+    int fd = open(name, O_RDONLY);
+
+    if ( fd < 0 )
+    {
+        printf("ERROR: can't open %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+
+    if ( fstat(fd, &st) or (size_t)st.st_size < sizeof(CompactFileHeader) )
+    {
+        printf("ERROR: %s is too short\n", name);
+        close(fd);
+        return -1;
+    }
+
+    size_t size = st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if ( map == MAP_FAILED )
+    {
+        printf("ERROR: can't map %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    const uint8_t* base = (const uint8_t*)map;
+    CompactFileHeader hdr;
+    memcpy(&hdr, base, sizeof(hdr));
+
+    if ( hdr.magic != COMPACT_LOG_MAGIC or hdr.version != COMPACT_LOG_VERSION )
+    {
+        printf("ERROR: %s is not a compact event log\n", name);
+        munmap(map, size);
+        return -1;
+    }
+
+    printf("file %s created %u linktype %u\n", name, hdr.created, hdr.linktype);
+
+    CompactTrailer trailer;
+    memcpy(&trailer, base + size - sizeof(trailer), sizeof(trailer));
+
+    Stats stats;
+    int ret = 0;
+
+    if ( trailer.magic == COMPACT_LOG_INDEX_MAGIC and trailer.index_offset +
+        trailer.blocks * sizeof(CompactIndexEntry) + sizeof(trailer) == size )
+    {
+        for ( uint32_t i = 0; i < trailer.blocks; ++i )
+        {
+            CompactIndexEntry e;
+            memcpy(&e, base + trailer.index_offset + i * sizeof(e), sizeof(e));
+
+            if ( !filter.match(e.summary) )
+                stats.skipped++;
+
+            else if ( !dump_block(base, size, e.offset, filter, stats) )
+            {
+                ret = -1;
+                break;
+            }
+        }
+    }
+    else
+    {
+        // not closed, so use the index file for the blocks it has and read
+        // the rest in order
+        std::vector<CompactIndexEntry> index;
+        read_index_file(name, index);
+
+        uint64_t offset = hdr.header_size;
+
+        if ( index.empty() )
+            printf("WARNING: %s has no index\n", name);
+
+        else
+            printf("WARNING: %s has a partial index of %zu blocks\n", name, index.size());
+
+        for ( const auto& e : index )
+        {
+            // blocks are indexed in order after they are written
+            if ( e.offset != offset )
+            {
+                printf("ERROR: index entry for offset %" PRIu64 " is out of order\n", e.offset);
+                break;
+            }
+
+            CompactBlockHeader bh;
+
+            if ( offset + sizeof(bh) > size )
+                break;
+
+            memcpy(&bh, base + offset, sizeof(bh));
+
+            if ( bh.magic != COMPACT_LOG_BLOCK_MAGIC )
+                break;
+
+            if ( !filter.match(e.summary) )
+                stats.skipped++;
+
+            else if ( !dump_block(base, size, offset, filter, stats) )
+            {
+                ret = -1;
+                break;
+            }
+
+            offset += sizeof(bh) + bh.stored_size;
+        }
+
+        while ( !ret and offset + sizeof(CompactBlockHeader) <= size )
+        {
+            CompactBlockHeader bh;
+            memcpy(&bh, base + offset, sizeof(bh));
+
+            if ( !dump_block(base, size, offset, filter, stats) )
+                break;
+
+            offset += sizeof(bh) + bh.stored_size;
+        }
+    }
+
+    printf("blocks read %u, skipped %u, events %u\n", stats.blocks, stats.skipped, stats.events);
+
+    munmap(map, size);
+    return ret;
+}
+
+static void usage()
+{
+    puts("usage: compact_reader [-s sid]... [-f from] [-t to] [-p] <file>...");
+    puts("    -s sid   only events for this sid, may be repeated");
+    puts("    -f from  only events at or after this second");
+    puts("    -t to    only events at or before this second");
+    puts("    -p       dump the payloads");
+}
+
+int main(int argc, char** argv)
+{
+    Filter filter;
+    int opt;
+
+    while ( (opt = getopt(argc, argv, "s:f:t:p")) != -1 )
+    {
+        switch ( opt )
+        {
+        case 's':
+            filter.sids.insert(strtoul(optarg, nullptr, 0));
+            break;
+        case 'f':
+            filter.from = strtoul(optarg, nullptr, 0);
+            break;
+        case 't':
+            filter.to = strtoul(optarg, nullptr, 0);
+            break;
+        case 'p':
+            filter.payload = true;
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if ( optind >= argc )
+    {
+        usage();
+        return 1;
+    }
+
+    int ret = 0;
+
+    for ( int i = optind; i < argc; ++i )
+    {
+        if ( dump_file(argv[i], filter) )
+            ret = 1;
+    }
+
+    return ret;
+}